@@ -0,0 +1,172 @@
+// alimerImageDecodeBatch against a serial alimerImageCreateFromMemory loop over a mixed PNG, JPEG and EXR corpus,
+// at 1, 2, 4 ... hardware threads. The measured per-image times are also replayed on N lanes to show what the
+// largest-first order buys over input order, independent of the cores of the machine running it.
+#include "alimer_assets.h"
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    double Now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool ALIMER_CALL WriteChunk(const void* data, size_t size, void* userData)
+    {
+        std::vector<uint8_t>* file = (std::vector<uint8_t>*)userData;
+        file->insert(file->end(), (const uint8_t*)data, (const uint8_t*)data + size);
+        return true;
+    }
+
+    Image* MakeImage(uint32_t width, uint32_t height, uint32_t seed)
+    {
+        Image* image = alimerImageCreate2D(PixelFormat_RGBA8Unorm, width, height, 1, 1);
+        const ImageLevel* level = alimerImageGetLevel(image, 0, 0);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint8_t* pixel = level->pixels + y * level->rowPitch + x * 4;
+                const float wave = sinf(x * 0.013f + (float)seed) * cosf(y * 0.011f);
+                seed = seed * 1664525u + 1013904223u;
+                pixel[0] = (uint8_t)(127.0f + 120.0f * wave);
+                pixel[1] = (uint8_t)(x ^ y);
+                pixel[2] = (uint8_t)((seed >> 24) & 15) + (uint8_t)(y / 4);
+                pixel[3] = 255;
+            }
+        }
+        return image;
+    }
+
+    std::vector<uint8_t> Save(Image* image, ImageFileType fileType, uint32_t quality)
+    {
+        std::vector<uint8_t> file;
+        alimerImageSaveToMemory(image, fileType, quality, WriteChunk, &file);
+        return file;
+    }
+
+    double Median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+}
+
+int main()
+{
+    // The EXRs come last, so input order is the bad case for a scheduler that doesn't sort.
+    std::vector<std::vector<uint8_t>> files;
+    for (uint32_t i = 0; i < 24; ++i)
+    {
+        Image* image = MakeImage(512, 512, i);
+        files.push_back(Save(image, ImageFileType_PNG, 0));
+        alimerImageDestroy(image);
+    }
+    for (uint32_t i = 0; i < 24; ++i)
+    {
+        Image* image = MakeImage(1024, 768, 100 + i);
+        files.push_back(Save(image, ImageFileType_JPG, 90));
+        alimerImageDestroy(image);
+    }
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        Image* image = MakeImage(2048, 1024, 200 + i);
+        Image* half = alimerImageConvert(image, PixelFormat_RGBA16Float);
+        files.push_back(Save(half, ImageFileType_EXR, 0));
+        alimerImageDestroy(image);
+        alimerImageDestroy(half);
+    }
+
+    const uint32_t count = (uint32_t)files.size();
+    std::vector<const void*> buffers(count);
+    std::vector<size_t> sizes(count);
+    size_t totalSize = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        buffers[i] = files[i].data();
+        sizes[i] = files[i].size();
+        totalSize += sizes[i];
+    }
+
+    std::vector<double> imageTimes(count, 1e9);
+    for (uint32_t run = 0; run < 3; ++run)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const double start = Now();
+            Image* image = alimerImageCreateFromMemory(buffers[i], sizes[i]);
+            imageTimes[i] = std::min(imageTimes[i], Now() - start);
+            alimerImageDestroy(image);
+        }
+    }
+
+    double serialTime = 0.0;
+    for (double time : imageTimes)
+        serialTime += time;
+
+    const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    printf("corpus: %u files, %.1f MB, serial sum %.0f ms, %u hardware threads\n", count, totalSize / 1e6, serialTime * 1e3, hardwareThreads);
+
+    // Medians of interleaved runs, so a noisy neighbour hits both sides alike.
+    std::vector<Image*> images(count);
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t threads = 1; threads < hardwareThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(hardwareThreads);
+    for (uint32_t threads : threadCounts)
+    {
+        std::vector<double> loopTimes;
+        std::vector<double> batchTimes;
+        for (uint32_t run = 0; run < 7; ++run)
+        {
+            double start = Now();
+            for (uint32_t i = 0; i < count; ++i)
+                images[i] = alimerImageCreateFromMemory(buffers[i], sizes[i]);
+            loopTimes.push_back(Now() - start);
+            for (Image* image : images)
+                alimerImageDestroy(image);
+
+            start = Now();
+            const uint32_t decoded = alimerImageDecodeBatch(buffers.data(), sizes.data(), count, images.data(), threads);
+            batchTimes.push_back(Now() - start);
+            if (decoded != count)
+                printf("decoded %u of %u\n", decoded, count);
+            for (Image* image : images)
+                alimerImageDestroy(image);
+        }
+
+        const double loopTime = Median(loopTimes);
+        const double batchTime = Median(batchTimes);
+        printf("threads %2u: serial loop %7.1f ms, batch %7.1f ms (x%.2f)\n", threads, loopTime * 1e3, batchTime * 1e3, loopTime / batchTime);
+    }
+
+    // Greedy list scheduling of the measured times: each image goes to the lane that frees up first.
+    std::vector<uint32_t> bySize(count);
+    std::vector<uint32_t> byInput(count);
+    for (uint32_t i = 0; i < count; ++i)
+        bySize[i] = byInput[i] = i;
+    std::sort(bySize.begin(), bySize.end(), [&](uint32_t a, uint32_t b) { return sizes[a] > sizes[b]; });
+
+    printf("replayed on N lanes:\n");
+    for (uint32_t lanes = 1; lanes <= 32; lanes *= 2)
+    {
+        auto replay = [&](const std::vector<uint32_t>& order) {
+            std::vector<double> laneTimes(lanes, 0.0);
+            for (uint32_t index : order)
+                *std::min_element(laneTimes.begin(), laneTimes.end()) += imageTimes[index];
+            return *std::max_element(laneTimes.begin(), laneTimes.end());
+        };
+
+        const double sizeOrder = replay(bySize);
+        const double inputOrder = replay(byInput);
+        printf("lanes %2u: largest first %7.1f ms (x%.2f), input order %7.1f ms (x%.2f)\n",
+            lanes, sizeOrder * 1e3, serialTime / sizeOrder, inputOrder * 1e3, serialTime / inputOrder);
+    }
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+// Per-glyph font queries and alimerFontLayoutText over Latin, Japanese-like and Chinese-like text, for every font
+// file passed on the command line (fonts aren't shipped with the repository, e.g. pass a Latin font and Noto Sans CJK).
+// The query loop is what a layout loop does per glyph: GetGlyphIndex, GetCharacter and GetKerning with the previous glyph.
+#include "alimer_assets.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace
+{
+    double Now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint32_t s_seed = 12345;
+
+    uint32_t Random()
+    {
+        s_seed = s_seed * 1664525u + 1013904223u;
+        return s_seed >> 8;
+    }
+
+    void AppendUtf8(std::string* text, uint32_t codepoint)
+    {
+        if (codepoint < 0x80)
+        {
+            text->push_back((char)codepoint);
+        }
+        else if (codepoint < 0x800)
+        {
+            text->push_back((char)(0xC0 | (codepoint >> 6)));
+            text->push_back((char)(0x80 | (codepoint & 0x3F)));
+        }
+        else if (codepoint < 0x10000)
+        {
+            text->push_back((char)(0xE0 | (codepoint >> 12)));
+            text->push_back((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+            text->push_back((char)(0x80 | (codepoint & 0x3F)));
+        }
+        else
+        {
+            text->push_back((char)(0xF0 | (codepoint >> 18)));
+            text->push_back((char)(0x80 | ((codepoint >> 12) & 0x3F)));
+            text->push_back((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+            text->push_back((char)(0x80 | (codepoint & 0x3F)));
+        }
+    }
+
+    struct Text
+    {
+        const char* name;
+        std::vector<uint32_t> codepoints;
+        std::string utf8;
+    };
+
+    Text MakeLatin()
+    {
+        Text text = { "latin", {}, {} };
+        for (uint32_t i = 0; i < 40; ++i)
+            text.utf8 += "The quick brown fox jumps over the lazy dog. AVATAR Wave, To. Typography kerning: VA Ty Yo LT. ";
+        for (char c : text.utf8)
+            text.codepoints.push_back((uint8_t)c);
+        return text;
+    }
+
+    // Common ideographs are spread over the whole unified block, so a text touches most of its cmap range.
+    // A fixed set of 3000 stands in for the common characters, one in five comes from anywhere in Ext A and the block.
+    Text MakeCJK(const char* name, uint32_t kanaPercent)
+    {
+        std::vector<uint32_t> common(3000);
+        for (uint32_t& codepoint : common)
+            codepoint = 0x4E00 + Random() % (0xA000 - 0x4E00);
+
+        static const uint32_t kPunctuation[] = { 0x3001, 0x3002, 0x300C, 0x300D, 0xFF08, 0xFF09, 0xFF0C };
+        Text text = { name, {}, {} };
+        for (uint32_t i = 0; i < 4000; ++i)
+        {
+            uint32_t codepoint;
+            if (i % 13 == 12)
+                codepoint = kPunctuation[Random() % 7];
+            else if (Random() % 100 < kanaPercent)
+                codepoint = (Random() & 1) ? 0x3041 + Random() % 0x56 : 0x30A1 + Random() % 0x56;
+            else if (Random() % 5 == 0)
+                codepoint = 0x3400 + Random() % (0xA000 - 0x3400);
+            else
+                codepoint = common[Random() % common.size()];
+
+            text.codepoints.push_back(codepoint);
+            AppendUtf8(&text.utf8, codepoint);
+        }
+        return text;
+    }
+
+    bool ReadFile(const char* path, std::vector<uint8_t>* data)
+    {
+        FILE* file = fopen(path, "rb");
+        if (!file)
+            return false;
+        fseek(file, 0, SEEK_END);
+        data->resize((size_t)ftell(file));
+        fseek(file, 0, SEEK_SET);
+        const bool result = fread(data->data(), 1, data->size(), file) == data->size();
+        fclose(file);
+        return result;
+    }
+
+    double QueryText(Font* font, const Text& text, float scale)
+    {
+        const double start = Now();
+        int previous = 0;
+        float x = 0.0f;
+        for (uint32_t codepoint : text.codepoints)
+        {
+            const int glyph = alimerFontGetGlyphIndex(font, (int)codepoint);
+            int width, height, visible;
+            float advance, offsetX, offsetY;
+            alimerFontGetCharacter(font, glyph, scale, &width, &height, &advance, &offsetX, &offsetY, &visible);
+            x += advance + alimerFontGetKerning(font, previous, glyph, scale);
+            previous = glyph;
+        }
+        const double time = Now() - start;
+
+        // Keeps the loop from being optimized away.
+        if (x < 0.0f)
+            printf("%f\n", x);
+        return time;
+    }
+
+    void Run(const char* path)
+    {
+        std::vector<uint8_t> data;
+        if (!ReadFile(path, &data))
+        {
+            printf("%s: can't read\n", path);
+            return;
+        }
+
+        const char* name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+        const double createStart = Now();
+        Font* font = alimerFontCreateFromMemory(data.data(), data.size());
+        const double createTime = Now() - createStart;
+        if (!font)
+        {
+            printf("%s: not a font\n", name);
+            return;
+        }
+
+        printf("%s (%.1f MB): created in %.2f ms\n", name, data.size() / 1e6, createTime * 1e3);
+
+        // Each text gets a fresh Font, so the first query pass pays for building the cmap and metrics blocks.
+        s_seed = 12345;
+        const Text texts[] = { MakeLatin(), MakeCJK("japanese", 40), MakeCJK("chinese", 0) };
+        for (const Text& text : texts)
+        {
+            alimerFontDestroy(font);
+            font = alimerFontCreateFromMemory(data.data(), data.size());
+
+            const float size = 18.0f;
+            const float scale = alimerFontGetScale(font, size);
+            uint32_t missing = 0;
+            for (uint32_t codepoint : text.codepoints)
+                missing += alimerFontGetGlyphIndex(font, (int)codepoint) == 0 ? 1 : 0;
+
+            alimerFontDestroy(font);
+            font = alimerFontCreateFromMemory(data.data(), data.size());
+            const double coldTime = QueryText(font, text, scale);
+            double queryTime = 1e9;
+            for (uint32_t run = 0; run < 50; ++run)
+                queryTime = std::min(queryTime, QueryText(font, text, scale));
+
+            std::vector<FontGlyphQuad> quads(text.codepoints.size());
+            uint32_t quadCount = 0;
+            double layoutTime = 1e9;
+            for (uint32_t run = 0; run < 50; ++run)
+            {
+                quadCount = (uint32_t)quads.size();
+                const double start = Now();
+                alimerFontLayoutText(font, text.utf8.data(), (uint32_t)text.utf8.size(), size, 0.0f, FontTextAlign_Left, quads.data(), &quadCount);
+                layoutTime = std::min(layoutTime, Now() - start);
+            }
+
+            const double count = (double)text.codepoints.size();
+            printf("  %-8s %5u glyphs (%u missing): queries cold %5.1f, warm %5.1f Mglyph/s, layout %5.1f Mglyph/s (%u quads)\n",
+                text.name, (uint32_t)text.codepoints.size(), missing, count / coldTime / 1e6, count / queryTime / 1e6,
+                count / layoutTime / 1e6, quadCount);
+        }
+
+        alimerFontDestroy(font);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: alimer_font_layout_bench font.ttf [font.otf ...]\n");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; ++i)
+        Run(argv[i]);
+    return 0;
+}
@@ -0,0 +1,203 @@
+// Reduced JPEG decode (alimerImageCreateFromMemoryReduced) against a full decode plus box resize at mips 1 to 3:
+// time of both, and the PSNR of the reduced image against an aligned box average of the full decode. Pass JPEG files,
+// or none for a synthetic set.
+#include "alimer_assets.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace
+{
+    double Now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool ALIMER_CALL WriteChunk(const void* data, size_t size, void* userData)
+    {
+        std::vector<uint8_t>* file = (std::vector<uint8_t>*)userData;
+        file->insert(file->end(), (const uint8_t*)data, (const uint8_t*)data + size);
+        return true;
+    }
+
+    // Smooth gradients, a few hard edges and some grain, closer to a photo than noise.
+    std::vector<uint8_t> MakeJpeg(PixelFormat format, uint32_t width, uint32_t height, uint32_t quality)
+    {
+        Image* image = alimerImageCreate2D(format, width, height, 1, 1);
+        const ImageLevel* level = alimerImageGetLevel(image, 0, 0);
+        const uint32_t channels = format == PixelFormat_R8Unorm ? 1 : 4;
+        uint32_t seed = 1;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                const float grain = (float)(seed >> 28) - 7.5f;
+                const float edge = ((x / 97 + y / 61) & 1) ? 40.0f : 0.0f;
+                const float value[3] = {
+                    128.0f + 90.0f * sinf(x * 0.011f) * cosf(y * 0.007f) + edge + grain,
+                    110.0f + 70.0f * cosf((x + y) * 0.005f) - edge * 0.5f + grain,
+                    100.0f + 80.0f * sinf(y * 0.013f + x * 0.002f) + grain,
+                };
+                uint8_t* pixel = level->pixels + y * level->rowPitch + x * channels;
+                for (uint32_t c = 0; c < channels; ++c)
+                    pixel[c] = c == 3 ? 255 : (uint8_t)std::min(255.0f, std::max(0.0f, value[c]));
+            }
+        }
+
+        std::vector<uint8_t> file;
+        alimerImageSaveToMemory(image, ImageFileType_JPG, quality, WriteChunk, &file);
+        alimerImageDestroy(image);
+        return file;
+    }
+
+    bool ReadFile(const char* path, std::vector<uint8_t>* data)
+    {
+        FILE* file = fopen(path, "rb");
+        if (!file)
+            return false;
+        fseek(file, 0, SEEK_END);
+        data->resize((size_t)ftell(file));
+        fseek(file, 0, SEEK_SET);
+        const bool result = fread(data->data(), 1, data->size(), file) == data->size();
+        fclose(file);
+        return result;
+    }
+
+    // The reduced image averages aligned factor x factor blocks, the remainder of odd sizes folds into the last texel.
+    // A resampling resize of such sizes is offset by a fraction of a texel and can't serve as the reference.
+    std::vector<double> BoxReference(Image* full, uint32_t mipLevel, uint32_t width, uint32_t height, uint32_t stride)
+    {
+        const ImageLevel* level = alimerImageGetLevel(full, 0, 0);
+        const uint32_t factor = 1u << mipLevel;
+        std::vector<double> sums((size_t)width * height * stride, 0.0);
+        std::vector<uint32_t> counts((size_t)width * height, 0);
+        for (uint32_t y = 0; y < level->height; ++y)
+        {
+            const uint32_t outY = std::min(y / factor, height - 1);
+            for (uint32_t x = 0; x < level->width; ++x)
+            {
+                const size_t index = (size_t)outY * width + std::min(x / factor, width - 1);
+                for (uint32_t c = 0; c < stride; ++c)
+                    sums[index * stride + c] += level->pixels[y * level->rowPitch + x * stride + c];
+                counts[index]++;
+            }
+        }
+
+        for (size_t i = 0; i < sums.size(); ++i)
+            sums[i] /= counts[i / stride];
+        return sums;
+    }
+
+    // Color channels only, alpha is always opaque.
+    void Compare(Image* reduced, const std::vector<double>& reference, double* psnr, int* maxError)
+    {
+        const ImageLevel* level = alimerImageGetLevel(reduced, 0, 0);
+        const uint32_t channels = alimerImageGetFormat(reduced) == PixelFormat_R8Unorm ? 1 : 3;
+        const uint32_t stride = channels == 1 ? 1 : 4;
+        double sum = 0.0;
+        *maxError = 0;
+        for (uint32_t y = 0; y < level->height; ++y)
+        {
+            for (uint32_t x = 0; x < level->width; ++x)
+            {
+                for (uint32_t c = 0; c < channels; ++c)
+                {
+                    const double expected = reference[((size_t)y * level->width + x) * stride + c];
+                    const double error = fabs(level->pixels[y * level->rowPitch + x * stride + c] - expected);
+                    sum += error * error;
+                    *maxError = std::max(*maxError, (int)(error + 0.5));
+                }
+            }
+        }
+
+        const double mse = sum / ((double)level->width * level->height * channels);
+        *psnr = mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+    }
+
+    template <typename Function>
+    double Best(int runs, Function function)
+    {
+        double best = 1e9;
+        for (int run = 0; run < runs; ++run)
+        {
+            const double start = Now();
+            function();
+            best = std::min(best, Now() - start);
+        }
+        return best;
+    }
+
+    void Run(const char* name, const std::vector<uint8_t>& file)
+    {
+        ImageInfo info = {};
+        if (!alimerImageGetInfoFromMemory(file.data(), file.size(), &info))
+        {
+            printf("%s: not an image\n", name);
+            return;
+        }
+
+        printf("%s (%ux%u)\n", name, info.width, info.height);
+        for (uint32_t mipLevel = 1; mipLevel <= 3; ++mipLevel)
+        {
+            const uint32_t width = std::max(info.width >> mipLevel, 1u);
+            const uint32_t height = std::max(info.height >> mipLevel, 1u);
+            Image* resized = nullptr;
+            Image* reduced = nullptr;
+            const double fullTime = Best(5, [&] {
+                alimerImageDestroy(resized);
+                Image* full = alimerImageCreateFromMemory(file.data(), file.size());
+                resized = alimerImageResize(full, width, height, ImageFilter_Box, ImageEdgeMode_Clamp, 0);
+                alimerImageDestroy(full);
+            });
+            const double reducedTime = Best(5, [&] {
+                alimerImageDestroy(reduced);
+                reduced = alimerImageCreateFromMemoryReduced(file.data(), file.size(), mipLevel);
+            });
+
+            Image* full = alimerImageCreateFromMemory(file.data(), file.size());
+            if (!full || !resized || !reduced)
+            {
+                printf("  mip %u: decode failed\n", mipLevel);
+            }
+            else
+            {
+                const uint32_t stride = alimerImageGetFormat(full) == PixelFormat_R8Unorm ? 1 : 4;
+                double psnr;
+                int maxError;
+                Compare(reduced, BoxReference(full, mipLevel, width, height, stride), &psnr, &maxError);
+                printf("  mip %u: reduced %7.2f ms, full + box %7.2f ms (x%.1f), PSNR %.1f dB, max error %d\n",
+                    mipLevel, reducedTime * 1e3, fullTime * 1e3, fullTime / reducedTime, psnr, maxError);
+            }
+
+            alimerImageDestroy(full);
+            alimerImageDestroy(resized);
+            alimerImageDestroy(reduced);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::vector<uint8_t> file;
+            if (ReadFile(argv[i], &file))
+                Run(argv[i], file);
+            else
+                printf("%s: can't read\n", argv[i]);
+        }
+        return 0;
+    }
+
+    // stb_image_write subsamples chroma 4:2:0 at quality 90 and below.
+    Run("synthetic 4:2:0", MakeJpeg(PixelFormat_RGBA8Unorm, 2048, 1536, 90));
+    Run("synthetic 4:4:4", MakeJpeg(PixelFormat_RGBA8Unorm, 2048, 1536, 95));
+    Run("synthetic gray", MakeJpeg(PixelFormat_R8Unorm, 2048, 1536, 90));
+    return 0;
+}
@@ -41,7 +41,17 @@
 #include <stdbool.h>
 
 typedef struct Image Image;
+typedef struct MipStream MipStream;
+typedef struct ImageResizer ImageResizer;
 typedef struct Font Font;
+typedef struct GlyphCache GlyphCache;
+
+typedef struct AllocationCallbacks {
+	void* (ALIMER_CALL* allocate)(size_t size, void* userData);
+	void* (ALIMER_CALL* reallocate)(void* ptr, size_t size, void* userData);
+	void (ALIMER_CALL* free)(void* ptr, void* userData);
+	void* userData;
+} AllocationCallbacks;
 
 typedef enum PixelFormat {
 	PixelFormat_Undefined = 0,
@@ -195,6 +205,34 @@ typedef enum ImageDimension {
 	_ImageDimensiont_Force32 = 0x7FFFFFFF
 } ImageDimension;
 
+typedef enum ImageFileType {
+	/// Unknown or unsupported container.
+	ImageFileType_Unknown = 0,
+	/// Windows bitmap.
+	ImageFileType_BMP,
+	/// Portable Network Graphics.
+	ImageFileType_PNG,
+	/// JPEG (baseline and progressive).
+	ImageFileType_JPG,
+	/// Truevision TGA.
+	ImageFileType_TGA,
+	/// Graphics Interchange Format (first frame only).
+	ImageFileType_GIF,
+	/// Radiance RGBE.
+	ImageFileType_HDR,
+	/// Quite OK Image format.
+	ImageFileType_QOI,
+	/// OpenEXR.
+	ImageFileType_EXR,
+	/// DirectDraw Surface, with or without the DX10 header.
+	ImageFileType_DDS,
+	/// Khronos Texture 2.0, without supercompression.
+	ImageFileType_KTX2,
+
+	_ImageFileType_Count,
+	_ImageFileType_Force32 = 0x7FFFFFFF
+} ImageFileType;
+
 typedef struct PixelFormatInfo {
 	PixelFormat format;
 	uint8_t bytesPerBlock;
@@ -203,6 +241,276 @@ typedef struct PixelFormatInfo {
 	PixelFormatKind kind;
 } PixelFormatInfo;
 
+typedef enum ImageFilter {
+	/// Mitchell when downsampling, Catmull-Rom when upsampling.
+	ImageFilter_Default = 0,
+	/// Box filter, the same result as averaging for integer scale ratios.
+	ImageFilter_Box = 1,
+	/// Triangle (bilinear) filter.
+	ImageFilter_Triangle = 2,
+	/// Cubic B-spline, gaussian-esque.
+	ImageFilter_CubicBSpline = 3,
+	/// Interpolating cubic spline.
+	ImageFilter_CatmullRom = 4,
+	/// Mitchell-Netrevalli filter with B=1/3, C=1/3.
+	ImageFilter_Mitchell = 5,
+	/// Point sampling.
+	ImageFilter_Point = 6,
+
+	_ImageFilter_Count,
+	_ImageFilter_Force32 = 0x7FFFFFFF
+} ImageFilter;
+
+typedef enum ImageMipmapFlags {
+	ImageMipmapFlags_None = 0,
+	/// Filter color channels as sRGB even when the format is not an sRGB format.
+	ImageMipmapFlags_ForceSrgb = 1 << 0,
+	/// Filter the stored values as is, even for sRGB formats.
+	ImageMipmapFlags_ForceLinear = 1 << 1,
+	/// Color channels are already premultiplied by alpha, don't apply alpha weighting.
+	ImageMipmapFlags_PremultipliedAlpha = 1 << 2,
+	/// Wrap around the image edges (tiling textures) instead of clamping.
+	ImageMipmapFlags_Wrap = 1 << 3,
+
+	_ImageMipmapFlags_Force32 = 0x7FFFFFFF
+} ImageMipmapFlags;
+
+typedef enum ImageEdgeMode {
+	/// Repeat the edge texels.
+	ImageEdgeMode_Clamp = 0,
+	/// Mirror the image at its edges.
+	ImageEdgeMode_Reflect = 1,
+	/// Wrap around the image edges (tiling textures).
+	ImageEdgeMode_Wrap = 2,
+	/// Read texels outside of the image as zero.
+	ImageEdgeMode_Zero = 3,
+
+	_ImageEdgeMode_Count,
+	_ImageEdgeMode_Force32 = 0x7FFFFFFF
+} ImageEdgeMode;
+
+typedef enum FontDistanceField {
+	/// Single channel true distance (R8Unorm), corners come out rounded when magnified.
+	FontDistanceField_SDF = 0,
+	/// Multi-channel pseudo-distance in RGB whose median keeps corners sharp, alpha holds the true distance (RGBA8Unorm).
+	FontDistanceField_MSDF = 1,
+
+	_FontDistanceField_Count,
+	_FontDistanceField_Force32 = 0x7FFFFFFF
+} FontDistanceField;
+
+typedef enum FontTextAlign {
+	FontTextAlign_Left = 0,
+	FontTextAlign_Center = 1,
+	FontTextAlign_Right = 2,
+
+	_FontTextAlign_Count,
+	_FontTextAlign_Force32 = 0x7FFFFFFF
+} FontTextAlign;
+
+typedef enum ImageCompressQuality {
+	/// Single endpoint fit per block (BC7 mode 6 only).
+	ImageCompressQuality_Fast = 0,
+	/// Endpoint refinement and the best few BC7 partitions.
+	ImageCompressQuality_Normal,
+	/// More refinement passes and BC7 partitions, several times slower than Normal.
+	ImageCompressQuality_High,
+
+	_ImageCompressQuality_Count,
+	_ImageCompressQuality_Force32 = 0x7FFFFFFF
+} ImageCompressQuality;
+
+typedef struct ImageInfo {
+	ImageFileType fileType;
+	ImageDimension dimension;
+	/// The format alimerImageCreateFromMemory will decode into.
+	PixelFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t depthOrArrayLayers;
+	uint32_t mipLevelCount;
+	/// Number of channels stored in the file.
+	uint32_t channels;
+} ImageInfo;
+
+/// A band of decoded rows, valid only for the duration of the stream callback.
+typedef struct ImageStreamBand {
+	/// First pixel row of the band.
+	uint32_t y;
+	/// Number of pixel rows, a multiple of the block height except for the last band.
+	uint32_t rowCount;
+	/// Bytes between two rows of blocks.
+	size_t rowPitch;
+	const uint8_t* pixels;
+} ImageStreamBand;
+
+/// Receives the bands from top to bottom, return false to stop the stream.
+typedef bool (ALIMER_CALL* ImageStreamCallback)(const ImageInfo* info, const ImageStreamBand* band, void* userData);
+
+/// Receives the bytes of a saved file in order and in pieces of any size, return false to abort the save.
+typedef bool (ALIMER_CALL* ImageWriteCallback)(const void* data, size_t size, void* userData);
+
+/// Selects what alimerImageCreateFromEXR reads, layers are the channel name prefixes before the last '.' ("diffuse" for diffuse.R).
+typedef struct ExrLoadDesc {
+	/// Layer to read, NULL or empty for the channels without a layer.
+	const char* layer;
+	/// Channel names within the layer for R, G, B and A, missing ones read as 0 (1 for alpha). All NULL picks R, G, B and A, a layer with a single channel is gray.
+	const char* channels[4];
+} ExrLoadDesc;
+
+/// Read size bytes at offset of a container into dst, return false on failure. Called on the thread that requests the levels.
+typedef bool (ALIMER_CALL* MipStreamReadCallback)(uint64_t offset, void* dst, size_t size, void* userData);
+
+typedef struct ImageDesc {
+	ImageDimension dimension;
+	PixelFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t depthOrArrayLayers;
+	/// Number of mip levels, 0 for the full chain down to 1x1.
+	uint32_t mipLevelCount;
+	/// Row pitch and subresource offset alignment in bytes, power of two (256 for D3D12, 0 or 1 for tightly packed rows).
+	uint32_t rowPitchAlignment;
+} ImageDesc;
+
+/// Location of one subresource (array layer and mip level) inside the image data.
+typedef struct ImageLevel {
+	uint32_t width;
+	uint32_t height;
+	uint32_t depth;
+	PixelFormat format;
+	/// Byte offset from the start of the image data.
+	size_t offset;
+	/// Bytes between two rows of blocks, including the alignment padding.
+	size_t rowPitch;
+	/// Bytes of one depth slice (rowPitch * rowCount).
+	size_t slicePitch;
+	/// Number of rows of blocks (height for uncompressed formats).
+	uint32_t rowCount;
+	uint8_t* pixels;
+} ImageLevel;
+
+typedef enum MemoryCategory {
+	/// Worker pool, scratch arenas and other library bookkeeping.
+	MemoryCategory_Internal = 0,
+	/// Transient decoder memory (file parsing, decompression, filtering).
+	MemoryCategory_ImageDecode,
+	/// Image objects and their pixel data.
+	MemoryCategory_ImageStorage,
+	/// Font objects and glyph rasterization.
+	MemoryCategory_Font,
+	/// Image encoders.
+	MemoryCategory_Encoder,
+
+	_MemoryCategory_Count,
+	_MemoryCategory_Force32 = 0x7FFFFFFF
+} MemoryCategory;
+
+typedef struct MemoryCategoryStats {
+	/// Bytes currently allocated.
+	uint64_t currentBytes;
+	/// Highest value of currentBytes since startup.
+	uint64_t peakBytes;
+	/// Allocations made since startup.
+	uint64_t allocationCount;
+	/// Allocations not freed yet.
+	uint64_t liveAllocations;
+} MemoryCategoryStats;
+
+typedef struct MemoryStats {
+	/// Totals over all the categories, the peak is the peak of the sum.
+	MemoryCategoryStats total;
+	MemoryCategoryStats categories[_MemoryCategory_Count];
+	/// Bytes of memory mapped files, not included in the heap totals.
+	uint64_t mappedBytes;
+	/// Image objects not destroyed yet.
+	uint32_t liveImages;
+	/// Font objects not destroyed yet.
+	uint32_t liveFonts;
+} MemoryStats;
+
+typedef struct FontCodepointRange {
+	uint32_t firstCodepoint;
+	uint32_t count;
+} FontCodepointRange;
+
+/// A glyph packed in an atlas, positions are in pixels from the pen on the baseline with y pointing down.
+typedef struct FontAtlasGlyph {
+	uint32_t codepoint;
+	uint32_t glyph;
+	/// Texel rectangle in the atlas, empty for glyphs without an outline.
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+	/// Normalized texture coordinates of the rectangle.
+	float u0;
+	float v0;
+	float u1;
+	float v1;
+	/// Quad the rectangle is drawn to, (x0, y0) is the top left corner.
+	float x0;
+	float y0;
+	float x1;
+	float y1;
+	float advance;
+} FontAtlasGlyph;
+
+/// A glyph placed by alimerFontLayoutText, the bitmap box in pixels from the top left of the text with y pointing down.
+typedef struct FontGlyphQuad {
+	uint32_t glyph;
+	float x;
+	float y;
+	float width;
+	float height;
+} FontGlyphQuad;
+
+typedef struct GlyphCacheDesc {
+	/// Width and height of the R8 atlas pages, 0 for 1024.
+	uint32_t pageSize;
+	/// Page budget, 0 for 4. Once reached, the least recently used page that wasn't used in the current frame is cleared for new glyphs.
+	uint32_t maxPages;
+	/// Empty texels around glyphs, 1 is enough for bilinear filtering.
+	uint32_t padding;
+	/// Horizontal subpixel positions a glyph is rasterized at (1-8), 0 for 4.
+	uint32_t subpixelSteps;
+} GlyphCacheDesc;
+
+typedef struct CachedGlyph {
+	/// Atlas page, UINT32_MAX for glyphs without an outline or that didn't fit.
+	uint32_t page;
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+	float u0;
+	float v0;
+	float u1;
+	float v1;
+	/// Quad relative to the pen position rounded down to a whole pixel, y pointing down.
+	float x0;
+	float y0;
+	float x1;
+	float y1;
+	float advance;
+} CachedGlyph;
+
+typedef struct GlyphCacheRect {
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+} GlyphCacheRect;
+
+/// Route every allocation through the given callbacks (NULL restores malloc/realloc/free). Must be called before any other function.
+ALIMER_API void alimerSetAllocator(const AllocationCallbacks* callbacks);
+
+/// Give each thread a bump arena of this size for transient decoder memory, reset after every call (0 disables it, the default).
+ALIMER_API void alimerSetScratchArenaSize(size_t size);
+
+/// Snapshot of the library heap usage, the counters are updated atomically and can be read from any thread.
+ALIMER_API void alimerGetMemoryStats(MemoryStats* stats);
+
 ALIMER_API bool GetPixelFormatInfo(PixelFormat format, PixelFormatInfo* info);
 
 /// Get the number of bytes per format.
@@ -245,10 +553,104 @@ ALIMER_API PixelFormat SrgbToLinearFormat(PixelFormat format);
 ALIMER_API PixelFormat LinearToSrgbFormat(PixelFormat format);
 
 /* Image */
+/// Create an image with zeroed storage for every array layer and mip level in a single allocation.
+ALIMER_API Image* alimerImageCreate(const ImageDesc* desc);
 ALIMER_API Image* alimerImageCreate2D(PixelFormat format, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevelCount);
+/// Cubemap of size x size faces, each cube takes six array layers in the +X, -X, +Y, -Y, +Z, -Z order.
+ALIMER_API Image* alimerImageCreateCube(PixelFormat format, uint32_t size, uint32_t cubeCount, uint32_t mipLevelCount);
 ALIMER_API Image* alimerImageCreateFromMemory(const void* pData, size_t dataSize);
+/// Load an image from a memory-mapped file, GPU-ready payloads (DDS, single level KTX2) reference the mapped pages without a copy.
+ALIMER_API Image* alimerImageCreateFromFile(const char* path);
+/// Decode a single part EXR (scanlines or level 0 tiles) on worker threads into RGBA16Float when every selected channel is half, RGBA32Float otherwise. desc can be NULL.
+ALIMER_API Image* alimerImageCreateFromEXR(const void* pData, size_t dataSize, const ExrLoadDesc* desc);
+/// Decode count images on the worker pool (threadCount 0 uses every core). Lanes pull from one shared atomic cursor over the buffers sorted largest first, there is no per-thread queue or work stealing. Failed entries are set to NULL, returns the number of decoded images.
+ALIMER_API uint32_t alimerImageDecodeBatch(const void** buffers, const size_t* sizes, uint32_t count, Image** outImages, uint32_t threadCount);
 ALIMER_API void alimerImageDestroy(Image* image);
 
+/// Detect the container from its magic bytes and read only the header, without decoding any pixel.
+ALIMER_API bool alimerImageGetInfoFromMemory(const void* pData, size_t dataSize, ImageInfo* info);
+
+/// Encode through the callback: DDS and KTX2 store every subresource as is, other types the converted top level of the first layer. quality is the JPEG quality or PNG level, 0 for the default.
+ALIMER_API bool alimerImageSaveToMemory(Image* image, ImageFileType fileType, uint32_t quality, ImageWriteCallback callback, void* userData);
+
+ALIMER_API ImageDimension alimerImageGetDimension(Image* image);
+ALIMER_API PixelFormat alimerImageGetFormat(Image* image);
+ALIMER_API uint32_t alimerImageGetWidth(Image* image, uint32_t level);
+ALIMER_API uint32_t alimerImageGetHeight(Image* image, uint32_t level);
+ALIMER_API uint32_t alimerImageGetDepth(Image* image, uint32_t level);
+ALIMER_API uint32_t alimerImageGetArrayLayers(Image* image);
+ALIMER_API uint32_t alimerImageGetMipLevelCount(Image* image);
+ALIMER_API void* alimerImageGetData(Image* image, size_t* size);
+ALIMER_API uint32_t alimerImageGetRowPitchAlignment(Image* image);
+
+/// Get the layout of a subresource, layers are stored one after another and each layer holds its whole mip chain.
+ALIMER_API const ImageLevel* alimerImageGetLevel(Image* image, uint32_t layer, uint32_t mipLevel);
+
+/// Repack the rows of every subresource to a new row pitch alignment (power of two).
+ALIMER_API bool alimerImageSetRowPitchAlignment(Image* image, uint32_t alignment);
+
+/// Decode the top level in bands of bandHeight rows (0 for 64). Non-interlaced PNG, uncompressed 8/24/32-bit BMP, raw or RLE 8/24/32-bit TGA, EXR, DDS and KTX2 stream with memory proportional to the width, other files (interlaced PNG, JPEG, GIF, HDR, QOI, 16-bit TGA, RLE BMP) are decoded in full first.
+ALIMER_API bool alimerImageStreamFromMemory(const void* pData, size_t dataSize, uint32_t bandHeight, ImageStreamCallback callback, void* userData);
+ALIMER_API bool alimerImageStreamFromFile(const char* path, uint32_t bandHeight, ImageStreamCallback callback, void* userData);
+
+/// Stream a file straight into the given box filtered mip level without holding the full image, JPEG scales down in its IDCT.
+ALIMER_API Image* alimerImageCreateFromMemoryReduced(const void* pData, size_t dataSize, uint32_t mipLevel);
+ALIMER_API Image* alimerImageCreateFromFileReduced(const char* path, uint32_t mipLevel);
+
+/// Build every mip level from level 0 (the full chain for a single level image) on worker threads, for 8/16-bit unorm and 16/32-bit float formats.
+ALIMER_API bool alimerImageGenerateMipmaps(Image* image, ImageFilter filter, uint32_t flags);
+
+/// Resize level 0 of every layer into a new single level image on worker threads, flags are ImageMipmapFlags with edgeMode in place of Wrap.
+ALIMER_API Image* alimerImageResize(Image* image, uint32_t width, uint32_t height, ImageFilter filter, ImageEdgeMode edgeMode, uint32_t flags);
+
+/// Plan a resize once (filter kernels and thread splits) and run it on any number of images of the same format and size.
+ALIMER_API ImageResizer* alimerImageResizerCreate(PixelFormat format, uint32_t srcWidth, uint32_t srcHeight, uint32_t width, uint32_t height, ImageFilter filter, ImageEdgeMode edgeMode, uint32_t flags);
+ALIMER_API void alimerImageResizerDestroy(ImageResizer* resizer);
+/// Same result as alimerImageResize, fails if the image doesn't match the resizer. A resizer runs one image at a time.
+ALIMER_API Image* alimerImageResizerRun(ImageResizer* resizer, Image* image);
+
+/// Convert every subresource to another uncompressed color format into a new image with the same layout, through linear RGBA float.
+ALIMER_API Image* alimerImageConvert(Image* image, PixelFormat format);
+
+/// Compress every subresource to BC1-BC5, BC7, ETC2/EAC or ASTC LDR into a new image with the same layout, block rows are split across worker threads.
+ALIMER_API Image* alimerImageCompress(Image* image, PixelFormat format, ImageCompressQuality quality);
+/// Decode the top level of a file in bands and compress each band as it arrives, the uncompressed image is never held in full.
+ALIMER_API Image* alimerImageCompressFromMemory(const void* pData, size_t dataSize, PixelFormat format, ImageCompressQuality quality);
+ALIMER_API Image* alimerImageCompressFromFile(const char* path, PixelFormat format, ImageCompressQuality quality);
+
+/// Decompress every subresource of a BC, ETC2/EAC or ASTC image into a new uncompressed image, invalid blocks decode to their format's error color.
+ALIMER_API Image* alimerImageDecompress(Image* image, PixelFormat format);
+
+/* Environment maps */
+/// Cubemap faces use the D3D/Vulkan orientation with +Y up, equirect images are centered on +Z. Faces and rows are split across worker threads.
+
+/// Resample the top level of an equirectangular image into a single level cubemap (faceSize 0 for width / 4), supersampled when the source is larger.
+ALIMER_API Image* alimerImageCreateCubeFromEquirect(Image* image, uint32_t faceSize);
+/// Resample the top level of a cubemap into a width x width / 2 equirectangular image (0 for 4 * face size).
+ALIMER_API Image* alimerImageCreateEquirectFromCube(Image* image, uint32_t width);
+
+/// GGX prefilter for split-sum IBL, mip i holds roughness i / (mipLevelCount - 1). sampleCount, faceSize and mipLevelCount 0 pick the defaults.
+ALIMER_API Image* alimerImagePrefilterSpecular(Image* image, uint32_t faceSize, uint32_t mipLevelCount, uint32_t sampleCount);
+/// Project the top level onto 9 RGB spherical harmonics in (l, m) order, weighted by texel solid angle.
+ALIMER_API bool alimerImageComputeSH9(Image* image, float coefficients[9][3]);
+/// Diffuse irradiance cubemap (faceSize 0 for 32) evaluated from the SH9 projection, stored divided by pi so that diffuse lighting is albedo times the texel.
+ALIMER_API Image* alimerImageCreateIrradianceCube(Image* image, uint32_t faceSize);
+
+/* Mip streaming */
+/// Open a DDS or KTX2 container reading only its header and the smallest tailLevelCount (at least one) mip levels of every layer.
+ALIMER_API MipStream* alimerMipStreamCreate(uint64_t size, MipStreamReadCallback read, void* userData, uint32_t tailLevelCount);
+/// Same with a memory-mapped file, only the pages of the resident levels are ever read from disk.
+ALIMER_API MipStream* alimerMipStreamCreateFromFile(const char* path, uint32_t tailLevelCount);
+ALIMER_API void alimerMipStreamDestroy(MipStream* stream);
+
+/// Header of the container, with the full mip chain.
+ALIMER_API void alimerMipStreamGetInfo(MipStream* stream, ImageInfo* info);
+/// The resident levels, owned by the stream: level 0 is container level alimerMipStreamGetResidentLevel.
+ALIMER_API Image* alimerMipStreamGetImage(MipStream* stream);
+ALIMER_API uint32_t alimerMipStreamGetResidentLevel(MipStream* stream);
+/// Read or drop levels so that mipLevel is the top resident one, level pointers are invalidated and failure keeps the current levels.
+ALIMER_API bool alimerMipStreamSetResidentLevel(MipStream* stream, uint32_t mipLevel);
+
 /* Font */
 ALIMER_API Font* alimerFontCreateFromMemory(const uint8_t* data, size_t size);
 ALIMER_API void alimerFontDestroy(Font* font);
@@ -258,5 +660,28 @@ ALIMER_API float alimerFontGetScale(Font* font, float size);
 ALIMER_API float alimerFontGetKerning(Font* font, int glyph1, int glyph2, float scale);
 ALIMER_API void alimerFontGetCharacter(Font* font, int glyph, float scale, int* width, int* height, float* advance, float* offsetX, float* offsetY, int* visible);
 ALIMER_API void alimerFontGetPixels(Font* font, uint8_t* dest, int glyph, int width, int height, float scale);
+/// Lay out UTF-8 text with kerning, line breaks, word wrap within maxWidth (0 for none) and alignment. quads must hold length entries.
+ALIMER_API bool alimerFontLayoutText(Font* font, const char* utf8, uint32_t length, float size, float maxWidth, FontTextAlign align, FontGlyphQuad* quads, uint32_t* quadCount);
+
+/// Rasterize the ranges at pixelSize into one skyline packed R8 atlas on worker threads, oversample 1-8. glyphs must hold the total count of the ranges.
+ALIMER_API Image* alimerFontBuildAtlas(Font* font, const FontCodepointRange* ranges, uint32_t rangeCount, float pixelSize, uint32_t padding, uint32_t oversampleX, uint32_t oversampleY, FontAtlasGlyph* glyphs, uint32_t* glyphCount);
+/// Same with SDF or MSDF texels encoding 0.5 + distance / (2 * spread), one atlas serves every size. spread is at most 64 pixels.
+ALIMER_API Image* alimerFontBuildDistanceFieldAtlas(Font* font, const FontCodepointRange* ranges, uint32_t rangeCount, float pixelSize, float spread, FontDistanceField type, FontAtlasGlyph* glyphs, uint32_t* glyphCount);
+
+/* Glyph cache */
+/// Rasterize glyphs on first use into LRU atlas pages. Not thread safe, the font must outlive the cache.
+ALIMER_API GlyphCache* alimerGlyphCacheCreate(Font* font, const GlyphCacheDesc* desc);
+ALIMER_API void alimerGlyphCacheDestroy(GlyphCache* cache);
+/// Look up a glyph at pixelSize and pen position penX, rasterizing it on a miss. False if it doesn't fit in a page this frame.
+ALIMER_API bool alimerGlyphCacheGetGlyph(GlyphCache* cache, uint32_t glyph, float pixelSize, float penX, CachedGlyph* result);
+/// Same for a run of glyphs (penX can be null for whole pixel positions), the misses are rasterized on worker threads.
+ALIMER_API bool alimerGlyphCacheGetGlyphs(GlyphCache* cache, const uint32_t* glyphs, const float* penX, uint32_t count, float pixelSize, CachedGlyph* results);
+ALIMER_API uint32_t alimerGlyphCacheGetPageCount(GlyphCache* cache);
+/// The page images are owned by the cache and keep the same handle for its whole lifetime.
+ALIMER_API Image* alimerGlyphCacheGetPage(GlyphCache* cache, uint32_t page);
+/// Regions of a page changed since the last alimerGlyphCacheEndFrame, returns the count (at most 8) and writes up to capacity of them.
+ALIMER_API uint32_t alimerGlyphCacheGetDirtyRects(GlyphCache* cache, uint32_t page, GlyphCacheRect* rects, uint32_t capacity);
+/// Clear the dirty rectangles and start a new frame. Glyphs returned earlier stay valid until their page is evicted, which never happens to a page used in the current frame.
+ALIMER_API void alimerGlyphCacheEndFrame(GlyphCache* cache);
 
 #endif /* _ALIMER_ASSETS_H */
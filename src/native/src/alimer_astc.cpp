@@ -0,0 +1,1753 @@
+// Copyright (c) Amer Koleci and Contributors.
+// Licensed under the MIT License (MIT). See LICENSE in the repository root for more information.
+
+#include "alimer_internal.h"
+#include <math.h>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define ALIMER_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   include <arm_neon.h>
+#   define ALIMER_NEON 1
+#endif
+
+// ASTC LDR 2D blocks (4x4 to 12x12). Blocks are 128-bit little endian bit streams: block mode, partitioning and
+// color endpoint mode at the bottom, integer sequence encoded endpoints after them and weights bit-reversed from the top.
+#define ALIMER_ASTC_MAX_TEXELS 144
+#define ALIMER_ASTC_MAX_WEIGHTS 64
+#define ALIMER_ASTC_BLOCK_SIZES 14
+// Candidate weight grids kept per block size, endpoint mode and partition count.
+#define ALIMER_ASTC_MAX_CANDIDATES 16
+
+namespace
+{
+    /* Integer sequence encoding */
+    struct QuantMode
+    {
+        uint8_t bits;
+        uint8_t trits;
+        uint8_t quints;
+    };
+
+    // Every range from 0..1 to 0..255, weights use the first 12.
+    const QuantMode kQuantModes[21] = {
+        { 1, 0, 0 }, { 0, 1, 0 }, { 2, 0, 0 }, { 0, 0, 1 }, { 1, 1, 0 }, { 3, 0, 0 }, { 1, 0, 1 },
+        { 2, 1, 0 }, { 4, 0, 0 }, { 2, 0, 1 }, { 3, 1, 0 }, { 5, 0, 0 }, { 3, 0, 1 }, { 4, 1, 0 },
+        { 6, 0, 0 }, { 4, 0, 1 }, { 5, 1, 0 }, { 7, 0, 0 }, { 5, 0, 1 }, { 6, 1, 0 }, { 8, 0, 0 },
+    };
+
+    const uint32_t kQuantLevels[21] = { 2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 32, 40, 48, 64, 80, 96, 128, 160, 192, 256 };
+
+    // Smallest range the decoder accepts for color endpoints (0..5).
+    const uint32_t kMinColorRange = 4;
+
+    uint32_t GetISEBitCount(uint32_t count, uint32_t range)
+    {
+        const QuantMode& mode = kQuantModes[range];
+        return count * mode.bits + (mode.trits ? (count * 8 + 4) / 5 : 0) + (mode.quints ? (count * 7 + 2) / 3 : 0);
+    }
+
+    inline uint32_t Bit(uint32_t value, uint32_t bit)
+    {
+        return (value >> bit) & 1;
+    }
+
+    void DecodeTrits(uint32_t packed, uint8_t* trits)
+    {
+        uint32_t c;
+        if (((packed >> 2) & 7) == 7)
+        {
+            c = (((packed >> 5) & 7) << 2) | (packed & 3);
+            trits[4] = 2;
+            trits[3] = 2;
+        }
+        else
+        {
+            c = packed & 0x1F;
+            if (((packed >> 5) & 3) == 3)
+            {
+                trits[4] = 2;
+                trits[3] = (uint8_t)Bit(packed, 7);
+            }
+            else
+            {
+                trits[4] = (uint8_t)Bit(packed, 7);
+                trits[3] = (uint8_t)((packed >> 5) & 3);
+            }
+        }
+
+        if ((c & 3) == 3)
+        {
+            trits[2] = 2;
+            trits[1] = (uint8_t)Bit(c, 4);
+            trits[0] = (uint8_t)((Bit(c, 3) << 1) | (Bit(c, 2) & ~Bit(c, 3) & 1));
+        }
+        else if (((c >> 2) & 3) == 3)
+        {
+            trits[2] = 2;
+            trits[1] = 2;
+            trits[0] = (uint8_t)(c & 3);
+        }
+        else
+        {
+            trits[2] = (uint8_t)Bit(c, 4);
+            trits[1] = (uint8_t)((c >> 2) & 3);
+            trits[0] = (uint8_t)((Bit(c, 1) << 1) | (Bit(c, 0) & ~Bit(c, 1) & 1));
+        }
+    }
+
+    void DecodeQuints(uint32_t packed, uint8_t* quints)
+    {
+        if (((packed >> 1) & 3) == 3 && ((packed >> 5) & 3) == 0)
+        {
+            quints[2] = (uint8_t)((Bit(packed, 0) << 2) | ((Bit(packed, 4) & ~Bit(packed, 0) & 1) << 1) | (Bit(packed, 3) & ~Bit(packed, 0) & 1));
+            quints[1] = 4;
+            quints[0] = 4;
+            return;
+        }
+
+        uint32_t c;
+        if (((packed >> 1) & 3) == 3)
+        {
+            quints[2] = 4;
+            c = (((packed >> 3) & 3) << 3) | ((~packed >> 5) & 3) << 1 | Bit(packed, 0);
+        }
+        else
+        {
+            quints[2] = (uint8_t)((packed >> 5) & 3);
+            c = packed & 0x1F;
+        }
+
+        if ((c & 7) == 5)
+        {
+            quints[1] = 4;
+            quints[0] = (uint8_t)((c >> 3) & 3);
+        }
+        else
+        {
+            quints[1] = (uint8_t)((c >> 3) & 3);
+            quints[0] = (uint8_t)(c & 7);
+        }
+    }
+
+    struct QuantTables
+    {
+        uint8_t tritDecode[256][5];
+        uint8_t quintDecode[128][3];
+        // Indexed by t0 + 3 t1 + 9 t2 + 27 t3 + 81 t4 (and q0 + 5 q1 + 25 q2).
+        uint8_t tritEncode[243];
+        uint8_t quintEncode[125];
+        // Weights unquantize to 0..64, color endpoints to 0..255.
+        uint8_t weightUnquantize[12][32];
+        uint8_t weightQuantize[12][65];
+        uint8_t colorUnquantize[21][256];
+        uint8_t colorQuantize[21][256];
+
+        QuantTables()
+        {
+            for (uint32_t packed = 256; packed-- > 0;)
+            {
+                DecodeTrits(packed, tritDecode[packed]);
+                const uint8_t* t = tritDecode[packed];
+                tritEncode[t[0] + 3 * t[1] + 9 * t[2] + 27 * t[3] + 81 * t[4]] = (uint8_t)packed;
+            }
+            for (uint32_t packed = 128; packed-- > 0;)
+            {
+                DecodeQuints(packed, quintDecode[packed]);
+                const uint8_t* q = quintDecode[packed];
+                quintEncode[q[0] + 5 * q[1] + 25 * q[2]] = (uint8_t)packed;
+            }
+
+            for (uint32_t range = 0; range < 12; ++range)
+            {
+                for (uint32_t symbol = 0; symbol < kQuantLevels[range]; ++symbol)
+                    weightUnquantize[range][symbol] = (uint8_t)UnquantizeWeight(range, symbol);
+                BuildNearest(weightUnquantize[range], kQuantLevels[range], 65, weightQuantize[range]);
+            }
+
+            for (uint32_t range = 0; range < 21; ++range)
+            {
+                for (uint32_t symbol = 0; symbol < kQuantLevels[range]; ++symbol)
+                    colorUnquantize[range][symbol] = (uint8_t)UnquantizeColor(range, symbol);
+                BuildNearest(colorUnquantize[range], kQuantLevels[range], 256, colorQuantize[range]);
+            }
+        }
+
+        static void BuildNearest(const uint8_t* values, uint32_t levels, uint32_t count, uint8_t* nearest)
+        {
+            for (uint32_t v = 0; v < count; ++v)
+            {
+                uint32_t best = 0;
+                int32_t bestDistance = 1 << 30;
+                for (uint32_t symbol = 0; symbol < levels; ++symbol)
+                {
+                    int32_t distance = (int32_t)values[symbol] - (int32_t)v;
+                    distance = distance < 0 ? -distance : distance;
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = symbol;
+                    }
+                }
+                nearest[v] = (uint8_t)best;
+            }
+        }
+
+        static uint32_t Replicate(uint32_t value, uint32_t bits, uint32_t targetBits)
+        {
+            uint32_t result = 0;
+            int32_t shift = (int32_t)targetBits - (int32_t)bits;
+            for (; shift > -(int32_t)bits; shift -= (int32_t)bits)
+                result |= shift >= 0 ? value << shift : value >> -shift;
+            return result & ((1u << targetBits) - 1);
+        }
+
+        static uint32_t UnquantizeWeight(uint32_t range, uint32_t symbol)
+        {
+            const QuantMode& mode = kQuantModes[range];
+            uint32_t result;
+            if (!mode.trits && !mode.quints)
+            {
+                result = Replicate(symbol, mode.bits, 6);
+            }
+            else if (mode.bits == 0)
+            {
+                // Already spread over 0..64.
+                return mode.trits ? symbol * 32 : symbol * 16;
+            }
+            else
+            {
+                const uint32_t d = symbol >> mode.bits;
+                const uint32_t m = symbol & ((1u << mode.bits) - 1);
+                const uint32_t a = Bit(m, 0) ? 0x7F : 0;
+                const uint32_t b = Bit(m, 1);
+                const uint32_t c = Bit(m, 2);
+                uint32_t scale = 0;
+                uint32_t offset = 0;
+                if (mode.trits)
+                {
+                    switch (mode.bits)
+                    {
+                        case 1: scale = 50; break;
+                        case 2: scale = 23; offset = (b << 6) | (b << 2) | b; break;
+                        default: scale = 11; offset = (c << 6) | (b << 5) | (c << 1) | b; break;
+                    }
+                }
+                else
+                {
+                    switch (mode.bits)
+                    {
+                        case 1: scale = 28; break;
+                        default: scale = 13; offset = (b << 6) | (b << 1); break;
+                    }
+                }
+
+                result = ((d * scale + offset) ^ a);
+                result = (a & 0x20) | (result >> 2);
+            }
+
+            return result > 32 ? result + 1 : result;
+        }
+
+        static uint32_t UnquantizeColor(uint32_t range, uint32_t symbol)
+        {
+            const QuantMode& mode = kQuantModes[range];
+            if (!mode.trits && !mode.quints)
+                return Replicate(symbol, mode.bits, 8);
+
+            const uint32_t d = symbol >> mode.bits;
+            const uint32_t m = symbol & ((1u << mode.bits) - 1);
+            const uint32_t a = Bit(m, 0) ? 0x1FF : 0;
+            const uint32_t b = Bit(m, 1), c = Bit(m, 2), e = Bit(m, 3), f = Bit(m, 4), g = Bit(m, 5);
+            uint32_t scale = 0;
+            uint32_t offset = 0;
+            if (mode.trits)
+            {
+                switch (mode.bits)
+                {
+                    case 1: scale = 204; break;
+                    case 2: scale = 93; offset = (b << 8) | (b << 4) | (b << 2) | (b << 1); break;
+                    case 3: scale = 44; offset = (c << 8) | (b << 7) | (c << 3) | (b << 2) | (c << 1) | b; break;
+                    case 4: scale = 22; offset = (e << 8) | (c << 7) | (b << 6) | (e << 2) | (c << 1) | b; break;
+                    case 5: scale = 11; offset = (f << 8) | (e << 7) | (c << 6) | (b << 5) | (f << 1) | e; break;
+                    default: scale = 5; offset = (g << 8) | (f << 7) | (e << 6) | (c << 5) | (b << 4) | g; break;
+                }
+            }
+            else
+            {
+                switch (mode.bits)
+                {
+                    case 1: scale = 113; break;
+                    case 2: scale = 54; offset = (b << 8) | (b << 3) | (b << 2); break;
+                    case 3: scale = 26; offset = (c << 8) | (b << 7) | (c << 2) | (b << 1) | c; break;
+                    case 4: scale = 13; offset = (e << 8) | (c << 7) | (b << 6) | (e << 1) | c; break;
+                    default: scale = 6; offset = (f << 8) | (e << 7) | (c << 6) | (b << 5) | f; break;
+                }
+            }
+
+            const uint32_t result = (d * scale + offset) ^ a;
+            return (a & 0x80) | (result >> 2);
+        }
+    };
+
+    const QuantTables& GetQuantTables()
+    {
+        static const QuantTables tables;
+        return tables;
+    }
+
+    inline uint32_t ReadBits(const uint8_t* data, uint32_t position, uint32_t count)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < count; ++i, ++position)
+            value |= (uint32_t)((data[position >> 3] >> (position & 7)) & 1) << i;
+        return value;
+    }
+
+    inline void WriteBits(uint8_t* data, uint32_t position, uint32_t count, uint32_t value)
+    {
+        for (uint32_t i = 0; i < count; ++i, ++position)
+        {
+            if ((value >> i) & 1)
+                data[position >> 3] |= (uint8_t)(1u << (position & 7));
+        }
+    }
+
+    // Trits pack five values in 8 bits and quints three values in 7 bits, interleaved with the low bits of each value.
+    const uint8_t kTritBits[5] = { 2, 2, 1, 2, 1 };
+    const uint8_t kQuintBits[3] = { 3, 2, 2 };
+
+    void WriteISE(uint8_t* data, uint32_t position, const uint8_t* values, uint32_t count, uint32_t range)
+    {
+        const QuantTables& tables = GetQuantTables();
+        const QuantMode& mode = kQuantModes[range];
+        const uint32_t mask = (1u << mode.bits) - 1;
+        const uint32_t groupSize = mode.trits ? 5 : (mode.quints ? 3 : 1);
+        for (uint32_t first = 0; first < count; first += groupSize)
+        {
+            const uint32_t groupCount = count - first < groupSize ? count - first : groupSize;
+            uint32_t packed = 0;
+            if (mode.trits || mode.quints)
+            {
+                uint32_t high[5] = {};
+                for (uint32_t i = 0; i < groupCount; ++i)
+                    high[i] = values[first + i] >> mode.bits;
+                packed = mode.trits
+                    ? tables.tritEncode[high[0] + 3 * high[1] + 9 * high[2] + 27 * high[3] + 81 * high[4]]
+                    : tables.quintEncode[high[0] + 5 * high[1] + 25 * high[2]];
+            }
+
+            for (uint32_t i = 0; i < groupCount; ++i)
+            {
+                WriteBits(data, position, mode.bits, values[first + i] & mask);
+                position += mode.bits;
+                if (mode.trits || mode.quints)
+                {
+                    const uint32_t bits = mode.trits ? kTritBits[i] : kQuintBits[i];
+                    WriteBits(data, position, bits, packed);
+                    packed >>= bits;
+                    position += bits;
+                }
+            }
+        }
+    }
+
+    void ReadISE(const uint8_t* data, uint32_t position, uint8_t* values, uint32_t count, uint32_t range)
+    {
+        const QuantTables& tables = GetQuantTables();
+        const QuantMode& mode = kQuantModes[range];
+        const uint32_t groupSize = mode.trits ? 5 : (mode.quints ? 3 : 1);
+        for (uint32_t first = 0; first < count; first += groupSize)
+        {
+            const uint32_t groupCount = count - first < groupSize ? count - first : groupSize;
+            uint32_t low[5] = {};
+            uint32_t packed = 0;
+            uint32_t packedShift = 0;
+            for (uint32_t i = 0; i < groupCount; ++i)
+            {
+                low[i] = ReadBits(data, position, mode.bits);
+                position += mode.bits;
+                if (mode.trits || mode.quints)
+                {
+                    const uint32_t bits = mode.trits ? kTritBits[i] : kQuintBits[i];
+                    packed |= ReadBits(data, position, bits) << packedShift;
+                    packedShift += bits;
+                    position += bits;
+                }
+            }
+
+            for (uint32_t i = 0; i < groupCount; ++i)
+            {
+                uint32_t high = 0;
+                if (mode.trits)
+                    high = tables.tritDecode[packed][i];
+                else if (mode.quints)
+                    high = tables.quintDecode[packed][i];
+                values[first + i] = (uint8_t)((high << mode.bits) | low[i]);
+            }
+        }
+    }
+
+
+    /* Block modes */
+    struct BlockMode
+    {
+        uint8_t gridWidth;
+        uint8_t gridHeight;
+        uint8_t weightRange;
+        bool dualPlane;
+    };
+
+    bool DecodeBlockMode(uint32_t mode, BlockMode* result)
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t range;
+        uint32_t high = Bit(mode, 9);
+        uint32_t dual = Bit(mode, 10);
+        const uint32_t a = (mode >> 5) & 3;
+        if (mode & 3)
+        {
+            range = ((mode & 3) << 1) | Bit(mode, 4);
+            const uint32_t b = (mode >> 7) & 3;
+            switch ((mode >> 2) & 3)
+            {
+                case 0: width = b + 4; height = a + 2; break;
+                case 1: width = b + 8; height = a + 2; break;
+                case 2: width = a + 2; height = b + 8; break;
+                default:
+                    if (mode & 0x100)
+                    {
+                        width = (b & 1) + 2;
+                        height = a + 2;
+                    }
+                    else
+                    {
+                        width = a + 2;
+                        height = (b & 1) + 6;
+                    }
+                    break;
+            }
+        }
+        else
+        {
+            range = ((mode >> 1) & 6) | Bit(mode, 4);
+            switch ((mode >> 7) & 3)
+            {
+                case 0: width = 12; height = a + 2; break;
+                case 1: width = a + 2; height = 12; break;
+                case 2:
+                    width = a + 6;
+                    height = ((mode >> 9) & 3) + 6;
+                    high = 0;
+                    dual = 0;
+                    break;
+                default:
+                    if (a > 1)
+                        return false;
+                    width = a ? 10 : 6;
+                    height = a ? 6 : 10;
+                    break;
+            }
+        }
+
+        if (range < 2)
+            return false;
+
+        const uint32_t weightRange = range - 2 + (high ? 6 : 0);
+        const uint32_t weightCount = width * height * (dual + 1);
+        const uint32_t weightBits = GetISEBitCount(weightCount, weightRange);
+        if (weightCount > ALIMER_ASTC_MAX_WEIGHTS || weightBits < 24 || weightBits > 96)
+            return false;
+
+        result->gridWidth = (uint8_t)width;
+        result->gridHeight = (uint8_t)height;
+        result->weightRange = (uint8_t)weightRange;
+        result->dualPlane = dual != 0;
+        return true;
+    }
+
+    /* Partitioning */
+    uint32_t HashPartition(uint32_t seed)
+    {
+        seed ^= seed >> 15;
+        seed -= seed << 17;
+        seed += seed << 7;
+        seed += seed << 4;
+        seed ^= seed >> 5;
+        seed += seed << 16;
+        seed ^= seed >> 7;
+        seed ^= seed >> 3;
+        seed ^= seed << 6;
+        seed ^= seed >> 17;
+        return seed;
+    }
+
+    uint32_t SelectPartition(uint32_t seed, uint32_t x, uint32_t y, uint32_t partitionCount, bool smallBlock)
+    {
+        if (smallBlock)
+        {
+            x <<= 1;
+            y <<= 1;
+        }
+
+        seed += (partitionCount - 1) * 1024;
+        const uint32_t random = HashPartition(seed);
+        uint32_t seeds[8];
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            seeds[i] = (random >> (i * 4)) & 0xF;
+            seeds[i] *= seeds[i];
+        }
+
+        uint32_t shift1;
+        uint32_t shift2;
+        if (seed & 1)
+        {
+            shift1 = (seed & 2) ? 4 : 5;
+            shift2 = partitionCount == 3 ? 6 : 5;
+        }
+        else
+        {
+            shift1 = partitionCount == 3 ? 6 : 5;
+            shift2 = (seed & 2) ? 4 : 5;
+        }
+
+        for (uint32_t i = 0; i < 8; i += 2)
+        {
+            seeds[i] >>= shift1;
+            seeds[i + 1] >>= shift2;
+        }
+
+        // 2D blocks, the z terms of the hash vanish.
+        const uint32_t a = (seeds[0] * x + seeds[1] * y + (random >> 14)) & 0x3F;
+        const uint32_t b = (seeds[2] * x + seeds[3] * y + (random >> 10)) & 0x3F;
+        const uint32_t c = partitionCount < 3 ? 0 : (seeds[4] * x + seeds[5] * y + (random >> 6)) & 0x3F;
+        const uint32_t d = partitionCount < 4 ? 0 : (seeds[6] * x + seeds[7] * y + (random >> 2)) & 0x3F;
+        if (a >= b && a >= c && a >= d)
+            return 0;
+        if (b >= c && b >= d)
+            return 1;
+        if (c >= d)
+            return 2;
+        return 3;
+    }
+
+    /* Weight grid */
+    struct InfillTexel
+    {
+        uint8_t index[4];
+        uint8_t weight[4];
+    };
+
+    // Bilinear contribution of the weight grid points to every texel, the weights of a texel add up to 16.
+    void ComputeInfill(uint32_t blockWidth, uint32_t blockHeight, uint32_t gridWidth, uint32_t gridHeight, InfillTexel* texels)
+    {
+        const uint32_t ds = (1024 + blockWidth / 2) / (blockWidth - 1);
+        const uint32_t dt = (1024 + blockHeight / 2) / (blockHeight - 1);
+        const uint32_t last = gridWidth * gridHeight - 1;
+        for (uint32_t t = 0; t < blockHeight; ++t)
+        {
+            for (uint32_t s = 0; s < blockWidth; ++s)
+            {
+                const uint32_t gs = (ds * s * (gridWidth - 1) + 32) >> 6;
+                const uint32_t gt = (dt * t * (gridHeight - 1) + 32) >> 6;
+                const uint32_t fs = gs & 15;
+                const uint32_t ft = gt & 15;
+                const uint32_t v0 = (gs >> 4) + (gt >> 4) * gridWidth;
+                const uint32_t w11 = (fs * ft + 8) >> 4;
+
+                InfillTexel& texel = texels[t * blockWidth + s];
+                const uint32_t indices[4] = { v0, v0 + 1, v0 + gridWidth, v0 + gridWidth + 1 };
+                texel.weight[0] = (uint8_t)(16 - fs - ft + w11);
+                texel.weight[1] = (uint8_t)(fs - w11);
+                texel.weight[2] = (uint8_t)(ft - w11);
+                texel.weight[3] = (uint8_t)w11;
+                for (uint32_t i = 0; i < 4; ++i)
+                    texel.index[i] = (uint8_t)(indices[i] > last ? last : indices[i]);
+            }
+        }
+    }
+
+    /* Endpoints */
+    void BitTransferSigned(int32_t& a, int32_t& b)
+    {
+        b >>= 1;
+        b |= a & 0x80;
+        a >>= 1;
+        a &= 0x3F;
+        if (a & 0x20)
+            a -= 0x40;
+    }
+
+    inline int32_t Clamp255(int32_t value)
+    {
+        return value < 0 ? 0 : (value > 255 ? 255 : value);
+    }
+
+    void BlueContract(int32_t* color)
+    {
+        color[0] = (color[0] + color[2]) >> 1;
+        color[1] = (color[1] + color[2]) >> 1;
+    }
+
+    // LDR endpoint modes, false for the HDR ones.
+    bool DecodeEndpoints(uint32_t mode, const uint8_t* v, int32_t e0[4], int32_t e1[4])
+    {
+        int32_t values[8];
+        for (uint32_t i = 0; i < 8; ++i)
+            values[i] = i < ((mode >> 2) + 1) * 2 ? v[i] : 0;
+
+        switch (mode)
+        {
+            case 0:
+                e0[0] = e0[1] = e0[2] = values[0];
+                e1[0] = e1[1] = e1[2] = values[1];
+                e0[3] = e1[3] = 255;
+                return true;
+            case 1:
+            {
+                const int32_t l0 = (values[0] >> 2) | (values[1] & 0xC0);
+                const int32_t l1 = l0 + (values[1] & 0x3F) > 255 ? 255 : l0 + (values[1] & 0x3F);
+                e0[0] = e0[1] = e0[2] = l0;
+                e1[0] = e1[1] = e1[2] = l1;
+                e0[3] = e1[3] = 255;
+                return true;
+            }
+            case 4:
+                e0[0] = e0[1] = e0[2] = values[0];
+                e1[0] = e1[1] = e1[2] = values[1];
+                e0[3] = values[2];
+                e1[3] = values[3];
+                return true;
+            case 5:
+                BitTransferSigned(values[1], values[0]);
+                BitTransferSigned(values[3], values[2]);
+                e0[0] = e0[1] = e0[2] = values[0];
+                e1[0] = e1[1] = e1[2] = Clamp255(values[0] + values[1]);
+                e0[3] = values[2];
+                e1[3] = Clamp255(values[2] + values[3]);
+                return true;
+            case 6:
+            case 10:
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    e0[c] = (values[c] * values[3]) >> 8;
+                    e1[c] = values[c];
+                }
+                e0[3] = mode == 10 ? values[4] : 255;
+                e1[3] = mode == 10 ? values[5] : 255;
+                return true;
+            case 8:
+            case 12:
+            {
+                const int32_t alpha0 = mode == 12 ? values[6] : 255;
+                const int32_t alpha1 = mode == 12 ? values[7] : 255;
+                if (values[1] + values[3] + values[5] >= values[0] + values[2] + values[4])
+                {
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        e0[c] = values[c * 2];
+                        e1[c] = values[c * 2 + 1];
+                    }
+                    e0[3] = alpha0;
+                    e1[3] = alpha1;
+                }
+                else
+                {
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        e0[c] = values[c * 2 + 1];
+                        e1[c] = values[c * 2];
+                    }
+                    e0[3] = alpha1;
+                    e1[3] = alpha0;
+                    BlueContract(e0);
+                    BlueContract(e1);
+                }
+                return true;
+            }
+            case 9:
+            case 13:
+            {
+                for (uint32_t i = 0; i < 8; i += 2)
+                    BitTransferSigned(values[i + 1], values[i]);
+
+                int32_t base[4] = { values[0], values[2], values[4], mode == 13 ? values[6] : 255 };
+                int32_t offset[4] = { values[0] + values[1], values[2] + values[3], values[4] + values[5], mode == 13 ? values[6] + values[7] : 255 };
+                if (values[1] + values[3] + values[5] >= 0)
+                {
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        e0[c] = base[c];
+                        e1[c] = Clamp255(offset[c]);
+                    }
+                }
+                else
+                {
+                    BlueContract(offset);
+                    BlueContract(base);
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        e0[c] = Clamp255(offset[c]);
+                        e1[c] = Clamp255(base[c]);
+                    }
+                }
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    // Top byte of the 16-bit interpolation, sRGB endpoints are expanded with 0x80 instead of replicating the byte.
+    inline uint8_t InterpolateTexel(int32_t e0, int32_t e1, int32_t weight, bool srgb)
+    {
+        const int32_t c0 = srgb ? (e0 << 8) | 0x80 : e0 * 257;
+        const int32_t c1 = srgb ? (e1 << 8) | 0x80 : e1 * 257;
+        return (uint8_t)(((c0 * (64 - weight) + c1 * weight + 32) >> 6) >> 8);
+    }
+
+    /* Encoding */
+    const uint8_t kBlockSizes[ALIMER_ASTC_BLOCK_SIZES][2] = {
+        { 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+        { 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 },
+    };
+
+    struct Candidate
+    {
+        uint16_t mode;
+        uint8_t gridWidth;
+        uint8_t gridHeight;
+        uint8_t weightRange;
+        uint8_t colorRange;
+    };
+
+    struct CandidateList
+    {
+        uint32_t count;
+        Candidate candidates[ALIMER_ASTC_MAX_CANDIDATES];
+    };
+
+    struct BlockSizeTables
+    {
+        // [partitions - 1][endpoint pairs per partition - 1][dual plane]
+        CandidateList candidates[2][4][2];
+        // Bit i set when texel i is in the second partition of a 2-partition seed.
+        uint64_t partitionMasks[1024][3];
+        bool partitionValid[1024];
+    };
+
+    // Expected squared error of a grid for a block spread of about 64 levels: weight steps, endpoint steps and lost resolution.
+    float ScoreCandidate(uint32_t blockWidth, uint32_t blockHeight, const Candidate& candidate, uint32_t channels)
+    {
+        const float weightSteps = (float)(kQuantLevels[candidate.weightRange] - 1);
+        const float colorLevels = (float)kQuantLevels[candidate.colorRange];
+        const float coverage = (float)(candidate.gridWidth * candidate.gridHeight) / (float)(blockWidth * blockHeight);
+        return 341.0f / (weightSteps * weightSteps) + 2730.0f * channels / (colorLevels * colorLevels) + 410.0f * (1.0f - coverage);
+    }
+
+    void BuildBlockSizeTables(uint32_t blockWidth, uint32_t blockHeight, BlockSizeTables* tables)
+    {
+        for (uint32_t partitions = 1; partitions <= 2; ++partitions)
+        {
+            for (uint32_t pairs = 1; pairs <= 4; ++pairs)
+            {
+                for (uint32_t dual = 0; dual < 2; ++dual)
+                {
+                    CandidateList& list = tables->candidates[partitions - 1][pairs - 1][dual];
+                    float scores[ALIMER_ASTC_MAX_CANDIDATES];
+                    list.count = 0;
+                    for (uint32_t mode = 0; mode < 2048; ++mode)
+                    {
+                        BlockMode blockMode;
+                        if ((mode & 0x1FF) == 0x1FC || !DecodeBlockMode(mode, &blockMode) || blockMode.dualPlane != (dual != 0) ||
+                            blockMode.gridWidth > blockWidth || blockMode.gridHeight > blockHeight)
+                        {
+                            continue;
+                        }
+
+                        const uint32_t weightCount = blockMode.gridWidth * blockMode.gridHeight * (dual + 1);
+                        const int32_t colorBits = 128 - (partitions == 1 ? 17 : 29) - (int32_t)(dual * 2) - (int32_t)GetISEBitCount(weightCount, blockMode.weightRange);
+                        const uint32_t colorCount = pairs * 2 * partitions;
+                        uint32_t colorRange = 20;
+                        while (colorRange >= kMinColorRange && colorBits >= 0 && GetISEBitCount(colorCount, colorRange) > (uint32_t)colorBits)
+                            colorRange--;
+                        if (colorBits < 0 || colorRange < kMinColorRange)
+                            continue;
+
+                        Candidate candidate;
+                        candidate.mode = (uint16_t)mode;
+                        candidate.gridWidth = blockMode.gridWidth;
+                        candidate.gridHeight = blockMode.gridHeight;
+                        candidate.weightRange = blockMode.weightRange;
+                        candidate.colorRange = (uint8_t)colorRange;
+
+                        bool duplicate = false;
+                        for (uint32_t i = 0; i < list.count && !duplicate; ++i)
+                        {
+                            const Candidate& other = list.candidates[i];
+                            duplicate = other.gridWidth == candidate.gridWidth && other.gridHeight == candidate.gridHeight && other.weightRange == candidate.weightRange;
+                        }
+                        if (duplicate)
+                            continue;
+
+                        // Insertion into the sorted list of the best candidates.
+                        const float score = ScoreCandidate(blockWidth, blockHeight, candidate, pairs);
+                        uint32_t position = list.count;
+                        while (position > 0 && scores[position - 1] > score)
+                            position--;
+                        if (position >= ALIMER_ASTC_MAX_CANDIDATES)
+                            continue;
+
+                        const uint32_t last = list.count < ALIMER_ASTC_MAX_CANDIDATES ? list.count : ALIMER_ASTC_MAX_CANDIDATES - 1;
+                        for (uint32_t i = last; i > position; --i)
+                        {
+                            list.candidates[i] = list.candidates[i - 1];
+                            scores[i] = scores[i - 1];
+                        }
+                        list.candidates[position] = candidate;
+                        scores[position] = score;
+                        if (list.count < ALIMER_ASTC_MAX_CANDIDATES)
+                            list.count++;
+                    }
+                }
+            }
+        }
+
+        const bool smallBlock = blockWidth * blockHeight < 31;
+        for (uint32_t seed = 0; seed < 1024; ++seed)
+        {
+            uint64_t* mask = tables->partitionMasks[seed];
+            mask[0] = mask[1] = mask[2] = 0;
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < blockWidth * blockHeight; ++i)
+            {
+                if (SelectPartition(seed, i % blockWidth, i / blockWidth, 2, smallBlock))
+                {
+                    mask[i >> 6] |= (uint64_t)1 << (i & 63);
+                    count++;
+                }
+            }
+            tables->partitionValid[seed] = count > 0 && count < blockWidth * blockHeight;
+        }
+    }
+
+    const BlockSizeTables* GetBlockSizeTables(uint32_t blockWidth, uint32_t blockHeight)
+    {
+        static BlockSizeTables s_tables[ALIMER_ASTC_BLOCK_SIZES];
+        static std::once_flag s_once[ALIMER_ASTC_BLOCK_SIZES];
+        for (uint32_t i = 0; i < ALIMER_ASTC_BLOCK_SIZES; ++i)
+        {
+            if (kBlockSizes[i][0] == blockWidth && kBlockSizes[i][1] == blockHeight)
+            {
+                std::call_once(s_once[i], BuildBlockSizeTables, blockWidth, blockHeight, &s_tables[i]);
+                return &s_tables[i];
+            }
+        }
+        return nullptr;
+    }
+
+    struct Texels
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t count;
+        bool srgb;
+        uint8_t pixels[ALIMER_ASTC_MAX_TEXELS][4];
+    };
+
+    struct Partitioning
+    {
+        uint32_t count;
+        uint32_t seed;
+        uint8_t assignment[ALIMER_ASTC_MAX_TEXELS];
+    };
+
+    // Endpoint mode with the channels it stores: luminance modes for gray blocks, alpha modes when any texel is translucent.
+    struct EndpointMode
+    {
+        uint32_t mode;
+        uint32_t pairs;
+        // Channels fitted on the first plane.
+        uint32_t channelMask;
+    };
+
+    // Principal axis of the texels of a partition through power iteration, endpoints are the extreme projections.
+    void FitLine(const Texels& texels, const Partitioning& partitioning, uint32_t partition, uint32_t channelMask, float endpoints[2][4])
+    {
+        float mean[4] = {};
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < texels.count; ++i)
+        {
+            if (partitioning.assignment[i] != partition)
+                continue;
+            for (uint32_t c = 0; c < 4; ++c)
+                mean[c] += texels.pixels[i][c];
+            count++;
+        }
+
+        for (uint32_t c = 0; c < 4; ++c)
+            mean[c] = count ? mean[c] / (float)count : 0.0f;
+
+        float covariance[4][4] = {};
+        float minValue[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+        float maxValue[4] = {};
+        for (uint32_t i = 0; i < texels.count; ++i)
+        {
+            if (partitioning.assignment[i] != partition)
+                continue;
+
+            float diff[4];
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const float value = texels.pixels[i][c];
+                diff[c] = (channelMask & (1u << c)) ? value - mean[c] : 0.0f;
+                minValue[c] = value < minValue[c] ? value : minValue[c];
+                maxValue[c] = value > maxValue[c] ? value : maxValue[c];
+            }
+            for (uint32_t a = 0; a < 4; ++a)
+                for (uint32_t b = 0; b < 4; ++b)
+                    covariance[a][b] += diff[a] * diff[b];
+        }
+
+        float axis[4];
+        for (uint32_t c = 0; c < 4; ++c)
+            axis[c] = (channelMask & (1u << c)) ? maxValue[c] - minValue[c] : 0.0f;
+
+        for (uint32_t iteration = 0; iteration < 6; ++iteration)
+        {
+            float next[4] = {};
+            float length = 0.0f;
+            for (uint32_t a = 0; a < 4; ++a)
+            {
+                for (uint32_t b = 0; b < 4; ++b)
+                    next[a] += covariance[a][b] * axis[b];
+                length = fabsf(next[a]) > length ? fabsf(next[a]) : length;
+            }
+            if (length < 1e-6f)
+                break;
+            for (uint32_t c = 0; c < 4; ++c)
+                axis[c] = next[c] / length;
+        }
+
+        float axisLength = 0.0f;
+        for (uint32_t c = 0; c < 4; ++c)
+            axisLength += axis[c] * axis[c];
+
+        float minT = 0.0f;
+        float maxT = 0.0f;
+        if (axisLength > 0.0f)
+        {
+            minT = 1e30f;
+            maxT = -1e30f;
+            for (uint32_t i = 0; i < texels.count; ++i)
+            {
+                if (partitioning.assignment[i] != partition)
+                    continue;
+
+                float t = 0.0f;
+                for (uint32_t c = 0; c < 4; ++c)
+                    t += (texels.pixels[i][c] - mean[c]) * axis[c];
+                t /= axisLength;
+                minT = t < minT ? t : minT;
+                maxT = t > maxT ? t : maxT;
+            }
+        }
+
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] = mean[c] + minT * axis[c];
+            endpoints[1][c] = mean[c] + maxT * axis[c];
+        }
+    }
+
+    // Position of each texel of the plane channels along its partition endpoints, 0..1.
+    void ComputeIdealWeights(const Texels& texels, const Partitioning& partitioning, const float endpoints[4][2][4], uint32_t channelMask, float* weights)
+    {
+        for (uint32_t i = 0; i < texels.count; ++i)
+        {
+            const float (*e)[4] = endpoints[partitioning.assignment[i]];
+            float dot = 0.0f;
+            float length = 0.0f;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                if (!(channelMask & (1u << c)))
+                    continue;
+                const float direction = e[1][c] - e[0][c];
+                dot += (texels.pixels[i][c] - e[0][c]) * direction;
+                length += direction * direction;
+            }
+
+            const float t = length > 0.0f ? dot / length : 0.0f;
+            weights[i] = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        }
+    }
+
+    // Grid weights whose bilinear infill best matches the texel weights: the transpose of the infill, then a few correction passes.
+    void DecimateWeights(const Texels& texels, const InfillTexel* infill, uint32_t gridCount, const float* ideal, uint32_t iterations, float* grid)
+    {
+        float total[ALIMER_ASTC_MAX_WEIGHTS] = {};
+        float sum[ALIMER_ASTC_MAX_WEIGHTS] = {};
+        for (uint32_t i = 0; i < texels.count; ++i)
+        {
+            for (uint32_t k = 0; k < 4; ++k)
+            {
+                const float weight = infill[i].weight[k];
+                total[infill[i].index[k]] += weight;
+                sum[infill[i].index[k]] += weight * ideal[i];
+            }
+        }
+
+        for (uint32_t g = 0; g < gridCount; ++g)
+            grid[g] = total[g] > 0.0f ? sum[g] / total[g] : 0.5f;
+
+        for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+        {
+            float correction[ALIMER_ASTC_MAX_WEIGHTS] = {};
+            for (uint32_t i = 0; i < texels.count; ++i)
+            {
+                float value = 0.0f;
+                for (uint32_t k = 0; k < 4; ++k)
+                    value += grid[infill[i].index[k]] * infill[i].weight[k];
+                const float error = ideal[i] - value * (1.0f / 16.0f);
+                for (uint32_t k = 0; k < 4; ++k)
+                    correction[infill[i].index[k]] += error * infill[i].weight[k];
+            }
+
+            for (uint32_t g = 0; g < gridCount; ++g)
+            {
+                const float value = total[g] > 0.0f ? grid[g] + correction[g] / total[g] : grid[g];
+                grid[g] = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+            }
+        }
+    }
+
+    // Least squares endpoints of every partition channel for the decoded texel weights.
+    void RefineEndpoints(const Texels& texels, const Partitioning& partitioning, const int32_t* const weights[2], uint32_t planeChannel, float endpoints[4][2][4])
+    {
+        for (uint32_t p = 0; p < partitioning.count; ++p)
+        {
+            for (uint32_t plane = 0; plane < (planeChannel < 4 ? 2u : 1u); ++plane)
+            {
+                float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+                float ax[4] = {};
+                float bx[4] = {};
+                for (uint32_t i = 0; i < texels.count; ++i)
+                {
+                    if (partitioning.assignment[i] != p)
+                        continue;
+
+                    const float t = weights[plane][i] * (1.0f / 64.0f);
+                    const float s = 1.0f - t;
+                    aa += s * s;
+                    ab += s * t;
+                    bb += t * t;
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        ax[c] += s * texels.pixels[i][c];
+                        bx[c] += t * texels.pixels[i][c];
+                    }
+                }
+
+                const float determinant = aa * bb - ab * ab;
+                if (fabsf(determinant) < 1e-3f)
+                    continue;
+
+                const float inverse = 1.0f / determinant;
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    if ((c == planeChannel) != (plane == 1))
+                        continue;
+                    endpoints[p][0][c] = (ax[c] * bb - bx[c] * ab) * inverse;
+                    endpoints[p][1][c] = (bx[c] * aa - ax[c] * ab) * inverse;
+                }
+            }
+        }
+    }
+
+    struct Encoding
+    {
+        uint32_t mode;
+        uint32_t endpointMode;
+        uint32_t colorCount;
+        uint32_t colorRange;
+        uint32_t weightCount;
+        uint32_t weightRange;
+        uint32_t planeChannel;
+        uint8_t colors[18];
+        uint8_t weights[ALIMER_ASTC_MAX_WEIGHTS];
+    };
+
+    void WriteBlock(const Partitioning& partitioning, const Encoding& encoding, uint8_t* block)
+    {
+        memset(block, 0, 16);
+        WriteBits(block, 0, 11, encoding.mode);
+        WriteBits(block, 11, 2, partitioning.count - 1);
+        uint32_t colorStart = 17;
+        if (partitioning.count == 1)
+        {
+            WriteBits(block, 13, 4, encoding.endpointMode);
+        }
+        else
+        {
+            // Every partition shares the endpoint mode.
+            WriteBits(block, 13, 10, partitioning.seed);
+            WriteBits(block, 23, 6, encoding.endpointMode << 2);
+            colorStart = 29;
+        }
+
+        WriteISE(block, colorStart, encoding.colors, encoding.colorCount, encoding.colorRange);
+
+        uint8_t weights[16] = {};
+        WriteISE(weights, 0, encoding.weights, encoding.weightCount, encoding.weightRange);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint8_t value = weights[i];
+            value = (uint8_t)(((value * 0x0802u & 0x22110u) | (value * 0x8020u & 0x88440u)) * 0x10101u >> 16);
+            block[15 - i] |= value;
+        }
+
+        if (encoding.planeChannel < 4)
+            WriteBits(block, 128 - GetISEBitCount(encoding.weightCount, encoding.weightRange) - 2, 2, encoding.planeChannel);
+    }
+
+    // The RGB direct modes blue contract endpoints stored with a larger first sum, keep the brighter endpoint second.
+    void OrientEndpoints(const EndpointMode& mode, float endpoints[2][4])
+    {
+        if ((mode.mode != 8 && mode.mode != 12) ||
+            endpoints[1][0] + endpoints[1][1] + endpoints[1][2] >= endpoints[0][0] + endpoints[0][1] + endpoints[0][2])
+        {
+            return;
+        }
+
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            const float swap = endpoints[0][c];
+            endpoints[0][c] = endpoints[1][c];
+            endpoints[1][c] = swap;
+        }
+    }
+
+    // Quantized endpoints of the mode, rounding can still flip the order of nearly equal sums: the second endpoint is then raised.
+    void QuantizeEndpoints(const EndpointMode& mode, const float endpoints[2][4], uint32_t range, uint8_t* colors)
+    {
+        const QuantTables& tables = GetQuantTables();
+        const uint8_t* quantize = tables.colorQuantize[range];
+        const uint8_t* unquantize = tables.colorUnquantize[range];
+        const uint32_t channelCount = mode.pairs;
+        for (uint32_t i = 0; i < channelCount; ++i)
+        {
+            // Luminance modes store the red channel, alpha is always the last pair.
+            const uint32_t channel = (i == channelCount - 1 && (mode.mode == 4 || mode.mode == 12)) ? 3 : i;
+            for (uint32_t e = 0; e < 2; ++e)
+                colors[i * 2 + e] = quantize[Clamp255((int32_t)(endpoints[e][channel] + 0.5f))];
+        }
+
+        if (mode.mode != 8 && mode.mode != 12)
+            return;
+
+        uint32_t sum0 = unquantize[colors[0]] + unquantize[colors[2]] + unquantize[colors[4]];
+        uint32_t sum1 = unquantize[colors[1]] + unquantize[colors[3]] + unquantize[colors[5]];
+        while (sum1 < sum0)
+        {
+            uint32_t channel = 0;
+            for (uint32_t c = 1; c < 3; ++c)
+            {
+                if (unquantize[colors[c * 2 + 1]] < unquantize[colors[channel * 2 + 1]])
+                    channel = c;
+            }
+
+            uint8_t& color = colors[channel * 2 + 1];
+            const uint32_t value = unquantize[color];
+            for (uint32_t next = value + 1; next < 256 && unquantize[color] == value; ++next)
+                color = quantize[next];
+            sum1 += unquantize[color] - value;
+        }
+    }
+
+    // Encode the block with one partitioning, endpoint mode and weight grid, returns the measured error.
+    uint32_t EncodeCandidate(const Texels& texels, const Partitioning& partitioning, const EndpointMode& mode, const Candidate& candidate,
+        uint32_t planeChannel, ImageCompressQuality quality, uint8_t* block)
+    {
+        const QuantTables& tables = GetQuantTables();
+        const uint32_t planeCount = planeChannel < 4 ? 2 : 1;
+        const uint32_t gridCount = candidate.gridWidth * candidate.gridHeight;
+        const uint32_t planeMasks[2] = { mode.channelMask & ~(planeChannel < 4 ? 1u << planeChannel : 0u), planeChannel < 4 ? 1u << planeChannel : 0u };
+
+        InfillTexel infill[ALIMER_ASTC_MAX_TEXELS];
+        ComputeInfill(texels.width, texels.height, candidate.gridWidth, candidate.gridHeight, infill);
+
+        float endpoints[4][2][4];
+        for (uint32_t p = 0; p < partitioning.count; ++p)
+        {
+            FitLine(texels, partitioning, p, planeMasks[0], endpoints[p]);
+            if (planeCount == 2)
+            {
+                float separate[2][4];
+                FitLine(texels, partitioning, p, planeMasks[1], separate);
+                endpoints[p][0][planeChannel] = separate[0][planeChannel];
+                endpoints[p][1][planeChannel] = separate[1][planeChannel];
+            }
+            OrientEndpoints(mode, endpoints[p]);
+        }
+
+        Encoding encoding;
+        encoding.mode = candidate.mode;
+        encoding.endpointMode = mode.mode;
+        encoding.colorCount = mode.pairs * 2 * partitioning.count;
+        encoding.colorRange = candidate.colorRange;
+        encoding.weightCount = gridCount * planeCount;
+        encoding.weightRange = candidate.weightRange;
+        encoding.planeChannel = planeChannel;
+
+        const uint32_t levels = kQuantLevels[candidate.weightRange];
+        const uint8_t* weightUnquantize = tables.weightUnquantize[candidate.weightRange];
+        const uint32_t passes = quality == ImageCompressQuality_Fast ? 1 : (quality == ImageCompressQuality_Normal ? 2 : 3);
+        const uint32_t decimationIterations = gridCount == texels.count ? 0 : (quality == ImageCompressQuality_Fast ? 1 : 3);
+
+        uint32_t bestError = UINT32_MAX;
+        for (uint32_t pass = 0; pass < passes; ++pass)
+        {
+            int32_t texelWeights[2][ALIMER_ASTC_MAX_TEXELS];
+            for (uint32_t plane = 0; plane < planeCount; ++plane)
+            {
+                float ideal[ALIMER_ASTC_MAX_TEXELS];
+                float grid[ALIMER_ASTC_MAX_WEIGHTS];
+                ComputeIdealWeights(texels, partitioning, endpoints, planeMasks[plane], ideal);
+                DecimateWeights(texels, infill, gridCount, ideal, decimationIterations, grid);
+                for (uint32_t g = 0; g < gridCount; ++g)
+                    encoding.weights[g * planeCount + plane] = tables.weightQuantize[candidate.weightRange][(int32_t)(grid[g] * 64.0f + 0.5f)];
+
+                for (uint32_t i = 0; i < texels.count; ++i)
+                {
+                    uint32_t sum = 0;
+                    for (uint32_t k = 0; k < 4; ++k)
+                        sum += weightUnquantize[encoding.weights[infill[i].index[k] * planeCount + plane]] * infill[i].weight[k];
+                    texelWeights[plane][i] = (int32_t)((sum + 8) >> 4);
+                }
+            }
+
+            const int32_t* weightPlanes[2] = { texelWeights[0], texelWeights[1] };
+            RefineEndpoints(texels, partitioning, weightPlanes, planeChannel, endpoints);
+
+            for (uint32_t p = 0; p < partitioning.count; ++p)
+                QuantizeEndpoints(mode, endpoints[p], candidate.colorRange, encoding.colors + p * mode.pairs * 2);
+
+            int32_t decoded[4][2][4];
+            for (uint32_t p = 0; p < partitioning.count; ++p)
+            {
+                uint8_t unquantized[8];
+                for (uint32_t i = 0; i < mode.pairs * 2; ++i)
+                    unquantized[i] = tables.colorUnquantize[candidate.colorRange][encoding.colors[p * mode.pairs * 2 + i]];
+                DecodeEndpoints(mode.mode, unquantized, decoded[p][0], decoded[p][1]);
+            }
+
+            if (gridCount == texels.count && planeCount == 1)
+            {
+                // One weight per texel: pick each from the palette of the quantized endpoints.
+                for (uint32_t p = 0; p < partitioning.count; ++p)
+                {
+                    uint8_t palette[32][4];
+                    for (uint32_t level = 0; level < levels; ++level)
+                    {
+                        for (uint32_t c = 0; c < 4; ++c)
+                            palette[level][c] = InterpolateTexel(decoded[p][0][c], decoded[p][1][c], weightUnquantize[level], texels.srgb);
+                    }
+
+                    uint8_t gathered[ALIMER_ASTC_MAX_TEXELS][4];
+                    uint8_t texelIndex[ALIMER_ASTC_MAX_TEXELS];
+                    uint32_t count = 0;
+                    for (uint32_t i = 0; i < texels.count; ++i)
+                    {
+                        if (partitioning.assignment[i] != p)
+                            continue;
+                        memcpy(gathered[count], texels.pixels[i], 4);
+                        texelIndex[count++] = (uint8_t)i;
+                    }
+
+                    uint8_t indices[ALIMER_ASTC_MAX_TEXELS];
+                    uint32_t errors[ALIMER_ASTC_MAX_TEXELS];
+                    alimerFindNearestColors(gathered, count, palette, levels, indices, errors);
+                    for (uint32_t i = 0; i < count; ++i)
+                    {
+                        encoding.weights[texelIndex[i]] = indices[i];
+                        texelWeights[0][texelIndex[i]] = weightUnquantize[indices[i]];
+                    }
+                }
+            }
+
+            // Same arithmetic as the decoder, the block is only assembled when it improves.
+            uint32_t error = 0;
+            for (uint32_t i = 0; i < texels.count; ++i)
+            {
+                const uint32_t p = partitioning.assignment[i];
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    const int32_t weight = c == planeChannel ? texelWeights[1][i] : texelWeights[0][i];
+                    const int32_t diff = (int32_t)InterpolateTexel(decoded[p][0][c], decoded[p][1][c], weight, texels.srgb) - (int32_t)texels.pixels[i][c];
+                    error += (uint32_t)(diff * diff);
+                }
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                WriteBlock(partitioning, encoding, block);
+            }
+            if (error == 0)
+                break;
+
+            // Next pass starts from the endpoints that were actually stored.
+            for (uint32_t p = 0; p < partitioning.count; ++p)
+            {
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    endpoints[p][0][c] = (float)decoded[p][0][c];
+                    endpoints[p][1][c] = (float)decoded[p][1][c];
+                }
+            }
+        }
+
+        return bestError;
+    }
+
+    /* Decoding */
+    void FillErrorColor(uint32_t count, uint8_t (*texels)[4])
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            texels[i][0] = 255;
+            texels[i][1] = 0;
+            texels[i][2] = 255;
+            texels[i][3] = 255;
+        }
+    }
+
+
+    // InterpolateTexel of every channel: with S = e0 * (64 - w) + e1 * w it is (257 * S + 32) >> 14, or (256 * S + 8224) >> 14 for sRGB.
+    void InterpolateTexels(const uint8_t (*e0)[4], const uint8_t (*e1)[4], const uint8_t (*weights)[4], uint32_t count, bool srgb, uint8_t (*texels)[4])
+    {
+        uint32_t first = 0;
+#if defined(ALIMER_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(64);
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i factors = srgb ? _mm_set1_epi32(256 | (8224 << 16)) : _mm_set1_epi32(257 | (32 << 16));
+        for (; first + 4 <= count; first += 4)
+        {
+            const __m128i a = _mm_loadu_si128((const __m128i*)e0[first]);
+            const __m128i b = _mm_loadu_si128((const __m128i*)e1[first]);
+            const __m128i w = _mm_loadu_si128((const __m128i*)weights[first]);
+            __m128i result[2];
+            for (uint32_t i = 0; i < 2; ++i)
+            {
+                const __m128i a16 = i ? _mm_unpackhi_epi8(a, zero) : _mm_unpacklo_epi8(a, zero);
+                const __m128i b16 = i ? _mm_unpackhi_epi8(b, zero) : _mm_unpacklo_epi8(b, zero);
+                const __m128i w16 = i ? _mm_unpackhi_epi8(w, zero) : _mm_unpacklo_epi8(w, zero);
+                const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a16, _mm_sub_epi16(full, w16)), _mm_mullo_epi16(b16, w16));
+                const __m128i low = _mm_srli_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(sum, one), factors), 14);
+                const __m128i high = _mm_srli_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(sum, one), factors), 14);
+                result[i] = _mm_packs_epi32(low, high);
+            }
+            _mm_storeu_si128((__m128i*)texels[first], _mm_packus_epi16(result[0], result[1]));
+        }
+#elif defined(ALIMER_NEON)
+        const uint8x16_t full = vdupq_n_u8(64);
+        const uint16_t scale = srgb ? 256 : 257;
+        const uint32x4_t bias = vdupq_n_u32(srgb ? 8224 : 32);
+        for (; first + 4 <= count; first += 4)
+        {
+            const uint8x16_t a = vld1q_u8(e0[first]);
+            const uint8x16_t b = vld1q_u8(e1[first]);
+            const uint8x16_t w = vld1q_u8(weights[first]);
+            const uint8x16_t inverse = vsubq_u8(full, w);
+            const uint16x8_t sums[2] = {
+                vmlal_u8(vmull_u8(vget_low_u8(a), vget_low_u8(inverse)), vget_low_u8(b), vget_low_u8(w)),
+                vmlal_u8(vmull_u8(vget_high_u8(a), vget_high_u8(inverse)), vget_high_u8(b), vget_high_u8(w)),
+            };
+            uint8x8_t result[2];
+            for (uint32_t i = 0; i < 2; ++i)
+            {
+                const uint16x4_t low = vshrn_n_u32(vmlal_n_u16(bias, vget_low_u16(sums[i]), scale), 14);
+                const uint16x4_t high = vshrn_n_u32(vmlal_n_u16(bias, vget_high_u16(sums[i]), scale), 14);
+                result[i] = vmovn_u16(vcombine_u16(low, high));
+            }
+            vst1q_u8(texels[first], vcombine_u8(result[0], result[1]));
+        }
+#endif
+        for (uint32_t i = first; i < count; ++i)
+        {
+            for (uint32_t c = 0; c < 4; ++c)
+                texels[i][c] = InterpolateTexel(e0[i][c], e1[i][c], weights[i][c], srgb);
+        }
+    }
+
+    // Infill of the last decoded weight grid, the blocks of an image mostly share a few grids.
+    struct InfillCache
+    {
+        uint32_t gridWidth;
+        uint32_t gridHeight;
+        InfillTexel texels[ALIMER_ASTC_MAX_TEXELS];
+    };
+
+    // Returns false (and the error color) for blocks outside the LDR profile or with invalid encodings.
+    bool DecodeBlock(const uint8_t* block, uint32_t blockWidth, uint32_t blockHeight, bool srgb, InfillCache& infill, uint8_t (*texels)[4])
+    {
+        const uint32_t texelCount = blockWidth * blockHeight;
+        const uint32_t mode = ReadBits(block, 0, 11);
+        if ((mode & 0x1FF) == 0x1FC)
+        {
+            // Void extent: a constant color, HDR ones are errors in the LDR profile.
+            if (mode & 0x200)
+            {
+                FillErrorColor(texelCount, texels);
+                return false;
+            }
+
+            uint8_t color[4];
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                color[c] = (uint8_t)(ReadBits(block, 64 + c * 16, 16) >> 8);
+            }
+            for (uint32_t i = 0; i < texelCount; ++i)
+                memcpy(texels[i], color, 4);
+            return true;
+        }
+
+        BlockMode blockMode;
+        const uint32_t partitionCount = ReadBits(block, 11, 2) + 1;
+        if (!DecodeBlockMode(mode, &blockMode) || blockMode.gridWidth > blockWidth || blockMode.gridHeight > blockHeight ||
+            (blockMode.dualPlane && partitionCount == 4))
+        {
+            FillErrorColor(texelCount, texels);
+            return false;
+        }
+
+        const uint32_t planeCount = blockMode.dualPlane ? 2 : 1;
+        const uint32_t weightCount = blockMode.gridWidth * blockMode.gridHeight * planeCount;
+        const uint32_t weightBits = GetISEBitCount(weightCount, blockMode.weightRange);
+        uint32_t belowWeights = 128 - weightBits;
+
+        uint32_t modes[4];
+        uint32_t seed = 0;
+        uint32_t colorStart = 17;
+        if (partitionCount == 1)
+        {
+            modes[0] = ReadBits(block, 13, 4);
+        }
+        else
+        {
+            seed = ReadBits(block, 13, 10);
+            colorStart = 29;
+            uint32_t encoded = ReadBits(block, 23, 6);
+            if ((encoded & 3) == 0)
+            {
+                for (uint32_t p = 0; p < partitionCount; ++p)
+                    modes[p] = encoded >> 2;
+            }
+            else
+            {
+                // Per partition class offsets and modes, the bits that don't fit in the field sit below the weights.
+                const uint32_t extraBits = 3 * partitionCount - 4;
+                belowWeights -= extraBits;
+                encoded |= ReadBits(block, belowWeights, extraBits) << 6;
+                const uint32_t baseClass = (encoded & 3) - 1;
+                encoded >>= 2;
+                for (uint32_t p = 0; p < partitionCount; ++p)
+                    modes[p] = ((baseClass + Bit(encoded, p)) << 2) | ((encoded >> (partitionCount + 2 * p)) & 3);
+            }
+        }
+
+        uint32_t planeChannel = 4;
+        if (blockMode.dualPlane)
+        {
+            belowWeights -= 2;
+            planeChannel = ReadBits(block, belowWeights, 2);
+        }
+
+        uint32_t colorCount = 0;
+        for (uint32_t p = 0; p < partitionCount; ++p)
+            colorCount += ((modes[p] >> 2) + 1) * 2;
+
+        if (colorCount > 18 || belowWeights < colorStart)
+        {
+            FillErrorColor(texelCount, texels);
+            return false;
+        }
+
+        const uint32_t colorBits = belowWeights - colorStart;
+        uint32_t colorRange = 20;
+        while (colorRange >= kMinColorRange && GetISEBitCount(colorCount, colorRange) > colorBits)
+            colorRange--;
+        if (colorRange < kMinColorRange)
+        {
+            FillErrorColor(texelCount, texels);
+            return false;
+        }
+
+        const QuantTables& tables = GetQuantTables();
+        uint8_t colorValues[18];
+        ReadISE(block, colorStart, colorValues, colorCount, colorRange);
+        for (uint32_t i = 0; i < colorCount; ++i)
+            colorValues[i] = tables.colorUnquantize[colorRange][colorValues[i]];
+
+        int32_t endpoints[4][2][4];
+        for (uint32_t p = 0, offset = 0; p < partitionCount; ++p)
+        {
+            if (!DecodeEndpoints(modes[p], colorValues + offset, endpoints[p][0], endpoints[p][1]))
+            {
+                FillErrorColor(texelCount, texels);
+                return false;
+            }
+            offset += ((modes[p] >> 2) + 1) * 2;
+        }
+
+        // The weight stream is read from the top of the block down.
+        uint8_t reversed[16];
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint8_t value = block[15 - i];
+            value = (uint8_t)(((value * 0x0802u & 0x22110u) | (value * 0x8020u & 0x88440u)) * 0x10101u >> 16);
+            reversed[i] = value;
+        }
+
+        uint8_t weights[ALIMER_ASTC_MAX_WEIGHTS];
+        ReadISE(reversed, 0, weights, weightCount, blockMode.weightRange);
+        for (uint32_t i = 0; i < weightCount; ++i)
+            weights[i] = tables.weightUnquantize[blockMode.weightRange][weights[i]];
+
+        if (infill.gridWidth != blockMode.gridWidth || infill.gridHeight != blockMode.gridHeight)
+        {
+            infill.gridWidth = blockMode.gridWidth;
+            infill.gridHeight = blockMode.gridHeight;
+            ComputeInfill(blockWidth, blockHeight, blockMode.gridWidth, blockMode.gridHeight, infill.texels);
+        }
+
+        uint8_t e0[ALIMER_ASTC_MAX_TEXELS][4];
+        uint8_t e1[ALIMER_ASTC_MAX_TEXELS][4];
+        uint8_t texelWeights[ALIMER_ASTC_MAX_TEXELS][4];
+        const bool smallBlock = texelCount < 31;
+        for (uint32_t i = 0; i < texelCount; ++i)
+        {
+            uint8_t planeWeights[2] = {};
+            for (uint32_t plane = 0; plane < planeCount; ++plane)
+            {
+                const InfillTexel& texel = infill.texels[i];
+                uint32_t sum = 0;
+                for (uint32_t k = 0; k < 4; ++k)
+                    sum += weights[texel.index[k] * planeCount + plane] * texel.weight[k];
+                planeWeights[plane] = (uint8_t)((sum + 8) >> 4);
+            }
+
+            const uint32_t partition = partitionCount > 1 ? SelectPartition(seed, i % blockWidth, i / blockWidth, partitionCount, smallBlock) : 0;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                e0[i][c] = (uint8_t)endpoints[partition][0][c];
+                e1[i][c] = (uint8_t)endpoints[partition][1][c];
+                texelWeights[i][c] = c == planeChannel ? planeWeights[1] : planeWeights[0];
+            }
+        }
+
+        InterpolateTexels(e0, e1, texelWeights, texelCount, srgb, texels);
+        return true;
+    }
+}
+
+void alimerEncodeASTCBlock(uint32_t blockWidth, uint32_t blockHeight, bool srgb, const uint8_t* pixels, void* block, ImageCompressQuality quality)
+{
+    uint8_t* output = (uint8_t*)block;
+    const BlockSizeTables* sizeTables = GetBlockSizeTables(blockWidth, blockHeight);
+    ALIMER_ASSERT(sizeTables != nullptr);
+
+    Texels texels;
+    texels.width = blockWidth;
+    texels.height = blockHeight;
+    texels.count = blockWidth * blockHeight;
+    texels.srgb = srgb;
+    memcpy(texels.pixels, pixels, texels.count * 4);
+
+    bool constant = true;
+    bool gray = true;
+    bool opaque = true;
+    for (uint32_t i = 0; i < texels.count; ++i)
+    {
+        const uint8_t* pixel = texels.pixels[i];
+        constant &= memcmp(pixel, texels.pixels[0], 4) == 0;
+        gray &= pixel[0] == pixel[1] && pixel[1] == pixel[2];
+        opaque &= pixel[3] == 255;
+    }
+
+    if (constant)
+    {
+        // Void extent block covering the whole texture, the color is stored as UNORM16.
+        memset(output, 0, 16);
+        WriteBits(output, 0, 12, 0xDFC);
+        for (uint32_t i = 0; i < 4; ++i)
+            WriteBits(output, 12 + i * 13, 13, 0x1FFF);
+        for (uint32_t c = 0; c < 4; ++c)
+            WriteBits(output, 64 + c * 16, 16, texels.pixels[0][c] * 257u);
+        return;
+    }
+
+    EndpointMode mode;
+    if (gray)
+        mode = opaque ? EndpointMode{ 0, 1, 0x1 } : EndpointMode{ 4, 2, 0x9 };
+    else
+        mode = opaque ? EndpointMode{ 8, 3, 0x7 } : EndpointMode{ 12, 4, 0xF };
+
+    // Candidates tried per quality: single plane grids, dual plane grids for alpha, partitionings and their grids.
+    static const uint32_t kSinglePlane[] = { 2, 4, 8 };
+    static const uint32_t kDualPlane[] = { 0, 2, 4 };
+    static const uint32_t kPartitionSeeds[] = { 0, 2, 6 };
+    static const uint32_t kPartitionGrids[] = { 0, 2, 4 };
+
+    Partitioning partitioning;
+    partitioning.count = 1;
+    partitioning.seed = 0;
+    memset(partitioning.assignment, 0, texels.count);
+
+    uint32_t bestError = UINT32_MAX;
+    uint8_t candidateBlock[16];
+    const CandidateList& single = sizeTables->candidates[0][mode.pairs - 1][0];
+    for (uint32_t i = 0; i < single.count && i < kSinglePlane[quality] && bestError > 0; ++i)
+    {
+        const uint32_t error = EncodeCandidate(texels, partitioning, mode, single.candidates[i], 4, quality, candidateBlock);
+        if (error < bestError)
+        {
+            bestError = error;
+            memcpy(output, candidateBlock, 16);
+        }
+    }
+
+    if (!opaque)
+    {
+        // Alpha often varies independently of the color, give it its own weights.
+        const CandidateList& dual = sizeTables->candidates[0][mode.pairs - 1][1];
+        for (uint32_t i = 0; i < dual.count && i < kDualPlane[quality] && bestError > 0; ++i)
+        {
+            const uint32_t error = EncodeCandidate(texels, partitioning, mode, dual.candidates[i], 3, quality, candidateBlock);
+            if (error < bestError)
+            {
+                bestError = error;
+                memcpy(output, candidateBlock, 16);
+            }
+        }
+    }
+
+    // Two partitions for blocks that a single line fits poorly, seeds ranked by how well they match a 2-means clustering.
+    const CandidateList& split = sizeTables->candidates[1][mode.pairs - 1][0];
+    if (kPartitionSeeds[quality] == 0 || split.count == 0 || bestError <= texels.count * 4)
+        return;
+
+    float line[2][4];
+    FitLine(texels, partitioning, 0, mode.channelMask, line);
+    float centers[2][4];
+    memcpy(centers, line, sizeof(centers));
+    uint64_t cluster[3] = {};
+    for (uint32_t iteration = 0; iteration < 4; ++iteration)
+    {
+        float sums[2][4] = {};
+        uint32_t counts[2] = {};
+        cluster[0] = cluster[1] = cluster[2] = 0;
+        for (uint32_t i = 0; i < texels.count; ++i)
+        {
+            float distance[2] = {};
+            for (uint32_t k = 0; k < 2; ++k)
+            {
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    const float diff = texels.pixels[i][c] - centers[k][c];
+                    distance[k] += diff * diff;
+                }
+            }
+
+            const uint32_t k = distance[1] < distance[0] ? 1 : 0;
+            if (k)
+                cluster[i >> 6] |= (uint64_t)1 << (i & 63);
+            counts[k]++;
+            for (uint32_t c = 0; c < 4; ++c)
+                sums[k][c] += texels.pixels[i][c];
+        }
+
+        for (uint32_t k = 0; k < 2; ++k)
+        {
+            for (uint32_t c = 0; c < 4 && counts[k] > 0; ++c)
+                centers[k][c] = sums[k][c] / (float)counts[k];
+        }
+    }
+
+    uint32_t seeds[8];
+    uint32_t mismatches[8];
+    uint32_t seedCount = 0;
+    for (uint32_t seed = 0; seed < 1024; ++seed)
+    {
+        if (!sizeTables->partitionValid[seed])
+            continue;
+
+        const uint64_t* mask = sizeTables->partitionMasks[seed];
+        uint32_t mismatch = 0;
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            uint64_t bits = mask[i] ^ cluster[i];
+            for (; bits; bits &= bits - 1)
+                mismatch++;
+        }
+        // The partition labels are arbitrary.
+        mismatch = mismatch < texels.count - mismatch ? mismatch : texels.count - mismatch;
+
+        uint32_t position = seedCount;
+        while (position > 0 && mismatches[position - 1] > mismatch)
+            position--;
+        if (position >= kPartitionSeeds[quality])
+            continue;
+
+        const uint32_t last = seedCount < kPartitionSeeds[quality] ? seedCount : kPartitionSeeds[quality] - 1;
+        for (uint32_t i = last; i > position; --i)
+        {
+            seeds[i] = seeds[i - 1];
+            mismatches[i] = mismatches[i - 1];
+        }
+        seeds[position] = seed;
+        mismatches[position] = mismatch;
+        if (seedCount < kPartitionSeeds[quality])
+            seedCount++;
+    }
+
+    partitioning.count = 2;
+    for (uint32_t s = 0; s < seedCount && bestError > 0; ++s)
+    {
+        partitioning.seed = seeds[s];
+        const uint64_t* mask = sizeTables->partitionMasks[seeds[s]];
+        for (uint32_t i = 0; i < texels.count; ++i)
+            partitioning.assignment[i] = (uint8_t)((mask[i >> 6] >> (i & 63)) & 1);
+
+        for (uint32_t i = 0; i < split.count && i < kPartitionGrids[quality] && bestError > 0; ++i)
+        {
+            const uint32_t error = EncodeCandidate(texels, partitioning, mode, split.candidates[i], 4, quality, candidateBlock);
+            if (error < bestError)
+            {
+                bestError = error;
+                memcpy(output, candidateBlock, 16);
+            }
+        }
+    }
+}
+
+void alimerDecodeASTCBlocks(uint32_t blockWidth, uint32_t blockHeight, bool srgb, const void* blocks, uint32_t blockCount, void* pixels, size_t rowPitch)
+{
+    const uint8_t* input = (const uint8_t*)blocks;
+    uint8_t* output = (uint8_t*)pixels;
+    InfillCache infill;
+    infill.gridWidth = 0;
+    infill.gridHeight = 0;
+    for (uint32_t b = 0; b < blockCount; ++b)
+    {
+        uint8_t texels[ALIMER_ASTC_MAX_TEXELS][4];
+        DecodeBlock(input + b * 16, blockWidth, blockHeight, srgb, infill, texels);
+        for (uint32_t y = 0; y < blockHeight; ++y)
+            memcpy(output + y * rowPitch + b * blockWidth * 4, texels[y * blockWidth], blockWidth * 4);
+    }
+}
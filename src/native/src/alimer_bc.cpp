@@ -0,0 +1,1810 @@
+// Copyright (c) Amer Koleci and Contributors.
+// Licensed under the MIT License (MIT). See LICENSE in the repository root for more information.
+
+#include "alimer_internal.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define ALIMER_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   include <arm_neon.h>
+#   define ALIMER_NEON 1
+#endif
+
+// Ties go to the lowest index.
+void alimerFindNearestColors(const uint8_t (*pixels)[4], uint32_t count, const uint8_t (*palette)[4], uint32_t paletteSize, uint8_t* indices, uint32_t* errors)
+{
+    uint32_t first = 0;
+#if defined(ALIMER_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    // Palette entries widened to 16 bits once, two copies per register to match two pixels.
+    __m128i entries[32];
+    for (uint32_t i = 0; i < paletteSize; ++i)
+    {
+        int32_t entry;
+        memcpy(&entry, palette[i], 4);
+        entries[i] = _mm_shuffle_epi32(_mm_unpacklo_epi8(_mm_cvtsi32_si128(entry), zero), _MM_SHUFFLE(1, 0, 1, 0));
+    }
+
+    for (; first + 4 <= count; first += 4)
+    {
+        const __m128i value = _mm_loadu_si128((const __m128i*)pixels[first]);
+        const __m128i low = _mm_unpacklo_epi8(value, zero);
+        const __m128i high = _mm_unpackhi_epi8(value, zero);
+
+        __m128i bestError = _mm_set1_epi32(0x7FFFFFFF);
+        __m128i bestIndex = zero;
+        for (uint32_t i = 0; i < paletteSize; ++i)
+        {
+            const __m128i lowDiff = _mm_sub_epi16(low, entries[i]);
+            const __m128i highDiff = _mm_sub_epi16(high, entries[i]);
+            // (r² + g², b² + a²) per pixel, then the two halves are added.
+            const __m128 lowSum = _mm_castsi128_ps(_mm_madd_epi16(lowDiff, lowDiff));
+            const __m128 highSum = _mm_castsi128_ps(_mm_madd_epi16(highDiff, highDiff));
+            const __m128i error = _mm_add_epi32(
+                _mm_castps_si128(_mm_shuffle_ps(lowSum, highSum, _MM_SHUFFLE(2, 0, 2, 0))),
+                _mm_castps_si128(_mm_shuffle_ps(lowSum, highSum, _MM_SHUFFLE(3, 1, 3, 1))));
+
+            const __m128i better = _mm_cmplt_epi32(error, bestError);
+            bestError = _mm_or_si128(_mm_and_si128(better, error), _mm_andnot_si128(better, bestError));
+            bestIndex = _mm_or_si128(_mm_and_si128(better, _mm_set1_epi32((int)i)), _mm_andnot_si128(better, bestIndex));
+        }
+
+        uint32_t groupIndices[4];
+        _mm_storeu_si128((__m128i*)(errors + first), bestError);
+        _mm_storeu_si128((__m128i*)groupIndices, bestIndex);
+        for (uint32_t p = 0; p < 4; ++p)
+            indices[first + p] = (uint8_t)groupIndices[p];
+    }
+#elif defined(ALIMER_NEON)
+    int16x8_t entries[32];
+    for (uint32_t i = 0; i < paletteSize; ++i)
+    {
+        uint32_t entry;
+        memcpy(&entry, palette[i], 4);
+        const int16x4_t widened = vreinterpret_s16_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(entry)))));
+        entries[i] = vcombine_s16(widened, widened);
+    }
+
+    for (; first + 4 <= count; first += 4)
+    {
+        const uint8x16_t value = vld1q_u8(pixels[first]);
+        const int16x8_t low = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(value)));
+        const int16x8_t high = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(value)));
+
+        uint32x4_t bestError = vdupq_n_u32(0x7FFFFFFF);
+        uint32x4_t bestIndex = vdupq_n_u32(0);
+        for (uint32_t i = 0; i < paletteSize; ++i)
+        {
+            const int16x8_t lowDiff = vsubq_s16(low, entries[i]);
+            const int16x8_t highDiff = vsubq_s16(high, entries[i]);
+            const int32x4_t pixel0 = vmull_s16(vget_low_s16(lowDiff), vget_low_s16(lowDiff));
+            const int32x4_t pixel1 = vmull_s16(vget_high_s16(lowDiff), vget_high_s16(lowDiff));
+            const int32x4_t pixel2 = vmull_s16(vget_low_s16(highDiff), vget_low_s16(highDiff));
+            const int32x4_t pixel3 = vmull_s16(vget_high_s16(highDiff), vget_high_s16(highDiff));
+            const uint32x4_t error = vreinterpretq_u32_s32(vpaddq_s32(vpaddq_s32(pixel0, pixel1), vpaddq_s32(pixel2, pixel3)));
+
+            const uint32x4_t better = vcltq_u32(error, bestError);
+            bestError = vbslq_u32(better, error, bestError);
+            bestIndex = vbslq_u32(better, vdupq_n_u32(i), bestIndex);
+        }
+
+        uint32_t groupIndices[4];
+        vst1q_u32(errors + first, bestError);
+        vst1q_u32(groupIndices, bestIndex);
+        for (uint32_t p = 0; p < 4; ++p)
+            indices[first + p] = (uint8_t)groupIndices[p];
+    }
+#endif
+
+    for (uint32_t p = first; p < count; ++p)
+    {
+        uint32_t bestError = 0x7FFFFFFF;
+        uint32_t bestIndex = 0;
+        for (uint32_t i = 0; i < paletteSize; ++i)
+        {
+            uint32_t error = 0;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const int32_t diff = (int32_t)pixels[p][c] - (int32_t)palette[i][c];
+                error += (uint32_t)(diff * diff);
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                bestIndex = i;
+            }
+        }
+
+        errors[p] = bestError;
+        indices[p] = (uint8_t)bestIndex;
+    }
+}
+
+// BC1-BC5 and BC7 block encoders. Every encoder works on a 4x4 block of RGBA8 pixels (row major) and follows the same scheme:
+// principal axis endpoints, nearest palette indices, then least squares refinement of the endpoints from the indices.
+namespace
+{
+    typedef uint8_t BlockPixels[16][4];
+
+    /* Endpoint fitting */
+    // Principal axis of the selected pixels (power iteration on the covariance), endpoints are the extreme projections.
+    void FitLine(const BlockPixels pixels, uint32_t mask, uint32_t channels, float endpoints[2][4])
+    {
+        float mean[4] = {};
+        float minValue[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+        float maxValue[4] = {};
+        uint32_t count = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            if (!(mask & (1u << p)))
+                continue;
+
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                const float value = pixels[p][c];
+                mean[c] += value;
+                minValue[c] = value < minValue[c] ? value : minValue[c];
+                maxValue[c] = value > maxValue[c] ? value : maxValue[c];
+            }
+            count++;
+        }
+
+        for (uint32_t c = 0; c < channels; ++c)
+            mean[c] /= (float)count;
+
+        float covariance[4][4] = {};
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            if (!(mask & (1u << p)))
+                continue;
+
+            float diff[4];
+            for (uint32_t c = 0; c < channels; ++c)
+                diff[c] = pixels[p][c] - mean[c];
+            for (uint32_t i = 0; i < channels; ++i)
+                for (uint32_t j = 0; j < channels; ++j)
+                    covariance[i][j] += diff[i] * diff[j];
+        }
+
+        float axis[4];
+        for (uint32_t c = 0; c < channels; ++c)
+            axis[c] = maxValue[c] - minValue[c];
+
+        for (uint32_t iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            float length = 0.0f;
+            for (uint32_t i = 0; i < channels; ++i)
+            {
+                for (uint32_t j = 0; j < channels; ++j)
+                    next[i] += covariance[i][j] * axis[j];
+                length = fabsf(next[i]) > length ? fabsf(next[i]) : length;
+            }
+
+            // Flat block, the bounding box diagonal is as good as anything.
+            if (length < 1e-6f)
+                break;
+
+            for (uint32_t c = 0; c < channels; ++c)
+                axis[c] = next[c] / length;
+        }
+
+        float axisLength = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c)
+            axisLength += axis[c] * axis[c];
+
+        float minT = 0.0f;
+        float maxT = 0.0f;
+        if (axisLength > 0.0f)
+        {
+            minT = 1e30f;
+            maxT = -1e30f;
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                if (!(mask & (1u << p)))
+                    continue;
+
+                float t = 0.0f;
+                for (uint32_t c = 0; c < channels; ++c)
+                    t += (pixels[p][c] - mean[c]) * axis[c];
+                t /= axisLength;
+                minT = t < minT ? t : minT;
+                maxT = t > maxT ? t : maxT;
+            }
+        }
+
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            const float e0 = c < channels ? mean[c] + minT * axis[c] : 255.0f;
+            const float e1 = c < channels ? mean[c] + maxT * axis[c] : 255.0f;
+            endpoints[0][c] = e0 < 0.0f ? 0.0f : (e0 > 255.0f ? 255.0f : e0);
+            endpoints[1][c] = e1 < 0.0f ? 0.0f : (e1 > 255.0f ? 255.0f : e1);
+        }
+    }
+
+    // Least squares endpoints for the given interpolation weights (0 at the first endpoint, 1 at the second).
+    bool RefineLine(const BlockPixels pixels, uint32_t mask, const uint8_t* indices, const float* weights, uint32_t channels, float endpoints[2][4])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {};
+        float bx[4] = {};
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            if (!(mask & (1u << p)))
+                continue;
+
+            const float t = weights[indices[p]];
+            const float s = 1.0f - t;
+            aa += s * s;
+            ab += s * t;
+            bb += t * t;
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                ax[c] += s * pixels[p][c];
+                bx[c] += t * pixels[p][c];
+            }
+        }
+
+        const float determinant = aa * bb - ab * ab;
+        if (fabsf(determinant) < 1e-6f)
+            return false;
+
+        const float inverse = 1.0f / determinant;
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            const float e0 = (ax[c] * bb - bx[c] * ab) * inverse;
+            const float e1 = (bx[c] * aa - ax[c] * ab) * inverse;
+            endpoints[0][c] = e0 < 0.0f ? 0.0f : (e0 > 255.0f ? 255.0f : e0);
+            endpoints[1][c] = e1 < 0.0f ? 0.0f : (e1 > 255.0f ? 255.0f : e1);
+        }
+        return true;
+    }
+
+    struct BitWriter
+    {
+        uint8_t* data;
+        uint32_t position;
+
+        void Write(uint32_t value, uint32_t bits)
+        {
+            for (uint32_t i = 0; i < bits; ++i, ++position)
+            {
+                if ((value >> i) & 1)
+                    data[position >> 3] |= (uint8_t)(1u << (position & 7));
+            }
+        }
+    };
+
+    /* BC1 */
+    inline uint32_t Expand5(uint32_t value) { return (value << 3) | (value >> 2); }
+    inline uint32_t Expand6(uint32_t value) { return (value << 2) | (value >> 4); }
+
+    inline uint32_t Quantize(float value, uint32_t maxValue)
+    {
+        return (uint32_t)(value * maxValue / 255.0f + 0.5f);
+    }
+
+    uint16_t Pack565(const float color[4])
+    {
+        return (uint16_t)((Quantize(color[0], 31) << 11) | (Quantize(color[1], 63) << 5) | Quantize(color[2], 31));
+    }
+
+    void Unpack565(uint16_t value, uint8_t color[4])
+    {
+        color[0] = (uint8_t)Expand5(value >> 11);
+        color[1] = (uint8_t)Expand6((value >> 5) & 0x3F);
+        color[2] = (uint8_t)Expand5(value & 0x1F);
+        color[3] = 0;
+    }
+
+    // Best endpoint pair for a solid color at 1/3 of the way, as in stb_dxt.
+    struct SingleColorTables
+    {
+        uint8_t match5[256][2];
+        uint8_t match6[256][2];
+
+        SingleColorTables()
+        {
+            Build(match5, 31, Expand5);
+            Build(match6, 63, Expand6);
+        }
+
+        static void Build(uint8_t table[256][2], uint32_t maxValue, uint32_t (*expand)(uint32_t))
+        {
+            for (int32_t value = 0; value < 256; ++value)
+            {
+                int32_t bestError = 256;
+                for (uint32_t a = 0; a <= maxValue; ++a)
+                {
+                    for (uint32_t b = 0; b <= maxValue; ++b)
+                    {
+                        const int32_t interpolated = (int32_t)(2 * expand(a) + expand(b)) / 3;
+                        int32_t error = interpolated - value;
+                        error = error < 0 ? -error : error;
+                        // Slight preference for close endpoints, they survive the GPU interpolation rounding better.
+                        error = error * 100 + (int32_t)(a > b ? a - b : b - a);
+                        if (error < bestError)
+                        {
+                            bestError = error;
+                            table[value][0] = (uint8_t)a;
+                            table[value][1] = (uint8_t)b;
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    const SingleColorTables& GetSingleColorTables()
+    {
+        static const SingleColorTables tables;
+        return tables;
+    }
+
+    void BuildBC1Palette(uint16_t color0, uint16_t color1, bool fourColors, uint8_t palette[4][4])
+    {
+        Unpack565(color0, palette[0]);
+        Unpack565(color1, palette[1]);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            if (fourColors)
+            {
+                palette[2][c] = (uint8_t)((2 * palette[0][c] + palette[1][c]) / 3);
+                palette[3][c] = (uint8_t)((palette[0][c] + 2 * palette[1][c]) / 3);
+            }
+            else
+            {
+                palette[2][c] = (uint8_t)((palette[0][c] + palette[1][c]) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 0;
+        palette[3][3] = 0;
+    }
+
+    // Color block of BC1/BC2/BC3, punch-through alpha only when allowed (BC1), the other formats always decode four colors.
+    void EncodeBC1(const BlockPixels input, uint8_t* block, bool allowAlpha, uint32_t iterations)
+    {
+        BlockPixels pixels;
+        uint32_t mask = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            pixels[p][0] = input[p][0];
+            pixels[p][1] = input[p][1];
+            pixels[p][2] = input[p][2];
+            pixels[p][3] = 0;
+            if (!allowAlpha || input[p][3] >= 128)
+                mask |= 1u << p;
+        }
+
+        uint16_t color0 = 0;
+        uint16_t color1 = 0;
+        uint8_t indices[16] = {};
+        if (mask == 0)
+        {
+            // Fully transparent, three color mode with every index on the transparent entry.
+            memset(block, 0, 4);
+            memset(block + 4, 0xFF, 4);
+            return;
+        }
+
+        const bool threeColors = mask != 0xFFFF;
+        bool solid = true;
+        uint32_t first = 0;
+        while (!(mask & (1u << first)))
+            first++;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            if ((mask & (1u << p)) && memcmp(pixels[p], pixels[first], 3) != 0)
+                solid = false;
+        }
+
+        if (solid && !threeColors)
+        {
+            const SingleColorTables& tables = GetSingleColorTables();
+            const uint8_t* color = pixels[first];
+            color0 = (uint16_t)((tables.match5[color[0]][0] << 11) | (tables.match6[color[1]][0] << 5) | tables.match5[color[2]][0]);
+            color1 = (uint16_t)((tables.match5[color[0]][1] << 11) | (tables.match6[color[1]][1] << 5) | tables.match5[color[2]][1]);
+            memset(indices, 2, sizeof(indices));
+        }
+        else
+        {
+            static const float kWeights4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+            static const float kWeights3[3] = { 0.0f, 1.0f, 0.5f };
+            const float* weights = threeColors ? kWeights3 : kWeights4;
+            const uint32_t paletteSize = threeColors ? 3 : 4;
+
+            float endpoints[2][4];
+            FitLine(pixels, mask, 3, endpoints);
+
+            uint32_t bestError = UINT32_MAX;
+            for (uint32_t iteration = 0; iteration <= iterations; ++iteration)
+            {
+                const uint16_t c0 = Pack565(endpoints[0]);
+                const uint16_t c1 = Pack565(endpoints[1]);
+                uint8_t palette[4][4];
+                BuildBC1Palette(c0, c1, !threeColors, palette);
+
+                uint8_t candidate[16];
+                uint32_t errors[16];
+                alimerFindNearestColors(pixels, 16, palette, paletteSize, candidate, errors);
+
+                uint32_t error = 0;
+                for (uint32_t p = 0; p < 16; ++p)
+                {
+                    if (mask & (1u << p))
+                        error += errors[p];
+                }
+
+                if (error >= bestError)
+                    break;
+
+                bestError = error;
+                color0 = c0;
+                color1 = c1;
+                memcpy(indices, candidate, sizeof(indices));
+                if (error == 0 || !RefineLine(pixels, mask, candidate, weights, 3, endpoints))
+                    break;
+            }
+        }
+
+        // The endpoint order selects the mode: color0 > color1 for four colors, color0 <= color1 for three colors and transparency.
+        if (threeColors)
+        {
+            if (color0 > color1)
+            {
+                const uint16_t swap = color0;
+                color0 = color1;
+                color1 = swap;
+                for (uint32_t p = 0; p < 16; ++p)
+                    indices[p] = indices[p] == 2 ? 2 : (uint8_t)(indices[p] ^ 1);
+            }
+
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                if (!(mask & (1u << p)))
+                    indices[p] = 3;
+            }
+        }
+        else if (color0 < color1)
+        {
+            const uint16_t swap = color0;
+            color0 = color1;
+            color1 = swap;
+            for (uint32_t p = 0; p < 16; ++p)
+                indices[p] ^= 1;
+        }
+        else if (color0 == color1)
+        {
+            memset(indices, 0, sizeof(indices));
+        }
+
+        uint32_t packedIndices = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+            packedIndices |= (uint32_t)indices[p] << (p * 2);
+
+        block[0] = (uint8_t)(color0 & 0xFF);
+        block[1] = (uint8_t)(color0 >> 8);
+        block[2] = (uint8_t)(color1 & 0xFF);
+        block[3] = (uint8_t)(color1 >> 8);
+        block[4] = (uint8_t)(packedIndices & 0xFF);
+        block[5] = (uint8_t)((packedIndices >> 8) & 0xFF);
+        block[6] = (uint8_t)((packedIndices >> 16) & 0xFF);
+        block[7] = (uint8_t)(packedIndices >> 24);
+    }
+
+    /* BC4 */
+    inline int32_t DivideRound(int32_t value, int32_t divisor)
+    {
+        return (value >= 0 ? value + divisor / 2 : value - divisor / 2) / divisor;
+    }
+
+    void BuildBC4Palette(int32_t e0, int32_t e1, bool snorm, int32_t palette[8])
+    {
+        palette[0] = e0;
+        palette[1] = e1;
+        if (e0 > e1)
+        {
+            for (int32_t i = 1; i < 7; ++i)
+                palette[i + 1] = DivideRound((7 - i) * e0 + i * e1, 7);
+        }
+        else
+        {
+            for (int32_t i = 1; i < 5; ++i)
+                palette[i + 1] = DivideRound((5 - i) * e0 + i * e1, 5);
+            palette[6] = snorm ? -127 : 0;
+            palette[7] = snorm ? 127 : 255;
+        }
+    }
+
+    uint32_t EvaluateBC4(const int32_t* values, int32_t e0, int32_t e1, bool snorm, uint8_t* indices)
+    {
+        int32_t palette[8];
+        BuildBC4Palette(e0, e1, snorm, palette);
+
+        uint32_t total = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            uint32_t bestError = UINT32_MAX;
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                const int32_t diff = values[p] - palette[i];
+                const uint32_t error = (uint32_t)(diff * diff);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    indices[p] = (uint8_t)i;
+                }
+            }
+            total += bestError;
+        }
+        return total;
+    }
+
+    // Single channel block (BC4, BC5 channels and the BC3 alpha), values are 0..255 or -127..127 for snorm.
+    void EncodeBC4(const int32_t* values, bool snorm, uint8_t* block, uint32_t searchRadius)
+    {
+        int32_t minValue = values[0];
+        int32_t maxValue = values[0];
+        // Extremes excluded, the six value mode has them for free.
+        const int32_t low = snorm ? -127 : 0;
+        const int32_t high = snorm ? 127 : 255;
+        int32_t innerMin = high;
+        int32_t innerMax = low;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            minValue = values[p] < minValue ? values[p] : minValue;
+            maxValue = values[p] > maxValue ? values[p] : maxValue;
+            if (values[p] != low && values[p] != high)
+            {
+                innerMin = values[p] < innerMin ? values[p] : innerMin;
+                innerMax = values[p] > innerMax ? values[p] : innerMax;
+            }
+        }
+
+        int32_t bestE0 = maxValue;
+        int32_t bestE1 = minValue;
+        uint8_t indices[16];
+        uint32_t bestError = EvaluateBC4(values, bestE0, bestE1, snorm, indices);
+
+        // Eight value mode with the range shrunk a little, the extremes rarely need to be exact.
+        for (int32_t d0 = 0; d0 <= (int32_t)searchRadius && bestError > 0; ++d0)
+        {
+            for (int32_t d1 = 0; d1 <= (int32_t)searchRadius; ++d1)
+            {
+                const int32_t e0 = maxValue - d0;
+                const int32_t e1 = minValue + d1;
+                if (e0 <= e1 || (d0 == 0 && d1 == 0))
+                    continue;
+
+                uint8_t candidate[16];
+                const uint32_t error = EvaluateBC4(values, e0, e1, snorm, candidate);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestE0 = e0;
+                    bestE1 = e1;
+                    memcpy(indices, candidate, sizeof(indices));
+                }
+            }
+        }
+
+        if (searchRadius > 0 && bestError > 0 && innerMin <= innerMax)
+        {
+            uint8_t candidate[16];
+            const uint32_t error = EvaluateBC4(values, innerMin, innerMax, snorm, candidate);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestE0 = innerMin;
+                bestE1 = innerMax;
+                memcpy(indices, candidate, sizeof(indices));
+            }
+        }
+
+        // Snorm endpoints are stored as two's complement bytes.
+        block[0] = (uint8_t)(bestE0 & 0xFF);
+        block[1] = (uint8_t)(bestE1 & 0xFF);
+
+        uint64_t packedIndices = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+            packedIndices |= (uint64_t)indices[p] << (p * 3);
+        for (uint32_t i = 0; i < 6; ++i)
+            block[2 + i] = (uint8_t)(packedIndices >> (i * 8));
+    }
+
+    void EncodeBC4Channel(const BlockPixels pixels, uint32_t channel, bool snorm, uint8_t* block, uint32_t searchRadius)
+    {
+        int32_t values[16];
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            // -128 and -127 both decode to -1.0.
+            values[p] = snorm ? (int32_t)(int8_t)pixels[p][channel] : (int32_t)pixels[p][channel];
+            if (values[p] < -127)
+                values[p] = -127;
+        }
+        EncodeBC4(values, snorm, block, searchRadius);
+    }
+
+    void EncodeBC2Alpha(const BlockPixels pixels, uint8_t* block)
+    {
+        for (uint32_t p = 0; p < 16; p += 2)
+        {
+            const uint32_t a0 = (pixels[p][3] * 15 + 127) / 255;
+            const uint32_t a1 = (pixels[p + 1][3] * 15 + 127) / 255;
+            block[p / 2] = (uint8_t)(a0 | (a1 << 4));
+        }
+    }
+
+    /* BC7 */
+    const uint16_t kPartitions2[64] = {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    // Pixel holding the index MSB-less anchor of the second subset.
+    const uint8_t kAnchors2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+        15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+        6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+    };
+
+    const uint8_t kWeights2[4] = { 0, 21, 43, 64 };
+    const uint8_t kWeights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    const uint8_t kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    struct BC7ModeInfo
+    {
+        uint32_t mode;
+        uint32_t subsets;
+        // Bits per color and alpha endpoint channel, 0 alpha bits for the opaque modes.
+        uint32_t colorBits;
+        uint32_t alphaBits;
+        // 0 none, 1 shared by the endpoints of a subset, 2 one per endpoint.
+        uint32_t pbitMode;
+        uint32_t indexBits;
+    };
+
+    const BC7ModeInfo kBC7Mode1 = { 1, 2, 6, 0, 1, 3 };
+    const BC7ModeInfo kBC7Mode3 = { 3, 2, 7, 0, 2, 2 };
+    const BC7ModeInfo kBC7Mode6 = { 6, 1, 7, 7, 2, 4 };
+    const BC7ModeInfo kBC7Mode7 = { 7, 2, 5, 5, 2, 2 };
+
+    const uint8_t* GetBC7Weights(uint32_t indexBits)
+    {
+        return indexBits == 2 ? kWeights2 : (indexBits == 3 ? kWeights3 : kWeights4);
+    }
+
+    inline uint8_t Interpolate(uint32_t e0, uint32_t e1, uint32_t weight)
+    {
+        return (uint8_t)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+    }
+
+    inline uint32_t ExpandBits(uint32_t value, uint32_t bits)
+    {
+        return bits >= 8 ? value : (value << (8 - bits)) | (value >> (2 * bits - 8));
+    }
+
+    // Quantized endpoint of one channel, with the p-bit appended as the lowest bit of the stored precision.
+    uint32_t QuantizeBC7(float value, uint32_t bits, int32_t pbit)
+    {
+        if (pbit < 0)
+        {
+            const uint32_t maxValue = (1u << bits) - 1;
+            const uint32_t result = (uint32_t)(value * maxValue / 255.0f + 0.5f);
+            return result > maxValue ? maxValue : result;
+        }
+
+        const uint32_t maxValue = (1u << bits) - 1;
+        const float scaled = value * (float)((1u << (bits + 1)) - 1) / 255.0f;
+        const int32_t result = (int32_t)floorf((scaled - (float)pbit) * 0.5f + 0.5f);
+        return result < 0 ? 0 : (result > (int32_t)maxValue ? maxValue : (uint32_t)result);
+    }
+
+    struct BC7Subset
+    {
+        // Stored endpoint values (without p-bits).
+        uint8_t endpoints[2][4];
+        uint8_t pbits[2];
+    };
+
+    struct BC7Candidate
+    {
+        const BC7ModeInfo* info;
+        uint32_t partition;
+        BC7Subset subsets[2];
+        uint8_t indices[16];
+        uint32_t error;
+    };
+
+    void ExpandBC7Endpoints(const BC7ModeInfo& info, const BC7Subset& subset, uint8_t expanded[2][4])
+    {
+        for (uint32_t e = 0; e < 2; ++e)
+        {
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const uint32_t bits = c < 3 ? info.colorBits : info.alphaBits;
+                if (bits == 0)
+                {
+                    expanded[e][c] = 255;
+                    continue;
+                }
+
+                if (info.pbitMode == 0)
+                    expanded[e][c] = (uint8_t)ExpandBits(subset.endpoints[e][c], bits);
+                else
+                    expanded[e][c] = (uint8_t)ExpandBits((uint32_t)(subset.endpoints[e][c] << 1) | subset.pbits[e], bits + 1);
+            }
+        }
+    }
+
+    // Quantize and evaluate one subset for every p-bit choice, returns the error over the subset pixels.
+    uint32_t QuantizeBC7Subset(const BlockPixels pixels, uint32_t mask, const BC7ModeInfo& info, const float endpoints[2][4], BC7Subset* subset, uint8_t* indices)
+    {
+        const uint32_t pbitCount = info.pbitMode == 0 ? 1 : (info.pbitMode == 1 ? 2 : 4);
+        const uint32_t paletteSize = 1u << info.indexBits;
+        const uint8_t* weights = GetBC7Weights(info.indexBits);
+
+        uint32_t bestError = UINT32_MAX;
+        for (uint32_t combination = 0; combination < pbitCount; ++combination)
+        {
+            BC7Subset candidate;
+            candidate.pbits[0] = (uint8_t)(combination & 1);
+            candidate.pbits[1] = (uint8_t)(info.pbitMode == 1 ? (combination & 1) : (combination >> 1));
+            for (uint32_t e = 0; e < 2; ++e)
+            {
+                const int32_t pbit = info.pbitMode == 0 ? -1 : (int32_t)candidate.pbits[e];
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    const uint32_t bits = c < 3 ? info.colorBits : info.alphaBits;
+                    candidate.endpoints[e][c] = bits ? (uint8_t)QuantizeBC7(endpoints[e][c], bits, pbit) : 0;
+                }
+            }
+
+            uint8_t expanded[2][4];
+            ExpandBC7Endpoints(info, candidate, expanded);
+            uint8_t palette[16][4];
+            for (uint32_t i = 0; i < paletteSize; ++i)
+            {
+                for (uint32_t c = 0; c < 4; ++c)
+                    palette[i][c] = Interpolate(expanded[0][c], expanded[1][c], weights[i]);
+            }
+
+            uint8_t candidateIndices[16];
+            uint32_t errors[16];
+            alimerFindNearestColors(pixels, 16, palette, paletteSize, candidateIndices, errors);
+
+            uint32_t error = 0;
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                if (mask & (1u << p))
+                    error += errors[p];
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                *subset = candidate;
+                for (uint32_t p = 0; p < 16; ++p)
+                {
+                    if (mask & (1u << p))
+                        indices[p] = candidateIndices[p];
+                }
+            }
+        }
+
+        return bestError;
+    }
+
+    uint32_t EncodeBC7Subset(const BlockPixels pixels, uint32_t mask, const BC7ModeInfo& info, uint32_t iterations, BC7Subset* subset, uint8_t* indices)
+    {
+        const uint32_t channels = info.alphaBits ? 4 : 3;
+        float endpoints[2][4];
+        FitLine(pixels, mask, channels, endpoints);
+
+        float weights[16];
+        const uint8_t* intWeights = GetBC7Weights(info.indexBits);
+        for (uint32_t i = 0; i < (1u << info.indexBits); ++i)
+            weights[i] = intWeights[i] / 64.0f;
+
+        uint32_t bestError = QuantizeBC7Subset(pixels, mask, info, endpoints, subset, indices);
+        for (uint32_t iteration = 0; iteration < iterations && bestError > 0; ++iteration)
+        {
+            if (!RefineLine(pixels, mask, indices, weights, channels, endpoints))
+                break;
+
+            BC7Subset candidate;
+            uint8_t candidateIndices[16];
+            memcpy(candidateIndices, indices, sizeof(candidateIndices));
+            const uint32_t error = QuantizeBC7Subset(pixels, mask, info, endpoints, &candidate, candidateIndices);
+            if (error >= bestError)
+                break;
+
+            bestError = error;
+            *subset = candidate;
+            memcpy(indices, candidateIndices, sizeof(candidateIndices));
+        }
+
+        return bestError;
+    }
+
+    uint32_t GetSubsetMask(const BC7ModeInfo& info, uint32_t partition, uint32_t subset)
+    {
+        if (info.subsets == 1)
+            return 0xFFFF;
+        return subset == 0 ? (uint32_t)(~kPartitions2[partition] & 0xFFFF) : kPartitions2[partition];
+    }
+
+    void EncodeBC7Mode(const BlockPixels pixels, const BC7ModeInfo& info, uint32_t partition, uint32_t iterations, BC7Candidate* best)
+    {
+        BC7Candidate candidate;
+        candidate.info = &info;
+        candidate.partition = partition;
+        candidate.error = 0;
+        for (uint32_t s = 0; s < info.subsets && candidate.error < best->error; ++s)
+        {
+            candidate.error += EncodeBC7Subset(pixels, GetSubsetMask(info, partition, s), info, iterations, &candidate.subsets[s], candidate.indices);
+        }
+
+        if (candidate.error < best->error)
+            *best = candidate;
+    }
+
+    struct PixelMoments
+    {
+        float count;
+        float sum[4];
+        // Upper triangle of the sum of outer products.
+        float products[10];
+    };
+
+    void AddMoments(PixelMoments& moments, const uint8_t* pixel)
+    {
+        moments.count += 1.0f;
+        for (uint32_t i = 0, k = 0; i < 4; ++i)
+        {
+            moments.sum[i] += pixel[i];
+            for (uint32_t j = i; j < 4; ++j, ++k)
+                moments.products[k] += (float)(pixel[i] * pixel[j]);
+        }
+    }
+
+    // Squared distance of the pixels to their principal axis: trace of the covariance minus its largest eigenvalue.
+    float EstimateLineError(const PixelMoments& moments, uint32_t channels)
+    {
+        if (moments.count < 1.0f)
+            return 0.0f;
+
+        float covariance[4][4];
+        for (uint32_t i = 0, k = 0; i < 4; ++i)
+        {
+            for (uint32_t j = i; j < 4; ++j, ++k)
+            {
+                covariance[i][j] = moments.products[k] - moments.sum[i] * moments.sum[j] / moments.count;
+                covariance[j][i] = covariance[i][j];
+            }
+        }
+
+        float trace = 0.0f;
+        float axis[4] = {};
+        uint32_t largest = 0;
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            trace += covariance[c][c];
+            largest = covariance[c][c] > covariance[largest][largest] ? c : largest;
+        }
+        if (trace <= 0.0f)
+            return 0.0f;
+
+        for (uint32_t c = 0; c < channels; ++c)
+            axis[c] = covariance[largest][c];
+
+        float eigenvalue = 0.0f;
+        for (uint32_t iteration = 0; iteration < 4; ++iteration)
+        {
+            float next[4] = {};
+            float length = 0.0f;
+            for (uint32_t i = 0; i < channels; ++i)
+            {
+                for (uint32_t j = 0; j < channels; ++j)
+                    next[i] += covariance[i][j] * axis[j];
+                length += next[i] * next[i];
+            }
+            if (length <= 0.0f)
+                break;
+
+            // Rayleigh quotient of the current axis.
+            float axisLength = 0.0f;
+            float projection = 0.0f;
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                axisLength += axis[c] * axis[c];
+                projection += axis[c] * next[c];
+            }
+            eigenvalue = projection / axisLength;
+
+            const float scale = 1.0f / sqrtf(length);
+            for (uint32_t c = 0; c < channels; ++c)
+                axis[c] = next[c] * scale;
+        }
+
+        const float error = trace - eigenvalue;
+        return error > 0.0f ? error : 0.0f;
+    }
+
+    // Rank the 2-subset partitions by how well each subset fits a line, only the best few get fully encoded.
+    void RankPartitions(const BlockPixels pixels, uint32_t channels, uint32_t count, uint32_t* partitions)
+    {
+        PixelMoments total = {};
+        for (uint32_t p = 0; p < 16; ++p)
+            AddMoments(total, pixels[p]);
+
+        float errors[64];
+        for (uint32_t partition = 0; partition < 64; ++partition)
+        {
+            PixelMoments second = {};
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                if (kPartitions2[partition] & (1u << p))
+                    AddMoments(second, pixels[p]);
+            }
+
+            PixelMoments first = total;
+            first.count -= second.count;
+            for (uint32_t c = 0; c < 4; ++c)
+                first.sum[c] -= second.sum[c];
+            for (uint32_t k = 0; k < 10; ++k)
+                first.products[k] -= second.products[k];
+
+            errors[partition] = EstimateLineError(first, channels) + EstimateLineError(second, channels);
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t best = 0;
+            for (uint32_t p = 1; p < 64; ++p)
+            {
+                if (errors[p] < errors[best])
+                    best = p;
+            }
+            partitions[i] = best;
+            errors[best] = 1e30f;
+        }
+    }
+
+    void WriteBC7Block(BC7Candidate& candidate, uint8_t* block)
+    {
+        const BC7ModeInfo& info = *candidate.info;
+        const uint32_t maxIndex = (1u << info.indexBits) - 1;
+
+        // The anchor index of every subset must have its top bit clear, otherwise swap the endpoints.
+        for (uint32_t s = 0; s < info.subsets; ++s)
+        {
+            const uint32_t anchor = s == 0 ? 0 : kAnchors2[candidate.partition];
+            if (candidate.indices[anchor] <= maxIndex / 2)
+                continue;
+
+            BC7Subset& subset = candidate.subsets[s];
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const uint8_t swap = subset.endpoints[0][c];
+                subset.endpoints[0][c] = subset.endpoints[1][c];
+                subset.endpoints[1][c] = swap;
+            }
+            const uint8_t swap = subset.pbits[0];
+            subset.pbits[0] = subset.pbits[1];
+            subset.pbits[1] = swap;
+
+            const uint32_t mask = GetSubsetMask(info, candidate.partition, s);
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                if (mask & (1u << p))
+                    candidate.indices[p] = (uint8_t)(maxIndex - candidate.indices[p]);
+            }
+        }
+
+        memset(block, 0, 16);
+        BitWriter writer = { block, 0 };
+        writer.Write(1u << info.mode, info.mode + 1);
+        if (info.subsets > 1)
+            writer.Write(candidate.partition, 6);
+
+        const uint32_t channels = info.alphaBits ? 4 : 3;
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            for (uint32_t s = 0; s < info.subsets; ++s)
+            {
+                writer.Write(candidate.subsets[s].endpoints[0][c], c < 3 ? info.colorBits : info.alphaBits);
+                writer.Write(candidate.subsets[s].endpoints[1][c], c < 3 ? info.colorBits : info.alphaBits);
+            }
+        }
+
+        for (uint32_t s = 0; s < info.subsets; ++s)
+        {
+            if (info.pbitMode == 1)
+            {
+                writer.Write(candidate.subsets[s].pbits[0], 1);
+            }
+            else if (info.pbitMode == 2)
+            {
+                writer.Write(candidate.subsets[s].pbits[0], 1);
+                writer.Write(candidate.subsets[s].pbits[1], 1);
+            }
+        }
+
+        const uint32_t anchor2 = info.subsets > 1 ? kAnchors2[candidate.partition] : 0;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            const bool anchor = p == 0 || (info.subsets > 1 && p == anchor2);
+            writer.Write(candidate.indices[p], anchor ? info.indexBits - 1 : info.indexBits);
+        }
+
+        ALIMER_ASSERT(writer.position == 128);
+    }
+
+    // Mode 5: RGB 7-bit and alpha 8-bit endpoints with separate 2-bit color and alpha indices, no rotation.
+    uint32_t EncodeBC7Mode5(const BlockPixels pixels, uint32_t iterations, uint8_t* block)
+    {
+        BlockPixels color;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            memcpy(color[p], pixels[p], 3);
+            color[p][3] = 255;
+        }
+
+        const BC7ModeInfo colorInfo = { 5, 1, 7, 0, 0, 2 };
+        BC7Subset subset;
+        uint8_t colorIndices[16];
+        const uint32_t colorError = EncodeBC7Subset(color, 0xFFFF, colorInfo, iterations, &subset, colorIndices);
+
+        int32_t alpha0 = 255;
+        int32_t alpha1 = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            alpha0 = pixels[p][3] < alpha0 ? pixels[p][3] : alpha0;
+            alpha1 = pixels[p][3] > alpha1 ? pixels[p][3] : alpha1;
+        }
+
+        uint8_t alphaIndices[16];
+        uint32_t alphaError = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            uint32_t bestError = UINT32_MAX;
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                const int32_t diff = (int32_t)pixels[p][3] - Interpolate((uint32_t)alpha0, (uint32_t)alpha1, kWeights2[i]);
+                if ((uint32_t)(diff * diff) < bestError)
+                {
+                    bestError = (uint32_t)(diff * diff);
+                    alphaIndices[p] = (uint8_t)i;
+                }
+            }
+            alphaError += bestError;
+        }
+
+        if (!block)
+            return colorError + alphaError;
+
+        if (colorIndices[0] > 1)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                const uint8_t swap = subset.endpoints[0][c];
+                subset.endpoints[0][c] = subset.endpoints[1][c];
+                subset.endpoints[1][c] = swap;
+            }
+            for (uint32_t p = 0; p < 16; ++p)
+                colorIndices[p] = (uint8_t)(3 - colorIndices[p]);
+        }
+
+        if (alphaIndices[0] > 1)
+        {
+            const int32_t swap = alpha0;
+            alpha0 = alpha1;
+            alpha1 = swap;
+            for (uint32_t p = 0; p < 16; ++p)
+                alphaIndices[p] = (uint8_t)(3 - alphaIndices[p]);
+        }
+
+        memset(block, 0, 16);
+        BitWriter writer = { block, 0 };
+        writer.Write(1u << 5, 6);
+        writer.Write(0, 2);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            writer.Write(subset.endpoints[0][c], 7);
+            writer.Write(subset.endpoints[1][c], 7);
+        }
+        writer.Write((uint32_t)alpha0, 8);
+        writer.Write((uint32_t)alpha1, 8);
+        for (uint32_t p = 0; p < 16; ++p)
+            writer.Write(colorIndices[p], p == 0 ? 1 : 2);
+        for (uint32_t p = 0; p < 16; ++p)
+            writer.Write(alphaIndices[p], p == 0 ? 1 : 2);
+
+        ALIMER_ASSERT(writer.position == 128);
+        return colorError + alphaError;
+    }
+
+    // Fast: mode 6 only. Normal adds the best 2-subset partitions (mode 1 for opaque blocks, mode 5 and 7 with alpha).
+    // High searches more partitions and adds mode 3.
+    void EncodeBC7(const BlockPixels pixels, uint8_t* block, ImageCompressQuality quality)
+    {
+        bool opaque = true;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            if (pixels[p][3] != 255)
+                opaque = false;
+        }
+
+        const uint32_t iterations = quality == ImageCompressQuality_Fast ? 1 : 2;
+        BC7Candidate best = {};
+        best.error = UINT32_MAX;
+        EncodeBC7Mode(pixels, kBC7Mode6, 0, iterations, &best);
+
+        if (quality != ImageCompressQuality_Fast && best.error > 0)
+        {
+            const uint32_t partitionCount = quality == ImageCompressQuality_High ? 16 : 4;
+            uint32_t partitions[16];
+            RankPartitions(pixels, opaque ? 3 : 4, partitionCount, partitions);
+            for (uint32_t i = 0; i < partitionCount && best.error > 0; ++i)
+            {
+                if (opaque)
+                {
+                    EncodeBC7Mode(pixels, kBC7Mode1, partitions[i], iterations, &best);
+                    if (quality == ImageCompressQuality_High)
+                        EncodeBC7Mode(pixels, kBC7Mode3, partitions[i], iterations, &best);
+                }
+                else
+                {
+                    EncodeBC7Mode(pixels, kBC7Mode7, partitions[i], iterations, &best);
+                }
+            }
+
+            if (!opaque && EncodeBC7Mode5(pixels, iterations, nullptr) < best.error)
+            {
+                EncodeBC7Mode5(pixels, iterations, block);
+                return;
+            }
+        }
+
+        WriteBC7Block(best, block);
+    }
+
+    /* Decoding */
+    // Three subset partitions, two bits per pixel.
+    const uint32_t kPartitions3[64] = {
+        0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+        0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+        0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+        0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+        0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+        0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+        0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+        0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+    };
+
+    // Anchor pixels of the second and third subsets.
+    const uint8_t kAnchors3[2][64] = {
+        {
+            3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+            3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+            8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+            3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+        },
+        {
+            15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+            15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+            15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+            15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+        },
+    };
+
+    // Reads the fields of a 128-bit block from its lowest bit up.
+    struct BitReader
+    {
+        uint64_t low;
+        uint64_t high;
+
+        explicit BitReader(const uint8_t* block)
+        {
+            memcpy(&low, block, sizeof(uint64_t));
+            memcpy(&high, block + 8, sizeof(uint64_t));
+        }
+
+        uint32_t Read(uint32_t count)
+        {
+            if (count == 0)
+                return 0;
+
+            const uint32_t value = (uint32_t)(low & ((1ull << count) - 1));
+            low = (low >> count) | (high << (64 - count));
+            high >>= count;
+            return value;
+        }
+    };
+
+    inline uint32_t LoadBits32(const uint8_t* data)
+    {
+        return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    }
+
+    inline uint64_t LoadBits48(const uint8_t* data)
+    {
+        return (uint64_t)LoadBits32(data) | ((uint64_t)data[4] << 32) | ((uint64_t)data[5] << 40);
+    }
+
+    // Per channel blend ((64 - w) * e0 + w * e1 + 32) >> 6 of the 16 pixels of a block.
+    void InterpolatePixels(const BlockPixels e0, const BlockPixels e1, const BlockPixels weights, BlockPixels pixels)
+    {
+#if defined(ALIMER_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(64);
+        const __m128i half = _mm_set1_epi16(32);
+        for (uint32_t p = 0; p < 16; p += 4)
+        {
+            const __m128i a = _mm_loadu_si128((const __m128i*)e0[p]);
+            const __m128i b = _mm_loadu_si128((const __m128i*)e1[p]);
+            const __m128i w = _mm_loadu_si128((const __m128i*)weights[p]);
+            __m128i result[2];
+            for (uint32_t i = 0; i < 2; ++i)
+            {
+                const __m128i a16 = i ? _mm_unpackhi_epi8(a, zero) : _mm_unpacklo_epi8(a, zero);
+                const __m128i b16 = i ? _mm_unpackhi_epi8(b, zero) : _mm_unpacklo_epi8(b, zero);
+                const __m128i w16 = i ? _mm_unpackhi_epi8(w, zero) : _mm_unpacklo_epi8(w, zero);
+                __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a16, _mm_sub_epi16(full, w16)), _mm_mullo_epi16(b16, w16));
+                result[i] = _mm_srli_epi16(_mm_add_epi16(sum, half), 6);
+            }
+            _mm_storeu_si128((__m128i*)pixels[p], _mm_packus_epi16(result[0], result[1]));
+        }
+#elif defined(ALIMER_NEON)
+        const uint8x16_t full = vdupq_n_u8(64);
+        for (uint32_t p = 0; p < 16; p += 4)
+        {
+            const uint8x16_t a = vld1q_u8(e0[p]);
+            const uint8x16_t b = vld1q_u8(e1[p]);
+            const uint8x16_t w = vld1q_u8(weights[p]);
+            const uint8x16_t inverse = vsubq_u8(full, w);
+            uint16x8_t low = vmlal_u8(vmull_u8(vget_low_u8(a), vget_low_u8(inverse)), vget_low_u8(b), vget_low_u8(w));
+            uint16x8_t high = vmlal_u8(vmull_u8(vget_high_u8(a), vget_high_u8(inverse)), vget_high_u8(b), vget_high_u8(w));
+            vst1q_u8(pixels[p], vcombine_u8(vrshrn_n_u16(low, 6), vrshrn_n_u16(high, 6)));
+        }
+#else
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            for (uint32_t c = 0; c < 4; ++c)
+                pixels[p][c] = Interpolate(e0[p][c], e1[p][c], weights[p][c]);
+        }
+#endif
+    }
+
+    void DecodeBC1(const uint8_t* block, bool allowAlpha, BlockPixels pixels)
+    {
+        const uint16_t color0 = (uint16_t)(block[0] | (block[1] << 8));
+        const uint16_t color1 = (uint16_t)(block[2] | (block[3] << 8));
+        const bool fourColors = !allowAlpha || color0 > color1;
+        uint8_t palette[4][4];
+        BuildBC1Palette(color0, color1, fourColors, palette);
+        for (uint32_t i = 0; i < 4; ++i)
+            palette[i][3] = 255;
+        if (!fourColors)
+            palette[3][3] = 0;
+
+        const uint32_t indices = LoadBits32(block + 4);
+        for (uint32_t p = 0; p < 16; ++p)
+            memcpy(pixels[p], palette[(indices >> (2 * p)) & 3], 4);
+    }
+
+    void DecodeBC2Alpha(const uint8_t* block, BlockPixels pixels)
+    {
+        for (uint32_t p = 0; p < 16; ++p)
+            pixels[p][3] = (uint8_t)(((block[p / 2] >> ((p & 1) * 4)) & 15) * 17);
+    }
+
+    // Snorm endpoints of -128 decode as -127, the values are stored as two's complement bytes.
+    void DecodeBC4(const uint8_t* block, bool snorm, uint32_t channel, BlockPixels pixels)
+    {
+        int32_t e0 = snorm ? (int8_t)block[0] : block[0];
+        int32_t e1 = snorm ? (int8_t)block[1] : block[1];
+        if (snorm)
+        {
+            e0 = e0 < -127 ? -127 : e0;
+            e1 = e1 < -127 ? -127 : e1;
+        }
+
+        int32_t palette[8];
+        BuildBC4Palette(e0, e1, snorm, palette);
+        const uint64_t indices = LoadBits48(block + 2);
+        for (uint32_t p = 0; p < 16; ++p)
+            pixels[p][channel] = (uint8_t)palette[(indices >> (3 * p)) & 7];
+    }
+
+    struct BC7ModeLayout
+    {
+        uint32_t subsets;
+        uint32_t partitionBits;
+        uint32_t rotationBits;
+        uint32_t indexSelectionBits;
+        uint32_t colorBits;
+        uint32_t alphaBits;
+        // 1 when every endpoint has a p-bit, 2 when the endpoints of a subset share one.
+        uint32_t pbitMode;
+        uint32_t indexBits;
+        uint32_t secondaryIndexBits;
+    };
+
+    const BC7ModeLayout kBC7Layouts[8] = {
+        { 3, 4, 0, 0, 4, 0, 1, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, 2, 3, 0 },
+        { 3, 6, 0, 0, 5, 0, 0, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, 1, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, 0, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, 0, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, 1, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, 1, 2, 0 },
+    };
+
+    uint32_t GetBC7Subset(uint32_t subsets, uint32_t partition, uint32_t pixel)
+    {
+        if (subsets == 2)
+            return (kPartitions2[partition] >> pixel) & 1;
+        if (subsets == 3)
+            return (kPartitions3[partition] >> (2 * pixel)) & 3;
+        return 0;
+    }
+
+    // Reserved mode blocks decode to transparent black.
+    void DecodeBC7(const uint8_t* block, BlockPixels pixels)
+    {
+        uint32_t mode = 0;
+        while (mode < 8 && !(block[0] & (1u << mode)))
+            mode++;
+        if (mode == 8)
+        {
+            memset(pixels, 0, sizeof(BlockPixels));
+            return;
+        }
+
+        const BC7ModeLayout& layout = kBC7Layouts[mode];
+        BitReader reader(block);
+        reader.Read(mode + 1);
+        const uint32_t partition = reader.Read(layout.partitionBits);
+        const uint32_t rotation = reader.Read(layout.rotationBits);
+        const uint32_t indexSelection = reader.Read(layout.indexSelectionBits);
+
+        const uint32_t endpointCount = layout.subsets * 2;
+        uint32_t endpoints[6][4];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            const uint32_t bits = c < 3 ? layout.colorBits : layout.alphaBits;
+            for (uint32_t e = 0; e < endpointCount; ++e)
+                endpoints[e][c] = reader.Read(bits);
+        }
+
+        uint32_t pbits[6] = {};
+        if (layout.pbitMode == 1)
+        {
+            for (uint32_t e = 0; e < endpointCount; ++e)
+                pbits[e] = reader.Read(1);
+        }
+        else if (layout.pbitMode == 2)
+        {
+            for (uint32_t s = 0; s < layout.subsets; ++s)
+                pbits[s * 2] = pbits[s * 2 + 1] = reader.Read(1);
+        }
+
+        uint8_t expanded[6][4];
+        for (uint32_t e = 0; e < endpointCount; ++e)
+        {
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const uint32_t bits = c < 3 ? layout.colorBits : layout.alphaBits;
+                if (bits == 0)
+                    expanded[e][c] = 255;
+                else if (layout.pbitMode == 0)
+                    expanded[e][c] = (uint8_t)ExpandBits(endpoints[e][c], bits);
+                else
+                    expanded[e][c] = (uint8_t)ExpandBits((endpoints[e][c] << 1) | pbits[e], bits + 1);
+            }
+        }
+
+        // Anchor pixels store their index without the top bit.
+        uint8_t subsets[16];
+        uint8_t indices[16];
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            subsets[p] = (uint8_t)GetBC7Subset(layout.subsets, partition, p);
+            bool anchor = p == 0;
+            if (layout.subsets == 2)
+                anchor = anchor || p == kAnchors2[partition];
+            else if (layout.subsets == 3)
+                anchor = anchor || p == kAnchors3[0][partition] || p == kAnchors3[1][partition];
+            indices[p] = (uint8_t)reader.Read(layout.indexBits - (anchor ? 1 : 0));
+        }
+
+        uint8_t secondary[16] = {};
+        if (layout.secondaryIndexBits)
+        {
+            for (uint32_t p = 0; p < 16; ++p)
+                secondary[p] = (uint8_t)reader.Read(layout.secondaryIndexBits - (p == 0 ? 1 : 0));
+        }
+
+        const uint8_t* colorWeights = GetBC7Weights(indexSelection ? layout.secondaryIndexBits : layout.indexBits);
+        const uint8_t* alphaWeights = GetBC7Weights(layout.secondaryIndexBits && !indexSelection ? layout.secondaryIndexBits : layout.indexBits);
+        BlockPixels e0, e1, weights;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            memcpy(e0[p], expanded[subsets[p] * 2], 4);
+            memcpy(e1[p], expanded[subsets[p] * 2 + 1], 4);
+            const uint32_t colorIndex = indexSelection ? secondary[p] : indices[p];
+            const uint32_t alphaIndex = layout.secondaryIndexBits && !indexSelection ? secondary[p] : indices[p];
+            weights[p][0] = weights[p][1] = weights[p][2] = colorWeights[colorIndex];
+            weights[p][3] = alphaWeights[alphaIndex];
+        }
+
+        InterpolatePixels(e0, e1, weights, pixels);
+        if (rotation)
+        {
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                const uint8_t swap = pixels[p][3];
+                pixels[p][3] = pixels[p][rotation - 1];
+                pixels[p][rotation - 1] = swap;
+            }
+        }
+    }
+
+    /* BC6H */
+    // A run of endpoint (or partition) bits in stream order, from bit first to bit last of the field.
+    struct BC6HRun
+    {
+        // 0 for the partition, otherwise 1 + endpoint * 3 + channel.
+        uint8_t field;
+        uint8_t first;
+        uint8_t last;
+    };
+
+    struct BC6HMode
+    {
+        uint8_t header;
+        uint8_t regions;
+        bool transformed;
+        uint8_t endpointBits;
+        uint8_t deltaBits[3];
+        uint8_t runCount;
+        BC6HRun runs[22];
+    };
+
+    const BC6HMode kBC6HModes[14] = {
+        { 0x00, 2, true, 10, { 5, 5, 5 }, 20, { { 8, 4, 4 }, { 9, 4, 4 }, { 12, 4, 4 }, { 1, 0, 9 }, { 2, 0, 9 }, { 3, 0, 9 }, { 4, 0, 4 }, { 11, 4, 4 }, { 8, 0, 3 }, { 5, 0, 4 }, { 12, 0, 0 }, { 11, 0, 3 }, { 6, 0, 4 }, { 12, 1, 1 }, { 9, 0, 3 }, { 7, 0, 4 }, { 12, 2, 2 }, { 10, 0, 4 }, { 12, 3, 3 }, { 0, 0, 4 } } },
+        { 0x01, 2, true, 7, { 6, 6, 6 }, 21, { { 8, 5, 5 }, { 11, 4, 5 }, { 1, 0, 6 }, { 12, 0, 1 }, { 9, 4, 4 }, { 2, 0, 6 }, { 9, 5, 5 }, { 12, 2, 2 }, { 8, 4, 4 }, { 3, 0, 6 }, { 12, 3, 3 }, { 12, 5, 4 }, { 4, 0, 5 }, { 8, 0, 3 }, { 5, 0, 5 }, { 11, 0, 3 }, { 6, 0, 5 }, { 9, 0, 3 }, { 7, 0, 5 }, { 10, 0, 5 }, { 0, 0, 4 } } },
+        { 0x02, 2, true, 11, { 5, 4, 4 }, 19, { { 1, 0, 9 }, { 2, 0, 9 }, { 3, 0, 9 }, { 4, 0, 4 }, { 1, 10, 10 }, { 8, 0, 3 }, { 5, 0, 3 }, { 2, 10, 10 }, { 12, 0, 0 }, { 11, 0, 3 }, { 6, 0, 3 }, { 3, 10, 10 }, { 12, 1, 1 }, { 9, 0, 3 }, { 7, 0, 4 }, { 12, 2, 2 }, { 10, 0, 4 }, { 12, 3, 3 }, { 0, 0, 4 } } },
+        { 0x06, 2, true, 11, { 4, 5, 4 }, 21, { { 1, 0, 9 }, { 2, 0, 9 }, { 3, 0, 9 }, { 4, 0, 3 }, { 1, 10, 10 }, { 11, 4, 4 }, { 8, 0, 3 }, { 5, 0, 4 }, { 2, 10, 10 }, { 11, 0, 3 }, { 6, 0, 3 }, { 3, 10, 10 }, { 12, 1, 1 }, { 9, 0, 3 }, { 7, 0, 3 }, { 12, 0, 0 }, { 12, 2, 2 }, { 10, 0, 3 }, { 8, 4, 4 }, { 12, 3, 3 }, { 0, 0, 4 } } },
+        { 0x0A, 2, true, 11, { 4, 4, 5 }, 19, { { 1, 0, 9 }, { 2, 0, 9 }, { 3, 0, 9 }, { 4, 0, 3 }, { 1, 10, 10 }, { 9, 4, 4 }, { 8, 0, 3 }, { 5, 0, 3 }, { 2, 10, 10 }, { 12, 0, 0 }, { 11, 0, 3 }, { 6, 0, 4 }, { 3, 10, 10 }, { 9, 0, 3 }, { 7, 0, 3 }, { 12, 1, 2 }, { 10, 0, 3 }, { 12, 4, 3 }, { 0, 0, 4 } } },
+        { 0x0E, 2, true, 9, { 5, 5, 5 }, 20, { { 1, 0, 8 }, { 9, 4, 4 }, { 2, 0, 8 }, { 8, 4, 4 }, { 3, 0, 8 }, { 12, 4, 4 }, { 4, 0, 4 }, { 11, 4, 4 }, { 8, 0, 3 }, { 5, 0, 4 }, { 12, 0, 0 }, { 11, 0, 3 }, { 6, 0, 4 }, { 12, 1, 1 }, { 9, 0, 3 }, { 7, 0, 4 }, { 12, 2, 2 }, { 10, 0, 4 }, { 12, 3, 3 }, { 0, 0, 4 } } },
+        { 0x12, 2, true, 8, { 6, 5, 5 }, 19, { { 1, 0, 7 }, { 11, 4, 4 }, { 9, 4, 4 }, { 2, 0, 7 }, { 12, 2, 2 }, { 8, 4, 4 }, { 3, 0, 7 }, { 12, 3, 4 }, { 4, 0, 5 }, { 8, 0, 3 }, { 5, 0, 4 }, { 12, 0, 0 }, { 11, 0, 3 }, { 6, 0, 4 }, { 12, 1, 1 }, { 9, 0, 3 }, { 7, 0, 5 }, { 10, 0, 5 }, { 0, 0, 4 } } },
+        { 0x16, 2, true, 8, { 5, 6, 5 }, 21, { { 1, 0, 7 }, { 12, 0, 0 }, { 9, 4, 4 }, { 2, 0, 7 }, { 8, 5, 4 }, { 3, 0, 7 }, { 11, 5, 5 }, { 12, 4, 4 }, { 4, 0, 4 }, { 11, 4, 4 }, { 8, 0, 3 }, { 5, 0, 5 }, { 11, 0, 3 }, { 6, 0, 4 }, { 12, 1, 1 }, { 9, 0, 3 }, { 7, 0, 4 }, { 12, 2, 2 }, { 10, 0, 4 }, { 12, 3, 3 }, { 0, 0, 4 } } },
+        { 0x1A, 2, true, 8, { 5, 5, 6 }, 21, { { 1, 0, 7 }, { 12, 1, 1 }, { 9, 4, 4 }, { 2, 0, 7 }, { 9, 5, 5 }, { 8, 4, 4 }, { 3, 0, 7 }, { 12, 5, 4 }, { 4, 0, 4 }, { 11, 4, 4 }, { 8, 0, 3 }, { 5, 0, 4 }, { 12, 0, 0 }, { 11, 0, 3 }, { 6, 0, 5 }, { 9, 0, 3 }, { 7, 0, 4 }, { 12, 2, 2 }, { 10, 0, 4 }, { 12, 3, 3 }, { 0, 0, 4 } } },
+        { 0x1E, 2, false, 6, { 6, 6, 6 }, 22, { { 1, 0, 5 }, { 11, 4, 4 }, { 12, 0, 1 }, { 9, 4, 4 }, { 2, 0, 5 }, { 8, 5, 5 }, { 9, 5, 5 }, { 12, 2, 2 }, { 8, 4, 4 }, { 3, 0, 5 }, { 11, 5, 5 }, { 12, 3, 3 }, { 12, 5, 4 }, { 4, 0, 5 }, { 8, 0, 3 }, { 5, 0, 5 }, { 11, 0, 3 }, { 6, 0, 5 }, { 9, 0, 3 }, { 7, 0, 5 }, { 10, 0, 5 }, { 0, 0, 4 } } },
+        { 0x03, 1, false, 10, { 10, 10, 10 }, 6, { { 1, 0, 9 }, { 2, 0, 9 }, { 3, 0, 9 }, { 4, 0, 9 }, { 5, 0, 9 }, { 6, 0, 9 } } },
+        { 0x07, 1, true, 11, { 9, 9, 9 }, 9, { { 1, 0, 9 }, { 2, 0, 9 }, { 3, 0, 9 }, { 4, 0, 8 }, { 1, 10, 10 }, { 5, 0, 8 }, { 2, 10, 10 }, { 6, 0, 8 }, { 3, 10, 10 } } },
+        { 0x0B, 1, true, 12, { 8, 8, 8 }, 9, { { 1, 0, 9 }, { 2, 0, 9 }, { 3, 0, 9 }, { 4, 0, 7 }, { 1, 11, 10 }, { 5, 0, 7 }, { 2, 11, 10 }, { 6, 0, 7 }, { 3, 11, 10 } } },
+        { 0x0F, 1, true, 16, { 4, 4, 4 }, 9, { { 1, 0, 9 }, { 2, 0, 9 }, { 3, 0, 9 }, { 4, 0, 3 }, { 1, 15, 10 }, { 5, 0, 3 }, { 2, 15, 10 }, { 6, 0, 3 }, { 3, 15, 10 } } },
+    };
+
+    inline int32_t SignExtend(int32_t value, uint32_t bits)
+    {
+        const int32_t shift = 32 - (int32_t)bits;
+        return (int32_t)((uint32_t)value << shift) >> shift;
+    }
+
+    int32_t UnquantizeBC6H(int32_t value, uint32_t bits, bool isSigned)
+    {
+        if (!isSigned)
+        {
+            if (bits >= 15 || value == 0)
+                return value;
+            if (value == (1 << bits) - 1)
+                return 0xFFFF;
+            return ((value << 16) + 0x8000) >> bits;
+        }
+
+        if (bits >= 16)
+            return value;
+
+        const bool negative = value < 0;
+        const int32_t magnitude = negative ? -value : value;
+        int32_t result;
+        if (magnitude == 0)
+            result = 0;
+        else if (magnitude >= (1 << (bits - 1)) - 1)
+            result = 0x7FFF;
+        else
+            result = ((magnitude << 15) + 0x4000) >> (bits - 1);
+        return negative ? -result : result;
+    }
+
+    // Interpolated values are scaled to the half float bit patterns, the signed format keeps the sign bit apart.
+    inline uint16_t FinishBC6H(int32_t value, bool isSigned)
+    {
+        if (!isSigned)
+            return (uint16_t)((value * 31) >> 6);
+        return value < 0 ? (uint16_t)(0x8000 | ((-value * 31) >> 5)) : (uint16_t)((value * 31) >> 5);
+    }
+
+    // Reserved mode blocks decode to black, pixels receive RGBA half floats.
+    void DecodeBC6H(const uint8_t* block, bool isSigned, uint16_t pixels[16][4])
+    {
+        BitReader reader(block);
+        uint32_t header = reader.Read(2);
+        if (header > 1)
+            header |= reader.Read(3) << 2;
+
+        const BC6HMode* mode = nullptr;
+        for (uint32_t i = 0; i < ALIMER_ARRAYSIZE(kBC6HModes); ++i)
+        {
+            if (kBC6HModes[i].header == header)
+                mode = &kBC6HModes[i];
+        }
+
+        if (!mode)
+        {
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                pixels[p][0] = pixels[p][1] = pixels[p][2] = 0;
+                pixels[p][3] = 0x3C00;
+            }
+            return;
+        }
+
+        int32_t endpoints[4][3] = {};
+        uint32_t partition = 0;
+        for (uint32_t r = 0; r < mode->runCount; ++r)
+        {
+            const BC6HRun& run = mode->runs[r];
+            const int32_t step = run.first <= run.last ? 1 : -1;
+            for (int32_t bit = run.first;; bit += step)
+            {
+                const uint32_t value = reader.Read(1);
+                if (run.field == 0)
+                    partition |= value << bit;
+                else
+                    endpoints[(run.field - 1) / 3][(run.field - 1) % 3] |= (int32_t)(value << bit);
+                if (bit == run.last)
+                    break;
+            }
+        }
+
+        // Transformed modes store the other endpoints as deltas of the first one.
+        const uint32_t endpointCount = mode->regions * 2u;
+        const int32_t mask = (1 << mode->endpointBits) - 1;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            if (isSigned)
+                endpoints[0][c] = SignExtend(endpoints[0][c], mode->endpointBits);
+            for (uint32_t e = 1; e < endpointCount; ++e)
+            {
+                if (mode->transformed)
+                {
+                    const int32_t value = (endpoints[0][c] + SignExtend(endpoints[e][c], mode->deltaBits[c])) & mask;
+                    endpoints[e][c] = isSigned ? SignExtend(value, mode->endpointBits) : value;
+                }
+                else if (isSigned)
+                {
+                    endpoints[e][c] = SignExtend(endpoints[e][c], mode->endpointBits);
+                }
+            }
+        }
+
+        for (uint32_t e = 0; e < endpointCount; ++e)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+                endpoints[e][c] = UnquantizeBC6H(endpoints[e][c], mode->endpointBits, isSigned);
+        }
+
+        const uint32_t indexBits = mode->regions == 2 ? 3 : 4;
+        const uint8_t* weights = GetBC7Weights(indexBits);
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            const uint32_t subset = GetBC7Subset(mode->regions, partition, p);
+            const bool anchor = p == 0 || (mode->regions == 2 && p == kAnchors2[partition]);
+            const int32_t weight = weights[reader.Read(indexBits - (anchor ? 1 : 0))];
+            const int32_t* e0 = endpoints[subset * 2];
+            const int32_t* e1 = endpoints[subset * 2 + 1];
+            for (uint32_t c = 0; c < 3; ++c)
+                pixels[p][c] = FinishBC6H((e0[c] * (64 - weight) + e1[c] * weight + 32) >> 6, isSigned);
+            pixels[p][3] = 0x3C00;
+        }
+    }
+}
+
+bool alimerIsBlockEncodable(PixelFormat format)
+{
+    switch (format)
+    {
+        case PixelFormat_BC1RGBAUnorm:
+        case PixelFormat_BC1RGBAUnormSrgb:
+        case PixelFormat_BC2RGBAUnorm:
+        case PixelFormat_BC2RGBAUnormSrgb:
+        case PixelFormat_BC3RGBAUnorm:
+        case PixelFormat_BC3RGBAUnormSrgb:
+        case PixelFormat_BC4RUnorm:
+        case PixelFormat_BC4RSnorm:
+        case PixelFormat_BC5RGUnorm:
+        case PixelFormat_BC5RGSnorm:
+        case PixelFormat_BC7RGBAUnorm:
+        case PixelFormat_BC7RGBAUnormSrgb:
+        case PixelFormat_ETC2RGB8Unorm:
+        case PixelFormat_ETC2RGB8UnormSrgb:
+        case PixelFormat_ETC2RGB8A1Unorm:
+        case PixelFormat_ETC2RGB8A1UnormSrgb:
+        case PixelFormat_ETC2RGBA8Unorm:
+        case PixelFormat_ETC2RGBA8UnormSrgb:
+        case PixelFormat_EACR11Unorm:
+        case PixelFormat_EACR11Snorm:
+        case PixelFormat_EACRG11Unorm:
+        case PixelFormat_EACRG11Snorm:
+            return true;
+        default:
+            return IsASTCCompressedFormat(format);
+    }
+}
+
+void alimerEncodeBlock(PixelFormat format, const uint8_t* pixels, void* block, ImageCompressQuality quality)
+{
+    if (IsASTCCompressedFormat(format))
+    {
+        PixelFormatInfo info;
+        GetPixelFormatInfo(format, &info);
+        alimerEncodeASTCBlock(info.blockWidth, info.blockHeight, IsSrgbFormat(format), pixels, block, quality);
+        return;
+    }
+
+    const BlockPixels& input = *(const BlockPixels*)pixels;
+    uint8_t* output = (uint8_t*)block;
+    const uint32_t iterations = quality == ImageCompressQuality_Fast ? 1 : (quality == ImageCompressQuality_Normal ? 2 : 4);
+    const uint32_t searchRadius = quality == ImageCompressQuality_Fast ? 0 : (quality == ImageCompressQuality_Normal ? 2 : 4);
+
+    switch (format)
+    {
+        case PixelFormat_BC1RGBAUnorm:
+        case PixelFormat_BC1RGBAUnormSrgb:
+            EncodeBC1(input, output, true, iterations);
+            break;
+        case PixelFormat_BC2RGBAUnorm:
+        case PixelFormat_BC2RGBAUnormSrgb:
+            EncodeBC2Alpha(input, output);
+            EncodeBC1(input, output + 8, false, iterations);
+            break;
+        case PixelFormat_BC3RGBAUnorm:
+        case PixelFormat_BC3RGBAUnormSrgb:
+            EncodeBC4Channel(input, 3, false, output, searchRadius);
+            EncodeBC1(input, output + 8, false, iterations);
+            break;
+        case PixelFormat_BC4RUnorm:
+        case PixelFormat_BC4RSnorm:
+            EncodeBC4Channel(input, 0, format == PixelFormat_BC4RSnorm, output, searchRadius);
+            break;
+        case PixelFormat_BC5RGUnorm:
+        case PixelFormat_BC5RGSnorm:
+            EncodeBC4Channel(input, 0, format == PixelFormat_BC5RGSnorm, output, searchRadius);
+            EncodeBC4Channel(input, 1, format == PixelFormat_BC5RGSnorm, output + 8, searchRadius);
+            break;
+        case PixelFormat_BC7RGBAUnorm:
+        case PixelFormat_BC7RGBAUnormSrgb:
+            EncodeBC7(input, output, quality);
+            break;
+        case PixelFormat_ETC2RGB8Unorm:
+        case PixelFormat_ETC2RGB8UnormSrgb:
+        case PixelFormat_ETC2RGB8A1Unorm:
+        case PixelFormat_ETC2RGB8A1UnormSrgb:
+        case PixelFormat_ETC2RGBA8Unorm:
+        case PixelFormat_ETC2RGBA8UnormSrgb:
+        case PixelFormat_EACR11Unorm:
+        case PixelFormat_EACR11Snorm:
+        case PixelFormat_EACRG11Unorm:
+        case PixelFormat_EACRG11Snorm:
+            alimerEncodeETCBlock(format, pixels, block, quality);
+            break;
+        default:
+            ALIMER_ASSERT(false);
+            break;
+    }
+}
+
+PixelFormat alimerGetBlockDecodeFormat(PixelFormat format)
+{
+    switch (format)
+    {
+        case PixelFormat_BC4RSnorm:
+        case PixelFormat_BC5RGSnorm:
+            return PixelFormat_RGBA8Snorm;
+        case PixelFormat_BC6HRGBUfloat:
+        case PixelFormat_BC6HRGBFloat:
+            return PixelFormat_RGBA16Float;
+        case PixelFormat_EACR11Unorm:
+        case PixelFormat_EACRG11Unorm:
+            return PixelFormat_RGBA16Unorm;
+        case PixelFormat_EACR11Snorm:
+        case PixelFormat_EACRG11Snorm:
+            return PixelFormat_RGBA16Snorm;
+        default:
+            return IsSrgbFormat(format) ? PixelFormat_RGBA8UnormSrgb : PixelFormat_RGBA8Unorm;
+    }
+}
+
+void alimerDecodeBlocks(PixelFormat format, const void* blocks, uint32_t blockCount, void* pixels, size_t rowPitch)
+{
+    PixelFormatInfo info;
+    GetPixelFormatInfo(format, &info);
+    if (IsASTCCompressedFormat(format))
+    {
+        alimerDecodeASTCBlocks(info.blockWidth, info.blockHeight, IsSrgbFormat(format), blocks, blockCount, pixels, rowPitch);
+        return;
+    }
+
+    if (!IsBCCompressedFormat(format))
+    {
+        alimerDecodeETCBlocks(format, blocks, blockCount, pixels, rowPitch);
+        return;
+    }
+
+    const uint8_t* input = (const uint8_t*)blocks;
+    uint8_t* output = (uint8_t*)pixels;
+    const bool snorm = format == PixelFormat_BC4RSnorm || format == PixelFormat_BC5RGSnorm;
+    for (uint32_t b = 0; b < blockCount; ++b, input += info.bytesPerBlock)
+    {
+        if (format == PixelFormat_BC6HRGBUfloat || format == PixelFormat_BC6HRGBFloat)
+        {
+            uint16_t decoded[16][4];
+            DecodeBC6H(input, format == PixelFormat_BC6HRGBFloat, decoded);
+            for (uint32_t y = 0; y < 4; ++y)
+                memcpy(output + y * rowPitch + b * 32, decoded[y * 4], 32);
+            continue;
+        }
+
+        BlockPixels decoded;
+        switch (format)
+        {
+            case PixelFormat_BC1RGBAUnorm:
+            case PixelFormat_BC1RGBAUnormSrgb:
+                DecodeBC1(input, true, decoded);
+                break;
+            case PixelFormat_BC2RGBAUnorm:
+            case PixelFormat_BC2RGBAUnormSrgb:
+                DecodeBC1(input + 8, false, decoded);
+                DecodeBC2Alpha(input, decoded);
+                break;
+            case PixelFormat_BC3RGBAUnorm:
+            case PixelFormat_BC3RGBAUnormSrgb:
+                DecodeBC1(input + 8, false, decoded);
+                DecodeBC4(input, false, 3, decoded);
+                break;
+            case PixelFormat_BC4RUnorm:
+            case PixelFormat_BC4RSnorm:
+            case PixelFormat_BC5RGUnorm:
+            case PixelFormat_BC5RGSnorm:
+                for (uint32_t p = 0; p < 16; ++p)
+                {
+                    decoded[p][1] = decoded[p][2] = 0;
+                    decoded[p][3] = snorm ? 127 : 255;
+                }
+                DecodeBC4(input, snorm, 0, decoded);
+                if (format == PixelFormat_BC5RGUnorm || format == PixelFormat_BC5RGSnorm)
+                    DecodeBC4(input + 8, snorm, 1, decoded);
+                break;
+            default:
+                DecodeBC7(input, decoded);
+                break;
+        }
+
+        for (uint32_t y = 0; y < 4; ++y)
+            memcpy(output + y * rowPitch + b * 16, decoded[y * 4], 16);
+    }
+}
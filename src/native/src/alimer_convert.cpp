@@ -0,0 +1,1024 @@
+// Copyright (c) Amer Koleci and Contributors.
+// Licensed under the MIT License (MIT). See LICENSE in the repository root for more information.
+
+#include "alimer_internal.h"
+#include <float.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define ALIMER_SSE2 1
+#endif
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define ALIMER_AVX2 1
+#endif
+
+// MSVC doesn't define __F16C__, every AVX2 CPU has it.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#   include <immintrin.h>
+#   define ALIMER_F16C 1
+#endif
+
+// AArch64 only, the kernels use the ARMv8 half and min/max instructions.
+#if defined(__aarch64__) || defined(_M_ARM64)
+#   include <arm_neon.h>
+#   define ALIMER_NEON 1
+#endif
+
+// Pixel conversion goes through RGBA float: every format has an unpack and a pack function, the common pairs
+// (swizzles, sRGB on 8-bit data, 32-bit float to half) skip the intermediate entirely.
+namespace
+{
+    constexpr uint32_t kChunkSize = 256;
+
+    struct FormatCodec;
+    typedef void (*UnpackFunc)(const FormatCodec& codec, const uint8_t* src, float* dst, uint32_t count);
+    typedef void (*PackFunc)(const FormatCodec& codec, const float* src, uint8_t* dst, uint32_t count);
+
+    struct FormatCodec
+    {
+        PixelFormatKind kind;
+        // Channel count and bits per channel, 0 bits for packed formats.
+        uint32_t channels;
+        uint32_t bits;
+        // Red and blue are stored swapped.
+        bool bgra;
+        UnpackFunc unpack;
+        PackFunc pack;
+    };
+
+    inline uint32_t AsUint(float value)
+    {
+        uint32_t result;
+        memcpy(&result, &value, sizeof(float));
+        return result;
+    }
+
+    inline float AsFloat(uint32_t value)
+    {
+        float result;
+        memcpy(&result, &value, sizeof(float));
+        return result;
+    }
+
+    // NaN goes to the lower bound.
+    inline float Clamp(float value, float low, float high)
+    {
+        return value > low ? (value < high ? value : high) : low;
+    }
+
+    inline int32_t Round(float value)
+    {
+        return (int32_t)(value >= 0.0f ? value + 0.5f : value - 0.5f);
+    }
+
+    inline uint32_t ToUnorm(float value, float maxValue)
+    {
+        return (uint32_t)(Clamp(value, 0.0f, 1.0f) * maxValue + 0.5f);
+    }
+
+    // Round to nearest even, overflow goes to infinity and NaN stays NaN.
+    uint16_t FloatToHalf(float value)
+    {
+        uint32_t f = AsUint(value);
+        const uint32_t sign = f & 0x80000000u;
+        f ^= sign;
+
+        uint32_t result;
+        if (f >= (143u << 23))
+        {
+            result = f > (255u << 23) ? 0x7E00u : 0x7C00u;
+        }
+        else if (f < (113u << 23))
+        {
+            // Denormal, let the FPU do the rounding.
+            const uint32_t magic = 126u << 23;
+            result = AsUint(AsFloat(f) + AsFloat(magic)) - magic;
+        }
+        else
+        {
+            const uint32_t mantissaOdd = (f >> 13) & 1;
+            f += (uint32_t)(15 - 127) << 23;
+            f += 0xFFF + mantissaOdd;
+            result = f >> 13;
+        }
+
+        return (uint16_t)(result | (sign >> 16));
+    }
+
+    float HalfToFloat(uint16_t value)
+    {
+        const uint32_t exponentMask = 0x7C00u << 13;
+        uint32_t result = (uint32_t)(value & 0x7FFF) << 13;
+        const uint32_t exponent = result & exponentMask;
+        result += (uint32_t)(127 - 15) << 23;
+        if (exponent == exponentMask)
+        {
+            // Infinity or NaN.
+            result += (uint32_t)(128 - 16) << 23;
+        }
+        else if (exponent == 0)
+        {
+            result += 1u << 23;
+            result = AsUint(AsFloat(result) - AsFloat(113u << 23));
+        }
+
+        return AsFloat(result | ((uint32_t)(value & 0x8000) << 16));
+    }
+
+    // Unsigned floats with a 5-bit exponent (bias 15) of RG11B10: 6 mantissa bits for red/green, 5 for blue.
+    uint32_t FloatToSmallFloat(float value, uint32_t mantissaBits)
+    {
+        const uint32_t exponentAll = 0x1Fu << mantissaBits;
+        const uint32_t maxValue = exponentAll - 1;
+        const uint32_t f = AsUint(value);
+        if ((f & 0x7FFFFFFF) > 0x7F800000)
+            return exponentAll | 1;
+        if (f & 0x80000000u)
+            return 0;
+        if (f == 0x7F800000)
+            return exponentAll;
+
+        // Largest finite value is (2 - 2^-m) * 2^15.
+        if (f >= ((127u + 16u) << 23))
+            return maxValue;
+
+        if (f < (113u << 23))
+            return (uint32_t)(value * AsFloat((127u + 14u + mantissaBits) << 23) + 0.5f);
+
+        const uint32_t shift = 23 - mantissaBits;
+        const uint32_t biased = f + ((uint32_t)(15 - 127) << 23);
+        const uint32_t result = (biased + (1u << (shift - 1)) - 1 + ((biased >> shift) & 1)) >> shift;
+        return result < maxValue ? result : maxValue;
+    }
+
+    float SmallFloatToFloat(uint32_t value, uint32_t mantissaBits)
+    {
+        const uint32_t exponent = value >> mantissaBits;
+        const uint32_t mantissa = value & ((1u << mantissaBits) - 1);
+        if (exponent == 0x1F)
+            return AsFloat(mantissa ? 0x7FC00000u : 0x7F800000u);
+        if (exponent == 0)
+            return (float)mantissa * AsFloat((127u - 14u - mantissaBits) << 23);
+
+        return AsFloat(((exponent + 127 - 15) << 23) | (mantissa << (23 - mantissaBits)));
+    }
+
+    // Shared exponent format, follows the EXT_texture_shared_exponent encoding.
+    uint32_t FloatToRGB9E5(const float* rgb)
+    {
+        const float maxValue = 65408.0f;
+        const float r = Clamp(rgb[0], 0.0f, maxValue);
+        const float g = Clamp(rgb[1], 0.0f, maxValue);
+        const float b = Clamp(rgb[2], 0.0f, maxValue);
+        const float maxChannel = r > g ? (r > b ? r : b) : (g > b ? g : b);
+
+        int32_t exponent = (int32_t)((AsUint(maxChannel) >> 23) & 0xFF) - 127;
+        exponent = (exponent < -16 ? -16 : exponent) + 16;
+        if ((uint32_t)(maxChannel * AsFloat((uint32_t)(127 + 24 - exponent) << 23) + 0.5f) == 512)
+            exponent++;
+
+        const float scale = AsFloat((uint32_t)(127 + 24 - exponent) << 23);
+        const uint32_t rm = (uint32_t)(r * scale + 0.5f);
+        const uint32_t gm = (uint32_t)(g * scale + 0.5f);
+        const uint32_t bm = (uint32_t)(b * scale + 0.5f);
+        return rm | (gm << 9) | (bm << 18) | ((uint32_t)exponent << 27);
+    }
+
+    void RGB9E5ToFloat(uint32_t value, float* rgb)
+    {
+        const float scale = AsFloat(((value >> 27) + 127 - 24) << 23);
+        rgb[0] = (float)(value & 0x1FF) * scale;
+        rgb[1] = (float)((value >> 9) & 0x1FF) * scale;
+        rgb[2] = (float)((value >> 18) & 0x1FF) * scale;
+    }
+
+    // Linear values below 2^-13 encode to 0, above that the float bits index the table (11 mantissa bits per octave).
+    constexpr uint32_t kSrgbTableBits = 12;
+    constexpr uint32_t kSrgbTableMin = (127u - 13u) << 23;
+    constexpr uint32_t kSrgbTableSize = ((127u << 23) - kSrgbTableMin) >> kSrgbTableBits;
+
+    float SrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    struct SrgbTables
+    {
+        float toLinear[256];
+        uint8_t fromLinear[kSrgbTableSize];
+        // 8-bit to 8-bit in both directions.
+        uint8_t toLinear8[256];
+        uint8_t toSrgb8[256];
+
+        SrgbTables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                toLinear[i] = SrgbToLinear(i / 255.0f);
+                toLinear8[i] = (uint8_t)(toLinear[i] * 255.0f + 0.5f);
+                toSrgb8[i] = (uint8_t)(LinearToSrgb(i / 255.0f) * 255.0f + 0.5f);
+            }
+
+            // Each entry is evaluated at the center of its bucket.
+            for (uint32_t i = 0; i < kSrgbTableSize; ++i)
+            {
+                const float value = AsFloat(kSrgbTableMin + (i << kSrgbTableBits) + (1u << (kSrgbTableBits - 1)));
+                fromLinear[i] = (uint8_t)(LinearToSrgb(value) * 255.0f + 0.5f);
+            }
+        }
+
+        uint8_t Encode(float value) const
+        {
+            const uint32_t bits = AsUint(value);
+            if (!(value >= AsFloat(kSrgbTableMin)))
+                return 0;
+            if (value >= 1.0f)
+                return 255;
+            return fromLinear[(bits - kSrgbTableMin) >> kSrgbTableBits];
+        }
+    };
+
+    const SrgbTables& GetSrgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    /* Half arrays */
+    void HalfToFloatArray(const uint16_t* src, float* dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(ALIMER_F16C) && defined(ALIMER_AVX2)
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+        }
+#endif
+#if defined(ALIMER_F16C)
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(dst + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(src + i))));
+        }
+#elif defined(ALIMER_NEON)
+        for (; i + 4 <= count; i += 4)
+        {
+            vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            dst[i] = HalfToFloat(src[i]);
+        }
+    }
+
+    void FloatToHalfArray(const float* src, uint16_t* dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(ALIMER_F16C) && defined(ALIMER_AVX2)
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm_storeu_si128((__m128i*)(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+        }
+#endif
+#if defined(ALIMER_F16C)
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storel_epi64((__m128i*)(dst + i), _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+        }
+#elif defined(ALIMER_NEON)
+        for (; i + 4 <= count; i += 4)
+        {
+            vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            dst[i] = FloatToHalf(src[i]);
+        }
+    }
+
+    /* 8-bit RGBA kernels */
+    void SwizzleRedBlue(const uint8_t* src, uint8_t* dst, uint32_t count)
+    {
+        uint32_t i = 0;
+#if defined(ALIMER_AVX2)
+        const __m256i greenAlpha256 = _mm256_set1_epi32((int)0xFF00FF00);
+        const __m256i low256 = _mm256_set1_epi32(0xFF);
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i value = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+            const __m256i red = _mm256_slli_epi32(_mm256_and_si256(value, low256), 16);
+            const __m256i blue = _mm256_and_si256(_mm256_srli_epi32(value, 16), low256);
+            const __m256i result = _mm256_or_si256(_mm256_and_si256(value, greenAlpha256), _mm256_or_si256(red, blue));
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), result);
+        }
+#endif
+#if defined(ALIMER_SSE2)
+        const __m128i greenAlpha = _mm_set1_epi32((int)0xFF00FF00);
+        const __m128i low = _mm_set1_epi32(0xFF);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i value = _mm_loadu_si128((const __m128i*)(src + i * 4));
+            const __m128i red = _mm_slli_epi32(_mm_and_si128(value, low), 16);
+            const __m128i blue = _mm_and_si128(_mm_srli_epi32(value, 16), low);
+            _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_and_si128(value, greenAlpha), _mm_or_si128(red, blue)));
+        }
+#elif defined(ALIMER_NEON)
+        for (; i + 16 <= count; i += 16)
+        {
+            uint8x16x4_t value = vld4q_u8(src + i * 4);
+            const uint8x16_t red = value.val[0];
+            value.val[0] = value.val[2];
+            value.val[2] = red;
+            vst4q_u8(dst + i * 4, value);
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            const uint8_t red = src[i * 4 + 0];
+            dst[i * 4 + 0] = src[i * 4 + 2];
+            dst[i * 4 + 1] = src[i * 4 + 1];
+            dst[i * 4 + 2] = red;
+            dst[i * 4 + 3] = src[i * 4 + 3];
+        }
+    }
+
+    // sRGB <-> linear on 8-bit data, with an optional red/blue swap.
+    void ConvertTransfer8(const uint8_t* table, bool swizzle, const uint8_t* src, uint8_t* dst, uint32_t count)
+    {
+        const uint32_t red = swizzle ? 2 : 0;
+        const uint32_t blue = swizzle ? 0 : 2;
+        for (uint32_t i = 0; i < count; ++i, src += 4, dst += 4)
+        {
+            const uint8_t r = table[src[red]];
+            const uint8_t g = table[src[1]];
+            const uint8_t b = table[src[blue]];
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+            dst[3] = src[3];
+        }
+    }
+
+    void UnpackUnorm8x4(const FormatCodec& codec, const uint8_t* src, float* dst, uint32_t count)
+    {
+        uint32_t i = 0;
+#if defined(ALIMER_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i value = _mm_loadu_si128((const __m128i*)(src + i * 4));
+            const __m128i low = _mm_unpacklo_epi8(value, zero);
+            const __m128i high = _mm_unpackhi_epi8(value, zero);
+            __m128 pixels[4] = {
+                _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale),
+                _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale),
+                _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale),
+                _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale),
+            };
+            for (uint32_t p = 0; p < 4; ++p)
+            {
+                if (codec.bgra)
+                    pixels[p] = _mm_shuffle_ps(pixels[p], pixels[p], _MM_SHUFFLE(3, 0, 1, 2));
+                _mm_storeu_ps(dst + (i + p) * 4, pixels[p]);
+            }
+        }
+#elif defined(ALIMER_NEON)
+        const float32x4_t scale = vdupq_n_f32(1.0f / 255.0f);
+        for (; i + 8 <= count; i += 8)
+        {
+            const uint8x8x4_t value = vld4_u8(src + i * 4);
+            float32x4x4_t low;
+            float32x4x4_t high;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const uint16x8_t wide = vmovl_u8(value.val[codec.bgra && c != 1 && c != 3 ? 2 - c : c]);
+                low.val[c] = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide))), scale);
+                high.val[c] = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(wide))), scale);
+            }
+            vst4q_f32(dst + i * 4, low);
+            vst4q_f32(dst + i * 4 + 16, high);
+        }
+#endif
+        const uint32_t red = codec.bgra ? 2 : 0;
+        const uint32_t blue = codec.bgra ? 0 : 2;
+        for (; i < count; ++i)
+        {
+            dst[i * 4 + 0] = src[i * 4 + red] * (1.0f / 255.0f);
+            dst[i * 4 + 1] = src[i * 4 + 1] * (1.0f / 255.0f);
+            dst[i * 4 + 2] = src[i * 4 + blue] * (1.0f / 255.0f);
+            dst[i * 4 + 3] = src[i * 4 + 3] * (1.0f / 255.0f);
+        }
+    }
+
+    void PackUnorm8x4(const FormatCodec& codec, const float* src, uint8_t* dst, uint32_t count)
+    {
+        uint32_t i = 0;
+#if defined(ALIMER_SSE2)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i pixels[4];
+            for (uint32_t p = 0; p < 4; ++p)
+            {
+                __m128 value = _mm_loadu_ps(src + (i + p) * 4);
+                if (codec.bgra)
+                    value = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 0, 1, 2));
+                // max returns the second operand for NaN.
+                value = _mm_min_ps(_mm_max_ps(value, zero), one);
+                pixels[p] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+            }
+            const __m128i low = _mm_packs_epi32(pixels[0], pixels[1]);
+            const __m128i high = _mm_packs_epi32(pixels[2], pixels[3]);
+            _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(low, high));
+        }
+#elif defined(ALIMER_NEON)
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t scale = vdupq_n_f32(255.0f);
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        for (; i + 8 <= count; i += 8)
+        {
+            const float32x4x4_t low = vld4q_f32(src + i * 4);
+            const float32x4x4_t high = vld4q_f32(src + i * 4 + 16);
+            uint8x8x4_t value;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                // vmaxnm returns the number for NaN.
+                const float32x4_t l = vminq_f32(vmaxnmq_f32(low.val[c], zero), one);
+                const float32x4_t h = vminq_f32(vmaxnmq_f32(high.val[c], zero), one);
+                const uint32x4_t li = vcvtq_u32_f32(vaddq_f32(vmulq_f32(l, scale), half));
+                const uint32x4_t hi = vcvtq_u32_f32(vaddq_f32(vmulq_f32(h, scale), half));
+                value.val[codec.bgra && c != 1 && c != 3 ? 2 - c : c] = vmovn_u16(vcombine_u16(vmovn_u32(li), vmovn_u32(hi)));
+            }
+            vst4_u8(dst + i * 4, value);
+        }
+#endif
+        const uint32_t red = codec.bgra ? 2 : 0;
+        const uint32_t blue = codec.bgra ? 0 : 2;
+        for (; i < count; ++i)
+        {
+            dst[i * 4 + red] = (uint8_t)ToUnorm(src[i * 4 + 0], 255.0f);
+            dst[i * 4 + 1] = (uint8_t)ToUnorm(src[i * 4 + 1], 255.0f);
+            dst[i * 4 + blue] = (uint8_t)ToUnorm(src[i * 4 + 2], 255.0f);
+            dst[i * 4 + 3] = (uint8_t)ToUnorm(src[i * 4 + 3], 255.0f);
+        }
+    }
+
+    void UnpackSrgb8x4(const FormatCodec& codec, const uint8_t* src, float* dst, uint32_t count)
+    {
+        const float* table = GetSrgbTables().toLinear;
+        const uint32_t red = codec.bgra ? 2 : 0;
+        const uint32_t blue = codec.bgra ? 0 : 2;
+        for (uint32_t i = 0; i < count; ++i, src += 4, dst += 4)
+        {
+            dst[0] = table[src[red]];
+            dst[1] = table[src[1]];
+            dst[2] = table[src[blue]];
+            dst[3] = src[3] * (1.0f / 255.0f);
+        }
+    }
+
+    void PackSrgb8x4(const FormatCodec& codec, const float* src, uint8_t* dst, uint32_t count)
+    {
+        const SrgbTables& tables = GetSrgbTables();
+        const uint32_t red = codec.bgra ? 2 : 0;
+        const uint32_t blue = codec.bgra ? 0 : 2;
+        for (uint32_t i = 0; i < count; ++i, src += 4, dst += 4)
+        {
+            dst[red] = tables.Encode(src[0]);
+            dst[1] = tables.Encode(src[1]);
+            dst[blue] = tables.Encode(src[2]);
+            dst[3] = (uint8_t)ToUnorm(src[3], 255.0f);
+        }
+    }
+
+    void UnpackHalf4(const FormatCodec& codec, const uint8_t* src, float* dst, uint32_t count)
+    {
+        ALIMER_UNUSED(codec);
+        HalfToFloatArray((const uint16_t*)src, dst, (size_t)count * 4);
+    }
+
+    void PackHalf4(const FormatCodec& codec, const float* src, uint8_t* dst, uint32_t count)
+    {
+        ALIMER_UNUSED(codec);
+        FloatToHalfArray(src, (uint16_t*)dst, (size_t)count * 4);
+    }
+
+    void UnpackFloat4(const FormatCodec& codec, const uint8_t* src, float* dst, uint32_t count)
+    {
+        ALIMER_UNUSED(codec);
+        memcpy(dst, src, (size_t)count * 4 * sizeof(float));
+    }
+
+    void PackFloat4(const FormatCodec& codec, const float* src, uint8_t* dst, uint32_t count)
+    {
+        ALIMER_UNUSED(codec);
+        memcpy(dst, src, (size_t)count * 4 * sizeof(float));
+    }
+
+    /* Generic formats, 1 to 4 channels of the same size */
+    template<typename T>
+    void UnpackChannels(const FormatCodec& codec, const uint8_t* src, float* dst, uint32_t count, float scale, float minValue)
+    {
+        const T* values = (const T*)src;
+        for (uint32_t i = 0; i < count; ++i, values += codec.channels, dst += 4)
+        {
+            float pixel[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            for (uint32_t c = 0; c < codec.channels; ++c)
+            {
+                const float value = (float)values[c] * scale;
+                pixel[c] = value > minValue ? value : minValue;
+            }
+
+            dst[0] = pixel[codec.bgra ? 2 : 0];
+            dst[1] = pixel[1];
+            dst[2] = pixel[codec.bgra ? 0 : 2];
+            dst[3] = pixel[3];
+        }
+    }
+
+    // Values are clamped to [low, high], scaled and rounded to nearest.
+    template<typename T>
+    void PackChannels(const FormatCodec& codec, const float* src, uint8_t* dst, uint32_t count, float low, float high, float scale)
+    {
+        T* values = (T*)dst;
+        for (uint32_t i = 0; i < count; ++i, values += codec.channels, src += 4)
+        {
+            const float pixel[4] = { src[codec.bgra ? 2 : 0], src[1], src[codec.bgra ? 0 : 2], src[3] };
+            for (uint32_t c = 0; c < codec.channels; ++c)
+            {
+                values[c] = (T)Round(Clamp(pixel[c], low, high) * scale);
+            }
+        }
+    }
+
+    // 32-bit integers don't fit a float, clamp and round in double precision.
+    template<typename T>
+    void PackChannels32(const FormatCodec& codec, const float* src, uint8_t* dst, uint32_t count, double low, double high)
+    {
+        T* values = (T*)dst;
+        for (uint32_t i = 0; i < count; ++i, values += codec.channels, src += 4)
+        {
+            for (uint32_t c = 0; c < codec.channels; ++c)
+            {
+                const double value = src[c];
+                const double clamped = value > low ? (value < high ? value : high) : low;
+                values[c] = (T)floor(clamped + 0.5);
+            }
+        }
+    }
+
+    void UnpackGeneric(const FormatCodec& codec, const uint8_t* src, float* dst, uint32_t count)
+    {
+        switch (codec.bits)
+        {
+            case 8:
+                if (codec.kind == PixelFormatKind_Unorm)
+                    UnpackChannels<uint8_t>(codec, src, dst, count, 1.0f / 255.0f, 0.0f);
+                else if (codec.kind == PixelFormatKind_Snorm)
+                    UnpackChannels<int8_t>(codec, src, dst, count, 1.0f / 127.0f, -1.0f);
+                else if (codec.kind == PixelFormatKind_Uint)
+                    UnpackChannels<uint8_t>(codec, src, dst, count, 1.0f, 0.0f);
+                else
+                    UnpackChannels<int8_t>(codec, src, dst, count, 1.0f, -FLT_MAX);
+                break;
+
+            case 16:
+                if (codec.kind == PixelFormatKind_Unorm)
+                    UnpackChannels<uint16_t>(codec, src, dst, count, 1.0f / 65535.0f, 0.0f);
+                else if (codec.kind == PixelFormatKind_Snorm)
+                    UnpackChannels<int16_t>(codec, src, dst, count, 1.0f / 32767.0f, -1.0f);
+                else if (codec.kind == PixelFormatKind_Uint)
+                    UnpackChannels<uint16_t>(codec, src, dst, count, 1.0f, 0.0f);
+                else if (codec.kind == PixelFormatKind_Sint)
+                    UnpackChannels<int16_t>(codec, src, dst, count, 1.0f, -FLT_MAX);
+                else
+                {
+                    const uint16_t* values = (const uint16_t*)src;
+                    for (uint32_t i = 0; i < count; ++i, values += codec.channels, dst += 4)
+                    {
+                        dst[0] = HalfToFloat(values[0]);
+                        dst[1] = codec.channels > 1 ? HalfToFloat(values[1]) : 0.0f;
+                        dst[2] = 0.0f;
+                        dst[3] = 1.0f;
+                    }
+                }
+                break;
+
+            case 32:
+                if (codec.kind == PixelFormatKind_Uint)
+                    UnpackChannels<uint32_t>(codec, src, dst, count, 1.0f, 0.0f);
+                else if (codec.kind == PixelFormatKind_Sint)
+                    UnpackChannels<int32_t>(codec, src, dst, count, 1.0f, -FLT_MAX);
+                else
+                    UnpackChannels<float>(codec, src, dst, count, 1.0f, -FLT_MAX);
+                break;
+        }
+    }
+
+    void PackGeneric(const FormatCodec& codec, const float* src, uint8_t* dst, uint32_t count)
+    {
+        switch (codec.bits)
+        {
+            case 8:
+                if (codec.kind == PixelFormatKind_Unorm)
+                    PackChannels<uint8_t>(codec, src, dst, count, 0.0f, 1.0f, 255.0f);
+                else if (codec.kind == PixelFormatKind_Snorm)
+                    PackChannels<int8_t>(codec, src, dst, count, -1.0f, 1.0f, 127.0f);
+                else if (codec.kind == PixelFormatKind_Uint)
+                    PackChannels<uint8_t>(codec, src, dst, count, 0.0f, 255.0f, 1.0f);
+                else
+                    PackChannels<int8_t>(codec, src, dst, count, -128.0f, 127.0f, 1.0f);
+                break;
+
+            case 16:
+                if (codec.kind == PixelFormatKind_Unorm)
+                    PackChannels<uint16_t>(codec, src, dst, count, 0.0f, 1.0f, 65535.0f);
+                else if (codec.kind == PixelFormatKind_Snorm)
+                    PackChannels<int16_t>(codec, src, dst, count, -1.0f, 1.0f, 32767.0f);
+                else if (codec.kind == PixelFormatKind_Uint)
+                    PackChannels<uint16_t>(codec, src, dst, count, 0.0f, 65535.0f, 1.0f);
+                else if (codec.kind == PixelFormatKind_Sint)
+                    PackChannels<int16_t>(codec, src, dst, count, -32768.0f, 32767.0f, 1.0f);
+                else
+                {
+                    uint16_t* values = (uint16_t*)dst;
+                    for (uint32_t i = 0; i < count; ++i, values += codec.channels, src += 4)
+                    {
+                        for (uint32_t c = 0; c < codec.channels; ++c)
+                            values[c] = FloatToHalf(src[c]);
+                    }
+                }
+                break;
+
+            case 32:
+                if (codec.kind == PixelFormatKind_Uint)
+                    PackChannels32<uint32_t>(codec, src, dst, count, 0.0, 4294967295.0);
+                else if (codec.kind == PixelFormatKind_Sint)
+                    PackChannels32<int32_t>(codec, src, dst, count, -2147483648.0, 2147483647.0);
+                else
+                {
+                    float* values = (float*)dst;
+                    for (uint32_t i = 0; i < count; ++i, values += codec.channels, src += 4)
+                    {
+                        for (uint32_t c = 0; c < codec.channels; ++c)
+                            values[c] = src[c];
+                    }
+                }
+                break;
+        }
+    }
+
+    /* Packed formats */
+    void UnpackPacked(PixelFormat format, const uint8_t* src, float* dst, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i, dst += 4)
+        {
+            if (format == PixelFormat_BGRA4Unorm || format == PixelFormat_B5G6R5Unorm || format == PixelFormat_BGR5A1Unorm)
+            {
+                uint16_t v;
+                memcpy(&v, src + i * 2, sizeof(uint16_t));
+                if (format == PixelFormat_BGRA4Unorm)
+                {
+                    dst[0] = ((v >> 8) & 0xF) / 15.0f;
+                    dst[1] = ((v >> 4) & 0xF) / 15.0f;
+                    dst[2] = (v & 0xF) / 15.0f;
+                    dst[3] = (v >> 12) / 15.0f;
+                }
+                else if (format == PixelFormat_B5G6R5Unorm)
+                {
+                    dst[0] = (v >> 11) / 31.0f;
+                    dst[1] = ((v >> 5) & 0x3F) / 63.0f;
+                    dst[2] = (v & 0x1F) / 31.0f;
+                    dst[3] = 1.0f;
+                }
+                else
+                {
+                    dst[0] = ((v >> 10) & 0x1F) / 31.0f;
+                    dst[1] = ((v >> 5) & 0x1F) / 31.0f;
+                    dst[2] = (v & 0x1F) / 31.0f;
+                    dst[3] = (float)(v >> 15);
+                }
+                continue;
+            }
+
+            uint32_t v;
+            memcpy(&v, src + i * 4, sizeof(uint32_t));
+            switch (format)
+            {
+                case PixelFormat_RGB10A2Unorm:
+                    dst[0] = (v & 0x3FF) / 1023.0f;
+                    dst[1] = ((v >> 10) & 0x3FF) / 1023.0f;
+                    dst[2] = ((v >> 20) & 0x3FF) / 1023.0f;
+                    dst[3] = (v >> 30) / 3.0f;
+                    break;
+                case PixelFormat_RGB10A2Uint:
+                    dst[0] = (float)(v & 0x3FF);
+                    dst[1] = (float)((v >> 10) & 0x3FF);
+                    dst[2] = (float)((v >> 20) & 0x3FF);
+                    dst[3] = (float)(v >> 30);
+                    break;
+                case PixelFormat_RG11B10UFloat:
+                    dst[0] = SmallFloatToFloat(v & 0x7FF, 6);
+                    dst[1] = SmallFloatToFloat((v >> 11) & 0x7FF, 6);
+                    dst[2] = SmallFloatToFloat(v >> 22, 5);
+                    dst[3] = 1.0f;
+                    break;
+                default:
+                    RGB9E5ToFloat(v, dst);
+                    dst[3] = 1.0f;
+                    break;
+            }
+        }
+    }
+
+    void PackPacked(PixelFormat format, const float* src, uint8_t* dst, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i, src += 4)
+        {
+            uint32_t v;
+            switch (format)
+            {
+                case PixelFormat_BGRA4Unorm:
+                    v = ToUnorm(src[2], 15.0f) | (ToUnorm(src[1], 15.0f) << 4) | (ToUnorm(src[0], 15.0f) << 8) | (ToUnorm(src[3], 15.0f) << 12);
+                    break;
+                case PixelFormat_B5G6R5Unorm:
+                    v = ToUnorm(src[2], 31.0f) | (ToUnorm(src[1], 63.0f) << 5) | (ToUnorm(src[0], 31.0f) << 11);
+                    break;
+                case PixelFormat_BGR5A1Unorm:
+                    v = ToUnorm(src[2], 31.0f) | (ToUnorm(src[1], 31.0f) << 5) | (ToUnorm(src[0], 31.0f) << 10) | (ToUnorm(src[3], 1.0f) << 15);
+                    break;
+                case PixelFormat_RGB10A2Unorm:
+                    v = ToUnorm(src[0], 1023.0f) | (ToUnorm(src[1], 1023.0f) << 10) | (ToUnorm(src[2], 1023.0f) << 20) | (ToUnorm(src[3], 3.0f) << 30);
+                    break;
+                case PixelFormat_RGB10A2Uint:
+                    v = (uint32_t)Round(Clamp(src[0], 0.0f, 1023.0f)) | ((uint32_t)Round(Clamp(src[1], 0.0f, 1023.0f)) << 10) |
+                        ((uint32_t)Round(Clamp(src[2], 0.0f, 1023.0f)) << 20) | ((uint32_t)Round(Clamp(src[3], 0.0f, 3.0f)) << 30);
+                    break;
+                case PixelFormat_RG11B10UFloat:
+                    v = FloatToSmallFloat(src[0], 6) | (FloatToSmallFloat(src[1], 6) << 11) | (FloatToSmallFloat(src[2], 5) << 22);
+                    break;
+                default:
+                    v = FloatToRGB9E5(src);
+                    break;
+            }
+
+            if (format == PixelFormat_BGRA4Unorm || format == PixelFormat_B5G6R5Unorm || format == PixelFormat_BGR5A1Unorm)
+            {
+                const uint16_t value = (uint16_t)v;
+                memcpy(dst + i * 2, &value, sizeof(uint16_t));
+            }
+            else
+            {
+                memcpy(dst + i * 4, &v, sizeof(uint32_t));
+            }
+        }
+    }
+
+#define ALIMER_PACKED_CODEC(name, format) \
+    void Unpack##name(const FormatCodec& codec, const uint8_t* src, float* dst, uint32_t count) { ALIMER_UNUSED(codec); UnpackPacked(format, src, dst, count); } \
+    void Pack##name(const FormatCodec& codec, const float* src, uint8_t* dst, uint32_t count) { ALIMER_UNUSED(codec); PackPacked(format, src, dst, count); }
+
+    ALIMER_PACKED_CODEC(BGRA4, PixelFormat_BGRA4Unorm)
+    ALIMER_PACKED_CODEC(B5G6R5, PixelFormat_B5G6R5Unorm)
+    ALIMER_PACKED_CODEC(BGR5A1, PixelFormat_BGR5A1Unorm)
+    ALIMER_PACKED_CODEC(RGB10A2, PixelFormat_RGB10A2Unorm)
+    ALIMER_PACKED_CODEC(RGB10A2Uint, PixelFormat_RGB10A2Uint)
+    ALIMER_PACKED_CODEC(RG11B10, PixelFormat_RG11B10UFloat)
+    ALIMER_PACKED_CODEC(RGB9E5, PixelFormat_RGB9E5UFloat)
+
+#undef ALIMER_PACKED_CODEC
+
+    bool GetFormatCodec(PixelFormat format, FormatCodec* codec)
+    {
+        // Compressed and depth formats fall through the switch below.
+        PixelFormatInfo info;
+        if (!GetPixelFormatInfo(format, &info))
+            return false;
+
+        codec->kind = info.kind;
+        codec->channels = 0;
+        codec->bits = 0;
+        codec->bgra = false;
+        codec->unpack = UnpackGeneric;
+        codec->pack = PackGeneric;
+
+        switch (format)
+        {
+            case PixelFormat_R8Unorm:
+            case PixelFormat_R8Snorm:
+            case PixelFormat_R8Uint:
+            case PixelFormat_R8Sint:
+                codec->channels = 1;
+                codec->bits = 8;
+                return true;
+            case PixelFormat_R16Unorm:
+            case PixelFormat_R16Snorm:
+            case PixelFormat_R16Uint:
+            case PixelFormat_R16Sint:
+            case PixelFormat_R16Float:
+                codec->channels = 1;
+                codec->bits = 16;
+                return true;
+            case PixelFormat_R32Uint:
+            case PixelFormat_R32Sint:
+            case PixelFormat_R32Float:
+                codec->channels = 1;
+                codec->bits = 32;
+                return true;
+            case PixelFormat_RG8Unorm:
+            case PixelFormat_RG8Snorm:
+            case PixelFormat_RG8Uint:
+            case PixelFormat_RG8Sint:
+                codec->channels = 2;
+                codec->bits = 8;
+                return true;
+            case PixelFormat_RG16Unorm:
+            case PixelFormat_RG16Snorm:
+            case PixelFormat_RG16Uint:
+            case PixelFormat_RG16Sint:
+            case PixelFormat_RG16Float:
+                codec->channels = 2;
+                codec->bits = 16;
+                return true;
+            case PixelFormat_RG32Uint:
+            case PixelFormat_RG32Sint:
+            case PixelFormat_RG32Float:
+                codec->channels = 2;
+                codec->bits = 32;
+                return true;
+            case PixelFormat_RGBA8Unorm:
+            case PixelFormat_BGRA8Unorm:
+                codec->channels = 4;
+                codec->bits = 8;
+                codec->bgra = format == PixelFormat_BGRA8Unorm;
+                codec->unpack = UnpackUnorm8x4;
+                codec->pack = PackUnorm8x4;
+                return true;
+            case PixelFormat_RGBA8UnormSrgb:
+            case PixelFormat_BGRA8UnormSrgb:
+                codec->channels = 4;
+                codec->bits = 8;
+                codec->bgra = format == PixelFormat_BGRA8UnormSrgb;
+                codec->unpack = UnpackSrgb8x4;
+                codec->pack = PackSrgb8x4;
+                return true;
+            case PixelFormat_RGBA8Snorm:
+            case PixelFormat_RGBA8Uint:
+            case PixelFormat_RGBA8Sint:
+                codec->channels = 4;
+                codec->bits = 8;
+                return true;
+            case PixelFormat_RGBA16Unorm:
+            case PixelFormat_RGBA16Snorm:
+            case PixelFormat_RGBA16Uint:
+            case PixelFormat_RGBA16Sint:
+                codec->channels = 4;
+                codec->bits = 16;
+                return true;
+            case PixelFormat_RGBA16Float:
+                codec->channels = 4;
+                codec->bits = 16;
+                codec->unpack = UnpackHalf4;
+                codec->pack = PackHalf4;
+                return true;
+            case PixelFormat_RGBA32Uint:
+            case PixelFormat_RGBA32Sint:
+                codec->channels = 4;
+                codec->bits = 32;
+                return true;
+            case PixelFormat_RGBA32Float:
+                codec->channels = 4;
+                codec->bits = 32;
+                codec->unpack = UnpackFloat4;
+                codec->pack = PackFloat4;
+                return true;
+
+            case PixelFormat_BGRA4Unorm:
+                codec->unpack = UnpackBGRA4;
+                codec->pack = PackBGRA4;
+                return true;
+            case PixelFormat_B5G6R5Unorm:
+                codec->unpack = UnpackB5G6R5;
+                codec->pack = PackB5G6R5;
+                return true;
+            case PixelFormat_BGR5A1Unorm:
+                codec->unpack = UnpackBGR5A1;
+                codec->pack = PackBGR5A1;
+                return true;
+            case PixelFormat_RGB10A2Unorm:
+                codec->unpack = UnpackRGB10A2;
+                codec->pack = PackRGB10A2;
+                return true;
+            case PixelFormat_RGB10A2Uint:
+                codec->unpack = UnpackRGB10A2Uint;
+                codec->pack = PackRGB10A2Uint;
+                return true;
+            case PixelFormat_RG11B10UFloat:
+                codec->unpack = UnpackRG11B10;
+                codec->pack = PackRG11B10;
+                return true;
+            case PixelFormat_RGB9E5UFloat:
+                codec->unpack = UnpackRGB9E5;
+                codec->pack = PackRGB9E5;
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    bool IsRGBA8(PixelFormat format, bool* bgra, bool* srgb)
+    {
+        *bgra = format == PixelFormat_BGRA8Unorm || format == PixelFormat_BGRA8UnormSrgb;
+        *srgb = format == PixelFormat_RGBA8UnormSrgb || format == PixelFormat_BGRA8UnormSrgb;
+        return format == PixelFormat_RGBA8Unorm || format == PixelFormat_BGRA8Unorm || *srgb;
+    }
+
+    // Conversions that don't need the float intermediate.
+    bool ConvertDirect(const FormatCodec& srcCodec, PixelFormat srcFormat, const uint8_t* src, const FormatCodec& dstCodec, PixelFormat dstFormat, uint8_t* dst, uint32_t count)
+    {
+        bool srcBgra, srcSrgb, dstBgra, dstSrgb;
+        if (IsRGBA8(srcFormat, &srcBgra, &srcSrgb) && IsRGBA8(dstFormat, &dstBgra, &dstSrgb))
+        {
+            if (srcSrgb == dstSrgb)
+            {
+                SwizzleRedBlue(src, dst, count);
+            }
+            else
+            {
+                const SrgbTables& tables = GetSrgbTables();
+                ConvertTransfer8(srcSrgb ? tables.toLinear8 : tables.toSrgb8, srcBgra != dstBgra, src, dst, count);
+            }
+            return true;
+        }
+
+        // 32-bit float to half with the same channels.
+        if (srcCodec.kind == PixelFormatKind_Float && dstCodec.kind == PixelFormatKind_Float && srcCodec.channels == dstCodec.channels && srcCodec.channels > 0)
+        {
+            if (srcCodec.bits == 32 && dstCodec.bits == 16)
+            {
+                FloatToHalfArray((const float*)src, (uint16_t*)dst, (size_t)count * srcCodec.channels);
+                return true;
+            }
+
+            if (srcCodec.bits == 16 && dstCodec.bits == 32)
+            {
+                HalfToFloatArray((const uint16_t*)src, (float*)dst, (size_t)count * srcCodec.channels);
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+bool alimerIsConvertibleFormat(PixelFormat format)
+{
+    FormatCodec codec;
+    return GetFormatCodec(format, &codec);
+}
+
+bool alimerConvertPixels(PixelFormat srcFormat, const void* src, PixelFormat dstFormat, void* dst, uint32_t count)
+{
+    FormatCodec srcCodec;
+    FormatCodec dstCodec;
+    if (!GetFormatCodec(srcFormat, &srcCodec) || !GetFormatCodec(dstFormat, &dstCodec))
+        return false;
+
+    const uint32_t srcStride = GetFormatBytesPerBlock(srcFormat);
+    const uint32_t dstStride = GetFormatBytesPerBlock(dstFormat);
+    if (srcFormat == dstFormat)
+    {
+        memcpy(dst, src, (size_t)count * srcStride);
+        return true;
+    }
+
+    const uint8_t* srcBytes = (const uint8_t*)src;
+    uint8_t* dstBytes = (uint8_t*)dst;
+    if (ConvertDirect(srcCodec, srcFormat, srcBytes, dstCodec, dstFormat, dstBytes, count))
+        return true;
+
+    float temp[kChunkSize * 4];
+    for (uint32_t i = 0; i < count; i += kChunkSize)
+    {
+        const uint32_t chunk = count - i < kChunkSize ? count - i : kChunkSize;
+        srcCodec.unpack(srcCodec, srcBytes + (size_t)i * srcStride, temp, chunk);
+        dstCodec.pack(dstCodec, temp, dstBytes + (size_t)i * dstStride, chunk);
+    }
+
+    return true;
+}
@@ -0,0 +1,983 @@
+// Copyright (c) Amer Koleci and Contributors.
+// Licensed under the MIT License (MIT). See LICENSE in the repository root for more information.
+
+#include "alimer_internal.h"
+#include <atomic>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define ALIMER_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   include <arm_neon.h>
+#   define ALIMER_NEON 1
+#endif
+
+// Environment maps are filtered in RGBA float: sources that are not RGBA32Float are converted once, a texel fits in one
+// SIMD register and the direction math stays scalar. Output rows are converted to the destination format as they are done.
+namespace
+{
+    constexpr float kPi = 3.14159265358979323846f;
+    constexpr uint32_t kFaceCount = 6;
+    constexpr uint32_t kMaxLevels = 16;
+    // Texel samples per task, the work of a texel is its sample count.
+    constexpr uint32_t kTaskSamples = 65536;
+    constexpr uint32_t kMaxSupersample = 4;
+    constexpr uint32_t kDefaultSampleCount = 64;
+    // Rough levels are wider lobes over 4x fewer texels per level, they get twice the samples of the level above up to this factor.
+    constexpr uint32_t kMaxSampleScale = 16;
+    constexpr uint32_t kDefaultIrradianceSize = 32;
+
+#if defined(ALIMER_SSE2)
+    typedef __m128 Color;
+    inline Color ColorZero() { return _mm_setzero_ps(); }
+    inline Color ColorLoad(const float* src) { return _mm_loadu_ps(src); }
+    inline void ColorStore(float* dst, Color color) { _mm_storeu_ps(dst, color); }
+    inline Color ColorAdd(Color a, Color b) { return _mm_add_ps(a, b); }
+    inline Color ColorSub(Color a, Color b) { return _mm_sub_ps(a, b); }
+    inline Color ColorScale(Color a, float scale) { return _mm_mul_ps(a, _mm_set1_ps(scale)); }
+    inline Color ColorMulAdd(Color acc, Color a, float scale) { return _mm_add_ps(acc, _mm_mul_ps(a, _mm_set1_ps(scale))); }
+#elif defined(ALIMER_NEON)
+    typedef float32x4_t Color;
+    inline Color ColorZero() { return vdupq_n_f32(0.0f); }
+    inline Color ColorLoad(const float* src) { return vld1q_f32(src); }
+    inline void ColorStore(float* dst, Color color) { vst1q_f32(dst, color); }
+    inline Color ColorAdd(Color a, Color b) { return vaddq_f32(a, b); }
+    inline Color ColorSub(Color a, Color b) { return vsubq_f32(a, b); }
+    inline Color ColorScale(Color a, float scale) { return vmulq_n_f32(a, scale); }
+    inline Color ColorMulAdd(Color acc, Color a, float scale) { return vfmaq_n_f32(acc, a, scale); }
+#else
+    struct Color
+    {
+        float v[4];
+    };
+
+    inline Color ColorZero() { return Color{ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+    inline Color ColorLoad(const float* src) { return Color{ { src[0], src[1], src[2], src[3] } }; }
+    inline void ColorStore(float* dst, Color color) { memcpy(dst, color.v, sizeof(color.v)); }
+    inline Color ColorAdd(Color a, Color b) { return Color{ { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+    inline Color ColorSub(Color a, Color b) { return Color{ { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+    inline Color ColorScale(Color a, float s) { return Color{ { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; }
+    inline Color ColorMulAdd(Color acc, Color a, float s) { return ColorAdd(acc, ColorScale(a, s)); }
+#endif
+
+    inline Color ColorLerp(Color a, Color b, float t)
+    {
+        return ColorMulAdd(a, ColorSub(b, a), t);
+    }
+
+    // RGBA32Float pixels, either referenced from the source image or converted into owned storage.
+    struct Plane
+    {
+        const uint8_t* pixels;
+        size_t rowPitch;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    inline const float* GetTexel(const Plane& plane, uint32_t x, uint32_t y)
+    {
+        return (const float*)(plane.pixels + y * plane.rowPitch) + x * 4;
+    }
+
+    // Texel centers are at integer coordinates, x0/x1 are already wrapped or clamped by the caller.
+    inline Color SampleBilinear(const Plane& plane, uint32_t x0, uint32_t x1, float tx, float fy)
+    {
+        fy = fy < 0.0f ? 0.0f : (fy > (float)(plane.height - 1) ? (float)(plane.height - 1) : fy);
+        const uint32_t y0 = (uint32_t)fy;
+        const uint32_t y1 = y0 + 1 < plane.height ? y0 + 1 : y0;
+        const float ty = fy - (float)y0;
+
+        const Color top = ColorLerp(ColorLoad(GetTexel(plane, x0, y0)), ColorLoad(GetTexel(plane, x1, y0)), tx);
+        const Color bottom = ColorLerp(ColorLoad(GetTexel(plane, x0, y1)), ColorLoad(GetTexel(plane, x1, y1)), tx);
+        return ColorLerp(top, bottom, ty);
+    }
+
+    inline Color SampleClamped(const Plane& plane, float fx, float fy)
+    {
+        fx = fx < 0.0f ? 0.0f : (fx > (float)(plane.width - 1) ? (float)(plane.width - 1) : fx);
+        const uint32_t x0 = (uint32_t)fx;
+        const uint32_t x1 = x0 + 1 < plane.width ? x0 + 1 : x0;
+        return SampleBilinear(plane, x0, x1, fx - (float)x0, fy);
+    }
+
+    inline void Normalize(float v[3])
+    {
+        const float scale = 1.0f / sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        v[0] *= scale;
+        v[1] *= scale;
+        v[2] *= scale;
+    }
+
+    // u goes right and v down on the face, both in [-1, 1].
+    inline void FaceToDirection(uint32_t face, float u, float v, float dir[3])
+    {
+        switch (face)
+        {
+            case 0: dir[0] = 1.0f; dir[1] = -v; dir[2] = -u; break;
+            case 1: dir[0] = -1.0f; dir[1] = -v; dir[2] = u; break;
+            case 2: dir[0] = u; dir[1] = 1.0f; dir[2] = v; break;
+            case 3: dir[0] = u; dir[1] = -1.0f; dir[2] = -v; break;
+            case 4: dir[0] = u; dir[1] = -v; dir[2] = 1.0f; break;
+            default: dir[0] = -u; dir[1] = -v; dir[2] = -1.0f; break;
+        }
+    }
+
+    inline uint32_t DirectionToFace(const float dir[3], float* u, float* v)
+    {
+        const float ax = fabsf(dir[0]);
+        const float ay = fabsf(dir[1]);
+        const float az = fabsf(dir[2]);
+        uint32_t face;
+        float major;
+        if (ax >= ay && ax >= az)
+        {
+            face = dir[0] > 0.0f ? 0 : 1;
+            major = ax;
+            *u = dir[0] > 0.0f ? -dir[2] : dir[2];
+            *v = -dir[1];
+        }
+        else if (ay >= az)
+        {
+            face = dir[1] > 0.0f ? 2 : 3;
+            major = ay;
+            *u = dir[0];
+            *v = dir[1] > 0.0f ? dir[2] : -dir[2];
+        }
+        else
+        {
+            face = dir[2] > 0.0f ? 4 : 5;
+            major = az;
+            *u = dir[2] > 0.0f ? dir[0] : -dir[0];
+            *v = -dir[1];
+        }
+
+        *u /= major;
+        *v /= major;
+        return face;
+    }
+
+    inline Color SampleFace(const Plane& plane, float u, float v)
+    {
+        return SampleClamped(plane, (u + 1.0f) * 0.5f * (float)plane.width - 0.5f, (v + 1.0f) * 0.5f * (float)plane.height - 0.5f);
+    }
+
+    // The cube is seamless between texel centers only, samples past the outer centers clamp to the face edge.
+    inline Color SampleCube(const Plane* faces, const float dir[3])
+    {
+        float u, v;
+        const uint32_t face = DirectionToFace(dir, &u, &v);
+        return SampleFace(faces[face], u, v);
+    }
+
+    // The horizontal axis wraps around, dir doesn't need to be normalized.
+    inline Color SampleEquirect(const Plane& plane, const float dir[3])
+    {
+        const float length = sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+        const float y = dir[1] / length;
+        const float fx = (0.5f + atan2f(dir[0], dir[2]) * (0.5f / kPi)) * (float)plane.width - 0.5f;
+        const float fy = acosf(y < -1.0f ? -1.0f : (y > 1.0f ? 1.0f : y)) * (1.0f / kPi) * (float)plane.height - 0.5f;
+
+        const float floorX = floorf(fx);
+        int32_t x0 = (int32_t)floorX % (int32_t)plane.width;
+        if (x0 < 0)
+            x0 += (int32_t)plane.width;
+        const uint32_t x1 = (uint32_t)x0 + 1 < plane.width ? (uint32_t)x0 + 1 : 0;
+        return SampleBilinear(plane, (uint32_t)x0, x1, fx - floorX, fy);
+    }
+
+    inline void EquirectToDirection(float x, float y, float dir[3])
+    {
+        const float phi = (x - 0.5f) * 2.0f * kPi;
+        const float theta = y * kPi;
+        const float sinTheta = sinf(theta);
+        dir[0] = sinTheta * sinf(phi);
+        dir[1] = cosf(theta);
+        dir[2] = sinTheta * cosf(phi);
+    }
+
+    // Level 0 of the first cube with a box filtered chain below it when the prefilter asks for one.
+    struct FloatCube
+    {
+        uint32_t levelCount;
+        Plane faces[kMaxLevels][kFaceCount];
+        float* storage;
+        float* chainStorage;
+    };
+
+    struct LoadJob
+    {
+        const ImageLevel* const* levels;
+        Plane* planes;
+        uint32_t rowsPerTask;
+        uint32_t tasksPerPlane;
+    };
+
+    void LoadRows(uint32_t index, void* userData)
+    {
+        const LoadJob* job = (const LoadJob*)userData;
+        const ImageLevel& level = *job->levels[index / job->tasksPerPlane];
+        const Plane& plane = job->planes[index / job->tasksPerPlane];
+        const uint32_t firstRow = (index % job->tasksPerPlane) * job->rowsPerTask;
+        for (uint32_t y = firstRow; y < firstRow + job->rowsPerTask && y < level.height; ++y)
+        {
+            alimerConvertPixels(level.format, level.pixels + y * level.rowPitch, PixelFormat_RGBA32Float, (uint8_t*)plane.pixels + y * plane.rowPitch, level.width);
+        }
+    }
+
+    // The levels share a size, RGBA32Float sources are referenced in place and storage is left NULL.
+    bool LoadPlanes(const ImageLevel* const* levels, uint32_t count, Plane* planes, float** storage)
+    {
+        *storage = nullptr;
+        const uint32_t width = levels[0]->width;
+        const uint32_t height = levels[0]->height;
+        if (levels[0]->format == PixelFormat_RGBA32Float)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                planes[i] = Plane{ levels[i]->pixels, levels[i]->rowPitch, width, height };
+            return true;
+        }
+
+        const size_t planeSize = (size_t)width * height * 4;
+        *storage = ALIMER_ALLOCN(float, planeSize * count);
+        if (!*storage)
+            return false;
+
+        for (uint32_t i = 0; i < count; ++i)
+            planes[i] = Plane{ (const uint8_t*)(*storage + planeSize * i), (size_t)width * 4 * sizeof(float), width, height };
+
+        LoadJob job;
+        job.levels = levels;
+        job.planes = planes;
+        job.rowsPerTask = width < kTaskSamples ? kTaskSamples / width : 1;
+        job.tasksPerPlane = (height + job.rowsPerTask - 1) / job.rowsPerTask;
+        if (count * job.tasksPerPlane == 1)
+            LoadRows(0, &job);
+        else
+            alimerParallelFor(count * job.tasksPerPlane, LoadRows, &job);
+        return true;
+    }
+
+    bool IsEnvironmentSource(Image* image, ImageDimension dimension)
+    {
+        return image && alimerImageGetData(image, nullptr) && alimerImageGetDimension(image) == dimension && alimerIsConvertibleFormat(alimerImageGetFormat(image));
+    }
+
+    bool LoadCube(Image* image, FloatCube* cube)
+    {
+        const ImageLevel* levels[kFaceCount];
+        for (uint32_t face = 0; face < kFaceCount; ++face)
+            levels[face] = alimerImageGetLevel(image, face, 0);
+
+        memset(cube, 0, sizeof(FloatCube));
+        cube->levelCount = 1;
+        return LoadPlanes(levels, kFaceCount, cube->faces[0], &cube->storage);
+    }
+
+    void FreeCube(FloatCube* cube)
+    {
+        alimerFree(cube->chainStorage);
+        alimerFree(cube->storage);
+    }
+
+    struct DownsampleJob
+    {
+        const Plane* src;
+        const Plane* dst;
+    };
+
+    // 2x2 box, odd sizes clamp the last column and row.
+    void DownsampleFace(uint32_t index, void* userData)
+    {
+        const DownsampleJob* job = (const DownsampleJob*)userData;
+        const Plane& src = job->src[index];
+        const Plane& dst = job->dst[index];
+        for (uint32_t y = 0; y < dst.height; ++y)
+        {
+            const uint32_t y0 = 2 * y;
+            const uint32_t y1 = 2 * y + 1 < src.height ? 2 * y + 1 : y0;
+            float* row = (float*)(dst.pixels + y * dst.rowPitch);
+            for (uint32_t x = 0; x < dst.width; ++x)
+            {
+                const uint32_t x0 = 2 * x;
+                const uint32_t x1 = 2 * x + 1 < src.width ? 2 * x + 1 : x0;
+                Color sum = ColorAdd(ColorLoad(GetTexel(src, x0, y0)), ColorLoad(GetTexel(src, x1, y0)));
+                sum = ColorAdd(sum, ColorAdd(ColorLoad(GetTexel(src, x0, y1)), ColorLoad(GetTexel(src, x1, y1))));
+                ColorStore(row + x * 4, ColorScale(sum, 0.25f));
+            }
+        }
+    }
+
+    bool BuildMipChain(FloatCube* cube)
+    {
+        uint32_t levelCount = 1;
+        size_t chainSize = 0;
+        for (uint32_t size = cube->faces[0][0].width; size > 1 && levelCount < kMaxLevels; ++levelCount)
+        {
+            size /= 2;
+            chainSize += (size_t)size * size * 4 * kFaceCount;
+        }
+
+        if (levelCount == 1)
+            return true;
+
+        cube->chainStorage = ALIMER_ALLOCN(float, chainSize);
+        if (!cube->chainStorage)
+            return false;
+
+        float* texels = cube->chainStorage;
+        for (uint32_t level = 1; level < levelCount; ++level)
+        {
+            const uint32_t size = cube->faces[level - 1][0].width / 2;
+            for (uint32_t face = 0; face < kFaceCount; ++face, texels += (size_t)size * size * 4)
+                cube->faces[level][face] = Plane{ (const uint8_t*)texels, (size_t)size * 4 * sizeof(float), size, size };
+
+            DownsampleJob job = { cube->faces[level - 1], cube->faces[level] };
+            alimerParallelFor(kFaceCount, DownsampleFace, &job);
+        }
+
+        cube->levelCount = levelCount;
+        return true;
+    }
+
+    inline Color SampleCubeLod(const FloatCube& cube, const float dir[3], float lod)
+    {
+        float u, v;
+        const uint32_t face = DirectionToFace(dir, &u, &v);
+        const uint32_t level = (uint32_t)lod;
+        const float t = lod - (float)level;
+        const Color color = SampleFace(cube.faces[level][face], u, v);
+        if (t <= 0.0f || level + 1 >= cube.levelCount)
+            return color;
+        return ColorLerp(color, SampleFace(cube.faces[level + 1][face], u, v), t);
+    }
+
+    /* Output */
+    struct OutputTask
+    {
+        uint32_t layer;
+        uint32_t mipLevel;
+        uint32_t firstRow;
+        uint32_t rowCount;
+    };
+
+    struct OutputJob;
+    // Fill the RGBA float texels of one row of a subresource.
+    typedef void (*ShadeRowFunc)(const OutputJob& job, const OutputTask& task, uint32_t y, uint32_t width, uint32_t height, float* row);
+
+    struct OutputJob
+    {
+        Image* image;
+        const OutputTask* tasks;
+        ShadeRowFunc shade;
+        const void* data;
+        std::atomic<bool> failed;
+    };
+
+    void ShadeRows(uint32_t index, void* userData)
+    {
+        OutputJob* job = (OutputJob*)userData;
+        const OutputTask& task = job->tasks[index];
+        const ImageLevel* level = alimerImageGetLevel(job->image, task.layer, task.mipLevel);
+
+        ScratchScope scratch;
+        float* row = (float*)alimerScratchAlloc((size_t)level->width * 4 * sizeof(float));
+        if (!row)
+        {
+            job->failed.store(true, std::memory_order_relaxed);
+            return;
+        }
+
+        for (uint32_t y = task.firstRow; y < task.firstRow + task.rowCount; ++y)
+        {
+            job->shade(*job, task, y, level->width, level->height, row);
+            alimerConvertPixels(PixelFormat_RGBA32Float, row, level->format, level->pixels + y * level->rowPitch, level->width);
+        }
+
+        alimerScratchFree(row);
+    }
+
+    // Split every subresource of the first layerCount layers in row bands, sampleCounts gives the cost of a texel per mip level.
+    bool RunOutput(Image* image, uint32_t layerCount, const uint32_t* sampleCounts, ShadeRowFunc shade, const void* data)
+    {
+        const uint32_t mipLevelCount = alimerImageGetMipLevelCount(image);
+        uint32_t taskCount = 0;
+        for (uint32_t layer = 0; layer < layerCount; ++layer)
+        {
+            for (uint32_t mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel)
+            {
+                const ImageLevel* level = alimerImageGetLevel(image, layer, mipLevel);
+                const uint64_t rowCost = (uint64_t)level->width * sampleCounts[mipLevel];
+                const uint32_t rowsPerTask = rowCost < kTaskSamples ? (uint32_t)(kTaskSamples / rowCost) : 1;
+                taskCount += (level->height + rowsPerTask - 1) / rowsPerTask;
+            }
+        }
+
+        OutputTask* tasks = ALIMER_ALLOCN(OutputTask, taskCount);
+        if (!tasks)
+            return false;
+
+        OutputTask* task = tasks;
+        for (uint32_t layer = 0; layer < layerCount; ++layer)
+        {
+            for (uint32_t mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel)
+            {
+                const ImageLevel* level = alimerImageGetLevel(image, layer, mipLevel);
+                const uint64_t rowCost = (uint64_t)level->width * sampleCounts[mipLevel];
+                const uint32_t rowsPerTask = rowCost < kTaskSamples ? (uint32_t)(kTaskSamples / rowCost) : 1;
+                for (uint32_t row = 0; row < level->height; row += rowsPerTask, ++task)
+                {
+                    task->layer = layer;
+                    task->mipLevel = mipLevel;
+                    task->firstRow = row;
+                    task->rowCount = level->height - row < rowsPerTask ? level->height - row : rowsPerTask;
+                }
+            }
+        }
+
+        OutputJob job;
+        job.image = image;
+        job.tasks = tasks;
+        job.shade = shade;
+        job.data = data;
+        job.failed.store(false, std::memory_order_relaxed);
+        if (taskCount == 1)
+            ShadeRows(0, &job);
+        else
+            alimerParallelFor(taskCount, ShadeRows, &job);
+
+        alimerFree(tasks);
+        return !job.failed.load(std::memory_order_relaxed);
+    }
+
+    // Supersampling factor so that a destination texel covers at most one source texel per sample.
+    uint32_t GetSupersample(float ratio)
+    {
+        const uint32_t count = (uint32_t)ceilf(ratio - 0.001f);
+        return count < 1 ? 1 : (count > kMaxSupersample ? kMaxSupersample : count);
+    }
+
+    /* Equirect <-> cube */
+    struct ResampleData
+    {
+        const Plane* src;
+        uint32_t supersample;
+    };
+
+    void ShadeCubeFromEquirect(const OutputJob& job, const OutputTask& task, uint32_t y, uint32_t width, uint32_t height, float* row)
+    {
+        const ResampleData& data = *(const ResampleData*)job.data;
+        const uint32_t count = data.supersample;
+        const float step = 1.0f / (float)count;
+        const float scaleX = 2.0f / (float)width;
+        const float scaleY = 2.0f / (float)height;
+        const float weight = 1.0f / (float)(count * count);
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            Color sum = ColorZero();
+            for (uint32_t j = 0; j < count; ++j)
+            {
+                const float v = ((float)y + ((float)j + 0.5f) * step) * scaleY - 1.0f;
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    const float u = ((float)x + ((float)i + 0.5f) * step) * scaleX - 1.0f;
+                    float dir[3];
+                    FaceToDirection(task.layer, u, v, dir);
+                    sum = ColorAdd(sum, SampleEquirect(*data.src, dir));
+                }
+            }
+            ColorStore(row + x * 4, ColorScale(sum, weight));
+        }
+    }
+
+    void ShadeEquirectFromCube(const OutputJob& job, const OutputTask& task, uint32_t y, uint32_t width, uint32_t height, float* row)
+    {
+        ALIMER_UNUSED(task);
+        const ResampleData& data = *(const ResampleData*)job.data;
+        const uint32_t count = data.supersample;
+        const float step = 1.0f / (float)count;
+        const float weight = 1.0f / (float)(count * count);
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            Color sum = ColorZero();
+            for (uint32_t j = 0; j < count; ++j)
+            {
+                const float v = ((float)y + ((float)j + 0.5f) * step) / (float)height;
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    float dir[3];
+                    EquirectToDirection(((float)x + ((float)i + 0.5f) * step) / (float)width, v, dir);
+                    sum = ColorAdd(sum, SampleCube(data.src, dir));
+                }
+            }
+            ColorStore(row + x * 4, ColorScale(sum, weight));
+        }
+    }
+
+    /* GGX prefilter */
+    // Light direction in the tangent frame of the texel (normal along z), with its NdotL weight and source lod.
+    struct PrefilterSample
+    {
+        float x, y, z;
+        float weight;
+        float lod;
+    };
+
+    struct PrefilterData
+    {
+        const FloatCube* src;
+        // Samples of every mip level one after another, none for roughness 0 which resamples the source.
+        const PrefilterSample* samples;
+        uint32_t sampleOffsets[kMaxLevels];
+        uint32_t sampleCounts[kMaxLevels];
+        float invWeights[kMaxLevels];
+        float resampleLods[kMaxLevels];
+    };
+
+    inline float RadicalInverse(uint32_t bits)
+    {
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return (float)bits * 2.3283064365386963e-10f;
+    }
+
+    // Importance sample the GGX half vector with N = V = R (split-sum assumption), reading from the source mip whose texel
+    // solid angle matches the sample (Colbert and Krivanek, GPU Gems 3 chapter 20), so a few dozen samples don't alias.
+    uint32_t BuildPrefilterSamples(float roughness, uint32_t sampleCount, uint32_t sourceSize, uint32_t sourceLevels, PrefilterSample* samples, float* weightSum)
+    {
+        const float alpha = roughness * roughness;
+        const float alpha2 = alpha * alpha;
+        const float texelSolidAngle = 4.0f * kPi / (6.0f * (float)sourceSize * (float)sourceSize);
+        uint32_t count = 0;
+        *weightSum = 0.0f;
+        for (uint32_t i = 0; i < sampleCount; ++i)
+        {
+            const float e1 = ((float)i + 0.5f) / (float)sampleCount;
+            const float e2 = RadicalInverse(i);
+            const float phi = 2.0f * kPi * e1;
+            const float cosTheta = sqrtf((1.0f - e2) / (1.0f + (alpha2 - 1.0f) * e2));
+            const float sinTheta = sqrtf(1.0f - cosTheta * cosTheta);
+
+            // L = 2 (V.H) H - V with V = (0, 0, 1).
+            const float NdotL = 2.0f * cosTheta * cosTheta - 1.0f;
+            if (NdotL <= 0.0f)
+                continue;
+
+            // pdf(L) = D(H) NdotH / (4 VdotH) = D(H) / 4.
+            const float denom = cosTheta * cosTheta * (alpha2 - 1.0f) + 1.0f;
+            const float pdf = alpha2 / (kPi * denom * denom) * 0.25f;
+            const float sampleSolidAngle = 1.0f / ((float)sampleCount * pdf);
+            float lod = 0.5f * log2f(sampleSolidAngle / texelSolidAngle) + 1.0f;
+            lod = lod < 0.0f ? 0.0f : (lod > (float)(sourceLevels - 1) ? (float)(sourceLevels - 1) : lod);
+
+            PrefilterSample& sample = samples[count++];
+            sample.x = 2.0f * cosTheta * sinTheta * cosf(phi);
+            sample.y = 2.0f * cosTheta * sinTheta * sinf(phi);
+            sample.z = NdotL;
+            sample.weight = NdotL;
+            sample.lod = lod;
+            *weightSum += NdotL;
+        }
+
+        return count;
+    }
+
+    void ShadePrefilter(const OutputJob& job, const OutputTask& task, uint32_t y, uint32_t width, uint32_t height, float* row)
+    {
+        const PrefilterData& data = *(const PrefilterData*)job.data;
+        const PrefilterSample* samples = data.samples + data.sampleOffsets[task.mipLevel];
+        const uint32_t sampleCount = data.sampleCounts[task.mipLevel];
+        const float v = ((float)y + 0.5f) * 2.0f / (float)height - 1.0f;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const float u = ((float)x + 0.5f) * 2.0f / (float)width - 1.0f;
+            float n[3];
+            FaceToDirection(task.layer, u, v, n);
+            if (!sampleCount)
+            {
+                ColorStore(row + x * 4, SampleCubeLod(*data.src, n, data.resampleLods[task.mipLevel]));
+                continue;
+            }
+
+            Normalize(n);
+            float t[3] = { 1.0f, 0.0f, 0.0f };
+            if (fabsf(n[2]) < 0.999f)
+            {
+                // cross((0, 0, 1), n)
+                t[0] = -n[1];
+                t[1] = n[0];
+                t[2] = 0.0f;
+            }
+            else
+            {
+                // cross((1, 0, 0), n)
+                t[0] = 0.0f;
+                t[1] = -n[2];
+                t[2] = n[1];
+            }
+            Normalize(t);
+            const float b[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+
+            Color sum = ColorZero();
+            for (uint32_t i = 0; i < sampleCount; ++i)
+            {
+                const PrefilterSample& sample = samples[i];
+                const float l[3] = {
+                    t[0] * sample.x + b[0] * sample.y + n[0] * sample.z,
+                    t[1] * sample.x + b[1] * sample.y + n[1] * sample.z,
+                    t[2] * sample.x + b[2] * sample.y + n[2] * sample.z
+                };
+                sum = ColorMulAdd(sum, SampleCubeLod(*data.src, l, sample.lod), sample.weight);
+            }
+            ColorStore(row + x * 4, ColorScale(sum, data.invWeights[task.mipLevel]));
+        }
+    }
+
+    /* Spherical harmonics */
+    inline void EvaluateSH9(const float dir[3], float basis[9])
+    {
+        const float x = dir[0];
+        const float y = dir[1];
+        const float z = dir[2];
+        basis[0] = 0.282095f;
+        basis[1] = 0.488603f * y;
+        basis[2] = 0.488603f * z;
+        basis[3] = 0.488603f * x;
+        basis[4] = 1.092548f * x * y;
+        basis[5] = 1.092548f * y * z;
+        basis[6] = 0.315392f * (3.0f * z * z - 1.0f);
+        basis[7] = 1.092548f * x * z;
+        basis[8] = 0.546274f * (x * x - y * y);
+    }
+
+    struct ProjectTask
+    {
+        uint32_t face;
+        uint32_t firstRow;
+        uint32_t rowCount;
+        // RGB per coefficient, then the total solid angle.
+        double sums[9 * 3 + 1];
+    };
+
+    struct ProjectJob
+    {
+        const Plane* faces;
+        ProjectTask* tasks;
+        std::atomic<bool> failed;
+    };
+
+    inline float SolidAngleTerm(float x, float y)
+    {
+        return atan2f(x * y, sqrtf(x * x + y * y + 1.0f));
+    }
+
+    void ProjectRows(uint32_t index, void* userData)
+    {
+        ProjectJob* job = (ProjectJob*)userData;
+        ProjectTask& task = job->tasks[index];
+        const Plane& plane = job->faces[task.face];
+        const float texelSize = 2.0f / (float)plane.width;
+        memset(task.sums, 0, sizeof(task.sums));
+
+        // Texel solid angles from the terms at the corners, the bottom corners of a row are the top ones of the next.
+        ScratchScope scratch;
+        float* corners = (float*)alimerScratchAlloc(sizeof(float) * 2 * (plane.width + 1));
+        if (!corners)
+        {
+            job->failed.store(true, std::memory_order_relaxed);
+            return;
+        }
+
+        float* top = corners;
+        float* bottom = corners + plane.width + 1;
+        for (uint32_t x = 0; x <= plane.width; ++x)
+            top[x] = SolidAngleTerm((float)x * texelSize - 1.0f, (float)task.firstRow * texelSize - 1.0f);
+
+        for (uint32_t y = task.firstRow; y < task.firstRow + task.rowCount; ++y)
+        {
+            const float v0 = (float)y * texelSize - 1.0f;
+            for (uint32_t x = 0; x <= plane.width; ++x)
+                bottom[x] = SolidAngleTerm((float)x * texelSize - 1.0f, v0 + texelSize);
+
+            float rowSums[9 * 3 + 1] = {};
+            for (uint32_t x = 0; x < plane.width; ++x)
+            {
+                const float u0 = (float)x * texelSize - 1.0f;
+                const float solidAngle = top[x] - bottom[x] - top[x + 1] + bottom[x + 1];
+
+                float dir[3];
+                FaceToDirection(task.face, u0 + 0.5f * texelSize, v0 + 0.5f * texelSize, dir);
+                Normalize(dir);
+                float basis[9];
+                EvaluateSH9(dir, basis);
+
+                const float* texel = GetTexel(plane, x, y);
+                for (uint32_t i = 0; i < 9; ++i)
+                {
+                    const float weight = basis[i] * solidAngle;
+                    rowSums[i * 3 + 0] += texel[0] * weight;
+                    rowSums[i * 3 + 1] += texel[1] * weight;
+                    rowSums[i * 3 + 2] += texel[2] * weight;
+                }
+                rowSums[27] += solidAngle;
+            }
+
+            for (uint32_t i = 0; i < 28; ++i)
+                task.sums[i] += rowSums[i];
+
+            float* swap = top;
+            top = bottom;
+            bottom = swap;
+        }
+
+        alimerScratchFree(corners);
+    }
+
+    bool ProjectSH9(const Plane* faces, float coefficients[9][3])
+    {
+        const uint32_t size = faces[0].width;
+        const uint32_t rowsPerTask = size < kTaskSamples ? kTaskSamples / size : 1;
+        const uint32_t tasksPerFace = (size + rowsPerTask - 1) / rowsPerTask;
+        ProjectTask* tasks = ALIMER_ALLOCN(ProjectTask, kFaceCount * tasksPerFace);
+        if (!tasks)
+            return false;
+
+        for (uint32_t i = 0; i < kFaceCount * tasksPerFace; ++i)
+        {
+            tasks[i].face = i / tasksPerFace;
+            tasks[i].firstRow = (i % tasksPerFace) * rowsPerTask;
+            tasks[i].rowCount = size - tasks[i].firstRow < rowsPerTask ? size - tasks[i].firstRow : rowsPerTask;
+        }
+
+        ProjectJob job;
+        job.faces = faces;
+        job.tasks = tasks;
+        job.failed.store(false, std::memory_order_relaxed);
+        alimerParallelFor(kFaceCount * tasksPerFace, ProjectRows, &job);
+        if (job.failed.load(std::memory_order_relaxed))
+        {
+            alimerFree(tasks);
+            return false;
+        }
+
+        // Summed in task order, the result doesn't depend on the thread count.
+        double sums[28] = {};
+        for (uint32_t i = 0; i < kFaceCount * tasksPerFace; ++i)
+        {
+            for (uint32_t j = 0; j < 28; ++j)
+                sums[j] += tasks[i].sums[j];
+        }
+        alimerFree(tasks);
+
+        // The texel solid angles add up to 4 pi up to rounding, normalize it away.
+        const double scale = 4.0 * 3.14159265358979323846 / sums[27];
+        for (uint32_t i = 0; i < 9; ++i)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+                coefficients[i][c] = (float)(sums[i * 3 + c] * scale);
+        }
+        return true;
+    }
+
+    void ShadeIrradiance(const OutputJob& job, const OutputTask& task, uint32_t y, uint32_t width, uint32_t height, float* row)
+    {
+        const float(*irradiance)[3] = (const float(*)[3])job.data;
+        const float v = ((float)y + 0.5f) * 2.0f / (float)height - 1.0f;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float dir[3];
+            FaceToDirection(task.layer, ((float)x + 0.5f) * 2.0f / (float)width - 1.0f, v, dir);
+            Normalize(dir);
+            float basis[9];
+            EvaluateSH9(dir, basis);
+
+            float* texel = row + x * 4;
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                float value = 0.0f;
+                for (uint32_t i = 0; i < 9; ++i)
+                    value += irradiance[i][c] * basis[i];
+                // Ringing of the truncated expansion can dip below zero around bright spots.
+                texel[c] = value > 0.0f ? value : 0.0f;
+            }
+            texel[3] = 1.0f;
+        }
+    }
+}
+
+Image* alimerImageCreateCubeFromEquirect(Image* image, uint32_t faceSize)
+{
+    if (!IsEnvironmentSource(image, ImageDimension_2D))
+        return nullptr;
+
+    const ImageLevel* level = alimerImageGetLevel(image, 0, 0);
+    if (!faceSize)
+        faceSize = level->width / 4 > 0 ? level->width / 4 : 1;
+
+    Plane src;
+    float* storage;
+    if (!LoadPlanes(&level, 1, &src, &storage))
+        return nullptr;
+
+    Image* result = alimerImageCreateCube(level->format, faceSize, 1, 1);
+    if (result)
+    {
+        // A face covers a quarter of the equirect width.
+        ResampleData data = { &src, GetSupersample((float)level->width / (4.0f * (float)faceSize)) };
+        const uint32_t sampleCount = data.supersample * data.supersample;
+        if (!RunOutput(result, kFaceCount, &sampleCount, ShadeCubeFromEquirect, &data))
+        {
+            alimerImageDestroy(result);
+            result = nullptr;
+        }
+    }
+
+    alimerFree(storage);
+    return result;
+}
+
+Image* alimerImageCreateEquirectFromCube(Image* image, uint32_t width)
+{
+    if (!IsEnvironmentSource(image, ImageDimension_Cube))
+        return nullptr;
+
+    FloatCube cube;
+    if (!LoadCube(image, &cube))
+        return nullptr;
+
+    const uint32_t faceSize = cube.faces[0][0].width;
+    if (!width)
+        width = 4 * faceSize;
+
+    Image* result = alimerImageCreate2D(alimerImageGetFormat(image), width, width / 2 > 0 ? width / 2 : 1, 1, 1);
+    if (result)
+    {
+        ResampleData data = { cube.faces[0], GetSupersample(4.0f * (float)faceSize / (float)width) };
+        const uint32_t sampleCount = data.supersample * data.supersample;
+        if (!RunOutput(result, 1, &sampleCount, ShadeEquirectFromCube, &data))
+        {
+            alimerImageDestroy(result);
+            result = nullptr;
+        }
+    }
+
+    FreeCube(&cube);
+    return result;
+}
+
+Image* alimerImagePrefilterSpecular(Image* image, uint32_t faceSize, uint32_t mipLevelCount, uint32_t sampleCount)
+{
+    if (!IsEnvironmentSource(image, ImageDimension_Cube))
+        return nullptr;
+
+    if (!sampleCount)
+        sampleCount = kDefaultSampleCount;
+
+    FloatCube cube;
+    if (!LoadCube(image, &cube))
+        return nullptr;
+
+    const uint32_t sourceSize = cube.faces[0][0].width;
+    if (!faceSize)
+        faceSize = sourceSize;
+
+    Image* result = nullptr;
+    PrefilterSample* samples = nullptr;
+    if (BuildMipChain(&cube))
+        result = alimerImageCreateCube(alimerImageGetFormat(image), faceSize, 1, mipLevelCount);
+
+    const uint32_t levelCount = result ? alimerImageGetMipLevelCount(result) : 0;
+    if (levelCount > kMaxLevels)
+    {
+        alimerImageDestroy(result);
+        result = nullptr;
+    }
+    else if (result)
+    {
+        samples = ALIMER_ALLOCN(PrefilterSample, (size_t)sampleCount * kMaxSampleScale * levelCount);
+    }
+
+    if (samples)
+    {
+        PrefilterData data = {};
+        data.src = &cube;
+        data.samples = samples;
+        uint32_t costs[kMaxLevels];
+        uint32_t offset = 0;
+        uint32_t sampleScale = 1;
+        for (uint32_t mipLevel = 0; mipLevel < levelCount; ++mipLevel)
+        {
+            const float roughness = levelCount > 1 ? (float)mipLevel / (float)(levelCount - 1) : 0.0f;
+            float weightSum = 0.0f;
+            data.sampleOffsets[mipLevel] = offset;
+            if (roughness > 0.0f)
+            {
+                data.sampleCounts[mipLevel] = BuildPrefilterSamples(roughness, sampleCount * sampleScale, sourceSize, cube.levelCount, samples + offset, &weightSum);
+                sampleScale = sampleScale * 2 <= kMaxSampleScale ? sampleScale * 2 : kMaxSampleScale;
+            }
+            data.invWeights[mipLevel] = weightSum > 0.0f ? 1.0f / weightSum : 0.0f;
+            offset += data.sampleCounts[mipLevel];
+
+            // A mirror reflection resamples the source from the level closest to the output size.
+            const float lod = log2f((float)sourceSize / (float)alimerImageGetWidth(result, mipLevel));
+            data.resampleLods[mipLevel] = lod < 0.0f ? 0.0f : (lod > (float)(cube.levelCount - 1) ? (float)(cube.levelCount - 1) : lod);
+            costs[mipLevel] = data.sampleCounts[mipLevel] > 0 ? data.sampleCounts[mipLevel] * 2 : 2;
+        }
+
+        if (!RunOutput(result, kFaceCount, costs, ShadePrefilter, &data))
+        {
+            alimerImageDestroy(result);
+            result = nullptr;
+        }
+    }
+    else if (result)
+    {
+        alimerImageDestroy(result);
+        result = nullptr;
+    }
+
+    alimerFree(samples);
+    FreeCube(&cube);
+    return result;
+}
+
+bool alimerImageComputeSH9(Image* image, float coefficients[9][3])
+{
+    if (!coefficients || !IsEnvironmentSource(image, ImageDimension_Cube))
+        return false;
+
+    FloatCube cube;
+    if (!LoadCube(image, &cube))
+        return false;
+
+    const bool result = ProjectSH9(cube.faces[0], coefficients);
+    FreeCube(&cube);
+    return result;
+}
+
+Image* alimerImageCreateIrradianceCube(Image* image, uint32_t faceSize)
+{
+    float irradiance[9][3];
+    if (!alimerImageComputeSH9(image, irradiance))
+        return nullptr;
+
+    // Cosine lobe convolution (pi, 2 pi / 3 and pi / 4 per band, Ramamoorthi and Hanrahan) divided by pi.
+    static const float kBandScale[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+    for (uint32_t i = 0; i < 9; ++i)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+            irradiance[i][c] *= kBandScale[i];
+    }
+
+    Image* result = alimerImageCreateCube(alimerImageGetFormat(image), faceSize ? faceSize : kDefaultIrradianceSize, 1, 1);
+    const uint32_t sampleCount = 1;
+    if (result && !RunOutput(result, kFaceCount, &sampleCount, ShadeIrradiance, irradiance))
+    {
+        alimerImageDestroy(result);
+        result = nullptr;
+    }
+    return result;
+}
@@ -0,0 +1,1104 @@
+// Copyright (c) Amer Koleci and Contributors.
+// Licensed under the MIT License (MIT). See LICENSE in the repository root for more information.
+
+#include "alimer_internal.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define ALIMER_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   include <arm_neon.h>
+#   define ALIMER_NEON 1
+#endif
+
+// ETC2 and EAC block encoders and decoders. Blocks are 64-bit big endian words, pixel indices are stored in column major order.
+namespace
+{
+    typedef uint8_t BlockPixels[16][4];
+
+    const int32_t kETCModifiers[8][2] = {
+        { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+    };
+
+    const int32_t kETCDistances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+    const int32_t kEACModifiers[16][8] = {
+        { -3, -6, -9, -15, 2, 5, 8, 14 },
+        { -3, -7, -10, -13, 2, 6, 9, 12 },
+        { -2, -5, -8, -13, 1, 4, 7, 12 },
+        { -2, -4, -6, -13, 1, 3, 5, 12 },
+        { -3, -6, -8, -12, 2, 5, 7, 11 },
+        { -3, -7, -9, -11, 2, 6, 8, 10 },
+        { -4, -7, -8, -11, 3, 6, 7, 10 },
+        { -3, -5, -8, -11, 2, 4, 7, 10 },
+        { -2, -6, -8, -10, 1, 5, 7, 9 },
+        { -2, -5, -8, -10, 1, 4, 7, 9 },
+        { -2, -4, -8, -10, 1, 3, 7, 9 },
+        { -2, -5, -7, -10, 1, 4, 6, 9 },
+        { -3, -4, -7, -10, 2, 3, 6, 9 },
+        { -1, -2, -3, -10, 0, 1, 2, 9 },
+        { -4, -6, -8, -9, 3, 5, 7, 8 },
+        { -3, -5, -7, -9, 2, 4, 6, 8 },
+    };
+
+    inline int32_t Clamp(int32_t value, int32_t low, int32_t high)
+    {
+        return value < low ? low : (value > high ? high : value);
+    }
+
+    inline int32_t ExpandBits(int32_t value, int32_t bits)
+    {
+        return (value << (8 - bits)) | (value >> (2 * bits - 8));
+    }
+
+    inline int32_t QuantizeBits(int32_t value, int32_t bits)
+    {
+        const int32_t maxValue = (1 << bits) - 1;
+        return (value * maxValue + 127) / 255;
+    }
+
+    // Bit of pixel (x, y) in the index words.
+    inline uint32_t PixelBit(uint32_t pixel)
+    {
+        return (pixel & 3) * 4 + (pixel >> 2);
+    }
+
+    void StoreBlock(uint64_t value, uint8_t* block)
+    {
+        for (uint32_t i = 0; i < 8; ++i)
+            block[i] = (uint8_t)(value >> (56 - i * 8));
+    }
+
+    uint64_t PackIndices(const uint8_t* indices)
+    {
+        uint64_t result = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            const uint32_t bit = PixelBit(p);
+            result |= (uint64_t)(indices[p] >> 1) << (16 + bit);
+            result |= (uint64_t)(indices[p] & 1) << bit;
+        }
+        return result;
+    }
+
+    void SetColor(uint8_t* entry, int32_t r, int32_t g, int32_t b)
+    {
+        entry[0] = (uint8_t)Clamp(r, 0, 255);
+        entry[1] = (uint8_t)Clamp(g, 0, 255);
+        entry[2] = (uint8_t)Clamp(b, 0, 255);
+        entry[3] = 0;
+    }
+
+    struct ColorBlock
+    {
+        // Colors with alpha cleared, alpha only decides which pixels are transparent.
+        uint8_t colors[16][4];
+        uint32_t opaqueMask;
+    };
+
+    struct EncodedBlock
+    {
+        uint64_t bits;
+        uint32_t error;
+    };
+
+    uint32_t SumErrors(const uint32_t* errors, uint32_t count, uint32_t mask)
+    {
+        uint32_t total = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (mask & (1u << i))
+                total += errors[i];
+        }
+        return total;
+    }
+
+    /* Individual and differential modes */
+    struct Subblock
+    {
+        uint8_t colors[8][4];
+        uint8_t pixels[8];
+        uint32_t opaqueMask;
+    };
+
+    struct SubblockFit
+    {
+        int32_t color[3];
+        uint32_t table;
+        uint32_t error;
+        uint8_t indices[8];
+    };
+
+    // Flip 0 splits the block in two 2x4 halves (left, right), flip 1 in two 4x2 halves (top, bottom).
+    void GatherSubblocks(const ColorBlock& input, uint32_t flip, Subblock subblocks[2])
+    {
+        uint32_t counts[2] = {};
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            const uint32_t x = p & 3;
+            const uint32_t y = p >> 2;
+            const uint32_t s = flip ? (y >> 1) : (x >> 1);
+            Subblock& subblock = subblocks[s];
+            if (counts[s] == 0)
+                subblock.opaqueMask = 0;
+            memcpy(subblock.colors[counts[s]], input.colors[p], 4);
+            subblock.pixels[counts[s]] = (uint8_t)p;
+            if (input.opaqueMask & (1u << p))
+                subblock.opaqueMask |= 1u << counts[s];
+            counts[s]++;
+        }
+    }
+
+    // Best modifier table for an expanded base color. Without the opaque bit, index 2 is transparent and index 0 is the base color.
+    void FitSubblock(const Subblock& subblock, const int32_t color[3], int32_t bits, bool punchThrough, SubblockFit* fit)
+    {
+        int32_t base[3];
+        for (uint32_t c = 0; c < 3; ++c)
+            base[c] = ExpandBits(color[c], bits);
+
+        fit->error = UINT32_MAX;
+        for (uint32_t table = 0; table < 8; ++table)
+        {
+            const int32_t a = kETCModifiers[table][0];
+            const int32_t b = kETCModifiers[table][1];
+            uint8_t palette[4][4];
+            uint8_t values[4];
+            uint32_t paletteSize;
+            if (punchThrough)
+            {
+                SetColor(palette[0], base[0], base[1], base[2]);
+                SetColor(palette[1], base[0] + b, base[1] + b, base[2] + b);
+                SetColor(palette[2], base[0] - b, base[1] - b, base[2] - b);
+                values[0] = 0;
+                values[1] = 1;
+                values[2] = 3;
+                paletteSize = 3;
+            }
+            else
+            {
+                SetColor(palette[0], base[0] + a, base[1] + a, base[2] + a);
+                SetColor(palette[1], base[0] + b, base[1] + b, base[2] + b);
+                SetColor(palette[2], base[0] - a, base[1] - a, base[2] - a);
+                SetColor(palette[3], base[0] - b, base[1] - b, base[2] - b);
+                for (uint32_t i = 0; i < 4; ++i)
+                    values[i] = (uint8_t)i;
+                paletteSize = 4;
+            }
+
+            uint8_t indices[8];
+            uint32_t errors[8];
+            alimerFindNearestColors(subblock.colors, 8, palette, paletteSize, indices, errors);
+            const uint32_t error = SumErrors(errors, 8, punchThrough ? subblock.opaqueMask : 0xFF);
+            if (error < fit->error)
+            {
+                fit->error = error;
+                fit->table = table;
+                for (uint32_t i = 0; i < 8; ++i)
+                    fit->indices[i] = (subblock.opaqueMask & (1u << i)) ? values[indices[i]] : 2;
+            }
+        }
+
+        memcpy(fit->color, color, sizeof(fit->color));
+    }
+
+    // Base colors around the subblock average: one for Fast, steps along the gray axis for Normal, every neighbour for High.
+    uint32_t FitCandidates(const Subblock& subblock, int32_t bits, bool punchThrough, ImageCompressQuality quality, SubblockFit* fits)
+    {
+        int32_t sum[3] = {};
+        uint32_t count = 0;
+        const uint32_t mask = subblock.opaqueMask ? subblock.opaqueMask : 0xFF;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            if (!(mask & (1u << i)))
+                continue;
+
+            for (uint32_t c = 0; c < 3; ++c)
+                sum[c] += subblock.colors[i][c];
+            count++;
+        }
+
+        int32_t center[3];
+        for (uint32_t c = 0; c < 3; ++c)
+            center[c] = QuantizeBits((sum[c] + (int32_t)count / 2) / (int32_t)count, bits);
+
+        const int32_t maxValue = (1 << bits) - 1;
+        uint32_t fitCount = 0;
+        for (int32_t dr = -1; dr <= 1; ++dr)
+        {
+            for (int32_t dg = -1; dg <= 1; ++dg)
+            {
+                for (int32_t db = -1; db <= 1; ++db)
+                {
+                    const bool gray = dr == dg && dg == db;
+                    if (quality == ImageCompressQuality_Fast && (dr || dg || db))
+                        continue;
+                    if (quality == ImageCompressQuality_Normal && !gray)
+                        continue;
+
+                    const int32_t color[3] = { center[0] + dr, center[1] + dg, center[2] + db };
+                    if (color[0] < 0 || color[1] < 0 || color[2] < 0 || color[0] > maxValue || color[1] > maxValue || color[2] > maxValue)
+                        continue;
+
+                    FitSubblock(subblock, color, bits, punchThrough, &fits[fitCount++]);
+                }
+            }
+        }
+        return fitCount;
+    }
+
+    const SubblockFit* BestFit(const SubblockFit* fits, uint32_t count)
+    {
+        const SubblockFit* best = &fits[0];
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            if (fits[i].error < best->error)
+                best = &fits[i];
+        }
+        return best;
+    }
+
+    uint64_t PackSubblockIndices(const Subblock subblocks[2], const SubblockFit* fit0, const SubblockFit* fit1)
+    {
+        uint8_t indices[16];
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            indices[subblocks[0].pixels[i]] = fit0->indices[i];
+            indices[subblocks[1].pixels[i]] = fit1->indices[i];
+        }
+        return PackIndices(indices);
+    }
+
+    void EncodeIndividual(const ColorBlock& input, ImageCompressQuality quality, EncodedBlock* best)
+    {
+        for (uint32_t flip = 0; flip < 2; ++flip)
+        {
+            Subblock subblocks[2];
+            GatherSubblocks(input, flip, subblocks);
+
+            SubblockFit fits[2][27];
+            const uint32_t count0 = FitCandidates(subblocks[0], 4, false, quality, fits[0]);
+            const uint32_t count1 = FitCandidates(subblocks[1], 4, false, quality, fits[1]);
+            const SubblockFit* fit0 = BestFit(fits[0], count0);
+            const SubblockFit* fit1 = BestFit(fits[1], count1);
+            const uint32_t error = fit0->error + fit1->error;
+            if (error >= best->error)
+                continue;
+
+            uint64_t bits = 0;
+            bits |= (uint64_t)fit0->color[0] << 60 | (uint64_t)fit1->color[0] << 56;
+            bits |= (uint64_t)fit0->color[1] << 52 | (uint64_t)fit1->color[1] << 48;
+            bits |= (uint64_t)fit0->color[2] << 44 | (uint64_t)fit1->color[2] << 40;
+            bits |= (uint64_t)fit0->table << 37 | (uint64_t)fit1->table << 34;
+            bits |= (uint64_t)flip << 32;
+            bits |= PackSubblockIndices(subblocks, fit0, fit1);
+            best->bits = bits;
+            best->error = error;
+        }
+    }
+
+    // The second color is stored as a 3-bit signed delta of the first, pairs out of range are replaced by a clamped one.
+    // Returns false when a flip needed the clamped color.
+    bool EncodeDifferential(const ColorBlock& input, bool punchThrough, uint32_t opaqueBit, ImageCompressQuality quality, EncodedBlock* best)
+    {
+        bool inRange = true;
+        for (uint32_t flip = 0; flip < 2; ++flip)
+        {
+            Subblock subblocks[2];
+            GatherSubblocks(input, flip, subblocks);
+
+            SubblockFit fits[2][28];
+            const uint32_t count0 = FitCandidates(subblocks[0], 5, punchThrough, quality, fits[0]);
+            uint32_t count1 = FitCandidates(subblocks[1], 5, punchThrough, quality, fits[1]);
+
+            const SubblockFit* best0 = BestFit(fits[0], count0);
+            const SubblockFit* best1 = BestFit(fits[1], count1);
+            int32_t clamped[3];
+            bool clamping = false;
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                clamped[c] = best0->color[c] + Clamp(best1->color[c] - best0->color[c], -4, 3);
+                clamping = clamping || clamped[c] != best1->color[c];
+            }
+            if (clamping)
+            {
+                FitSubblock(subblocks[1], clamped, 5, punchThrough, &fits[1][count1++]);
+                inRange = false;
+            }
+
+            const SubblockFit* fit0 = nullptr;
+            const SubblockFit* fit1 = nullptr;
+            uint32_t error = UINT32_MAX;
+            for (uint32_t i = 0; i < count0; ++i)
+            {
+                for (uint32_t j = 0; j < count1; ++j)
+                {
+                    bool valid = true;
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        const int32_t delta = fits[1][j].color[c] - fits[0][i].color[c];
+                        valid = valid && delta >= -4 && delta <= 3;
+                    }
+
+                    if (valid && fits[0][i].error + fits[1][j].error < error)
+                    {
+                        error = fits[0][i].error + fits[1][j].error;
+                        fit0 = &fits[0][i];
+                        fit1 = &fits[1][j];
+                    }
+                }
+            }
+
+            if (!fit0 || error >= best->error)
+                continue;
+
+            uint64_t bits = 0;
+            bits |= (uint64_t)fit0->color[0] << 59 | (uint64_t)((fit1->color[0] - fit0->color[0]) & 7) << 56;
+            bits |= (uint64_t)fit0->color[1] << 51 | (uint64_t)((fit1->color[1] - fit0->color[1]) & 7) << 48;
+            bits |= (uint64_t)fit0->color[2] << 43 | (uint64_t)((fit1->color[2] - fit0->color[2]) & 7) << 40;
+            bits |= (uint64_t)fit0->table << 37 | (uint64_t)fit1->table << 34;
+            bits |= (uint64_t)opaqueBit << 33 | (uint64_t)flip << 32;
+            bits |= PackSubblockIndices(subblocks, fit0, fit1);
+            best->bits = bits;
+            best->error = error;
+        }
+        return inRange;
+    }
+
+    /* T and H modes */
+    // Two means clustering seeded with the darkest and brightest pixels, mask bits select the second cluster.
+    void SplitColors(const ColorBlock& input, int32_t means[2][3])
+    {
+        uint32_t low = 0;
+        uint32_t high = 0;
+        int32_t luminance[16];
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            luminance[p] = input.colors[p][0] + input.colors[p][1] + input.colors[p][2];
+            low = luminance[p] < luminance[low] ? p : low;
+            high = luminance[p] > luminance[high] ? p : high;
+        }
+
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            means[0][c] = input.colors[low][c];
+            means[1][c] = input.colors[high][c];
+        }
+
+        for (uint32_t iteration = 0; iteration < 3; ++iteration)
+        {
+            int32_t sums[2][3] = {};
+            int32_t counts[2] = {};
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                int32_t distance[2] = {};
+                for (uint32_t k = 0; k < 2; ++k)
+                {
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        const int32_t diff = input.colors[p][c] - means[k][c];
+                        distance[k] += diff * diff;
+                    }
+                }
+
+                const uint32_t k = distance[1] < distance[0] ? 1 : 0;
+                for (uint32_t c = 0; c < 3; ++c)
+                    sums[k][c] += input.colors[p][c];
+                counts[k]++;
+            }
+
+            for (uint32_t k = 0; k < 2; ++k)
+            {
+                if (!counts[k])
+                    continue;
+                for (uint32_t c = 0; c < 3; ++c)
+                    means[k][c] = (sums[k][c] + counts[k] / 2) / counts[k];
+            }
+        }
+    }
+
+    // Bits for fields that overlap the delta of a differential channel so that channel overflows (sum outside 0..31).
+    // low is the 2-bit tail of the 5-bit field and delta the 2 low bits of the 3-bit delta.
+    uint64_t ForceOverflow(uint32_t low, uint32_t delta, uint32_t fieldShift, uint32_t signShift)
+    {
+        if (low + delta >= 4)
+            return (uint64_t)7 << (fieldShift + 2);
+        return (uint64_t)1 << signShift;
+    }
+
+    // Top bit of a 5-bit differential field that keeps field + delta inside 0..31.
+    uint64_t AvoidOverflow(uint64_t bits, uint32_t fieldShift)
+    {
+        const int32_t field = (int32_t)((bits >> fieldShift) & 15);
+        int32_t delta = (int32_t)((bits >> (fieldShift - 3)) & 7);
+        delta = delta >= 4 ? delta - 8 : delta;
+        return field + delta < 0 ? (uint64_t)1 << (fieldShift + 4) : 0;
+    }
+
+    void EncodeT(const ColorBlock& input, const int32_t means[2][3], EncodedBlock* best)
+    {
+        for (uint32_t single = 0; single < 2; ++single)
+        {
+            int32_t color1[3];
+            int32_t color2[3];
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                color1[c] = QuantizeBits(means[single][c], 4);
+                color2[c] = QuantizeBits(means[single ^ 1][c], 4);
+            }
+
+            for (uint32_t distance = 0; distance < 8; ++distance)
+            {
+                const int32_t d = kETCDistances[distance];
+                uint8_t palette[4][4];
+                SetColor(palette[0], color1[0] * 17, color1[1] * 17, color1[2] * 17);
+                SetColor(palette[1], color2[0] * 17 + d, color2[1] * 17 + d, color2[2] * 17 + d);
+                SetColor(palette[2], color2[0] * 17, color2[1] * 17, color2[2] * 17);
+                SetColor(palette[3], color2[0] * 17 - d, color2[1] * 17 - d, color2[2] * 17 - d);
+
+                uint8_t indices[16];
+                uint32_t errors[16];
+                alimerFindNearestColors(input.colors, 16, palette, 4, indices, errors);
+                const uint32_t error = SumErrors(errors, 16, 0xFFFF);
+                if (error >= best->error)
+                    continue;
+
+                uint64_t bits = 0;
+                bits |= (uint64_t)(color1[0] >> 2) << 59 | (uint64_t)(color1[0] & 3) << 56;
+                bits |= (uint64_t)color1[1] << 52 | (uint64_t)color1[2] << 48;
+                bits |= (uint64_t)color2[0] << 44 | (uint64_t)color2[1] << 40 | (uint64_t)color2[2] << 36;
+                bits |= (uint64_t)(distance >> 1) << 34 | (uint64_t)1 << 33 | (uint64_t)(distance & 1) << 32;
+                bits |= ForceOverflow((uint32_t)color1[0] >> 2, (uint32_t)color1[0] & 3, 59, 58);
+                bits |= PackIndices(indices);
+                best->bits = bits;
+                best->error = error;
+            }
+        }
+    }
+
+    void EncodeH(const ColorBlock& input, const int32_t means[2][3], EncodedBlock* best)
+    {
+        int32_t colors[2][3];
+        for (uint32_t k = 0; k < 2; ++k)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+                colors[k][c] = QuantizeBits(means[k][c], 4);
+        }
+
+        const int32_t packed0 = (colors[0][0] << 8) | (colors[0][1] << 4) | colors[0][2];
+        const int32_t packed1 = (colors[1][0] << 8) | (colors[1][1] << 4) | colors[1][2];
+        if (packed0 == packed1)
+            return;
+
+        for (uint32_t distance = 0; distance < 8; ++distance)
+        {
+            // The lowest distance bit is implied by the order of the two colors.
+            const uint32_t first = (packed0 >= packed1) == ((distance & 1) != 0) ? 0 : 1;
+            const int32_t* color1 = colors[first];
+            const int32_t* color2 = colors[first ^ 1];
+            const int32_t d = kETCDistances[distance];
+            uint8_t palette[4][4];
+            SetColor(palette[0], color1[0] * 17 + d, color1[1] * 17 + d, color1[2] * 17 + d);
+            SetColor(palette[1], color1[0] * 17 - d, color1[1] * 17 - d, color1[2] * 17 - d);
+            SetColor(palette[2], color2[0] * 17 + d, color2[1] * 17 + d, color2[2] * 17 + d);
+            SetColor(palette[3], color2[0] * 17 - d, color2[1] * 17 - d, color2[2] * 17 - d);
+
+            uint8_t indices[16];
+            uint32_t errors[16];
+            alimerFindNearestColors(input.colors, 16, palette, 4, indices, errors);
+            const uint32_t error = SumErrors(errors, 16, 0xFFFF);
+            if (error >= best->error)
+                continue;
+
+            uint64_t bits = 0;
+            bits |= (uint64_t)color1[0] << 59;
+            bits |= (uint64_t)(color1[1] >> 1) << 56 | (uint64_t)(color1[1] & 1) << 52;
+            bits |= (uint64_t)(color1[2] >> 3) << 51 | (uint64_t)(color1[2] & 7) << 47;
+            bits |= (uint64_t)color2[0] << 43 | (uint64_t)color2[1] << 39 | (uint64_t)color2[2] << 35;
+            bits |= (uint64_t)(distance >> 2) << 34 | (uint64_t)1 << 33 | (uint64_t)((distance >> 1) & 1) << 32;
+            bits |= ForceOverflow((uint32_t)(bits >> 51) & 3, (uint32_t)(bits >> 48) & 3, 51, 50);
+            bits |= AvoidOverflow(bits, 59);
+            bits |= PackIndices(indices);
+            best->bits = bits;
+            best->error = error;
+        }
+    }
+
+    /* Planar mode */
+    // Least squares plane per channel, then the quantized origin, horizontal and vertical colors around it are searched.
+    void EncodePlanar(const ColorBlock& input, ImageCompressQuality quality, EncodedBlock* best)
+    {
+        static const int32_t kBits[3] = { 6, 7, 6 };
+        int32_t values[3][3];
+        uint32_t error = 0;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            float mean = 0.0f;
+            float slopeX = 0.0f;
+            float slopeY = 0.0f;
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                const float value = input.colors[p][c];
+                mean += value;
+                slopeX += ((float)(p & 3) - 1.5f) * value;
+                slopeY += ((float)(p >> 2) - 1.5f) * value;
+            }
+            mean /= 16.0f;
+            slopeX /= 20.0f;
+            slopeY /= 20.0f;
+
+            const float origin = mean - 1.5f * slopeX - 1.5f * slopeY;
+            const float targets[3] = { origin, origin + 4.0f * slopeX, origin + 4.0f * slopeY };
+            const int32_t maxValue = (1 << kBits[c]) - 1;
+            int32_t centers[3];
+            for (uint32_t i = 0; i < 3; ++i)
+                centers[i] = Clamp((int32_t)(targets[i] * maxValue / 255.0f + 0.5f), 0, maxValue);
+
+            const int32_t radius = quality == ImageCompressQuality_Fast ? 0 : 1;
+            uint32_t bestError = UINT32_MAX;
+            for (int32_t o = centers[0] - radius; o <= centers[0] + radius; ++o)
+            {
+                for (int32_t h = centers[1] - radius; h <= centers[1] + radius; ++h)
+                {
+                    for (int32_t v = centers[2] - radius; v <= centers[2] + radius; ++v)
+                    {
+                        if (o < 0 || h < 0 || v < 0 || o > maxValue || h > maxValue || v > maxValue)
+                            continue;
+
+                        const int32_t eo = ExpandBits(o, kBits[c]);
+                        const int32_t eh = ExpandBits(h, kBits[c]);
+                        const int32_t ev = ExpandBits(v, kBits[c]);
+                        uint32_t channelError = 0;
+                        for (uint32_t p = 0; p < 16; ++p)
+                        {
+                            const int32_t x = (int32_t)(p & 3);
+                            const int32_t y = (int32_t)(p >> 2);
+                            const int32_t decoded = Clamp((x * (eh - eo) + y * (ev - eo) + 4 * eo + 2) >> 2, 0, 255);
+                            const int32_t diff = decoded - input.colors[p][c];
+                            channelError += (uint32_t)(diff * diff);
+                        }
+
+                        if (channelError < bestError)
+                        {
+                            bestError = channelError;
+                            values[c][0] = o;
+                            values[c][1] = h;
+                            values[c][2] = v;
+                        }
+                    }
+                }
+            }
+            error += bestError;
+        }
+
+        if (error >= best->error)
+            return;
+
+        const uint32_t ro = (uint32_t)values[0][0], rh = (uint32_t)values[0][1], rv = (uint32_t)values[0][2];
+        const uint32_t go = (uint32_t)values[1][0], gh = (uint32_t)values[1][1], gv = (uint32_t)values[1][2];
+        const uint32_t bo = (uint32_t)values[2][0], bh = (uint32_t)values[2][1], bv = (uint32_t)values[2][2];
+        uint64_t bits = 0;
+        bits |= (uint64_t)ro << 57;
+        bits |= (uint64_t)(go >> 6) << 56 | (uint64_t)(go & 63) << 49;
+        bits |= (uint64_t)(bo >> 5) << 48 | (uint64_t)((bo >> 3) & 3) << 43 | (uint64_t)(bo & 7) << 39;
+        bits |= (uint64_t)(rh >> 1) << 34 | (uint64_t)1 << 33 | (uint64_t)(rh & 1) << 32;
+        bits |= (uint64_t)gh << 25 | (uint64_t)bh << 19 | (uint64_t)rv << 13 | (uint64_t)gv << 6 | (uint64_t)bv;
+        bits |= ForceOverflow((bo >> 3) & 3, (bo >> 1) & 3, 43, 42);
+        bits |= AvoidOverflow(bits, 51);
+        bits |= AvoidOverflow(bits, 59);
+        best->bits = bits;
+        best->error = error;
+    }
+
+    // ETC2 RGB (and RGB with punch-through alpha): every mode is tried and the lowest error wins.
+    // Blocks with transparent pixels only have the differential mode.
+    void EncodeETC2Color(const BlockPixels pixels, bool punchThrough, ImageCompressQuality quality, uint8_t* block)
+    {
+        ColorBlock input;
+        input.opaqueMask = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            SetColor(input.colors[p], pixels[p][0], pixels[p][1], pixels[p][2]);
+            if (!punchThrough || pixels[p][3] >= 128)
+                input.opaqueMask |= 1u << p;
+        }
+
+        EncodedBlock best;
+        best.bits = 0;
+        best.error = UINT32_MAX;
+        if (input.opaqueMask != 0xFFFF)
+        {
+            EncodeDifferential(input, true, 0, quality, &best);
+            StoreBlock(best.bits, block);
+            return;
+        }
+
+        // Individual colors only pay off when the differential deltas are out of range, Fast skips them otherwise.
+        const bool inRange = EncodeDifferential(input, false, 1, quality, &best);
+        if (!punchThrough && (!inRange || quality != ImageCompressQuality_Fast))
+            EncodeIndividual(input, quality, &best);
+        if (best.error > 0)
+            EncodePlanar(input, quality, &best);
+
+        if (best.error > 0)
+        {
+            int32_t means[2][3];
+            SplitColors(input, means);
+            EncodeT(input, means, &best);
+            EncodeH(input, means, &best);
+        }
+
+        StoreBlock(best.bits, block);
+    }
+
+    /* EAC */
+    struct EACFormat
+    {
+        // Decoded value is clamp(base * scale + offset + modifier * multiplier * scale, low, high).
+        int32_t scale;
+        int32_t offset;
+        int32_t low;
+        int32_t high;
+        int32_t baseMin;
+        int32_t baseMax;
+    };
+
+    const EACFormat kEACAlpha = { 1, 0, 0, 255, 0, 255 };
+    const EACFormat kEACUnorm11 = { 8, 4, 0, 2047, 0, 255 };
+    const EACFormat kEACSnorm11 = { 8, 0, -1023, 1023, -127, 127 };
+
+    // Squared error of the best palette entry for each of the 16 values.
+    uint32_t EvaluateEAC(const int16_t* values, const int16_t* palette)
+    {
+#if defined(ALIMER_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i values0 = _mm_loadu_si128((const __m128i*)values);
+        const __m128i values1 = _mm_loadu_si128((const __m128i*)(values + 8));
+        __m128i best0 = _mm_set1_epi16(0x7FFF);
+        __m128i best1 = best0;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            const __m128i entry = _mm_set1_epi16(palette[i]);
+            const __m128i diff0 = _mm_sub_epi16(values0, entry);
+            const __m128i diff1 = _mm_sub_epi16(values1, entry);
+            best0 = _mm_min_epi16(best0, _mm_max_epi16(diff0, _mm_sub_epi16(zero, diff0)));
+            best1 = _mm_min_epi16(best1, _mm_max_epi16(diff1, _mm_sub_epi16(zero, diff1)));
+        }
+
+        __m128i sum = _mm_add_epi32(_mm_madd_epi16(best0, best0), _mm_madd_epi16(best1, best1));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        return (uint32_t)_mm_cvtsi128_si32(sum);
+#elif defined(ALIMER_NEON)
+        const int16x8_t values0 = vld1q_s16(values);
+        const int16x8_t values1 = vld1q_s16(values + 8);
+        int16x8_t best0 = vdupq_n_s16(0x7FFF);
+        int16x8_t best1 = best0;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            const int16x8_t entry = vdupq_n_s16(palette[i]);
+            best0 = vminq_s16(best0, vabdq_s16(values0, entry));
+            best1 = vminq_s16(best1, vabdq_s16(values1, entry));
+        }
+
+        int32x4_t sum = vmull_s16(vget_low_s16(best0), vget_low_s16(best0));
+        sum = vmlal_s16(sum, vget_high_s16(best0), vget_high_s16(best0));
+        sum = vmlal_s16(sum, vget_low_s16(best1), vget_low_s16(best1));
+        sum = vmlal_s16(sum, vget_high_s16(best1), vget_high_s16(best1));
+        return (uint32_t)vaddvq_s32(sum);
+#else
+        uint32_t total = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            int32_t best = 0x7FFF;
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                int32_t diff = values[p] - palette[i];
+                diff = diff < 0 ? -diff : diff;
+                best = diff < best ? diff : best;
+            }
+            total += (uint32_t)(best * best);
+        }
+        return total;
+#endif
+    }
+
+    void BuildEACPalette(const EACFormat& format, int32_t base, int32_t multiplier, uint32_t table, int16_t* palette)
+    {
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            const int32_t value = base * format.scale + format.offset + kEACModifiers[table][i] * multiplier * format.scale;
+            palette[i] = (int16_t)Clamp(value, format.low, format.high);
+        }
+    }
+
+    // Every table is tried with the multiplier and base that map its modifier range onto the value range, plus neighbours above Fast.
+    void EncodeEAC(const int16_t* values, const EACFormat& format, ImageCompressQuality quality, uint8_t* block)
+    {
+        int32_t low = values[0];
+        int32_t high = values[0];
+        for (uint32_t p = 1; p < 16; ++p)
+        {
+            low = values[p] < low ? values[p] : low;
+            high = values[p] > high ? values[p] : high;
+        }
+
+        const int32_t radius = quality == ImageCompressQuality_Fast ? 0 : (quality == ImageCompressQuality_Normal ? 1 : 2);
+        uint32_t bestError = UINT32_MAX;
+        int32_t bestBase = 0;
+        int32_t bestMultiplier = 1;
+        uint32_t bestTable = 0;
+        for (uint32_t table = 0; table < 16 && bestError > 0; ++table)
+        {
+            const int32_t modifierMin = kEACModifiers[table][3];
+            const int32_t modifierMax = kEACModifiers[table][7];
+            const int32_t span = (modifierMax - modifierMin) * format.scale;
+            const int32_t centerMultiplier = Clamp((high - low + span / 2) / span, 1, 15);
+            for (int32_t multiplier = centerMultiplier - radius; multiplier <= centerMultiplier + radius; ++multiplier)
+            {
+                if (multiplier < 1 || multiplier > 15)
+                    continue;
+
+                // Base that centers the modifier range on the value range.
+                const float center = (low + high) * 0.5f - format.offset - (modifierMin + modifierMax) * multiplier * format.scale * 0.5f;
+                const int32_t centerBase = (int32_t)floorf(center / format.scale + 0.5f);
+                for (int32_t base = centerBase - radius; base <= centerBase + radius; ++base)
+                {
+                    const int32_t clampedBase = Clamp(base, format.baseMin, format.baseMax);
+                    if (clampedBase != base && base != centerBase)
+                        continue;
+
+                    int16_t palette[8];
+                    BuildEACPalette(format, clampedBase, multiplier, table, palette);
+                    const uint32_t error = EvaluateEAC(values, palette);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        bestBase = clampedBase;
+                        bestMultiplier = multiplier;
+                        bestTable = table;
+                    }
+                }
+            }
+        }
+
+        int16_t palette[8];
+        BuildEACPalette(format, bestBase, bestMultiplier, bestTable, palette);
+        uint64_t bits = (uint64_t)(bestBase & 0xFF) << 56 | (uint64_t)bestMultiplier << 52 | (uint64_t)bestTable << 48;
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            uint32_t bestIndex = 0;
+            int32_t bestDiff = 0x7FFF;
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                int32_t diff = values[p] - palette[i];
+                diff = diff < 0 ? -diff : diff;
+                if (diff < bestDiff)
+                {
+                    bestDiff = diff;
+                    bestIndex = i;
+                }
+            }
+            bits |= (uint64_t)bestIndex << (45 - 3 * PixelBit(p));
+        }
+
+        StoreBlock(bits, block);
+    }
+
+    void EncodeEACChannel(const BlockPixels pixels, uint32_t channel, bool snorm, bool elevenBits, ImageCompressQuality quality, uint8_t* block)
+    {
+        int16_t values[16];
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            if (!elevenBits)
+                values[p] = pixels[p][channel];
+            else if (snorm)
+            {
+                const int32_t value = Clamp((int8_t)pixels[p][channel], -127, 127);
+                values[p] = (int16_t)((value * 1023 + (value < 0 ? -63 : 63)) / 127);
+            }
+            else
+                values[p] = (int16_t)((pixels[p][channel] * 2047 + 127) / 255);
+        }
+
+        EncodeEAC(values, !elevenBits ? kEACAlpha : (snorm ? kEACSnorm11 : kEACUnorm11), quality, block);
+    }
+
+    /* Decoding */
+    uint64_t LoadBlock(const uint8_t* block)
+    {
+        uint64_t value = 0;
+        for (uint32_t i = 0; i < 8; ++i)
+            value = (value << 8) | block[i];
+        return value;
+    }
+
+    inline uint32_t GetPixelIndex(uint64_t bits, uint32_t pixel)
+    {
+        const uint32_t bit = PixelBit(pixel);
+        return (uint32_t)((((bits >> (16 + bit)) & 1) << 1) | ((bits >> bit) & 1));
+    }
+
+    inline uint32_t GetField(uint64_t bits, uint32_t shift, uint32_t count)
+    {
+        return (uint32_t)(bits >> shift) & ((1u << count) - 1);
+    }
+
+    void DecodePlanar(uint64_t bits, BlockPixels pixels)
+    {
+        const int32_t origin[3] = {
+            ExpandBits((int32_t)GetField(bits, 57, 6), 6),
+            ExpandBits((int32_t)((GetField(bits, 56, 1) << 6) | GetField(bits, 49, 6)), 7),
+            ExpandBits((int32_t)((GetField(bits, 48, 1) << 5) | (GetField(bits, 43, 2) << 3) | GetField(bits, 39, 3)), 6),
+        };
+        const int32_t horizontal[3] = {
+            ExpandBits((int32_t)((GetField(bits, 34, 5) << 1) | GetField(bits, 32, 1)), 6),
+            ExpandBits((int32_t)GetField(bits, 25, 7), 7),
+            ExpandBits((int32_t)GetField(bits, 19, 6), 6),
+        };
+        const int32_t vertical[3] = {
+            ExpandBits((int32_t)GetField(bits, 13, 6), 6),
+            ExpandBits((int32_t)GetField(bits, 6, 7), 7),
+            ExpandBits((int32_t)GetField(bits, 0, 6), 6),
+        };
+
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            const int32_t x = (int32_t)(p & 3);
+            const int32_t y = (int32_t)(p >> 2);
+            for (uint32_t c = 0; c < 3; ++c)
+                pixels[p][c] = (uint8_t)Clamp((x * (horizontal[c] - origin[c]) + y * (vertical[c] - origin[c]) + 4 * origin[c] + 2) >> 2, 0, 255);
+            pixels[p][3] = 255;
+        }
+    }
+
+    // Without the opaque bit of the punch-through formats, index 2 is transparent black and index 0 is the base color.
+    void DecodeETC2Color(const uint8_t* block, bool punchThrough, BlockPixels pixels)
+    {
+        const uint64_t bits = LoadBlock(block);
+        const bool opaque = !punchThrough || GetField(bits, 33, 1);
+        uint8_t palette[2][4][4];
+        bool paletteIndices = false;
+        if (!punchThrough && !GetField(bits, 33, 1))
+        {
+            for (uint32_t s = 0; s < 2; ++s)
+            {
+                const int32_t shift = s ? 56 : 60;
+                palette[s][0][0] = (uint8_t)(GetField(bits, shift, 4) * 17);
+                palette[s][0][1] = (uint8_t)(GetField(bits, shift - 8, 4) * 17);
+                palette[s][0][2] = (uint8_t)(GetField(bits, shift - 16, 4) * 17);
+            }
+        }
+        else
+        {
+            int32_t colors[2][3];
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                const uint32_t shift = 59 - 8 * c;
+                colors[0][c] = (int32_t)GetField(bits, shift, 5);
+                const int32_t delta = (int32_t)GetField(bits, shift - 3, 3);
+                colors[1][c] = colors[0][c] + (delta >= 4 ? delta - 8 : delta);
+            }
+
+            if (colors[1][0] < 0 || colors[1][0] > 31)
+            {
+                // T mode.
+                const int32_t color1[3] = {
+                    (int32_t)((GetField(bits, 59, 2) << 2) | GetField(bits, 56, 2)) * 17,
+                    (int32_t)GetField(bits, 52, 4) * 17,
+                    (int32_t)GetField(bits, 48, 4) * 17,
+                };
+                const int32_t color2[3] = { (int32_t)GetField(bits, 44, 4) * 17, (int32_t)GetField(bits, 40, 4) * 17, (int32_t)GetField(bits, 36, 4) * 17 };
+                const int32_t d = kETCDistances[(GetField(bits, 34, 2) << 1) | GetField(bits, 32, 1)];
+                SetColor(palette[0][0], color1[0], color1[1], color1[2]);
+                SetColor(palette[0][1], color2[0] + d, color2[1] + d, color2[2] + d);
+                SetColor(palette[0][2], color2[0], color2[1], color2[2]);
+                SetColor(palette[0][3], color2[0] - d, color2[1] - d, color2[2] - d);
+                paletteIndices = true;
+            }
+            else if (colors[1][1] < 0 || colors[1][1] > 31)
+            {
+                // H mode, the lowest distance bit is the order of the two colors.
+                const int32_t color1[3] = {
+                    (int32_t)GetField(bits, 59, 4),
+                    (int32_t)((GetField(bits, 56, 3) << 1) | GetField(bits, 52, 1)),
+                    (int32_t)((GetField(bits, 51, 1) << 3) | GetField(bits, 47, 3)),
+                };
+                const int32_t color2[3] = { (int32_t)GetField(bits, 43, 4), (int32_t)GetField(bits, 39, 4), (int32_t)GetField(bits, 35, 4) };
+                const int32_t packed1 = (color1[0] << 8) | (color1[1] << 4) | color1[2];
+                const int32_t packed2 = (color2[0] << 8) | (color2[1] << 4) | color2[2];
+                const int32_t d = kETCDistances[(GetField(bits, 34, 1) << 2) | (GetField(bits, 32, 1) << 1) | (packed1 >= packed2 ? 1 : 0)];
+                SetColor(palette[0][0], color1[0] * 17 + d, color1[1] * 17 + d, color1[2] * 17 + d);
+                SetColor(palette[0][1], color1[0] * 17 - d, color1[1] * 17 - d, color1[2] * 17 - d);
+                SetColor(palette[0][2], color2[0] * 17 + d, color2[1] * 17 + d, color2[2] * 17 + d);
+                SetColor(palette[0][3], color2[0] * 17 - d, color2[1] * 17 - d, color2[2] * 17 - d);
+                paletteIndices = true;
+            }
+            else if (colors[1][2] < 0 || colors[1][2] > 31)
+            {
+                DecodePlanar(bits, pixels);
+                return;
+            }
+            else
+            {
+                for (uint32_t s = 0; s < 2; ++s)
+                {
+                    for (uint32_t c = 0; c < 3; ++c)
+                        palette[s][0][c] = (uint8_t)ExpandBits(colors[s][c], 5);
+                }
+            }
+        }
+
+        if (paletteIndices)
+        {
+            for (uint32_t i = 0; i < 4; ++i)
+                palette[0][i][3] = 255;
+            if (!opaque)
+                memset(palette[0][2], 0, 4);
+        }
+        else
+        {
+            // Base colors of the two subblocks with their modifier tables, indices 0 to 3 are +a, +b, -a, -b.
+            for (uint32_t s = 0; s < 2; ++s)
+            {
+                const int32_t base[3] = { palette[s][0][0], palette[s][0][1], palette[s][0][2] };
+                const uint32_t table = GetField(bits, s ? 34 : 37, 3);
+                const int32_t a = opaque ? kETCModifiers[table][0] : 0;
+                const int32_t b = kETCModifiers[table][1];
+                SetColor(palette[s][0], base[0] + a, base[1] + a, base[2] + a);
+                SetColor(palette[s][1], base[0] + b, base[1] + b, base[2] + b);
+                SetColor(palette[s][2], base[0] - a, base[1] - a, base[2] - a);
+                SetColor(palette[s][3], base[0] - b, base[1] - b, base[2] - b);
+                for (uint32_t i = 0; i < 4; ++i)
+                    palette[s][i][3] = 255;
+                if (!opaque)
+                    memset(palette[s][2], 0, 4);
+            }
+        }
+
+        // Flip 0 splits the block in left and right halves, flip 1 in top and bottom ones.
+        const uint32_t flip = GetField(bits, 32, 1);
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            const uint32_t s = paletteIndices ? 0 : (flip ? p >> 3 : (p & 3) >> 1);
+            memcpy(pixels[p], palette[s][GetPixelIndex(bits, p)], 4);
+        }
+    }
+
+    void DecodeEAC(const uint8_t* block, const EACFormat& format, int32_t values[16])
+    {
+        const uint64_t bits = LoadBlock(block);
+        int32_t base = format.baseMin < 0 ? (int32_t)(int8_t)GetField(bits, 56, 8) : (int32_t)GetField(bits, 56, 8);
+        // A signed base of -128 is treated as -127.
+        if (base < -127)
+            base = -127;
+        const int32_t multiplier = (int32_t)GetField(bits, 52, 4);
+        const uint32_t table = GetField(bits, 48, 4);
+        // A zero multiplier keeps the 11-bit modifiers unscaled.
+        const int32_t step = multiplier ? multiplier * format.scale : (format.scale > 1 ? 1 : 0);
+        for (uint32_t p = 0; p < 16; ++p)
+        {
+            const int32_t modifier = kEACModifiers[table][GetField(bits, 45 - 3 * PixelBit(p), 3)];
+            values[p] = Clamp(base * format.scale + format.offset + modifier * step, format.low, format.high);
+        }
+    }
+}
+
+void alimerEncodeETCBlock(PixelFormat format, const uint8_t* pixels, void* block, ImageCompressQuality quality)
+{
+    const BlockPixels& input = *(const BlockPixels*)pixels;
+    uint8_t* output = (uint8_t*)block;
+
+    switch (format)
+    {
+        case PixelFormat_ETC2RGB8Unorm:
+        case PixelFormat_ETC2RGB8UnormSrgb:
+            EncodeETC2Color(input, false, quality, output);
+            break;
+        case PixelFormat_ETC2RGB8A1Unorm:
+        case PixelFormat_ETC2RGB8A1UnormSrgb:
+            EncodeETC2Color(input, true, quality, output);
+            break;
+        case PixelFormat_ETC2RGBA8Unorm:
+        case PixelFormat_ETC2RGBA8UnormSrgb:
+            EncodeEACChannel(input, 3, false, false, quality, output);
+            EncodeETC2Color(input, false, quality, output + 8);
+            break;
+        case PixelFormat_EACR11Unorm:
+        case PixelFormat_EACR11Snorm:
+            EncodeEACChannel(input, 0, format == PixelFormat_EACR11Snorm, true, quality, output);
+            break;
+        case PixelFormat_EACRG11Unorm:
+        case PixelFormat_EACRG11Snorm:
+            EncodeEACChannel(input, 0, format == PixelFormat_EACRG11Snorm, true, quality, output);
+            EncodeEACChannel(input, 1, format == PixelFormat_EACRG11Snorm, true, quality, output + 8);
+            break;
+        default:
+            ALIMER_ASSERT(false);
+            break;
+    }
+}
+
+void alimerDecodeETCBlocks(PixelFormat format, const void* blocks, uint32_t blockCount, void* pixels, size_t rowPitch)
+{
+    const uint8_t* input = (const uint8_t*)blocks;
+    uint8_t* output = (uint8_t*)pixels;
+    const uint32_t blockSize = GetFormatBytesPerBlock(format);
+    for (uint32_t b = 0; b < blockCount; ++b, input += blockSize)
+    {
+        switch (format)
+        {
+            case PixelFormat_ETC2RGB8Unorm:
+            case PixelFormat_ETC2RGB8UnormSrgb:
+            case PixelFormat_ETC2RGB8A1Unorm:
+            case PixelFormat_ETC2RGB8A1UnormSrgb:
+            case PixelFormat_ETC2RGBA8Unorm:
+            case PixelFormat_ETC2RGBA8UnormSrgb:
+            {
+                const bool separateAlpha = format == PixelFormat_ETC2RGBA8Unorm || format == PixelFormat_ETC2RGBA8UnormSrgb;
+                BlockPixels decoded;
+                DecodeETC2Color(separateAlpha ? input + 8 : input, format == PixelFormat_ETC2RGB8A1Unorm || format == PixelFormat_ETC2RGB8A1UnormSrgb, decoded);
+                if (separateAlpha)
+                {
+                    int32_t alpha[16];
+                    DecodeEAC(input, kEACAlpha, alpha);
+                    for (uint32_t p = 0; p < 16; ++p)
+                        decoded[p][3] = (uint8_t)alpha[p];
+                }
+
+                for (uint32_t y = 0; y < 4; ++y)
+                    memcpy(output + y * rowPitch + b * 16, decoded[y * 4], 16);
+                break;
+            }
+            default:
+            {
+                // 11-bit values are widened to RGBA16, the unused channels decode to 0 and alpha to one.
+                const bool snorm = format == PixelFormat_EACR11Snorm || format == PixelFormat_EACRG11Snorm;
+                const uint32_t channelCount = format == PixelFormat_EACRG11Unorm || format == PixelFormat_EACRG11Snorm ? 2 : 1;
+                uint16_t decoded[16][4];
+                for (uint32_t p = 0; p < 16; ++p)
+                {
+                    decoded[p][1] = decoded[p][2] = 0;
+                    decoded[p][3] = snorm ? 0x7FFF : 0xFFFF;
+                }
+
+                for (uint32_t c = 0; c < channelCount; ++c)
+                {
+                    int32_t values[16];
+                    DecodeEAC(input + c * 8, snorm ? kEACSnorm11 : kEACUnorm11, values);
+                    for (uint32_t p = 0; p < 16; ++p)
+                    {
+                        const int32_t value = values[p];
+                        decoded[p][c] = snorm
+                            ? (uint16_t)(int16_t)((value * 32767 + (value < 0 ? -511 : 511)) / 1023)
+                            : (uint16_t)((value * 65535 + 1023) / 2047);
+                    }
+                }
+
+                for (uint32_t y = 0; y < 4; ++y)
+                    memcpy(output + y * rowPitch + b * 32, decoded[y * 4], 32);
+                break;
+            }
+        }
+    }
+}
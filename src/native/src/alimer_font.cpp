@@ -2,21 +2,431 @@
 // Licensed under the MIT License (MIT). See LICENSE in the repository root for more information.
 
 #include "alimer_internal.h"
+#include <math.h>
+#include <algorithm>
+#include <atomic>
 
 ALIMER_DISABLE_WARNINGS()
+#define STBTT_malloc(x, u) ((void)(u), alimerScratchAlloc(x))
+#define STBTT_free(x, u) ((void)(u), alimerScratchFree(x))
 #define STBTT_STATIC
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "third_party/stb_truetype.h"
 ALIMER_ENABLE_WARNINGS()
 
+#define ALIMER_FONT_BLOCK_SIZE 256
+#define ALIMER_FONT_CODEPOINT_BLOCKS (0x110000 / ALIMER_FONT_BLOCK_SIZE)
+#define ALIMER_FONT_KERN_EMPTY 0xFFFFFFFFu
+
+// Horizontal metrics and box of a glyph in font units.
+struct GlyphMetrics
+{
+    int16_t advance;
+    int16_t leftSideBearing;
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+    // stbtt_GetGlyphBox succeeded, the box is zero otherwise.
+    uint8_t hasBox;
+    uint8_t empty;
+};
+
+struct KernPair
+{
+    uint32_t key;
+    int32_t advance;
+};
+
+// GPOS class pair subtable: a glyph1 class row of advances indexed by the class of glyph2.
+struct KernClassTable
+{
+    const uint8_t* classRecords;
+    uint32_t class2Count;
+    // Class of every glyph in the second class definition, UINT16_MAX where stb_truetype gives up.
+    uint16_t* classes;
+};
+
 struct Font {
     stbtt_fontinfo info;
     int ascent;
     int descent;
     int lineGap;
     int spaceAdvance;
+    uint32_t numGlyphs;
+
+    // Filled on first use, a block is published once complete so readers never lock.
+    std::atomic<uint16_t*>* codepointBlocks;
+    std::atomic<GlyphMetrics*>* metricBlocks;
+
+    // Kerning flattened at creation, same results as stbtt_GetGlyphKernAdvance: the pairs of the format 1 subtables (and of the kern table)
+    // come first, then the class subtable that ends the GPOS search for glyph1.
+    uint32_t kernMask;
+    KernPair* kernPairs;
+    uint8_t* kernHasPairs;
+    uint32_t* kernClassRows;
+    uint32_t kernClassTableCount;
+    KernClassTable* kernClassTables;
+};
+
+/* Glyph tables */
+static uint16_t* LoadCodepointBlock(Font* font, uint32_t block)
+{
+    MemoryCategoryScope category(MemoryCategory_Font);
+    uint16_t* glyphs = ALIMER_ALLOCN(uint16_t, ALIMER_FONT_BLOCK_SIZE);
+    if (!glyphs)
+        return nullptr;
+
+    for (uint32_t i = 0; i < ALIMER_FONT_BLOCK_SIZE; ++i)
+        glyphs[i] = (uint16_t)stbtt_FindGlyphIndex(&font->info, (int)(block * ALIMER_FONT_BLOCK_SIZE + i));
+
+    // Another thread may have won the race, keep its block.
+    uint16_t* expected = nullptr;
+    if (!font->codepointBlocks[block].compare_exchange_strong(expected, glyphs, std::memory_order_acq_rel))
+    {
+        alimerFree(glyphs);
+        return expected;
+    }
+    return glyphs;
+}
+
+static GlyphMetrics* LoadMetricBlock(Font* font, uint32_t block)
+{
+    MemoryCategoryScope category(MemoryCategory_Font);
+    GlyphMetrics* metrics = ALIMER_ALLOCN(GlyphMetrics, ALIMER_FONT_BLOCK_SIZE);
+    if (!metrics)
+        return nullptr;
+
+    const uint32_t first = block * ALIMER_FONT_BLOCK_SIZE;
+    const uint32_t count = std::min(font->numGlyphs - first, (uint32_t)ALIMER_FONT_BLOCK_SIZE);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // The boxes of CFF glyphs come from running their charstrings, which uses the scratch arena.
+        ScratchScope scratch;
+        const int glyph = (int)(first + i);
+        int advance, bearing, x0, y0, x1, y1;
+        stbtt_GetGlyphHMetrics(&font->info, glyph, &advance, &bearing);
+        GlyphMetrics& glyphMetrics = metrics[i];
+        glyphMetrics.advance = (int16_t)advance;
+        glyphMetrics.leftSideBearing = (int16_t)bearing;
+        glyphMetrics.hasBox = stbtt_GetGlyphBox(&font->info, glyph, &x0, &y0, &x1, &y1) ? 1 : 0;
+        if (glyphMetrics.hasBox)
+        {
+            glyphMetrics.x0 = (int16_t)x0;
+            glyphMetrics.y0 = (int16_t)y0;
+            glyphMetrics.x1 = (int16_t)x1;
+            glyphMetrics.y1 = (int16_t)y1;
+        }
+        glyphMetrics.empty = stbtt_IsGlyphEmpty(&font->info, glyph) ? 1 : 0;
+    }
+
+    GlyphMetrics* expected = nullptr;
+    if (!font->metricBlocks[block].compare_exchange_strong(expected, metrics, std::memory_order_acq_rel))
+    {
+        alimerFree(metrics);
+        return expected;
+    }
+    return metrics;
+}
+
+static uint32_t FontFindGlyph(Font* font, uint32_t codepoint)
+{
+    if (codepoint >= 0x110000)
+        return (uint32_t)stbtt_FindGlyphIndex(&font->info, (int)codepoint);
+
+    const uint32_t block = codepoint / ALIMER_FONT_BLOCK_SIZE;
+    uint16_t* glyphs = font->codepointBlocks[block].load(std::memory_order_acquire);
+    if (ALIMER_UNLIKELY(!glyphs))
+    {
+        glyphs = LoadCodepointBlock(font, block);
+        if (!glyphs)
+            return (uint32_t)stbtt_FindGlyphIndex(&font->info, (int)codepoint);
+    }
+    return glyphs[codepoint % ALIMER_FONT_BLOCK_SIZE];
+}
+
+static const GlyphMetrics* FontGetGlyphMetrics(Font* font, uint32_t glyph)
+{
+    if (glyph >= font->numGlyphs)
+        return nullptr;
+
+    const uint32_t block = glyph / ALIMER_FONT_BLOCK_SIZE;
+    GlyphMetrics* metrics = font->metricBlocks[block].load(std::memory_order_acquire);
+    if (ALIMER_UNLIKELY(!metrics))
+    {
+        metrics = LoadMetricBlock(font, block);
+        if (!metrics)
+            return nullptr;
+    }
+    return &metrics[glyph % ALIMER_FONT_BLOCK_SIZE];
+}
+
+static uint32_t KernHash(uint32_t key, uint32_t mask)
+{
+    return (key * 0x9E3779B1u >> 7) & mask;
+}
+
+static int FontGetKernAdvance(const Font* font, uint32_t glyph1, uint32_t glyph2)
+{
+    if (glyph1 >= font->numGlyphs || glyph2 >= font->numGlyphs)
+        return 0;
+
+    if (font->kernHasPairs && font->kernHasPairs[glyph1])
+    {
+        const uint32_t key = glyph1 << 16 | glyph2;
+        for (uint32_t index = KernHash(key, font->kernMask); font->kernPairs[index].key != ALIMER_FONT_KERN_EMPTY; index = (index + 1) & font->kernMask)
+        {
+            if (font->kernPairs[index].key == key)
+                return font->kernPairs[index].advance;
+        }
+    }
+
+    if (!font->kernClassRows || font->kernClassRows[glyph1] == UINT32_MAX)
+        return 0;
+
+    const uint32_t row = font->kernClassRows[glyph1];
+    const KernClassTable& table = font->kernClassTables[row >> 16];
+    const uint32_t class2 = table.classes[glyph2];
+    if (class2 == UINT16_MAX)
+        return 0;
+    return ttSHORT((stbtt_uint8*)table.classRecords + 2 * ((row & 0xFFFF) * table.class2Count + class2));
+}
+
+// Growable list of pairs in lookup order, the first occurrence of a pair wins like in the stb_truetype search.
+struct KernPairList
+{
+    KernPair* pairs;
+    uint32_t count;
+    uint32_t capacity;
 };
 
+static bool AddKernPair(KernPairList* list, uint32_t glyph1, uint32_t glyph2, int advance)
+{
+    if (list->count == list->capacity)
+    {
+        const uint32_t capacity = std::max(list->capacity * 2, 1024u);
+        KernPair* pairs = (KernPair*)alimerRealloc(list->pairs, capacity * sizeof(KernPair));
+        if (!pairs)
+            return false;
+        list->pairs = pairs;
+        list->capacity = capacity;
+    }
+
+    list->pairs[list->count++] = { glyph1 << 16 | glyph2, advance };
+    return true;
+}
+
+static uint32_t AddKernClassTable(Font* font, const uint8_t* subtable)
+{
+    // Tables are referenced by subtable, the same one covers many glyph1 classes.
+    stbtt_uint8* table = (stbtt_uint8*)subtable;
+    for (uint32_t i = 0; i < font->kernClassTableCount; ++i)
+    {
+        if (font->kernClassTables[i].classRecords == table + 16)
+            return i;
+    }
+
+    const uint32_t count = font->kernClassTableCount;
+    KernClassTable* tables = (KernClassTable*)alimerRealloc(font->kernClassTables, (count + 1) * sizeof(KernClassTable));
+    uint16_t* classes = ALIMER_ALLOCN(uint16_t, font->numGlyphs);
+    if (tables)
+        font->kernClassTables = tables;
+    if (!tables || !classes || count >= UINT16_MAX)
+    {
+        alimerFree(classes);
+        return UINT32_MAX;
+    }
+
+    KernClassTable& classTable = font->kernClassTables[count];
+    classTable.classRecords = table + 16;
+    classTable.class2Count = ttUSHORT(table + 14);
+    classTable.classes = classes;
+    for (uint32_t glyph = 0; glyph < font->numGlyphs; ++glyph)
+    {
+        const stbtt_int32 glyphClass = stbtt__GetGlyphClass(table + ttUSHORT(table + 10), (int)glyph);
+        classes[glyph] = glyphClass < 0 || (uint32_t)glyphClass >= classTable.class2Count ? UINT16_MAX : (uint16_t)glyphClass;
+    }
+    font->kernClassTableCount++;
+    return count;
+}
+
+// Visit every glyph a GPOS coverage table covers with its coverage index.
+template<typename Func>
+static void ForEachCoveredGlyph(const uint8_t* coverage, Func func)
+{
+    stbtt_uint8* table = (stbtt_uint8*)coverage;
+    const stbtt_uint16 format = ttUSHORT(table);
+    const stbtt_uint16 count = ttUSHORT(table + 2);
+    if (format == 1)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            func(ttUSHORT(table + 4 + 2 * i), i);
+    }
+    else if (format == 2)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            stbtt_uint8* range = table + 4 + 6 * i;
+            const uint32_t start = ttUSHORT(range);
+            const uint32_t end = ttUSHORT(range + 2);
+            const uint32_t startIndex = ttUSHORT(range + 4);
+            for (uint32_t glyph = start; glyph <= end; ++glyph)
+                func(glyph, startIndex + glyph - start);
+        }
+    }
+}
+
+static bool CollectGPOSKerning(Font* font, KernPairList* list, uint8_t* finished)
+{
+    stbtt_uint8* data = font->info.data + font->info.gpos;
+    if (ttUSHORT(data) != 1 || ttUSHORT(data + 2) != 0)
+        return true;
+
+    // The same walk as stbtt__GetGlyphGPOSInfoAdvance, every glyph1 stops at the first subtable that returns.
+    bool success = true;
+    stbtt_uint8* lookupList = data + ttUSHORT(data + 8);
+    const stbtt_uint16 lookupCount = ttUSHORT(lookupList);
+    for (uint32_t i = 0; i < lookupCount && success; ++i)
+    {
+        stbtt_uint8* lookup = lookupList + ttUSHORT(lookupList + 2 + 2 * i);
+        if (ttUSHORT(lookup) != 2)
+            continue;
+
+        const stbtt_uint16 subtableCount = ttUSHORT(lookup + 4);
+        for (uint32_t j = 0; j < subtableCount && success; ++j)
+        {
+            stbtt_uint8* table = lookup + ttUSHORT(lookup + 6 + 2 * j);
+            const stbtt_uint16 format = ttUSHORT(table);
+            const bool xAdvanceOnly = (format == 1 || format == 2) && ttUSHORT(table + 4) == 4 && ttUSHORT(table + 6) == 0;
+            ForEachCoveredGlyph(table + ttUSHORT(table + 2), [&](uint32_t glyph1, uint32_t coverageIndex) {
+                if (glyph1 >= font->numGlyphs || finished[glyph1] || !success)
+                    return;
+
+                if (xAdvanceOnly && format == 1)
+                {
+                    // A glyph2 missing from the pair set moves on to the next subtable.
+                    if (coverageIndex >= ttUSHORT(table + 8))
+                    {
+                        finished[glyph1] = 1;
+                        return;
+                    }
+
+                    stbtt_uint8* pairSet = table + ttUSHORT(table + 10 + 2 * coverageIndex);
+                    const stbtt_uint16 pairCount = ttUSHORT(pairSet);
+                    for (uint32_t k = 0; k < pairCount && success; ++k)
+                        success = AddKernPair(list, glyph1, ttUSHORT(pairSet + 2 + 4 * k), ttSHORT(pairSet + 4 + 4 * k));
+                    font->kernHasPairs[glyph1] = 1;
+                    return;
+                }
+
+                finished[glyph1] = 1;
+                if (xAdvanceOnly && format == 2)
+                {
+                    const stbtt_int32 class1 = stbtt__GetGlyphClass(table + ttUSHORT(table + 8), (int)glyph1);
+                    if (class1 < 0 || class1 >= ttUSHORT(table + 12))
+                        return;
+
+                    const uint32_t tableIndex = AddKernClassTable(font, table);
+                    success = tableIndex != UINT32_MAX;
+                    font->kernClassRows[glyph1] = tableIndex << 16 | (uint32_t)class1;
+                }
+            });
+        }
+    }
+    return success;
+}
+
+static void CollectKernTablePairs(Font* font, KernPairList* list)
+{
+    // First table only, horizontal and format 0 like stb_truetype.
+    stbtt_uint8* data = font->info.data + font->info.kern;
+    if (ttUSHORT(data + 2) < 1 || ttUSHORT(data + 8) != 1)
+        return;
+
+    const stbtt_uint16 pairCount = ttUSHORT(data + 10);
+    for (uint32_t i = 0; i < pairCount; ++i)
+    {
+        const uint32_t glyph1 = ttUSHORT(data + 18 + 6 * i);
+        if (glyph1 < font->numGlyphs && AddKernPair(list, glyph1, ttUSHORT(data + 20 + 6 * i), ttSHORT(data + 22 + 6 * i)))
+            font->kernHasPairs[glyph1] = 1;
+    }
+}
+
+static bool BuildKerning(Font* font)
+{
+    if (!font->info.gpos && !font->info.kern)
+        return true;
+
+    font->kernHasPairs = ALIMER_ALLOCN(uint8_t, font->numGlyphs);
+    font->kernClassRows = (uint32_t*)alimerMalloc(sizeof(uint32_t) * font->numGlyphs);
+    uint8_t* finished = ALIMER_ALLOCN(uint8_t, font->numGlyphs);
+    KernPairList list = {};
+    bool success = font->kernHasPairs && font->kernClassRows && finished;
+    if (success)
+    {
+        memset(font->kernClassRows, 0xFF, sizeof(uint32_t) * font->numGlyphs);
+        if (font->info.gpos)
+            success = CollectGPOSKerning(font, &list, finished);
+        else
+            CollectKernTablePairs(font, &list);
+    }
+
+    if (success && list.count)
+    {
+        uint32_t capacity = 16;
+        while (capacity < list.count * 2)
+            capacity *= 2;
+
+        font->kernPairs = (KernPair*)alimerMalloc(sizeof(KernPair) * capacity);
+        success = font->kernPairs != nullptr;
+        if (success)
+        {
+            memset(font->kernPairs, 0xFF, sizeof(KernPair) * capacity);
+            font->kernMask = capacity - 1;
+            for (uint32_t i = 0; i < list.count; ++i)
+            {
+                uint32_t index = KernHash(list.pairs[i].key, font->kernMask);
+                while (font->kernPairs[index].key != ALIMER_FONT_KERN_EMPTY && font->kernPairs[index].key != list.pairs[i].key)
+                    index = (index + 1) & font->kernMask;
+                if (font->kernPairs[index].key == ALIMER_FONT_KERN_EMPTY)
+                    font->kernPairs[index] = list.pairs[i];
+            }
+        }
+    }
+
+    if (!font->kernPairs)
+    {
+        alimerFree(font->kernHasPairs);
+        font->kernHasPairs = nullptr;
+    }
+    if (!font->kernClassTableCount)
+    {
+        alimerFree(font->kernClassRows);
+        font->kernClassRows = nullptr;
+    }
+    alimerFree(list.pairs);
+    alimerFree(finished);
+    return success;
+}
+
+static void DestroyFont(Font* font)
+{
+    for (uint32_t i = 0; font->codepointBlocks && i < ALIMER_FONT_CODEPOINT_BLOCKS; ++i)
+        alimerFree(font->codepointBlocks[i].load(std::memory_order_relaxed));
+    for (uint32_t i = 0; font->metricBlocks && i < (font->numGlyphs + ALIMER_FONT_BLOCK_SIZE - 1) / ALIMER_FONT_BLOCK_SIZE; ++i)
+        alimerFree(font->metricBlocks[i].load(std::memory_order_relaxed));
+    for (uint32_t i = 0; i < font->kernClassTableCount; ++i)
+        alimerFree(font->kernClassTables[i].classes);
+
+    alimerFree(font->kernClassTables);
+    alimerFree(font->kernClassRows);
+    alimerFree(font->kernHasPairs);
+    alimerFree(font->kernPairs);
+    alimerFree(font->metricBlocks);
+    alimerFree(font->codepointBlocks);
+    alimerFree(font);
+}
+
 Font* alimerFontCreateFromMemory(const uint8_t* data, size_t size)
 {
     ALIMER_UNUSED(size);
@@ -28,8 +438,10 @@ Font* alimerFontCreateFromMemory(const uint8_t* data, size_t size)
         return nullptr;
     }
 
+    MemoryCategoryScope category(MemoryCategory_Font);
     Font* font = ALIMER_ALLOC(Font);
-    ALIMER_ASSERT(font);
+    if (!font)
+        return nullptr;
 
     if (!stbtt_InitFont(&font->info, data, offset))
     {
@@ -44,22 +456,40 @@ Font* alimerFontCreateFromMemory(const uint8_t* data, size_t size)
     stbtt_GetCodepointHMetrics(&font->info, ' ', &advance, &bearing);
     font->spaceAdvance = advance;
 
+    // Block tables start empty (null pointers), the blocks are loaded by the lookups.
+    font->numGlyphs = (uint32_t)std::max(font->info.numGlyphs, 0);
+    const uint32_t metricBlockCount = (font->numGlyphs + ALIMER_FONT_BLOCK_SIZE - 1) / ALIMER_FONT_BLOCK_SIZE;
+    font->codepointBlocks = ALIMER_ALLOCN(std::atomic<uint16_t*>, ALIMER_FONT_CODEPOINT_BLOCKS);
+    font->metricBlocks = ALIMER_ALLOCN(std::atomic<GlyphMetrics*>, metricBlockCount + 1);
+    if (!font->codepointBlocks || !font->metricBlocks || !BuildKerning(font))
+    {
+        DestroyFont(font);
+        return nullptr;
+    }
+
+    alimerTrackLiveFonts(1);
     return font;
 }
 
 void alimerFontDestroy(Font* font)
 {
-    alimerFree(font);
+    if (!font)
+        return;
+
+    DestroyFont(font);
+    alimerTrackLiveFonts(-1);
 }
 
 void alimerFontGetMetrics(Font* font, int* ascent, int* descent, int* linegap)
 {
-    stbtt_GetFontVMetrics(&font->info, ascent, descent, linegap);
+    *ascent = font->ascent;
+    *descent = font->descent;
+    *linegap = font->lineGap;
 }
 
 int alimerFontGetGlyphIndex(Font* font, int codepoint)
 {
-    return stbtt_FindGlyphIndex(&font->info, codepoint);
+    return (int)FontFindGlyph(font, (uint32_t)codepoint);
 }
 
 float alimerFontGetScale(Font* font, float size)
@@ -69,27 +499,46 @@ float alimerFontGetScale(Font* font, float size)
 
 float alimerFontGetKerning(Font* font, int glyph1, int glyph2, float scale)
 {
-    return stbtt_GetGlyphKernAdvance(&font->info, glyph1, glyph2) * scale;
+    return FontGetKernAdvance(font, (uint32_t)glyph1, (uint32_t)glyph2) * scale;
 }
 
 void alimerFontGetCharacter(Font* font, int glyph, float scale, int* width, int* height, float* advance, float* offsetX, float* offsetY, int* visible)
 {
-    int adv, ox, x0, y0, x1, y1;
+    const GlyphMetrics* metrics = FontGetGlyphMetrics(font, (uint32_t)glyph);
+    if (!metrics)
+    {
+        *width = 0;
+        *height = 0;
+        *advance = 0.0f;
+        *offsetX = 0.0f;
+        *offsetY = 0.0f;
+        *visible = 0;
+        return;
+    }
 
-    stbtt_GetGlyphHMetrics(&font->info, glyph, &adv, &ox);
-    stbtt_GetGlyphBitmapBox(&font->info, glyph, scale, scale, &x0, &y0, &x1, &y1);
+    // Same rounding as stbtt_GetGlyphBitmapBox.
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    if (metrics->hasBox)
+    {
+        x0 = (int)floor(metrics->x0 * scale);
+        y0 = (int)floor(-metrics->y1 * scale);
+        x1 = (int)ceil(metrics->x1 * scale);
+        y1 = (int)ceil(-metrics->y0 * scale);
+    }
 
     *width = (x1 - x0);
     *height = (y1 - y0);
-    *advance = adv * scale;
-    *offsetX = ox * scale;
+    *advance = metrics->advance * scale;
+    *offsetX = metrics->leftSideBearing * scale;
     *offsetY = (float)y0;
-    *visible = *width > 0 && *height > 0 && stbtt_IsGlyphEmpty(&font->info, glyph) == 0;
+    *visible = *width > 0 && *height > 0 && metrics->empty == 0;
 }
 
 void alimerFontGetPixels(Font* font, uint8_t* dest, int glyph, int width, int height, float scale)
 {
-    // parse it directly into the dest buffer
+    // parse it directly into the dest buffer, the rasterizer edge lists live in the thread arena
+    MemoryCategoryScope category(MemoryCategory_Font);
+    ScratchScope scratch;
     stbtt_MakeGlyphBitmap(&font->info, dest, width, height, width, scale, scale, glyph);
 
     // convert the buffer to RGBA data by working backwards, overwriting data
@@ -102,3 +551,1721 @@ void alimerFontGetPixels(Font* font, uint8_t* dest, int glyph, int width, int he
         dest[a + 3] = dest[b];
     }
 }
+
+/* Text layout */
+#define ALIMER_UTF8_REPLACEMENT 0xFFFDu
+
+// Decode the codepoint at *offset, malformed sequences (overlong, surrogates, truncated) give U+FFFD and skip a single byte.
+static uint32_t DecodeUtf8(const uint8_t* text, uint32_t length, uint32_t* offset)
+{
+    const uint32_t start = *offset;
+    const uint32_t lead = text[start];
+    *offset = start + 1;
+    if (lead < 0x80)
+        return lead;
+
+    uint32_t count, codepoint, minimum;
+    if ((lead & 0xE0) == 0xC0)
+    {
+        count = 1;
+        codepoint = lead & 0x1F;
+        minimum = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+        count = 2;
+        codepoint = lead & 0x0F;
+        minimum = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+        count = 3;
+        codepoint = lead & 0x07;
+        minimum = 0x10000;
+    }
+    else
+    {
+        return ALIMER_UTF8_REPLACEMENT;
+    }
+
+    if (count > length - start - 1)
+        return ALIMER_UTF8_REPLACEMENT;
+
+    for (uint32_t i = 1; i <= count; ++i)
+    {
+        const uint32_t next = text[start + i];
+        if ((next & 0xC0) != 0x80)
+            return ALIMER_UTF8_REPLACEMENT;
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+
+    if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+        return ALIMER_UTF8_REPLACEMENT;
+
+    *offset = start + 1 + count;
+    return codepoint;
+}
+
+struct TextLine
+{
+    uint32_t firstQuad;
+    float width;
+};
+
+struct TextLayout
+{
+    FontGlyphQuad* quads;
+    uint32_t quadCount;
+    float lineHeight;
+    float baseline;
+    float penX;
+    // Pen position after the last character that isn't a space, trailing spaces don't count towards the line width.
+    float contentWidth;
+    uint32_t prevGlyph;
+    uint32_t lineStart;
+    uint32_t lineChars;
+
+    // Last wrap opportunity of the line: the word after it starts at breakQuad and breakPenX.
+    bool hasBreak;
+    uint32_t breakQuad;
+    float breakPenX;
+    float breakWidth;
+    uint32_t breakChars;
+
+    // Only recorded when the lines need aligning.
+    TextLine* lines;
+    uint32_t lineCount;
+    uint32_t lineCapacity;
+    float maxLineWidth;
+};
+
+static bool EndTextLine(TextLayout* layout, float width, uint32_t endQuad)
+{
+    layout->maxLineWidth = std::max(layout->maxLineWidth, width);
+    if (layout->lines)
+    {
+        if (layout->lineCount == layout->lineCapacity)
+        {
+            const uint32_t capacity = std::max(layout->lineCapacity * 2, 16u);
+            TextLine* lines = (TextLine*)alimerScratchRealloc(layout->lines, sizeof(TextLine) * capacity);
+            if (!lines)
+                return false;
+            layout->lines = lines;
+            layout->lineCapacity = capacity;
+        }
+        layout->lines[layout->lineCount++] = { layout->lineStart, width };
+    }
+
+    layout->lineStart = endQuad;
+    layout->baseline += layout->lineHeight;
+    layout->hasBreak = false;
+    layout->prevGlyph = UINT32_MAX;
+    return true;
+}
+
+static void StartTextLine(TextLayout* layout)
+{
+    layout->penX = 0.0f;
+    layout->contentWidth = 0.0f;
+    layout->lineChars = 0;
+}
+
+// Move the word after the last wrap opportunity to a new line.
+static bool WrapTextLine(TextLayout* layout)
+{
+    const float shift = layout->breakPenX;
+    const uint32_t wordChars = layout->lineChars - layout->breakChars;
+    const float breakWidth = layout->breakWidth;
+    const uint32_t breakQuad = layout->breakQuad;
+    const uint32_t prevGlyph = layout->prevGlyph;
+    if (!EndTextLine(layout, breakWidth, breakQuad))
+        return false;
+
+    for (uint32_t i = breakQuad; i < layout->quadCount; ++i)
+    {
+        layout->quads[i].x -= shift;
+        layout->quads[i].y += layout->lineHeight;
+    }
+
+    // The kerning inside the word still applies, not the one across the break.
+    layout->penX -= shift;
+    layout->contentWidth = std::max(layout->contentWidth - shift, 0.0f);
+    layout->lineChars = wordChars;
+    layout->prevGlyph = wordChars ? prevGlyph : UINT32_MAX;
+    return true;
+}
+
+static void MarkTextBreak(TextLayout* layout)
+{
+    layout->hasBreak = true;
+    layout->breakQuad = layout->quadCount;
+    layout->breakPenX = layout->penX;
+    layout->breakChars = layout->lineChars;
+}
+
+bool alimerFontLayoutText(Font* font, const char* utf8, uint32_t length, float size, float maxWidth, FontTextAlign align, FontGlyphQuad* quads, uint32_t* quadCount)
+{
+    if (!font || (!utf8 && length) || !quads || !quadCount || !(size > 0.0f) || align >= _FontTextAlign_Count)
+        return false;
+
+    MemoryCategoryScope category(MemoryCategory_Font);
+    ScratchScope scratch;
+
+    const float scale = stbtt_ScaleForMappingEmToPixels(&font->info, size);
+    const uint8_t* text = (const uint8_t*)utf8;
+    const bool wrap = maxWidth > 0.0f;
+
+    TextLayout layout = {};
+    layout.quads = quads;
+    layout.lineHeight = (font->ascent - font->descent + font->lineGap) * scale;
+    layout.baseline = font->ascent * scale;
+    layout.prevGlyph = UINT32_MAX;
+    if (align != FontTextAlign_Left)
+    {
+        layout.lineCapacity = 16;
+        layout.lines = (TextLine*)alimerScratchAlloc(sizeof(TextLine) * layout.lineCapacity);
+        if (!layout.lines)
+            return false;
+    }
+    StartTextLine(&layout);
+
+    bool result = true;
+    uint32_t offset = 0;
+    while (offset < length && result)
+    {
+        const uint32_t codepoint = DecodeUtf8(text, length, &offset);
+        if (codepoint == '\n' || codepoint == '\r')
+        {
+            if (codepoint == '\r' && offset < length && text[offset] == '\n')
+                ++offset;
+            result = EndTextLine(&layout, layout.contentWidth, layout.quadCount);
+            StartTextLine(&layout);
+            continue;
+        }
+
+        // Zero width space: a wrap opportunity without a glyph.
+        if (codepoint == 0x200B)
+        {
+            MarkTextBreak(&layout);
+            layout.breakWidth = layout.contentWidth;
+            layout.prevGlyph = UINT32_MAX;
+            continue;
+        }
+
+        // Other control characters and the byte order mark draw nothing.
+        if ((codepoint < 0x20 && codepoint != '\t') || codepoint == 0x7F || codepoint == 0xFEFF)
+            continue;
+
+        const bool space = codepoint == ' ' || codepoint == '\t';
+        const uint32_t glyph = FontFindGlyph(font, space ? ' ' : codepoint);
+        const GlyphMetrics* metrics = FontGetGlyphMetrics(font, glyph);
+        if (!metrics)
+            continue;
+
+        if (space)
+        {
+            // Spaces hang past maxWidth and never start a line, the word after them can.
+            const float advance = metrics->advance * scale * (codepoint == '\t' ? 4.0f : 1.0f);
+            if (layout.prevGlyph != UINT32_MAX)
+                layout.penX += FontGetKernAdvance(font, layout.prevGlyph, glyph) * scale;
+            layout.penX += advance;
+            MarkTextBreak(&layout);
+            layout.breakWidth = layout.contentWidth;
+            layout.prevGlyph = glyph;
+            continue;
+        }
+
+        float kern = layout.prevGlyph != UINT32_MAX ? FontGetKernAdvance(font, layout.prevGlyph, glyph) * scale : 0.0f;
+        const float advance = metrics->advance * scale;
+        if (wrap && layout.lineChars > 0 && layout.penX + kern + advance > maxWidth)
+        {
+            if (layout.hasBreak && layout.breakChars > 0)
+            {
+                result = WrapTextLine(&layout);
+                kern = layout.prevGlyph != UINT32_MAX ? FontGetKernAdvance(font, layout.prevGlyph, glyph) * scale : 0.0f;
+            }
+
+            // A word wider than maxWidth breaks between its characters.
+            if (result && layout.lineChars > 0 && layout.penX + kern + advance > maxWidth)
+            {
+                result = EndTextLine(&layout, layout.contentWidth, layout.quadCount);
+                StartTextLine(&layout);
+                kern = 0.0f;
+            }
+        }
+
+        layout.penX += kern;
+        if (metrics->hasBox && !metrics->empty)
+        {
+            // Same rounding as stbtt_GetGlyphBitmapBox, so the quads line up with the atlas and glyph cache rectangles.
+            const float x0 = floorf(metrics->x0 * scale);
+            const float y0 = floorf(-metrics->y1 * scale);
+            const float x1 = ceilf(metrics->x1 * scale);
+            const float y1 = ceilf(-metrics->y0 * scale);
+            if (x1 > x0 && y1 > y0)
+            {
+                FontGlyphQuad& quad = quads[layout.quadCount++];
+                quad.glyph = glyph;
+                quad.x = layout.penX + x0;
+                quad.y = layout.baseline + y0;
+                quad.width = x1 - x0;
+                quad.height = y1 - y0;
+            }
+        }
+
+        layout.penX += advance;
+        layout.contentWidth = layout.penX;
+        layout.lineChars++;
+        layout.prevGlyph = glyph;
+
+        // Break after hyphens as well.
+        if (codepoint == '-' || codepoint == 0x2010)
+        {
+            MarkTextBreak(&layout);
+            layout.breakWidth = layout.contentWidth;
+        }
+    }
+
+    if (result)
+        result = EndTextLine(&layout, layout.contentWidth, layout.quadCount);
+
+    if (result && align != FontTextAlign_Left)
+    {
+        const float boxWidth = wrap ? maxWidth : layout.maxLineWidth;
+        const float factor = align == FontTextAlign_Center ? 0.5f : 1.0f;
+        for (uint32_t line = 0; line < layout.lineCount; ++line)
+        {
+            const uint32_t end = line + 1 < layout.lineCount ? layout.lines[line + 1].firstQuad : layout.quadCount;
+            const float shift = (boxWidth - layout.lines[line].width) * factor;
+            for (uint32_t i = layout.lines[line].firstQuad; i < end; ++i)
+                quads[i].x += shift;
+        }
+    }
+
+    alimerScratchFree(layout.lines);
+    *quadCount = result ? layout.quadCount : 0;
+    return result;
+}
+
+/* Skyline packer */
+struct SkylineNode
+{
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+};
+
+// Bottom-left skyline: the top edge of the packed area is a list of horizontal segments sorted by x, a node is at least one texel wide.
+struct Skyline
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t nodeCount;
+    // width + 1 entries.
+    SkylineNode* nodes;
+};
+
+static void SkylineReset(Skyline* skyline)
+{
+    skyline->nodeCount = 1;
+    skyline->nodes[0].x = 0;
+    skyline->nodes[0].y = 0;
+    skyline->nodes[0].width = skyline->width;
+}
+
+// Place the rectangle where its top edge ends up the lowest, leftmost on ties.
+static bool SkylineInsert(Skyline* skyline, uint32_t width, uint32_t height, uint32_t* x, uint32_t* y)
+{
+    SkylineNode* nodes = skyline->nodes;
+    uint32_t bestIndex = UINT32_MAX;
+    uint32_t bestY = 0;
+    uint32_t bestTop = UINT32_MAX;
+    for (uint32_t i = 0; i < skyline->nodeCount && nodes[i].x + width <= skyline->width; ++i)
+    {
+        uint32_t top = 0;
+        for (uint32_t j = i; j < skyline->nodeCount && nodes[j].x < nodes[i].x + width; ++j)
+            top = nodes[j].y > top ? nodes[j].y : top;
+
+        if (top + height <= skyline->height && top + height < bestTop)
+        {
+            bestIndex = i;
+            bestY = top;
+            bestTop = top + height;
+        }
+    }
+
+    if (bestIndex == UINT32_MAX)
+        return false;
+
+    // Drop the nodes the rectangle covers and trim the one it overlaps partially.
+    const uint32_t left = nodes[bestIndex].x;
+    const uint32_t right = left + width;
+    uint32_t end = bestIndex;
+    while (end < skyline->nodeCount && nodes[end].x + nodes[end].width <= right)
+        ++end;
+    if (end < skyline->nodeCount && nodes[end].x < right)
+    {
+        nodes[end].width -= right - nodes[end].x;
+        nodes[end].x = right;
+    }
+
+    memmove(nodes + bestIndex + 1, nodes + end, (skyline->nodeCount - end) * sizeof(SkylineNode));
+    skyline->nodeCount -= end - bestIndex - 1;
+    nodes[bestIndex].x = left;
+    nodes[bestIndex].y = bestTop;
+    nodes[bestIndex].width = width;
+
+    // Merge with neighbours at the same height.
+    if (bestIndex + 1 < skyline->nodeCount && nodes[bestIndex + 1].y == bestTop)
+    {
+        nodes[bestIndex].width += nodes[bestIndex + 1].width;
+        memmove(nodes + bestIndex + 1, nodes + bestIndex + 2, (skyline->nodeCount - bestIndex - 2) * sizeof(SkylineNode));
+        skyline->nodeCount--;
+    }
+    if (bestIndex > 0 && nodes[bestIndex - 1].y == bestTop)
+    {
+        nodes[bestIndex - 1].width += nodes[bestIndex].width;
+        memmove(nodes + bestIndex, nodes + bestIndex + 1, (skyline->nodeCount - bestIndex - 1) * sizeof(SkylineNode));
+        skyline->nodeCount--;
+    }
+
+    *x = left;
+    *y = bestY;
+    return true;
+}
+
+/* Distance fields */
+// Multi-channel distance field from the glyph outline (Chlumsky, "Shape Decomposition for Multi-channel Distance Fields"):
+// edges are colored so that two channels change at every corner, each channel holds the pseudo-distance to its nearest edge
+// and the median of the three reconstructs sharp corners.
+#define ALIMER_MSDF_RED 1u
+#define ALIMER_MSDF_GREEN 2u
+#define ALIMER_MSDF_BLUE 4u
+#define ALIMER_MSDF_YELLOW (ALIMER_MSDF_RED | ALIMER_MSDF_GREEN)
+#define ALIMER_MSDF_MAGENTA (ALIMER_MSDF_RED | ALIMER_MSDF_BLUE)
+#define ALIMER_MSDF_CYAN (ALIMER_MSDF_GREEN | ALIMER_MSDF_BLUE)
+#define ALIMER_MSDF_WHITE (ALIMER_MSDF_RED | ALIMER_MSDF_GREEN | ALIMER_MSDF_BLUE)
+// sin(3 radians), consecutive edges meeting at a sharper angle form a corner.
+#define ALIMER_MSDF_CORNER_CROSS 0.14112f
+
+struct Vec2
+{
+    double x;
+    double y;
+};
+
+static inline Vec2 operator+(Vec2 a, Vec2 b) { return { a.x + b.x, a.y + b.y }; }
+static inline Vec2 operator-(Vec2 a, Vec2 b) { return { a.x - b.x, a.y - b.y }; }
+static inline Vec2 operator*(Vec2 a, double s) { return { a.x * s, a.y * s }; }
+static inline double Dot(Vec2 a, Vec2 b) { return a.x * b.x + a.y * b.y; }
+static inline double Cross(Vec2 a, Vec2 b) { return a.x * b.y - a.y * b.x; }
+static inline double Length(Vec2 a) { return sqrt(Dot(a, a)); }
+static inline Vec2 Normalize(Vec2 a)
+{
+    const double length = Length(a);
+    return length > 0.0 ? a * (1.0 / length) : Vec2{ 0.0, 1.0 };
+}
+
+// Linear (p1 unused) or quadratic edge in pixels, y pointing down.
+struct DistanceEdge
+{
+    Vec2 p0;
+    Vec2 p1;
+    Vec2 p2;
+    bool quadratic;
+    uint32_t color;
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+};
+
+struct SignedDistance
+{
+    double distance;
+    // Tie break between edges sharing their closest point, the more orthogonal one wins.
+    double dot;
+};
+
+static inline bool operator<(const SignedDistance& a, const SignedDistance& b)
+{
+    return fabs(a.distance) < fabs(b.distance) || (fabs(a.distance) == fabs(b.distance) && a.dot < b.dot);
+}
+
+static inline double NonZeroSign(double value)
+{
+    return value > 0.0 ? 1.0 : -1.0;
+}
+
+static Vec2 EdgePoint(const DistanceEdge& edge, double t)
+{
+    if (!edge.quadratic)
+        return edge.p0 + (edge.p2 - edge.p0) * t;
+
+    const double s = 1.0 - t;
+    return edge.p0 * (s * s) + edge.p1 * (2.0 * s * t) + edge.p2 * (t * t);
+}
+
+static Vec2 EdgeDirection(const DistanceEdge& edge, double t)
+{
+    if (!edge.quadratic)
+        return edge.p2 - edge.p0;
+
+    // Degenerate control points fall back to the chord.
+    const Vec2 direction = (edge.p1 - edge.p0) * (1.0 - t) + (edge.p2 - edge.p1) * t;
+    return direction.x == 0.0 && direction.y == 0.0 ? edge.p2 - edge.p0 : direction;
+}
+
+static void InitDistanceEdge(DistanceEdge* edge, Vec2 p0, Vec2 p1, Vec2 p2, bool quadratic, uint32_t color)
+{
+    edge->p0 = p0;
+    edge->p1 = p1;
+    edge->p2 = p2;
+    edge->quadratic = quadratic;
+    edge->color = color;
+
+    // The control polygon bounds the curve.
+    edge->minX = std::min(p0.x, p2.x);
+    edge->minY = std::min(p0.y, p2.y);
+    edge->maxX = std::max(p0.x, p2.x);
+    edge->maxY = std::max(p0.y, p2.y);
+    if (quadratic)
+    {
+        edge->minX = std::min(edge->minX, p1.x);
+        edge->minY = std::min(edge->minY, p1.y);
+        edge->maxX = std::max(edge->maxX, p1.x);
+        edge->maxY = std::max(edge->maxY, p1.y);
+    }
+}
+
+static void SplitDistanceEdge(const DistanceEdge& edge, double t0, double t1, DistanceEdge* part)
+{
+    const Vec2 p0 = EdgePoint(edge, t0);
+    const Vec2 p2 = EdgePoint(edge, t1);
+    const Vec2 p1 = edge.quadratic ? p0 + ((edge.p1 - edge.p0) * (1.0 - t0) + (edge.p2 - edge.p1) * t0) * (t1 - t0) : p0;
+    InitDistanceEdge(part, p0, p1, p2, edge.quadratic, edge.color);
+}
+
+static int SolveQuadratic(double x[2], double a, double b, double c)
+{
+    if (a == 0.0 || fabs(b) > 1e12 * fabs(a))
+    {
+        if (b == 0.0)
+            return 0;
+        x[0] = -c / b;
+        return 1;
+    }
+
+    double discriminant = b * b - 4.0 * a * c;
+    if (discriminant > 0.0)
+    {
+        discriminant = sqrt(discriminant);
+        x[0] = (-b + discriminant) / (2.0 * a);
+        x[1] = (-b - discriminant) / (2.0 * a);
+        return 2;
+    }
+    if (discriminant == 0.0)
+    {
+        x[0] = -b / (2.0 * a);
+        return 1;
+    }
+    return 0;
+}
+
+static int SolveCubic(double x[3], double a, double b, double c, double d)
+{
+    if (a == 0.0 || fabs(b / a) >= 1e6)
+        return SolveQuadratic(x, b, c, d);
+
+    // Normalized x^3 + a x^2 + b x + c.
+    const double an = b / a;
+    const double bn = c / a;
+    const double cn = d / a;
+    const double a2 = an * an;
+    double q = (a2 - 3.0 * bn) / 9.0;
+    const double r = (an * (2.0 * a2 - 9.0 * bn) + 27.0 * cn) / 54.0;
+    const double r2 = r * r;
+    const double q3 = q * q * q;
+    const double offset = an / 3.0;
+    if (r2 < q3)
+    {
+        double t = r / sqrt(q3);
+        t = acos(t < -1.0 ? -1.0 : (t > 1.0 ? 1.0 : t));
+        q = -2.0 * sqrt(q);
+        x[0] = q * cos(t / 3.0) - offset;
+        x[1] = q * cos((t + 2.0 * 3.14159265358979323846) / 3.0) - offset;
+        x[2] = q * cos((t - 2.0 * 3.14159265358979323846) / 3.0) - offset;
+        return 3;
+    }
+
+    const double u = (r < 0.0 ? 1.0 : -1.0) * pow(fabs(r) + sqrt(r2 - q3), 1.0 / 3.0);
+    const double v = u == 0.0 ? 0.0 : q / u;
+    x[0] = (u + v) - offset;
+    if (u == v || fabs(u - v) < 1e-12 * fabs(u + v))
+    {
+        x[1] = -0.5 * (u + v) - offset;
+        return 2;
+    }
+    return 1;
+}
+
+static SignedDistance EdgeSignedDistance(const DistanceEdge& edge, Vec2 origin, double* param)
+{
+    if (!edge.quadratic)
+    {
+        const Vec2 aq = origin - edge.p0;
+        const Vec2 ab = edge.p2 - edge.p0;
+        *param = Dot(aq, ab) / Dot(ab, ab);
+        const Vec2 eq = (*param > 0.5 ? edge.p2 : edge.p0) - origin;
+        const double endpointDistance = Length(eq);
+        if (*param > 0.0 && *param < 1.0)
+        {
+            const double orthoDistance = Cross(aq, ab) / Length(ab);
+            if (fabs(orthoDistance) < endpointDistance)
+                return { orthoDistance, 0.0 };
+        }
+        return { NonZeroSign(Cross(aq, ab)) * endpointDistance, fabs(Dot(Normalize(ab), Normalize(eq))) };
+    }
+
+    // Closest point of the quadratic: roots of the derivative of the squared distance.
+    const Vec2 qa = edge.p0 - origin;
+    const Vec2 ab = edge.p1 - edge.p0;
+    const Vec2 br = edge.p2 - edge.p1 - ab;
+    double t[3];
+    const int solutions = SolveCubic(t, Dot(br, br), 3.0 * Dot(ab, br), 2.0 * Dot(ab, ab) + Dot(qa, br), Dot(qa, ab));
+
+    Vec2 direction = EdgeDirection(edge, 0.0);
+    double minDistance = NonZeroSign(Cross(direction, qa)) * Length(qa);
+    *param = -Dot(qa, direction) / Dot(direction, direction);
+    {
+        direction = EdgeDirection(edge, 1.0);
+        const double distance = Length(edge.p2 - origin);
+        if (distance < fabs(minDistance))
+        {
+            minDistance = NonZeroSign(Cross(direction, edge.p2 - origin)) * distance;
+            *param = Dot(origin - edge.p1, direction) / Dot(direction, direction);
+        }
+    }
+
+    for (int i = 0; i < solutions; ++i)
+    {
+        if (t[i] > 0.0 && t[i] < 1.0)
+        {
+            const Vec2 qe = qa + ab * (2.0 * t[i]) + br * (t[i] * t[i]);
+            const double distance = Length(qe);
+            if (distance <= fabs(minDistance))
+            {
+                minDistance = NonZeroSign(Cross(ab + br * t[i], qe)) * distance;
+                *param = t[i];
+            }
+        }
+    }
+
+    if (*param >= 0.0 && *param <= 1.0)
+        return { minDistance, 0.0 };
+    if (*param < 0.5)
+        return { minDistance, fabs(Dot(Normalize(EdgeDirection(edge, 0.0)), Normalize(qa))) };
+    return { minDistance, fabs(Dot(Normalize(EdgeDirection(edge, 1.0)), Normalize(edge.p2 - origin))) };
+}
+
+// Past the ends of an edge the distance is measured to its tangent line, so channels keep their sign around corners.
+static double EdgePseudoDistance(const DistanceEdge& edge, Vec2 origin, SignedDistance distance, double param)
+{
+    if (param < 0.0)
+    {
+        const Vec2 direction = Normalize(EdgeDirection(edge, 0.0));
+        const Vec2 aq = origin - edge.p0;
+        if (Dot(aq, direction) < 0.0)
+        {
+            const double pseudoDistance = Cross(aq, direction);
+            if (fabs(pseudoDistance) <= fabs(distance.distance))
+                return pseudoDistance;
+        }
+    }
+    else if (param > 1.0)
+    {
+        const Vec2 direction = Normalize(EdgeDirection(edge, 1.0));
+        const Vec2 bq = origin - edge.p2;
+        if (Dot(bq, direction) > 0.0)
+        {
+            const double pseudoDistance = Cross(bq, direction);
+            if (fabs(pseudoDistance) <= fabs(distance.distance))
+                return pseudoDistance;
+        }
+    }
+    return distance.distance;
+}
+
+static void SwitchEdgeColor(uint32_t* color, uint32_t banned)
+{
+    const uint32_t combined = *color & banned;
+    if (combined == ALIMER_MSDF_RED || combined == ALIMER_MSDF_GREEN || combined == ALIMER_MSDF_BLUE)
+    {
+        *color = combined ^ ALIMER_MSDF_WHITE;
+        return;
+    }
+    if (*color == 0 || *color == ALIMER_MSDF_WHITE)
+    {
+        *color = ALIMER_MSDF_CYAN;
+        return;
+    }
+
+    const uint32_t shifted = *color << 1;
+    *color = (shifted | shifted >> 3) & ALIMER_MSDF_WHITE;
+}
+
+static bool IsContourCorner(const DistanceEdge* contour, uint32_t count, uint32_t index)
+{
+    const Vec2 a = Normalize(EdgeDirection(contour[(index + count - 1) % count], 1.0));
+    const Vec2 b = Normalize(EdgeDirection(contour[index], 0.0));
+    return Dot(a, b) <= 0.0 || fabs(Cross(a, b)) > ALIMER_MSDF_CORNER_CROSS;
+}
+
+// Color the edges of a contour, returns its new edge count: a contour with a single corner and fewer than three edges is split in thirds.
+static uint32_t ColorContour(DistanceEdge* contour, uint32_t count)
+{
+    uint32_t cornerCount = 0;
+    uint32_t firstCorner = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (IsContourCorner(contour, count, i) && cornerCount++ == 0)
+            firstCorner = i;
+    }
+
+    if (cornerCount == 0)
+    {
+        // Smooth contour, every channel holds the true distance.
+        for (uint32_t i = 0; i < count; ++i)
+            contour[i].color = ALIMER_MSDF_WHITE;
+        return count;
+    }
+
+    if (cornerCount == 1)
+    {
+        // Teardrop: spread three colors around the contour starting at the corner.
+        uint32_t colors[3] = { ALIMER_MSDF_WHITE, ALIMER_MSDF_WHITE, ALIMER_MSDF_WHITE };
+        SwitchEdgeColor(&colors[0], 0);
+        colors[2] = colors[0];
+        SwitchEdgeColor(&colors[2], 0);
+        if (count >= 3)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                contour[(firstCorner + i) % count].color = colors[(int)(3.0 + 2.875 * i / (count - 1) - 1.4375 + 0.5) - 2];
+            return count;
+        }
+
+        const DistanceEdge source[2] = { contour[firstCorner], contour[(firstCorner + 1) % count] };
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            for (uint32_t j = 0; j < 3; ++j)
+                SplitDistanceEdge(source[i], j / 3.0, (j + 1) / 3.0, &contour[i * 3 + j]);
+        }
+        for (uint32_t i = 0; i < count * 3; ++i)
+            contour[i].color = colors[count == 1 ? i : i / 2];
+        return count * 3;
+    }
+
+    // Switch color at every corner, the last spline also avoids the color of the first one.
+    uint32_t color = ALIMER_MSDF_WHITE;
+    SwitchEdgeColor(&color, 0);
+    const uint32_t initialColor = color;
+    uint32_t spline = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t index = (firstCorner + i) % count;
+        if (i > 0 && IsContourCorner(contour, count, index))
+        {
+            ++spline;
+            SwitchEdgeColor(&color, spline == cornerCount - 1 ? initialColor : 0);
+        }
+        contour[index].color = color;
+    }
+    return count;
+}
+
+static Vec2 CubicPoint(const Vec2 p[4], double t)
+{
+    const double s = 1.0 - t;
+    return p[0] * (s * s * s) + p[1] * (3.0 * s * s * t) + p[2] * (3.0 * s * t * t) + p[3] * (t * t * t);
+}
+
+static Vec2 CubicDirection(const Vec2 p[4], double t)
+{
+    const double s = 1.0 - t;
+    return ((p[1] - p[0]) * (s * s) + (p[2] - p[1]) * (2.0 * s * t) + (p[3] - p[2]) * (t * t)) * 3.0;
+}
+
+// Colored outline of a glyph in pixels from the pen, allocated in the scratch arena. The cubic curves of CFF fonts are approximated
+// by four quadratics each, well below a texel at atlas sizes.
+static uint32_t BuildDistanceShape(const stbtt_fontinfo* info, int glyph, float scale, DistanceEdge** result)
+{
+    stbtt_vertex* vertices = nullptr;
+    const int vertexCount = stbtt_GetGlyphShape(info, glyph, &vertices);
+    DistanceEdge* edges = vertexCount > 0 ? (DistanceEdge*)alimerScratchAlloc(sizeof(DistanceEdge) * vertexCount * 4) : nullptr;
+    if (!edges)
+    {
+        stbtt_FreeShape(info, vertices);
+        *result = nullptr;
+        return 0;
+    }
+
+    uint32_t count = 0;
+    uint32_t contourStart = 0;
+    Vec2 pen = { 0.0, 0.0 };
+    for (int i = 0; i <= vertexCount; ++i)
+    {
+        const stbtt_vertex* vertex = i < vertexCount ? &vertices[i] : nullptr;
+        const Vec2 point = vertex ? Vec2{ vertex->x * (double)scale, -vertex->y * (double)scale } : pen;
+        if (!vertex || vertex->type == STBTT_vmove)
+        {
+            if (count > contourStart)
+                count = contourStart + ColorContour(edges + contourStart, count - contourStart);
+            contourStart = count;
+        }
+        else if (vertex->type == STBTT_vline)
+        {
+            if (point.x != pen.x || point.y != pen.y)
+                InitDistanceEdge(&edges[count++], pen, pen, point, false, 0);
+        }
+        else if (vertex->type == STBTT_vcurve)
+        {
+            const Vec2 control = { vertex->cx * (double)scale, -vertex->cy * (double)scale };
+            if (point.x != pen.x || point.y != pen.y)
+                InitDistanceEdge(&edges[count++], pen, control, point, true, 0);
+        }
+        else if (vertex->type == STBTT_vcubic)
+        {
+            const Vec2 cubic[4] = { pen, { vertex->cx * (double)scale, -vertex->cy * (double)scale }, { vertex->cx1 * (double)scale, -vertex->cy1 * (double)scale }, point };
+            for (uint32_t j = 0; j < 4; ++j)
+            {
+                const double t0 = j * 0.25;
+                const double t1 = t0 + 0.25;
+                const Vec2 q0 = CubicPoint(cubic, t0);
+                const Vec2 q3 = CubicPoint(cubic, t1);
+                const Vec2 q1 = q0 + CubicDirection(cubic, t0) * (0.25 / 3.0);
+                const Vec2 q2 = q3 - CubicDirection(cubic, t1) * (0.25 / 3.0);
+                InitDistanceEdge(&edges[count++], q0, (q1 + q2) * 0.75 - (q0 + q3) * 0.25, q3, true, 0);
+            }
+        }
+        pen = point;
+    }
+
+    stbtt_FreeShape(info, vertices);
+    *result = edges;
+    return count;
+}
+
+struct WindingCrossing
+{
+    double x;
+    int winding;
+};
+
+// Crossings of the outline with the scanline y, sorted by x.
+static uint32_t FindWindingCrossings(const DistanceEdge* edges, uint32_t edgeCount, double y, WindingCrossing* crossings)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < edgeCount; ++i)
+    {
+        const DistanceEdge& edge = edges[i];
+        if (y < edge.minY || y > edge.maxY)
+            continue;
+
+        if (!edge.quadratic)
+        {
+            if ((edge.p0.y <= y) != (edge.p2.y <= y))
+            {
+                const double t = (y - edge.p0.y) / (edge.p2.y - edge.p0.y);
+                crossings[count++] = { edge.p0.x + (edge.p2.x - edge.p0.x) * t, edge.p2.y > edge.p0.y ? 1 : -1 };
+            }
+            continue;
+        }
+
+        // Split at the extremum into monotonic pieces that follow the same half-open rule as lines, a scanline through a vertex counts once.
+        const double a = edge.p0.y - 2.0 * edge.p1.y + edge.p2.y;
+        const double b = 2.0 * (edge.p1.y - edge.p0.y);
+        const double extremum = a != 0.0 ? -b / (2.0 * a) : 0.0;
+        const double bounds[3] = { 0.0, extremum > 0.0 && extremum < 1.0 ? extremum : 1.0, 1.0 };
+        for (uint32_t j = 0; j < 2 && bounds[j] < 1.0; ++j)
+        {
+            const double y0 = EdgePoint(edge, bounds[j]).y;
+            const double y1 = EdgePoint(edge, bounds[j + 1]).y;
+            if ((y0 <= y) == (y1 <= y))
+                continue;
+
+            double roots[2];
+            const int solutions = SolveQuadratic(roots, a, b, edge.p0.y - y);
+            double t = 0.5 * (bounds[j] + bounds[j + 1]);
+            for (int k = 0; k < solutions; ++k)
+            {
+                if (roots[k] >= bounds[j] && roots[k] <= bounds[j + 1])
+                    t = roots[k];
+            }
+            crossings[count++] = { EdgePoint(edge, t).x, y1 > y0 ? 1 : -1 };
+        }
+    }
+
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        const WindingCrossing crossing = crossings[i];
+        uint32_t j = i;
+        for (; j > 0 && crossings[j - 1].x > crossing.x; --j)
+            crossings[j] = crossings[j - 1];
+        crossings[j] = crossing;
+    }
+    return count;
+}
+
+static inline uint8_t EncodeDistance(double distance, double spread)
+{
+    const double value = 0.5 + distance / (2.0 * spread);
+    return (uint8_t)(value <= 0.0 ? 0.0 : (value >= 1.0 ? 255.0 : value * 255.0 + 0.5));
+}
+
+static inline double Median(double a, double b, double c)
+{
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+// RGB pseudo-distances and the true distance in alpha, texel (0, 0) is centered at (originX + 0.5, originY + 0.5) from the pen.
+static void GenerateGlyphMSDF(const stbtt_fontinfo* info, int glyph, float scale, float spread, int originX, int originY, uint32_t width, uint32_t height, uint8_t* pixels, size_t rowPitch)
+{
+    DistanceEdge* edges;
+    const uint32_t edgeCount = BuildDistanceShape(info, glyph, scale, &edges);
+    WindingCrossing* crossings = edgeCount ? (WindingCrossing*)alimerScratchAlloc(sizeof(WindingCrossing) * edgeCount * 2) : nullptr;
+    if (!crossings)
+    {
+        alimerScratchFree(edges);
+        return;
+    }
+
+    // The sign of an edge distance depends on the contour winding, outer contours decide for the glyph.
+    double area = 0.0;
+    for (uint32_t i = 0; i < edgeCount; ++i)
+        area += edges[i].quadratic ? Cross(edges[i].p0, edges[i].p1) + Cross(edges[i].p1, edges[i].p2) : Cross(edges[i].p0, edges[i].p2);
+    const double orientation = area > 0.0 ? -1.0 : 1.0;
+
+    const double maxDistance = (double)spread * 4.0 + (double)(width + height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const double sampleY = (double)originY + y + 0.5;
+        const uint32_t crossingCount = FindWindingCrossings(edges, edgeCount, sampleY, crossings);
+        uint32_t nextCrossing = 0;
+        int winding = 0;
+        uint8_t* row = pixels + y * rowPitch;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const Vec2 origin = { (double)originX + x + 0.5, sampleY };
+            for (; nextCrossing < crossingCount && crossings[nextCrossing].x < origin.x; ++nextCrossing)
+                winding += crossings[nextCrossing].winding;
+
+            SignedDistance best[3] = { { maxDistance, 0.0 }, { maxDistance, 0.0 }, { maxDistance, 0.0 } };
+            uint32_t bestEdge[3] = { UINT32_MAX, UINT32_MAX, UINT32_MAX };
+            double bestParam[3] = {};
+            double trueDistance = maxDistance;
+            for (uint32_t i = 0; i < edgeCount; ++i)
+            {
+                // Skip edges whose bounds are farther than every distance they could improve.
+                const DistanceEdge& edge = edges[i];
+                const double dx = std::max(std::max(edge.minX - origin.x, origin.x - edge.maxX), 0.0);
+                const double dy = std::max(std::max(edge.minY - origin.y, origin.y - edge.maxY), 0.0);
+                double limit = trueDistance;
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    if (edge.color & (1u << c))
+                        limit = std::max(limit, fabs(best[c].distance));
+                }
+                if (dx * dx + dy * dy > limit * limit)
+                    continue;
+
+                double param;
+                const SignedDistance distance = EdgeSignedDistance(edge, origin, &param);
+                trueDistance = std::min(trueDistance, fabs(distance.distance));
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    if ((edge.color & (1u << c)) && distance < best[c])
+                    {
+                        best[c] = distance;
+                        bestEdge[c] = i;
+                        bestParam[c] = param;
+                    }
+                }
+            }
+
+            const bool inside = winding != 0;
+            const double signedTrue = inside ? trueDistance : -trueDistance;
+            double channels[3];
+            for (uint32_t c = 0; c < 3; ++c)
+                channels[c] = bestEdge[c] != UINT32_MAX ? orientation * EdgePseudoDistance(edges[bestEdge[c]], origin, best[c], bestParam[c]) : signedTrue;
+
+            // Overlapping contours and clashing channels can flip the median, fall back to the true distance there.
+            if ((Median(channels[0], channels[1], channels[2]) > 0.0) != inside)
+                channels[0] = channels[1] = channels[2] = signedTrue;
+
+            row[x * 4 + 0] = EncodeDistance(channels[0], spread);
+            row[x * 4 + 1] = EncodeDistance(channels[1], spread);
+            row[x * 4 + 2] = EncodeDistance(channels[2], spread);
+            row[x * 4 + 3] = EncodeDistance(signedTrue, spread);
+        }
+    }
+
+    alimerScratchFree(crossings);
+    alimerScratchFree(edges);
+}
+
+/* Atlas */
+#define ALIMER_FONT_MAX_ATLAS_SIZE 16384
+#define ALIMER_FONT_RASTER_TASK_GLYPHS 32
+
+enum AtlasContent
+{
+    AtlasContent_Coverage,
+    AtlasContent_SDF,
+    AtlasContent_MSDF,
+};
+
+struct AtlasParams
+{
+    AtlasContent content;
+    float pixelSize;
+    uint32_t padding;
+    uint32_t oversampleX;
+    uint32_t oversampleY;
+    float spread;
+};
+
+// One rasterized glyph, the packed size includes the padding on its right and bottom.
+struct AtlasRect
+{
+    uint32_t glyph;
+    uint32_t width;
+    uint32_t height;
+    uint32_t x;
+    uint32_t y;
+    // Bitmap origin from the pen, in oversampled texels.
+    int originX;
+    int originY;
+};
+
+struct AtlasRasterJob
+{
+    const stbtt_fontinfo* info;
+    const AtlasParams* params;
+    const ImageLevel* level;
+    const AtlasRect* rects;
+    uint32_t rectCount;
+    uint32_t glyphsPerTask;
+    float scale;
+    uint32_t border;
+};
+
+static bool MeasureAtlasGlyph(const stbtt_fontinfo* info, const AtlasParams& params, float scale, uint32_t border, AtlasRect* rect)
+{
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBoxSubpixel(info, (int)rect->glyph, scale * params.oversampleX, scale * params.oversampleY, 0.0f, 0.0f, &x0, &y0, &x1, &y1);
+    if (x1 <= x0 || y1 <= y0)
+        return false;
+
+    // The prefilter needs oversample - 1 extra texels, distance fields extend by the spread around the outline.
+    rect->originX = x0 - (int)border;
+    rect->originY = y0 - (int)border;
+    rect->width = (uint32_t)(x1 - x0) + params.oversampleX - 1 + border * 2;
+    rect->height = (uint32_t)(y1 - y0) + params.oversampleY - 1 + border * 2;
+    return true;
+}
+
+static void RasterizeAtlasGlyphs(uint32_t index, void* userData)
+{
+    const AtlasRasterJob* job = (const AtlasRasterJob*)userData;
+    const AtlasParams& params = *job->params;
+    MemoryCategoryScope category(MemoryCategory_Font);
+
+    const uint32_t first = index * job->glyphsPerTask;
+    const uint32_t last = std::min(first + job->glyphsPerTask, job->rectCount);
+    for (uint32_t i = first; i < last; ++i)
+    {
+        // Rectangles don't overlap, so the glyphs are rendered straight into the shared atlas.
+        ScratchScope scratch;
+        const AtlasRect& rect = job->rects[i];
+        const size_t rowPitch = job->level->rowPitch;
+        uint8_t* dest = job->level->pixels + rect.y * rowPitch + rect.x * (params.content == AtlasContent_MSDF ? 4 : 1);
+        if (params.content == AtlasContent_Coverage)
+        {
+            float subX, subY;
+            stbtt_MakeGlyphBitmapSubpixelPrefilter(job->info, dest, (int)rect.width, (int)rect.height, (int)rowPitch, job->scale * params.oversampleX, job->scale * params.oversampleY,
+                0.0f, 0.0f, (int)params.oversampleX, (int)params.oversampleY, &subX, &subY, (int)rect.glyph);
+        }
+        else if (params.content == AtlasContent_SDF)
+        {
+            // Same encoding as the multi-channel fields: 0.5 on the outline, 0 and 1 at the spread outside and inside.
+            int width, height, offsetX, offsetY;
+            uint8_t* sdf = stbtt_GetGlyphSDF(job->info, job->scale, (int)rect.glyph, (int)job->border, 128, 127.5f / params.spread, &width, &height, &offsetX, &offsetY);
+            if (!sdf)
+                continue;
+
+            const uint32_t copyWidth = std::min((uint32_t)width, rect.width);
+            const uint32_t copyHeight = std::min((uint32_t)height, rect.height);
+            for (uint32_t y = 0; y < copyHeight; ++y)
+                memcpy(dest + y * rowPitch, sdf + y * width, copyWidth);
+            stbtt_FreeSDF(sdf, nullptr);
+        }
+        else
+        {
+            GenerateGlyphMSDF(job->info, (int)rect.glyph, job->scale, params.spread, rect.originX, rect.originY, rect.width, rect.height, dest, rowPitch);
+        }
+    }
+}
+
+static Image* BuildFontAtlas(Font* font, const FontCodepointRange* ranges, uint32_t rangeCount, const AtlasParams& params, FontAtlasGlyph* glyphs, uint32_t* glyphCount)
+{
+    MemoryCategoryScope category(MemoryCategory_Font);
+    const uint32_t numGlyphs = (uint32_t)font->info.numGlyphs;
+    uint32_t* glyphRects = ALIMER_ALLOCN(uint32_t, numGlyphs);
+    AtlasRect* rects = ALIMER_ALLOCN(AtlasRect, numGlyphs);
+    uint32_t* rectOfEntry = nullptr;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < rangeCount; ++i)
+        total += ranges[i].count;
+    if (total)
+        rectOfEntry = ALIMER_ALLOCN(uint32_t, (size_t)total);
+
+    if (!glyphRects || !rects || !rectOfEntry)
+    {
+        alimerFree(rectOfEntry);
+        alimerFree(rects);
+        alimerFree(glyphRects);
+        return nullptr;
+    }
+
+    // Map the codepoints and measure every distinct glyph once.
+    const float scale = stbtt_ScaleForMappingEmToPixels(&font->info, params.pixelSize);
+    const uint32_t border = params.content == AtlasContent_Coverage ? 0 : (uint32_t)ceilf(params.spread);
+    const uint32_t padding = params.padding;
+    memset(glyphRects, 0xFF, sizeof(uint32_t) * numGlyphs);
+    uint32_t entryCount = 0;
+    uint32_t rectCount = 0;
+    uint64_t area = 0;
+    uint32_t maxWidth = 0;
+    for (uint32_t i = 0; i < rangeCount; ++i)
+    {
+        for (uint32_t j = 0; j < ranges[i].count; ++j)
+        {
+            const uint32_t codepoint = ranges[i].firstCodepoint + j;
+            const uint32_t glyph = FontFindGlyph(font, codepoint);
+            if (glyph == 0 || glyph >= numGlyphs)
+                continue;
+
+            FontAtlasGlyph& entry = glyphs[entryCount];
+            memset(&entry, 0, sizeof(FontAtlasGlyph));
+            entry.codepoint = codepoint;
+            entry.glyph = glyph;
+
+            if (glyphRects[glyph] == UINT32_MAX)
+            {
+                AtlasRect& rect = rects[rectCount];
+                rect.glyph = glyph;
+                glyphRects[glyph] = UINT32_MAX - 1;
+                if (MeasureAtlasGlyph(&font->info, params, scale, border, &rect))
+                {
+                    area += (uint64_t)(rect.width + padding) * (rect.height + padding);
+                    maxWidth = std::max(maxWidth, rect.width + padding);
+                    glyphRects[glyph] = rectCount++;
+                }
+            }
+
+            rectOfEntry[entryCount++] = glyphRects[glyph];
+        }
+    }
+
+    // Tallest first, the usual order for a skyline. The width is the power of two fitting the area with some slack at up to twice its height,
+    // the height is trimmed to the packed rectangles afterwards.
+    uint32_t* order = ALIMER_ALLOCN(uint32_t, rectCount + 1);
+    uint32_t width = 1;
+    while (width < ALIMER_FONT_MAX_ATLAS_SIZE && ((uint64_t)width * width * 2 < area + area / 8 || width < maxWidth + padding))
+        width *= 2;
+
+    Skyline skyline = {};
+    skyline.width = width - padding;
+    skyline.height = ALIMER_FONT_MAX_ATLAS_SIZE - padding;
+    skyline.nodes = ALIMER_ALLOCN(SkylineNode, width + 1);
+
+    Image* atlas = nullptr;
+    bool packed = order && skyline.nodes && maxWidth + padding <= width;
+    uint32_t height = 1;
+    if (packed)
+    {
+        for (uint32_t i = 0; i < rectCount; ++i)
+            order[i] = i;
+        std::sort(order, order + rectCount, [rects](uint32_t a, uint32_t b) {
+            return rects[a].height != rects[b].height ? rects[a].height > rects[b].height : rects[a].width > rects[b].width;
+        });
+
+        SkylineReset(&skyline);
+        for (uint32_t i = 0; i < rectCount && packed; ++i)
+        {
+            AtlasRect& rect = rects[order[i]];
+            packed = SkylineInsert(&skyline, rect.width + padding, rect.height + padding, &rect.x, &rect.y);
+            rect.x += padding;
+            rect.y += padding;
+            height = std::max(height, rect.y + rect.height + padding);
+        }
+    }
+
+    if (packed)
+        atlas = alimerImageCreate2D(params.content == AtlasContent_MSDF ? PixelFormat_RGBA8Unorm : PixelFormat_R8Unorm, width, height, 1, 1);
+
+    if (atlas)
+    {
+        // Distance fields cost orders of magnitude more per glyph than coverage, split them finer.
+        AtlasRasterJob job;
+        job.info = &font->info;
+        job.params = &params;
+        job.level = alimerImageGetLevel(atlas, 0, 0);
+        job.rects = rects;
+        job.rectCount = rectCount;
+        job.glyphsPerTask = params.content == AtlasContent_Coverage ? ALIMER_FONT_RASTER_TASK_GLYPHS : 2;
+        job.scale = scale;
+        job.border = border;
+        const uint32_t taskCount = (rectCount + job.glyphsPerTask - 1) / job.glyphsPerTask;
+        if (taskCount == 1)
+            RasterizeAtlasGlyphs(0, &job);
+        else if (taskCount > 1)
+            alimerParallelFor(taskCount, RasterizeAtlasGlyphs, &job);
+
+        // Same placement as stbtt_PackFontRanges: the prefilter shifts the oversampled bitmap by a fraction of a texel.
+        const float subX = stbtt__oversample_shift((int)params.oversampleX);
+        const float subY = stbtt__oversample_shift((int)params.oversampleY);
+        const float invWidth = 1.0f / (float)width;
+        const float invHeight = 1.0f / (float)height;
+        for (uint32_t i = 0; i < entryCount; ++i)
+        {
+            FontAtlasGlyph& entry = glyphs[i];
+            const GlyphMetrics* metrics = FontGetGlyphMetrics(font, entry.glyph);
+            entry.advance = metrics ? (float)metrics->advance * scale : 0.0f;
+            if (rectOfEntry[i] >= rectCount)
+                continue;
+
+            const AtlasRect& rect = rects[rectOfEntry[i]];
+            entry.x = rect.x;
+            entry.y = rect.y;
+            entry.width = rect.width;
+            entry.height = rect.height;
+            entry.u0 = (float)rect.x * invWidth;
+            entry.v0 = (float)rect.y * invHeight;
+            entry.u1 = (float)(rect.x + rect.width) * invWidth;
+            entry.v1 = (float)(rect.y + rect.height) * invHeight;
+            entry.x0 = (float)rect.originX / (float)params.oversampleX + subX;
+            entry.y0 = (float)rect.originY / (float)params.oversampleY + subY;
+            entry.x1 = (float)(rect.originX + (int)rect.width) / (float)params.oversampleX + subX;
+            entry.y1 = (float)(rect.originY + (int)rect.height) / (float)params.oversampleY + subY;
+        }
+        *glyphCount = entryCount;
+    }
+
+    alimerFree(skyline.nodes);
+    alimerFree(order);
+    alimerFree(rectOfEntry);
+    alimerFree(rects);
+    alimerFree(glyphRects);
+    return atlas;
+}
+
+Image* alimerFontBuildAtlas(Font* font, const FontCodepointRange* ranges, uint32_t rangeCount, float pixelSize, uint32_t padding, uint32_t oversampleX, uint32_t oversampleY, FontAtlasGlyph* glyphs, uint32_t* glyphCount)
+{
+    if (glyphCount)
+        *glyphCount = 0;
+
+    if (!font || !ranges || !glyphs || !glyphCount || !(pixelSize > 0.0f))
+        return nullptr;
+    if (oversampleX < 1 || oversampleX > STBTT_MAX_OVERSAMPLE || oversampleY < 1 || oversampleY > STBTT_MAX_OVERSAMPLE)
+        return nullptr;
+
+    AtlasParams params = {};
+    params.content = AtlasContent_Coverage;
+    params.pixelSize = pixelSize;
+    params.padding = padding;
+    params.oversampleX = oversampleX;
+    params.oversampleY = oversampleY;
+    return BuildFontAtlas(font, ranges, rangeCount, params, glyphs, glyphCount);
+}
+
+Image* alimerFontBuildDistanceFieldAtlas(Font* font, const FontCodepointRange* ranges, uint32_t rangeCount, float pixelSize, float spread, FontDistanceField type, FontAtlasGlyph* glyphs, uint32_t* glyphCount)
+{
+    if (glyphCount)
+        *glyphCount = 0;
+
+    if (!font || !ranges || !glyphs || !glyphCount || !(pixelSize > 0.0f) || !(spread > 0.0f) || spread > 64.0f)
+        return nullptr;
+    if (type != FontDistanceField_SDF && type != FontDistanceField_MSDF)
+        return nullptr;
+
+    // The texels around a glyph already fade to zero, one more keeps bilinear taps of neighbours apart.
+    AtlasParams params = {};
+    params.content = type == FontDistanceField_MSDF ? AtlasContent_MSDF : AtlasContent_SDF;
+    params.pixelSize = pixelSize;
+    params.padding = 1;
+    params.oversampleX = 1;
+    params.oversampleY = 1;
+    params.spread = spread;
+    return BuildFontAtlas(font, ranges, rangeCount, params, glyphs, glyphCount);
+}
+
+/* Glyph cache */
+#define ALIMER_GLYPH_CACHE_MAX_DIRTY_RECTS 8
+#define ALIMER_GLYPH_CACHE_KEY_USED (1ull << 63)
+
+struct GlyphCachePage
+{
+    Image* image;
+    const ImageLevel* level;
+    Skyline skyline;
+    // Bumped when the page is cleared, cached entries of older generations are stale.
+    uint32_t generation;
+    uint64_t lastFrame;
+    uint64_t lastUse;
+    uint32_t dirtyCount;
+    GlyphCacheRect dirty[ALIMER_GLYPH_CACHE_MAX_DIRTY_RECTS];
+};
+
+// Open addressing with linear probing. Entries of evicted pages are never removed: they fail the generation check and get overwritten
+// by their key or dropped when the table grows.
+struct GlyphCacheSlot
+{
+    uint64_t key;
+    uint32_t generation;
+    CachedGlyph glyph;
+};
+
+struct GlyphCacheRaster
+{
+    uint8_t* pixels;
+    size_t rowPitch;
+    uint32_t glyph;
+    uint32_t width;
+    uint32_t height;
+    float scale;
+    float shiftX;
+};
+
+struct GlyphCache
+{
+    Font* font;
+    uint32_t pageSize;
+    uint32_t maxPages;
+    uint32_t padding;
+    uint32_t subpixelSteps;
+    uint32_t pageCount;
+    GlyphCachePage* pages;
+    uint64_t frame;
+    uint64_t useCounter;
+
+    uint32_t slotMask;
+    uint32_t slotCount;
+    GlyphCacheSlot* slots;
+
+    uint32_t rasterCapacity;
+    GlyphCacheRaster* rasters;
+    uint32_t rasterCount;
+};
+
+static uint32_t GlyphCacheHash(uint64_t key, uint32_t mask)
+{
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+static bool GlyphCacheIsLive(const GlyphCache* cache, const GlyphCacheSlot& slot)
+{
+    return slot.glyph.page == UINT32_MAX || cache->pages[slot.glyph.page].generation == slot.generation;
+}
+
+static bool GlyphCacheGrow(GlyphCache* cache)
+{
+    uint32_t liveCount = 0;
+    for (uint32_t i = 0; i <= cache->slotMask; ++i)
+    {
+        if (cache->slots[i].key && GlyphCacheIsLive(cache, cache->slots[i]))
+            liveCount++;
+    }
+
+    uint32_t capacity = 256;
+    while (capacity < liveCount * 4)
+        capacity *= 2;
+
+    GlyphCacheSlot* slots = ALIMER_ALLOCN(GlyphCacheSlot, capacity);
+    if (!slots)
+        return false;
+
+    for (uint32_t i = 0; i <= cache->slotMask; ++i)
+    {
+        const GlyphCacheSlot& slot = cache->slots[i];
+        if (!slot.key || !GlyphCacheIsLive(cache, slot))
+            continue;
+
+        uint32_t index = GlyphCacheHash(slot.key, capacity - 1);
+        while (slots[index].key)
+            index = (index + 1) & (capacity - 1);
+        slots[index] = slot;
+    }
+
+    alimerFree(cache->slots);
+    cache->slots = slots;
+    cache->slotMask = capacity - 1;
+    cache->slotCount = liveCount;
+    return true;
+}
+
+static bool GlyphCacheRectsOverlap(const GlyphCacheRect& a, const GlyphCacheRect& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static void GlyphCacheMarkDirty(GlyphCachePage* page, const GlyphCacheRect& rect)
+{
+    // Grow a rectangle it overlaps, append, or merge into the rectangle that grows the least once the list is full.
+    uint32_t target = UINT32_MAX;
+    for (uint32_t i = 0; i < page->dirtyCount && target == UINT32_MAX; ++i)
+    {
+        if (GlyphCacheRectsOverlap(page->dirty[i], rect))
+            target = i;
+    }
+
+    if (target == UINT32_MAX)
+    {
+        if (page->dirtyCount < ALIMER_GLYPH_CACHE_MAX_DIRTY_RECTS)
+        {
+            page->dirty[page->dirtyCount++] = rect;
+            return;
+        }
+
+        uint64_t bestGrowth = UINT64_MAX;
+        for (uint32_t i = 0; i < page->dirtyCount; ++i)
+        {
+            const GlyphCacheRect& dirty = page->dirty[i];
+            const uint64_t width = std::max(dirty.x + dirty.width, rect.x + rect.width) - std::min(dirty.x, rect.x);
+            const uint64_t height = std::max(dirty.y + dirty.height, rect.y + rect.height) - std::min(dirty.y, rect.y);
+            const uint64_t growth = width * height - (uint64_t)dirty.width * dirty.height;
+            if (growth < bestGrowth)
+            {
+                target = i;
+                bestGrowth = growth;
+            }
+        }
+    }
+
+    GlyphCacheRect& dirty = page->dirty[target];
+    const uint32_t x1 = std::max(dirty.x + dirty.width, rect.x + rect.width);
+    const uint32_t y1 = std::max(dirty.y + dirty.height, rect.y + rect.height);
+    dirty.x = std::min(dirty.x, rect.x);
+    dirty.y = std::min(dirty.y, rect.y);
+    dirty.width = x1 - dirty.x;
+    dirty.height = y1 - dirty.y;
+}
+
+static bool GlyphCacheAllocate(GlyphCache* cache, uint32_t width, uint32_t height, uint32_t* pageIndex, uint32_t* x, uint32_t* y)
+{
+    const uint32_t padding = cache->padding;
+    if (width + padding * 2 > cache->pageSize || height + padding * 2 > cache->pageSize)
+        return false;
+
+    uint32_t index = UINT32_MAX;
+    for (uint32_t i = 0; i < cache->pageCount && index == UINT32_MAX; ++i)
+    {
+        if (SkylineInsert(&cache->pages[i].skyline, width + padding, height + padding, x, y))
+            index = i;
+    }
+
+    if (index == UINT32_MAX && cache->pageCount < cache->maxPages)
+    {
+        GlyphCachePage& page = cache->pages[cache->pageCount];
+        page.image = alimerImageCreate2D(PixelFormat_R8Unorm, cache->pageSize, cache->pageSize, 1, 1);
+        page.skyline.nodes = ALIMER_ALLOCN(SkylineNode, cache->pageSize + 1);
+        if (!page.image || !page.skyline.nodes)
+        {
+            alimerImageDestroy(page.image);
+            alimerFree(page.skyline.nodes);
+            memset(&page, 0, sizeof(GlyphCachePage));
+            return false;
+        }
+
+        page.level = alimerImageGetLevel(page.image, 0, 0);
+        page.skyline.width = cache->pageSize - padding;
+        page.skyline.height = cache->pageSize - padding;
+        SkylineReset(&page.skyline);
+        index = cache->pageCount++;
+        SkylineInsert(&page.skyline, width + padding, height + padding, x, y);
+    }
+
+    if (index == UINT32_MAX)
+    {
+        // Evict the least recently used page, the ones used this frame may still be drawn from.
+        uint64_t oldest = UINT64_MAX;
+        for (uint32_t i = 0; i < cache->pageCount; ++i)
+        {
+            if (cache->pages[i].lastFrame != cache->frame && cache->pages[i].lastUse < oldest)
+            {
+                index = i;
+                oldest = cache->pages[i].lastUse;
+            }
+        }
+        if (index == UINT32_MAX)
+            return false;
+
+        // The whole page is uploaded again, stale texels would otherwise bleed into the padding of new glyphs.
+        GlyphCachePage& page = cache->pages[index];
+        memset(page.level->pixels, 0, page.level->slicePitch);
+        SkylineReset(&page.skyline);
+        page.generation++;
+        page.dirtyCount = 1;
+        page.dirty[0] = { 0, 0, cache->pageSize, cache->pageSize };
+        SkylineInsert(&page.skyline, width + padding, height + padding, x, y);
+    }
+
+    GlyphCachePage& page = cache->pages[index];
+    *x += padding;
+    *y += padding;
+    page.lastFrame = cache->frame;
+    page.lastUse = ++cache->useCounter;
+    GlyphCacheMarkDirty(&page, { *x, *y, width, height });
+    *pageIndex = index;
+    return true;
+}
+
+static bool GlyphCacheResolve(GlyphCache* cache, uint32_t glyph, float pixelSize, float scale, float penX, CachedGlyph* result)
+{
+    // The quad is relative to the whole pixel below the pen, a position rounding up to the next whole pixel moves it by one.
+    const float base = floorf(penX);
+    uint32_t step = (uint32_t)((penX - base) * (float)cache->subpixelSteps + 0.5f);
+    const float carry = step >= cache->subpixelSteps ? 1.0f : 0.0f;
+    step = step >= cache->subpixelSteps ? 0 : step;
+
+    uint32_t sizeBits;
+    memcpy(&sizeBits, &pixelSize, sizeof(float));
+    const uint64_t key = ALIMER_GLYPH_CACHE_KEY_USED | ((uint64_t)sizeBits << 32) | ((uint64_t)step << 16) | glyph;
+
+    if ((cache->slotCount + 1) * 2 > cache->slotMask + 1 && !GlyphCacheGrow(cache))
+        return false;
+
+    uint32_t index = GlyphCacheHash(key, cache->slotMask);
+    while (cache->slots[index].key && cache->slots[index].key != key)
+        index = (index + 1) & cache->slotMask;
+
+    GlyphCacheSlot& slot = cache->slots[index];
+    if (slot.key != key || !GlyphCacheIsLive(cache, slot))
+    {
+        const float shiftX = (float)step / (float)cache->subpixelSteps;
+        int x0, y0, x1, y1;
+        stbtt_GetGlyphBitmapBoxSubpixel(&cache->font->info, (int)glyph, scale, scale, shiftX, 0.0f, &x0, &y0, &x1, &y1);
+
+        const GlyphMetrics* metrics = FontGetGlyphMetrics(cache->font, glyph);
+        CachedGlyph entry = {};
+        entry.page = UINT32_MAX;
+        entry.advance = metrics ? (float)metrics->advance * scale : 0.0f;
+        if (x1 > x0 && y1 > y0)
+        {
+            const uint32_t width = (uint32_t)(x1 - x0);
+            const uint32_t height = (uint32_t)(y1 - y0);
+            uint32_t page, x, y;
+            if (!GlyphCacheAllocate(cache, width, height, &page, &x, &y))
+            {
+                *result = entry;
+                return false;
+            }
+
+            if (cache->rasterCount == cache->rasterCapacity)
+            {
+                const uint32_t capacity = std::max(cache->rasterCapacity * 2, 64u);
+                GlyphCacheRaster* rasters = (GlyphCacheRaster*)alimerRealloc(cache->rasters, capacity * sizeof(GlyphCacheRaster));
+                if (!rasters)
+                {
+                    *result = entry;
+                    return false;
+                }
+                cache->rasters = rasters;
+                cache->rasterCapacity = capacity;
+            }
+
+            const ImageLevel* level = cache->pages[page].level;
+            GlyphCacheRaster& raster = cache->rasters[cache->rasterCount++];
+            raster.pixels = level->pixels + y * level->rowPitch + x;
+            raster.rowPitch = level->rowPitch;
+            raster.glyph = glyph;
+            raster.width = width;
+            raster.height = height;
+            raster.scale = scale;
+            raster.shiftX = shiftX;
+
+            const float invSize = 1.0f / (float)cache->pageSize;
+            entry.page = page;
+            entry.x = x;
+            entry.y = y;
+            entry.width = width;
+            entry.height = height;
+            entry.u0 = (float)x * invSize;
+            entry.v0 = (float)y * invSize;
+            entry.u1 = (float)(x + width) * invSize;
+            entry.v1 = (float)(y + height) * invSize;
+            entry.x0 = (float)x0;
+            entry.y0 = (float)y0;
+            entry.x1 = (float)x1;
+            entry.y1 = (float)y1;
+        }
+
+        if (!slot.key)
+            cache->slotCount++;
+        slot.key = key;
+        slot.generation = entry.page != UINT32_MAX ? cache->pages[entry.page].generation : 0;
+        slot.glyph = entry;
+    }
+    else if (slot.glyph.page != UINT32_MAX)
+    {
+        GlyphCachePage& page = cache->pages[slot.glyph.page];
+        page.lastFrame = cache->frame;
+        page.lastUse = ++cache->useCounter;
+    }
+
+    *result = slot.glyph;
+    result->x0 += carry;
+    result->x1 += carry;
+    return true;
+}
+
+static void RasterizeCachedGlyphs(uint32_t index, void* userData)
+{
+    const GlyphCache* cache = (const GlyphCache*)userData;
+    MemoryCategoryScope category(MemoryCategory_Font);
+    ScratchScope scratch;
+
+    const uint32_t first = index * ALIMER_FONT_RASTER_TASK_GLYPHS;
+    const uint32_t last = std::min(first + ALIMER_FONT_RASTER_TASK_GLYPHS, cache->rasterCount);
+    for (uint32_t i = first; i < last; ++i)
+    {
+        const GlyphCacheRaster& raster = cache->rasters[i];
+        stbtt_MakeGlyphBitmapSubpixel(&cache->font->info, raster.pixels, (int)raster.width, (int)raster.height, (int)raster.rowPitch,
+            raster.scale, raster.scale, raster.shiftX, 0.0f, (int)raster.glyph);
+    }
+}
+
+GlyphCache* alimerGlyphCacheCreate(Font* font, const GlyphCacheDesc* desc)
+{
+    if (!font)
+        return nullptr;
+
+    const uint32_t pageSize = desc && desc->pageSize ? desc->pageSize : 1024;
+    const uint32_t maxPages = desc && desc->maxPages ? desc->maxPages : 4;
+    const uint32_t padding = desc ? desc->padding : 1;
+    const uint32_t subpixelSteps = desc && desc->subpixelSteps ? desc->subpixelSteps : 4;
+    if (pageSize > ALIMER_FONT_MAX_ATLAS_SIZE || padding * 2 >= pageSize || subpixelSteps > 8)
+        return nullptr;
+
+    MemoryCategoryScope category(MemoryCategory_Font);
+    GlyphCache* cache = ALIMER_ALLOC(GlyphCache);
+    if (!cache)
+        return nullptr;
+
+    cache->font = font;
+    cache->pageSize = pageSize;
+    cache->maxPages = maxPages;
+    cache->padding = padding;
+    cache->subpixelSteps = subpixelSteps;
+    cache->frame = 1;
+    cache->pages = ALIMER_ALLOCN(GlyphCachePage, maxPages);
+    cache->slots = ALIMER_ALLOCN(GlyphCacheSlot, 256);
+    cache->slotMask = 255;
+    if (!cache->pages || !cache->slots)
+    {
+        alimerGlyphCacheDestroy(cache);
+        return nullptr;
+    }
+
+    return cache;
+}
+
+void alimerGlyphCacheDestroy(GlyphCache* cache)
+{
+    if (!cache)
+        return;
+
+    for (uint32_t i = 0; i < cache->pageCount; ++i)
+    {
+        alimerImageDestroy(cache->pages[i].image);
+        alimerFree(cache->pages[i].skyline.nodes);
+    }
+
+    alimerFree(cache->rasters);
+    alimerFree(cache->slots);
+    alimerFree(cache->pages);
+    alimerFree(cache);
+}
+
+bool alimerGlyphCacheGetGlyph(GlyphCache* cache, uint32_t glyph, float pixelSize, float penX, CachedGlyph* result)
+{
+    return alimerGlyphCacheGetGlyphs(cache, &glyph, &penX, 1, pixelSize, result);
+}
+
+bool alimerGlyphCacheGetGlyphs(GlyphCache* cache, const uint32_t* glyphs, const float* penX, uint32_t count, float pixelSize, CachedGlyph* results)
+{
+    if (!cache || !glyphs || !results || !(pixelSize > 0.0f))
+        return false;
+
+    // Lookups and packing run in order, the glyphs missing from the cache are rasterized together at the end.
+    MemoryCategoryScope category(MemoryCategory_Font);
+    const float scale = stbtt_ScaleForMappingEmToPixels(&cache->font->info, pixelSize);
+    const uint32_t numGlyphs = (uint32_t)cache->font->info.numGlyphs;
+    bool success = true;
+    cache->rasterCount = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (glyphs[i] >= numGlyphs)
+        {
+            memset(&results[i], 0, sizeof(CachedGlyph));
+            results[i].page = UINT32_MAX;
+            success = false;
+        }
+        else if (!GlyphCacheResolve(cache, glyphs[i], pixelSize, scale, penX ? penX[i] : 0.0f, &results[i]))
+        {
+            success = false;
+        }
+    }
+
+    const uint32_t taskCount = (cache->rasterCount + ALIMER_FONT_RASTER_TASK_GLYPHS - 1) / ALIMER_FONT_RASTER_TASK_GLYPHS;
+    if (taskCount == 1)
+        RasterizeCachedGlyphs(0, cache);
+    else if (taskCount > 1)
+        alimerParallelFor(taskCount, RasterizeCachedGlyphs, cache);
+    cache->rasterCount = 0;
+    return success;
+}
+
+uint32_t alimerGlyphCacheGetPageCount(GlyphCache* cache)
+{
+    return cache ? cache->pageCount : 0;
+}
+
+Image* alimerGlyphCacheGetPage(GlyphCache* cache, uint32_t page)
+{
+    if (!cache || page >= cache->pageCount)
+        return nullptr;
+
+    return cache->pages[page].image;
+}
+
+uint32_t alimerGlyphCacheGetDirtyRects(GlyphCache* cache, uint32_t page, GlyphCacheRect* rects, uint32_t capacity)
+{
+    if (!cache || page >= cache->pageCount)
+        return 0;
+
+    const GlyphCachePage& cachePage = cache->pages[page];
+    if (rects)
+        memcpy(rects, cachePage.dirty, std::min(capacity, cachePage.dirtyCount) * sizeof(GlyphCacheRect));
+    return cachePage.dirtyCount;
+}
+
+void alimerGlyphCacheEndFrame(GlyphCache* cache)
+{
+    if (!cache)
+        return;
+
+    for (uint32_t i = 0; i < cache->pageCount; ++i)
+        cache->pages[i].dirtyCount = 0;
+    cache->frame++;
+}
@@ -3,21 +3,48 @@
 
 #include "alimer_internal.h"
 #include <stdio.h>
+#include <limits.h>
+#include <algorithm>
+#include <atomic>
 
 ALIMER_DISABLE_WARNINGS()
 #define STBI_ASSERT(x) ALIMER_ASSERT(x)
-#define STBI_MALLOC(sz) alimerMalloc(sz)
-#define STBI_REALLOC(p,newsz) alimerRealloc(p, newsz)
-#define STBI_FREE(p) alimerFree(p)
+#define STBI_MALLOC(sz) alimerScratchAlloc(sz)
+#define STBI_REALLOC(p,newsz) alimerScratchRealloc(p, newsz)
+#define STBI_FREE(p) alimerScratchFree(p)
 #define STBI_NO_PSD
 #define STBI_NO_PIC
 #define STBI_NO_PNM
 #define STBI_NO_FAILURE_STRINGS
 #define STBI_NO_STDIO
+#define STBI_PNG_ZLIB_DECODE(buffer, len, initialSize, outLen, parseHeader) PNG_ZlibDecode(buffer, len, initialSize, outLen, parseHeader)
 #define STB_IMAGE_STATIC
 #define STB_IMAGE_IMPLEMENTATION
+static char* PNG_ZlibDecode(const char* buffer, int len, int initialSize, int* outLen, int parseHeader);
 #include "third_party/stb_image.h"
 
+// stb_image passes the exact size of non interlaced data, Adam7 can need a little more and takes stb's growing decoder.
+static char* PNG_ZlibDecode(const char* buffer, int len, int initialSize, int* outLen, int parseHeader)
+{
+    char* data = (char*)STBI_MALLOC(initialSize);
+    if (!data)
+        return nullptr;
+
+    size_t size = 0;
+    const InflateStatus status = alimerInflateBuffer(buffer, (size_t)len, data, (size_t)initialSize, &size, parseHeader != 0);
+    if (status == InflateStatus_Success)
+    {
+        *outLen = (int)size;
+        return data;
+    }
+
+    // A corrupt stream fails here, decoding it again with stb would only fail slower.
+    STBI_FREE(data);
+    if (status != InflateStatus_OutputFull)
+        return nullptr;
+    return stbi_zlib_decode_malloc_guesssize_headerflag(buffer, len, initialSize, outLen, parseHeader);
+}
+
 #define STBIW_ASSERT(x) ALIMER_ASSERT(x)
 #define STBIW_MALLOC(sz) alimerMalloc(sz)
 #define STBIW_REALLOC(p, newsz) alimerRealloc(p, newsz)
@@ -32,8 +59,57 @@ ALIMER_DISABLE_WARNINGS()
 #define QOI_FREE(p) STBI_FREE(p) 
 #include "third_party/qoi.h"
 
+#define STBIR_ASSERT(x) ALIMER_ASSERT(x)
+#define STBIR_MALLOC(size, user_data) ((void)(user_data), alimerMalloc(size))
+#define STBIR_FREE(ptr, user_data) ((void)(user_data), alimerFree(ptr))
+#define STB_IMAGE_RESIZE_STATIC
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "third_party/stb_image_resize2.h"
+
+// tinyexr falls back to the zlib API when neither miniz nor stb are used, ZIP compressed EXR go through alimer_zlib.
+typedef unsigned long uLong;
+typedef unsigned char Bytef;
+#define Z_OK 0
+
+static uLong compressBound(uLong sourceLen)
+{
+    return (uLong)(2 + alimerDeflateBound(sourceLen) + 4);
+}
+
+static int compress(Bytef* dest, uLong* destLen, const Bytef* source, uLong sourceLen)
+{
+    if (*destLen < 6)
+        return -1;
+
+    // 32KB window, default level.
+    dest[0] = 0x78;
+    dest[1] = 0x9C;
+    const size_t size = alimerDeflate(source, sourceLen, 0, true, dest + 2, *destLen - 6);
+    if (size == 0)
+        return -1;
+
+    const uint32_t adler = alimerAdler32(1, source, sourceLen);
+    Bytef* trailer = dest + 2 + size;
+    trailer[0] = (Bytef)(adler >> 24);
+    trailer[1] = (Bytef)(adler >> 16);
+    trailer[2] = (Bytef)(adler >> 8);
+    trailer[3] = (Bytef)adler;
+    *destLen = (uLong)(size + 6);
+    return Z_OK;
+}
+
+static int uncompress(Bytef* dest, uLong* destLen, const Bytef* source, uLong sourceLen)
+{
+    size_t size = 0;
+    if (alimerInflateBuffer(source, sourceLen, dest, *destLen, &size, true) != InflateStatus_Success)
+        return -1;
+
+    *destLen = (uLong)size;
+    return Z_OK;
+}
+
 #define TINYEXR_USE_MINIZ 0
-#define TINYEXR_USE_STB_ZLIB 1
+#define TINYEXR_USE_STB_ZLIB 0
 #define TINYEXR_IMPLEMENTATION
 #include "third_party/tinyexr.h"
 ALIMER_ENABLE_WARNINGS()
@@ -46,8 +122,13 @@ struct Image
     uint32_t height;
     uint32_t depthOrArrayLayers;
     uint32_t mipLevelCount;
+    uint32_t rowPitchAlignment;
     size_t dataSize;
     void* pData;
+    /// One entry per subresource, indexed by layer * mipLevelCount + mipLevel.
+    ImageLevel* levels;
+    /// Set when pData points into a mapped file instead of an alimerMalloc allocation.
+    MappedFile mapping;
 };
 
 // Format mapping table. The rows must be in the exactly same order as Format enum members are defined.
@@ -127,8 +208,8 @@ const PixelFormatInfo kFormatDesc[] = {
     // ETC2/EAC compressed formats
     { PixelFormat_ETC2RGB8Unorm,           8,   4, 4, PixelFormatKind_Unorm },
     { PixelFormat_ETC2RGB8UnormSrgb,       8,   4, 4, PixelFormatKind_UnormSrgb },
-    { PixelFormat_ETC2RGB8A1Unorm,         16,   4, 4, PixelFormatKind_Unorm },
-    { PixelFormat_ETC2RGB8A1UnormSrgb,     16,   4, 4, PixelFormatKind_UnormSrgb },
+    { PixelFormat_ETC2RGB8A1Unorm,         8,   4, 4, PixelFormatKind_Unorm },
+    { PixelFormat_ETC2RGB8A1UnormSrgb,     8,   4, 4, PixelFormatKind_UnormSrgb },
     { PixelFormat_ETC2RGBA8Unorm,          16,   4, 4, PixelFormatKind_Unorm },
     { PixelFormat_ETC2RGBA8UnormSrgb,      16,   4, 4, PixelFormatKind_UnormSrgb },
     { PixelFormat_EACR11Unorm,             8,    4, 4, PixelFormatKind_Unorm },
@@ -312,6 +393,7 @@ bool IsASTCCompressedFormat(PixelFormat format)
         case PixelFormat_ASTC12x10Unorm:
         case PixelFormat_ASTC12x10UnormSrgb:
         case PixelFormat_ASTC12x12Unorm:
+        case PixelFormat_ASTC12x12UnormSrgb:
             return true;
         default:
             return false;
@@ -472,46 +554,4920 @@ PixelFormat LinearToSrgbFormat(PixelFormat format)
     }
 }
 
-Image* alimerImageCreate2D(PixelFormat format, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevelCount)
+// Largest width, height or depth and layer count accepted, headers beyond them are treated as corrupt.
+#define ALIMER_IMAGE_MAX_DIMENSION 65536u
+#define ALIMER_IMAGE_MAX_LAYERS 2048u
+
+static uint32_t GetFullMipLevelCount(uint32_t width, uint32_t height, uint32_t depth)
+{
+    uint32_t count = 1;
+    uint32_t size = width > height ? width : height;
+    size = size > depth ? size : depth;
+    while (size > 1)
+    {
+        size >>= 1;
+        count++;
+    }
+    return count;
+}
+
+static size_t AlignSize(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Checked size arithmetic for header driven layouts, false on overflow.
+static bool MultiplySize(size_t a, size_t b, size_t* result)
+{
+    if (b != 0 && a > SIZE_MAX / b)
+        return false;
+    *result = a * b;
+    return true;
+}
+
+static bool AddSize(size_t a, size_t b, size_t* result)
+{
+    if (a > SIZE_MAX - b)
+        return false;
+    *result = a + b;
+    return true;
+}
+
+static bool AlignSizeChecked(size_t value, size_t alignment, size_t* result)
+{
+    if (!AddSize(value, alignment - 1, result))
+        return false;
+    *result &= ~(alignment - 1);
+    return true;
+}
+
+static uint32_t GetLayerCount(const Image* image)
+{
+    return image->dimension == ImageDimension_3D ? 1u : image->depthOrArrayLayers;
+}
+
+// Place a level at the next aligned offset and move offset past it, false when its size overflows.
+static bool SetupLevelLayout(ImageLevel* level, PixelFormat format, uint32_t width, uint32_t height, uint32_t depth, size_t rowPitchAlignment, size_t* offset)
+{
+    const PixelFormatInfo& info = kFormatDesc[(uint32_t)format];
+    const size_t blocksX = (width + info.blockWidth - 1) / info.blockWidth;
+    const size_t blocksY = (height + info.blockHeight - 1) / info.blockHeight;
+
+    level->width = width;
+    level->height = height;
+    level->depth = depth;
+    level->format = format;
+    level->rowCount = (uint32_t)blocksY;
+
+    size_t levelSize;
+    return AlignSizeChecked(*offset, rowPitchAlignment, &level->offset) &&
+        AlignSizeChecked(blocksX * info.bytesPerBlock, rowPitchAlignment, &level->rowPitch) &&
+        MultiplySize(level->rowPitch, blocksY, &level->slicePitch) &&
+        MultiplySize(level->slicePitch, depth, &levelSize) &&
+        AddSize(level->offset, levelSize, offset);
+}
+
+// Build the subresource table from the image description, layer after layer with the mip chain of each layer (D3D12/DDS order).
+static bool SetupLayout(Image* image)
+{
+    const uint32_t layerCount = GetLayerCount(image);
+    MemoryCategoryScope category(MemoryCategory_ImageStorage);
+    ImageLevel* levels = ALIMER_ALLOCN(ImageLevel, (size_t)layerCount * image->mipLevelCount);
+    if (!levels)
+        return false;
+
+    size_t offset = 0;
+    ImageLevel* level = levels;
+    for (uint32_t layer = 0; layer < layerCount; ++layer)
+    {
+        for (uint32_t mipLevel = 0; mipLevel < image->mipLevelCount; ++mipLevel, ++level)
+        {
+            if (!SetupLevelLayout(level, image->format, alimerImageGetWidth(image, mipLevel), alimerImageGetHeight(image, mipLevel),
+                alimerImageGetDepth(image, mipLevel), image->rowPitchAlignment, &offset))
+            {
+                alimerFree(levels);
+                return false;
+            }
+        }
+    }
+
+    alimerFree(image->levels);
+    image->levels = levels;
+    image->dataSize = offset;
+    return true;
+}
+
+static void FreeImageData(Image* image)
+{
+    if (image->mapping.data)
+    {
+        alimerUnmapFile(&image->mapping);
+    }
+    else if (image->pData)
+    {
+        alimerFree(image->pData);
+    }
+
+    image->pData = nullptr;
+}
+
+static void UpdateLevelPixels(Image* image)
+{
+    const uint32_t count = GetLayerCount(image) * image->mipLevelCount;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        image->levels[i].pixels = image->pData ? (uint8_t*)image->pData + image->levels[i].offset : nullptr;
+    }
+}
+
+static void CopyLevel(const ImageLevel* src, ImageLevel* dst)
+{
+    ALIMER_ASSERT(src->rowCount == dst->rowCount && src->depth == dst->depth);
+
+    const size_t rowSize = src->rowPitch < dst->rowPitch ? src->rowPitch : dst->rowPitch;
+    const size_t rowCount = (size_t)src->rowCount * src->depth;
+    if (src->rowPitch == dst->rowPitch)
+    {
+        memcpy(dst->pixels, src->pixels, rowCount * src->rowPitch);
+        return;
+    }
+
+    for (size_t row = 0; row < rowCount; ++row)
+    {
+        memcpy(dst->pixels + row * dst->rowPitch, src->pixels + row * src->rowPitch, rowSize);
+    }
+}
+
+// Move the data to a new layout, keeping the mip levels present in both the old and new one.
+static bool RelayoutImage(Image* image, uint32_t mipLevelCount, uint32_t rowPitchAlignment)
+{
+    const uint32_t oldMipLevelCount = image->mipLevelCount;
+    const uint32_t oldRowPitchAlignment = image->rowPitchAlignment;
+    ImageLevel* oldLevels = image->levels;
+    void* oldData = image->pData;
+    const size_t oldDataSize = image->dataSize;
+    MappedFile oldMapping = image->mapping;
+
+    image->mipLevelCount = mipLevelCount;
+    image->rowPitchAlignment = rowPitchAlignment;
+    image->levels = nullptr;
+    image->pData = nullptr;
+    memset(&image->mapping, 0, sizeof(MappedFile));
+    if (SetupLayout(image))
+    {
+        MemoryCategoryScope category(MemoryCategory_ImageStorage);
+        image->pData = alimerCalloc(1, image->dataSize);
+    }
+
+    if (!image->pData)
+    {
+        alimerFree(image->levels);
+        image->mipLevelCount = oldMipLevelCount;
+        image->rowPitchAlignment = oldRowPitchAlignment;
+        image->levels = oldLevels;
+        image->pData = oldData;
+        image->dataSize = oldDataSize;
+        image->mapping = oldMapping;
+        return false;
+    }
+
+    UpdateLevelPixels(image);
+
+    const uint32_t copyLevelCount = oldMipLevelCount < mipLevelCount ? oldMipLevelCount : mipLevelCount;
+    for (uint32_t layer = 0; layer < GetLayerCount(image); ++layer)
+    {
+        for (uint32_t mipLevel = 0; mipLevel < copyLevelCount; ++mipLevel)
+        {
+            CopyLevel(&oldLevels[layer * oldMipLevelCount + mipLevel], &image->levels[layer * mipLevelCount + mipLevel]);
+        }
+    }
+
+    alimerFree(oldLevels);
+    if (oldMapping.data)
+        alimerUnmapFile(&oldMapping);
+    else
+        alimerFree(oldData);
+    return true;
+}
+
+// Check the description, mipLevelCount receives the level count of the image (0 and counts past the full chain make the full chain).
+static bool ValidateImageDesc(const ImageDesc* desc, uint32_t* mipLevelCount)
+{
+    if (!desc || desc->format == PixelFormat_Undefined || desc->format >= _PixelFormat_Count || desc->dimension >= _ImageDimension_Count)
+        return false;
+
+    if (!desc->width || !desc->height || !desc->depthOrArrayLayers)
+        return false;
+
+    const uint32_t maxDepthOrArrayLayers = desc->dimension == ImageDimension_3D ? ALIMER_IMAGE_MAX_DIMENSION : ALIMER_IMAGE_MAX_LAYERS;
+    if (desc->width > ALIMER_IMAGE_MAX_DIMENSION || desc->height > ALIMER_IMAGE_MAX_DIMENSION || desc->depthOrArrayLayers > maxDepthOrArrayLayers)
+        return false;
+
+    // Square faces, six layers per cube.
+    if (desc->dimension == ImageDimension_Cube && (desc->width != desc->height || desc->depthOrArrayLayers % 6 != 0))
+        return false;
+
+    if ((desc->rowPitchAlignment & (desc->rowPitchAlignment - 1)) != 0)
+        return false;
+
+    const uint32_t depth = desc->dimension == ImageDimension_3D ? desc->depthOrArrayLayers : 1;
+    const uint32_t fullMipLevelCount = GetFullMipLevelCount(desc->width, desc->height, depth);
+    *mipLevelCount = (desc->mipLevelCount == 0 || desc->mipLevelCount > fullMipLevelCount) ? fullMipLevelCount : desc->mipLevelCount;
+    return true;
+}
+
+// Bytes of data the layout of a valid description takes, computed without allocating anything so that containers can check their payload first.
+static bool GetImageDataSize(const ImageDesc* desc, uint32_t mipLevelCount, size_t* dataSize)
+{
+    const bool volume = desc->dimension == ImageDimension_3D;
+    const uint32_t layerCount = volume ? 1u : desc->depthOrArrayLayers;
+    const size_t rowPitchAlignment = desc->rowPitchAlignment > 0 ? desc->rowPitchAlignment : 1;
+    size_t offset = 0;
+    for (uint32_t layer = 0; layer < layerCount; ++layer)
+    {
+        for (uint32_t mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel)
+        {
+            ImageLevel level;
+            const uint32_t width = std::max(desc->width >> mipLevel, 1u);
+            const uint32_t height = std::max(desc->height >> mipLevel, 1u);
+            const uint32_t depth = volume ? std::max(desc->depthOrArrayLayers >> mipLevel, 1u) : 1u;
+            if (!SetupLevelLayout(&level, desc->format, width, height, depth, rowPitchAlignment, &offset))
+                return false;
+        }
+    }
+
+    *dataSize = offset;
+    return true;
+}
+
+// Validate the description and build the layout, without any storage.
+static Image* CreateImageLayout(const ImageDesc* desc)
 {
-    if (!width || !height || !arrayLayers)
-        return NULL;
+    uint32_t mipLevelCount;
+    if (!ValidateImageDesc(desc, &mipLevelCount))
+        return nullptr;
 
+    const uint32_t rowPitchAlignment = desc->rowPitchAlignment > 0 ? desc->rowPitchAlignment : 1;
+    MemoryCategoryScope category(MemoryCategory_ImageStorage);
     Image* image = ALIMER_ALLOC(Image);
-    if (!image) {
+    if (!image)
+        return nullptr;
+
+    image->dimension = desc->dimension;
+    image->format = desc->format;
+    image->width = desc->width;
+    image->height = desc->height;
+    image->depthOrArrayLayers = desc->depthOrArrayLayers;
+    image->mipLevelCount = mipLevelCount;
+    image->rowPitchAlignment = rowPitchAlignment;
+
+    if (!SetupLayout(image))
+    {
+        alimerFree(image);
+        return nullptr;
+    }
+
+    alimerTrackLiveImages(1);
+    return image;
+}
+
+Image* alimerImageCreate(const ImageDesc* desc)
+{
+    Image* image = CreateImageLayout(desc);
+    if (!image)
+        return nullptr;
+
+    MemoryCategoryScope category(MemoryCategory_ImageStorage);
+    image->pData = alimerCalloc(1, image->dataSize);
+    if (!image->pData)
+    {
+        alimerImageDestroy(image);
         return nullptr;
     }
 
+    UpdateLevelPixels(image);
+    return image;
+}
+
+Image* alimerImageCreate2D(PixelFormat format, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevelCount)
+{
+    ImageDesc desc = {};
+    desc.dimension = ImageDimension_2D;
+    desc.format = format;
+    desc.width = width;
+    desc.height = height;
+    desc.depthOrArrayLayers = arrayLayers;
+    desc.mipLevelCount = mipLevelCount;
+    desc.rowPitchAlignment = 1;
+    return alimerImageCreate(&desc);
+}
+
+Image* alimerImageCreateCube(PixelFormat format, uint32_t size, uint32_t cubeCount, uint32_t mipLevelCount)
+{
+    ImageDesc desc = {};
+    desc.dimension = ImageDimension_Cube;
+    desc.format = format;
+    desc.width = size;
+    desc.height = size;
+    desc.depthOrArrayLayers = cubeCount * 6;
+    desc.mipLevelCount = mipLevelCount;
+    desc.rowPitchAlignment = 1;
+    return alimerImageCreate(&desc);
+}
+
+// Also checked by the KTX2 header parser.
+static const uint8_t kKTX2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+static ImageFileType DetectFileType(const uint8_t* data, size_t size)
+{
+    static const uint8_t kPngMagic[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    static const uint8_t kExrMagic[4] = { 0x76, 0x2F, 0x31, 0x01 };
+
+    if (size >= 8 && memcmp(data, kPngMagic, 8) == 0)
+        return ImageFileType_PNG;
+
+    if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+        return ImageFileType_JPG;
+
+    if (size >= 4 && memcmp(data, "qoif", 4) == 0)
+        return ImageFileType_QOI;
+
+    if (size >= 4 && memcmp(data, kExrMagic, 4) == 0)
+        return ImageFileType_EXR;
+
+    // "#?RADIANCE" or "#?RGBE"
+    if (size >= 2 && data[0] == '#' && data[1] == '?')
+        return ImageFileType_HDR;
+
+    if (size >= 6 && memcmp(data, "GIF8", 4) == 0)
+        return ImageFileType_GIF;
+
+    if (size >= 2 && data[0] == 'B' && data[1] == 'M')
+        return ImageFileType_BMP;
+
+    if (size >= 4 && memcmp(data, "DDS ", 4) == 0)
+        return ImageFileType_DDS;
+
+    if (size >= sizeof(kKTX2Identifier) && memcmp(data, kKTX2Identifier, sizeof(kKTX2Identifier)) == 0)
+        return ImageFileType_KTX2;
+
+    // TGA has no magic number, let stb_image validate the header (every other enabled stb format has been ruled out above).
+    int x, y, comp;
+    if (size <= INT_MAX && stbi_info_from_memory(data, (int)size, &x, &y, &comp))
+        return ImageFileType_TGA;
+
+    return ImageFileType_Unknown;
+}
+
+static Image* CreateImageWithData(PixelFormat format, uint32_t width, uint32_t height, void* pData, size_t dataSize)
+{
+    MemoryCategoryScope category(MemoryCategory_ImageStorage);
+    Image* image = ALIMER_ALLOC(Image);
+    if (!image)
+        return nullptr;
+
     image->dimension = ImageDimension_2D;
     image->format = format;
     image->width = width;
     image->height = height;
-    image->depthOrArrayLayers = arrayLayers;
-    image->mipLevelCount = mipLevelCount;
+    image->depthOrArrayLayers = 1;
+    image->mipLevelCount = 1;
+    image->rowPitchAlignment = 1;
+    if (!SetupLayout(image))
+    {
+        alimerFree(image);
+        return nullptr;
+    }
 
+    // Decoders output tightly packed rows, which is the layout with an alignment of 1.
+    ALIMER_ASSERT(image->dataSize == dataSize);
+    ALIMER_UNUSED(dataSize);
+    image->pData = pData;
+    alimerSetAllocationCategory(pData, MemoryCategory_ImageStorage);
+    UpdateLevelPixels(image);
+    alimerTrackLiveImages(1);
     return image;
 }
 
-Image* alimerImageCreateFromMemory(const void* pData, size_t dataSize)
+static bool STB_GetInfo(const uint8_t* data, size_t size, ImageInfo* info)
 {
-    if (pData == nullptr || dataSize == 0)
+    if (size > INT_MAX)
+        return false;
+
+    int width, height, channels;
+    if (!stbi_info_from_memory(data, (int)size, &width, &height, &channels) || width <= 0 || height <= 0)
+        return false;
+
+    if (stbi_is_hdr_from_memory(data, (int)size))
+    {
+        info->format = PixelFormat_RGBA32Float;
+    }
+    else if (stbi_is_16_bit_from_memory(data, (int)size))
+    {
+        info->format = channels == 1 ? PixelFormat_R16Unorm : PixelFormat_RGBA16Unorm;
+    }
+    else
+    {
+        info->format = channels == 1 ? PixelFormat_R8Unorm : PixelFormat_RGBA8Unorm;
+    }
+
+    info->width = (uint32_t)width;
+    info->height = (uint32_t)height;
+    info->channels = (uint32_t)channels;
+    return true;
+}
+
+static Image* STB_LoadFromMemory(const uint8_t* data, size_t size)
+{
+    ImageInfo info = {};
+    if (!STB_GetInfo(data, size, &info))
         return nullptr;
 
-    Image* image = ALIMER_ALLOC(Image);
-    if (!image) {
+    // stb_image scratch (zlib buffers, intermediate conversions) comes from the thread arena when enabled.
+    ScratchScope scratch;
+    int width, height, channels;
+    void* pixels = nullptr;
+    size_t bytesPerPixel = 0;
+    switch (info.format)
+    {
+        case PixelFormat_RGBA32Float:
+            pixels = stbi_loadf_from_memory(data, (int)size, &width, &height, &channels, 4);
+            bytesPerPixel = 16;
+            break;
+        case PixelFormat_R16Unorm:
+        case PixelFormat_RGBA16Unorm:
+            bytesPerPixel = info.channels == 1 ? 2 : 8;
+            pixels = stbi_load_16_from_memory(data, (int)size, &width, &height, &channels, info.channels == 1 ? 1 : 4);
+            break;
+        default:
+            bytesPerPixel = info.channels == 1 ? 1 : 4;
+            pixels = stbi_load_from_memory(data, (int)size, &width, &height, &channels, info.channels == 1 ? 1 : 4);
+            break;
+    }
+
+    if (!pixels)
+        return nullptr;
+
+    if (width <= 0 || height <= 0)
+    {
+        stbi_image_free(pixels);
         return nullptr;
     }
 
+    // A heap result is adopted as is, one from the arena has to outlive the scope.
+    const size_t dataSize = (size_t)width * height * bytesPerPixel;
+    if (alimerScratchOwns(pixels))
+    {
+        void* heapPixels = alimerMalloc(dataSize);
+        if (heapPixels)
+            memcpy(heapPixels, pixels, dataSize);
+        stbi_image_free(pixels);
+        pixels = heapPixels;
+        if (!pixels)
+            return nullptr;
+    }
+
+    Image* image = CreateImageWithData(info.format, (uint32_t)width, (uint32_t)height, pixels, dataSize);
+    if (!image)
+        alimerFree(pixels);
     return image;
 }
 
-void alimerImageDestroy(Image* image)
+static bool QOI_GetInfo(const uint8_t* data, size_t size, ImageInfo* info)
+{
+    if (size < QOI_HEADER_SIZE + sizeof(qoi_padding))
+        return false;
+
+    int p = 0;
+    const unsigned int magic = qoi_read_32(data, &p);
+    const unsigned int width = qoi_read_32(data, &p);
+    const unsigned int height = qoi_read_32(data, &p);
+    const unsigned int channels = data[p++];
+    if (magic != QOI_MAGIC || width == 0 || height == 0 || channels < 3 || channels > 4)
+        return false;
+
+    info->format = PixelFormat_RGBA8Unorm;
+    info->width = width;
+    info->height = height;
+    info->channels = channels;
+    return true;
+}
+
+static Image* QOI_LoadFromMemory(const uint8_t* data, size_t size)
 {
+    if (size > INT_MAX)
+        return nullptr;
+
+    // No scratch scope is open, QOI_MALLOC falls back to alimerMalloc and the decoded buffer is adopted as is.
+    qoi_desc desc;
+    void* pixels = qoi_decode(data, (int)size, &desc, 4);
+    if (!pixels)
+        return nullptr;
+
+    const size_t dataSize = (size_t)desc.width * desc.height * 4;
+    Image* image = CreateImageWithData(PixelFormat_RGBA8Unorm, desc.width, desc.height, pixels, dataSize);
     if (!image)
-        return;
+        alimerFree(pixels);
+    return image;
+}
 
-    if (image->pData)
-        alimerFree(image->pData);
+// EXR, single part files. Layers are the channel name prefixes before the last '.', the channels without one form the default layer.
+static bool EXR_ParseHeader(const uint8_t* data, size_t size, EXRHeader* header)
+{
+    EXRVersion version;
+    if (ParseEXRVersionFromMemory(&version, data, size) != TINYEXR_SUCCESS || version.multipart || version.non_image)
+        return false;
 
-    alimerFree(image);
+    InitEXRHeader(header);
+    if (ParseEXRHeaderFromMemory(header, &version, data, size, nullptr) != TINYEXR_SUCCESS)
+        return false;
+
+    const int64_t width = (int64_t)header->data_window.max_x - header->data_window.min_x + 1;
+    const int64_t height = (int64_t)header->data_window.max_y - header->data_window.min_y + 1;
+    if (width <= 0 || height <= 0 || width > TINYEXR_DIMENSION_THRESHOLD || height > TINYEXR_DIMENSION_THRESHOLD)
+    {
+        FreeEXRHeader(header);
+        return false;
+    }
+
+    return true;
+}
+
+static bool EXR_IsInLayer(const char* name, const char* layer)
+{
+    const char* dot = strrchr(name, '.');
+    const size_t layerLength = layer ? strlen(layer) : 0;
+    if (!dot)
+        return layerLength == 0;
+    return (size_t)(dot - name) == layerLength && memcmp(name, layer, layerLength) == 0;
+}
+
+static int EXR_FindChannel(const EXRHeader& header, const char* layer, const char* channel)
+{
+    for (int c = 0; c < header.num_channels; ++c)
+    {
+        const char* name = header.channels[c].name;
+        const char* dot = strrchr(name, '.');
+        if (EXR_IsInLayer(name, layer) && strcmp(dot ? dot + 1 : name, channel) == 0)
+            return c;
+    }
+
+    return -1;
+}
+
+// Map the selected channels to RGBA and pick the image format, PixelFormat_Undefined when none of them exist.
+static PixelFormat EXR_SelectChannels(const EXRHeader& header, const ExrLoadDesc* desc, int channelIndex[4])
+{
+    static const char* const kDefaultChannels[4] = { "R", "G", "B", "A" };
+    const char* layer = desc ? desc->layer : nullptr;
+    const char* const* names = kDefaultChannels;
+    if (desc && (desc->channels[0] || desc->channels[1] || desc->channels[2] || desc->channels[3]))
+        names = desc->channels;
+
+    for (uint32_t i = 0; i < 4; ++i)
+        channelIndex[i] = names[i] ? EXR_FindChannel(header, layer, names[i]) : -1;
+
+    // A layer with a single channel (luminance, depth) is read as gray.
+    if (names == kDefaultChannels)
+    {
+        int single = -1;
+        int count = 0;
+        for (int c = 0; c < header.num_channels; ++c)
+        {
+            if (EXR_IsInLayer(header.channels[c].name, layer))
+            {
+                single = c;
+                count++;
+            }
+        }
+
+        if (count == 1)
+        {
+            channelIndex[0] = channelIndex[1] = channelIndex[2] = single;
+            channelIndex[3] = -1;
+        }
+    }
+
+    bool found = false;
+    bool half = true;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        if (channelIndex[i] < 0)
+            continue;
+        found = true;
+        half = half && header.channels[channelIndex[i]].pixel_type == TINYEXR_PIXELTYPE_HALF;
+    }
+
+    if (!found)
+        return PixelFormat_Undefined;
+    return half ? PixelFormat_RGBA16Float : PixelFormat_RGBA32Float;
+}
+
+static int EXR_GetLinesPerChunk(const EXRHeader& header)
+{
+    if (header.compression_type == TINYEXR_COMPRESSIONTYPE_ZIP || header.compression_type == TINYEXR_COMPRESSIONTYPE_ZFP)
+        return 16;
+    if (header.compression_type == TINYEXR_COMPRESSIONTYPE_PIZ)
+        return 32;
+    return 1;
+}
+
+static bool EXR_GetInfo(const uint8_t* data, size_t size, ImageInfo* info)
+{
+    EXRHeader header;
+    if (!EXR_ParseHeader(data, size, &header))
+        return false;
+
+    int channelIndex[4];
+    info->format = EXR_SelectChannels(header, nullptr, channelIndex);
+    info->width = (uint32_t)(header.data_window.max_x - header.data_window.min_x + 1);
+    info->height = (uint32_t)(header.data_window.max_y - header.data_window.min_y + 1);
+    info->channels = (uint32_t)header.num_channels;
+    FreeEXRHeader(&header);
+    return info->format != PixelFormat_Undefined;
+}
+
+// Interleave width samples of the selected channel planes from index base into a row of RGBA16Float or RGBA32Float pixels.
+static void EXR_InterleaveRow(const EXRHeader& header, const int channelIndex[4], PixelFormat format, unsigned char* const* images, size_t base, int width, uint8_t* row)
+{
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        const int channel = channelIndex[c];
+        if (format == PixelFormat_RGBA16Float)
+        {
+            uint16_t* dst = (uint16_t*)row + c;
+            const uint16_t* src = channel >= 0 ? (const uint16_t*)images[channel] + base : nullptr;
+            const uint16_t fill = c == 3 ? 0x3C00 : 0;
+            for (int x = 0; x < width; ++x)
+                dst[x * 4] = src ? src[x] : fill;
+        }
+        else if (channel < 0)
+        {
+            float* dst = (float*)row + c;
+            const float fill = c == 3 ? 1.0f : 0.0f;
+            for (int x = 0; x < width; ++x)
+                dst[x * 4] = fill;
+        }
+        else if (header.requested_pixel_types[channel] == TINYEXR_PIXELTYPE_UINT)
+        {
+            float* dst = (float*)row + c;
+            const uint32_t* src = (const uint32_t*)images[channel] + base;
+            for (int x = 0; x < width; ++x)
+                dst[x * 4] = (float)src[x];
+        }
+        else
+        {
+            float* dst = (float*)row + c;
+            const float* src = (const float*)images[channel] + base;
+            for (int x = 0; x < width; ++x)
+                dst[x * 4] = src[x];
+        }
+    }
+}
+
+// Halves are kept as is for a half image, everything else except uint is decoded to float.
+static void EXR_SetRequestedTypes(EXRHeader* header, PixelFormat format)
+{
+    for (int c = 0; c < header->num_channels; ++c)
+    {
+        const int type = header->channels[c].pixel_type;
+        const bool keep = type == TINYEXR_PIXELTYPE_UINT || (type == TINYEXR_PIXELTYPE_HALF && format == PixelFormat_RGBA16Float);
+        header->requested_pixel_types[c] = keep ? type : TINYEXR_PIXELTYPE_FLOAT;
+    }
+}
+
+struct EXRDecodeJob
+{
+    const EXRHeader* header;
+    const uint8_t* data;
+    size_t size;
+    size_t offsetTable;
+    const std::vector<size_t>* channelOffsets;
+    int pixelDataSize;
+    int channelIndex[4];
+    int linesPerChunk;
+    uint32_t tilesX;
+    uint32_t tilesY;
+    // Rows of the image held by level, chunks outside of them are rejected. Chunk indices start at firstChunk.
+    uint32_t bandY;
+    uint32_t bandHeight;
+    uint32_t firstChunk;
+    const ImageLevel* level;
+    std::atomic<bool> failed;
+};
+
+// Decompress one chunk to planes of 4 byte samples (halves use the first 2) and interleave the selected channels into the image.
+static bool EXR_DecodeChunk(EXRDecodeJob* job, uint32_t index)
+{
+    const EXRHeader& header = *job->header;
+    const ImageLevel& level = *job->level;
+    uint64_t offset;
+    memcpy(&offset, job->data + job->offsetTable + (size_t)index * 8, 8);
+    tinyexr::swap8((tinyexr::tinyexr_uint64*)&offset);
+
+    const size_t chunkHeaderSize = header.tiled ? 20 : 8;
+    if (offset < job->offsetTable || offset > job->size || job->size - offset < chunkHeaderSize)
+        return false;
+
+    int fields[5];
+    memcpy(fields, job->data + offset, chunkHeaderSize);
+    for (size_t i = 0; i < chunkHeaderSize / 4; ++i)
+        tinyexr::swap4(&fields[i]);
+
+    const int dataLength = fields[chunkHeaderSize / 4 - 1];
+    if (dataLength <= 0 || (uint64_t)dataLength > job->size - offset - chunkHeaderSize)
+        return false;
+
+    uint32_t x0 = 0;
+    uint32_t y0 = 0;
+    int stride = (int)level.width;
+    int width = (int)level.width;
+    int height = 0;
+    const int planeLines = header.tiled ? header.tile_size_y : job->linesPerChunk;
+    if (header.tiled)
+    {
+        // Tile coordinates and level, only level 0 is read.
+        if (fields[0] < 0 || fields[1] < 0 || (uint32_t)fields[0] >= job->tilesX || (uint32_t)fields[1] >= job->tilesY || fields[2] != 0 || fields[3] != 0)
+            return false;
+        x0 = (uint32_t)fields[0] * (uint32_t)header.tile_size_x;
+        y0 = (uint32_t)fields[1] * (uint32_t)header.tile_size_y;
+        stride = header.tile_size_x;
+        width = std::min(header.tile_size_x, (int)(level.width - x0));
+        height = std::min(header.tile_size_y, (int)(level.height - y0));
+    }
+    else
+    {
+        const int64_t y = (int64_t)fields[0] - header.data_window.min_y;
+        if (y < 0 || y >= (int64_t)level.height)
+            return false;
+        y0 = (uint32_t)y;
+        height = std::min(job->linesPerChunk, (int)(level.height - y0));
+    }
+
+    if (y0 < job->bandY || y0 + (uint32_t)height > job->bandY + job->bandHeight)
+        return false;
+
+    ScratchScope scratch;
+    const size_t planeSize = (size_t)stride * planeLines * 4;
+    uint8_t* planes = (uint8_t*)alimerScratchAlloc(planeSize * header.num_channels);
+    unsigned char** images = (unsigned char**)alimerScratchAlloc(sizeof(unsigned char*) * header.num_channels);
+    if (!planes || !images)
+    {
+        alimerScratchFree(images);
+        alimerScratchFree(planes);
+        return false;
+    }
+
+    for (int c = 0; c < header.num_channels; ++c)
+        images[c] = planes + planeSize * c;
+
+    const uint8_t* payload = job->data + offset + chunkHeaderSize;
+    bool result = tinyexr::DecodePixelData(images, header.requested_pixel_types, payload, (size_t)dataLength, header.compression_type, 0,
+        width, height, stride, 0, 0, height, (size_t)job->pixelDataSize, (size_t)header.num_custom_attributes, header.custom_attributes,
+        (size_t)header.num_channels, header.channels, *job->channelOffsets);
+
+    for (int line = 0; result && line < height; ++line)
+    {
+        uint8_t* row = level.pixels + (size_t)(y0 - job->bandY + line) * level.rowPitch + (size_t)x0 * GetFormatBytesPerBlock(level.format);
+        EXR_InterleaveRow(header, job->channelIndex, level.format, images, (size_t)line * stride, width, row);
+    }
+
+    alimerScratchFree(images);
+    alimerScratchFree(planes);
+    return result;
+}
+
+static void EXR_DecodeChunks(uint32_t index, void* userData)
+{
+    EXRDecodeJob* job = (EXRDecodeJob*)userData;
+    if (!job->failed.load(std::memory_order_relaxed) && !EXR_DecodeChunk(job, job->firstChunk + index))
+        job->failed.store(true, std::memory_order_relaxed);
+}
+
+static Image* EXR_Load(const uint8_t* data, size_t size, const ExrLoadDesc* desc)
+{
+    EXRHeader header;
+    if (!EXR_ParseHeader(data, size, &header))
+        return nullptr;
+
+    EXRDecodeJob job;
+    job.header = &header;
+    job.data = data;
+    job.size = size;
+    job.offsetTable = (size_t)header.header_len + 8;
+    job.linesPerChunk = EXR_GetLinesPerChunk(header);
+    job.failed = false;
+
+    std::vector<size_t> channelOffsets;
+    size_t channelOffset = 0;
+    const PixelFormat format = EXR_SelectChannels(header, desc, job.channelIndex);
+    const uint32_t width = (uint32_t)(header.data_window.max_x - header.data_window.min_x + 1);
+    const uint32_t height = (uint32_t)(header.data_window.max_y - header.data_window.min_y + 1);
+    uint32_t chunkCount = (height + job.linesPerChunk - 1) / job.linesPerChunk;
+    job.tilesX = 0;
+    job.tilesY = 0;
+    if (header.tiled)
+    {
+        if (header.tile_size_x <= 0 || header.tile_size_y <= 0)
+            chunkCount = 0;
+        else
+        {
+            job.tilesX = (width + header.tile_size_x - 1) / header.tile_size_x;
+            job.tilesY = (height + header.tile_size_y - 1) / header.tile_size_y;
+            chunkCount = job.tilesX * job.tilesY;
+        }
+    }
+
+    Image* image = nullptr;
+    if (format != PixelFormat_Undefined && chunkCount > 0 && job.offsetTable + (size_t)chunkCount * 8 <= size &&
+        tinyexr::ComputeChannelLayout(&channelOffsets, &job.pixelDataSize, &channelOffset, header.num_channels, header.channels))
+    {
+        image = alimerImageCreate2D(format, width, height, 1, 1);
+    }
+
+    if (image)
+    {
+        EXR_SetRequestedTypes(&header, format);
+
+        job.channelOffsets = &channelOffsets;
+        job.bandY = 0;
+        job.bandHeight = height;
+        job.firstChunk = 0;
+        job.level = &image->levels[0];
+        if (chunkCount == 1)
+            EXR_DecodeChunks(0, &job);
+        else
+            alimerParallelFor(chunkCount, EXR_DecodeChunks, &job);
+
+        if (job.failed)
+        {
+            alimerImageDestroy(image);
+            image = nullptr;
+        }
+    }
+
+    FreeEXRHeader(&header);
+    return image;
+}
+
+Image* alimerImageCreateFromEXR(const void* pData, size_t dataSize, const ExrLoadDesc* desc)
+{
+    if (pData == nullptr || dataSize == 0)
+        return nullptr;
+
+    MemoryCategoryScope category(MemoryCategory_ImageDecode);
+    return EXR_Load((const uint8_t*)pData, dataSize, desc);
+}
+
+// DDS, see https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dds-header
+#define DDS_MAGIC 0x20534444u // "DDS "
+#define DDS_MAKEFOURCC(a, b, c, d) ((uint32_t)(uint8_t)(a) | ((uint32_t)(uint8_t)(b) << 8) | ((uint32_t)(uint8_t)(c) << 16) | ((uint32_t)(uint8_t)(d) << 24))
+
+#define DDS_HEADER_FLAGS_DEPTH  0x00800000u
+#define DDS_PF_ALPHAPIXELS      0x00000001u
+#define DDS_PF_FOURCC           0x00000004u
+#define DDS_PF_RGB              0x00000040u
+#define DDS_PF_LUMINANCE        0x00020000u
+#define DDS_CAPS2_CUBEMAP       0x00000200u
+#define DDS_CAPS2_VOLUME        0x00200000u
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4u
+
+enum DDS_RESOURCE_DIMENSION
+{
+    DDS_DIMENSION_TEXTURE1D = 2,
+    DDS_DIMENSION_TEXTURE2D = 3,
+    DDS_DIMENSION_TEXTURE3D = 4,
+};
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t RGBBitCount;
+    uint32_t RBitMask;
+    uint32_t GBitMask;
+    uint32_t BBitMask;
+    uint32_t ABitMask;
+};
+
+struct DDS_HEADER
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DDS_HEADER) == 124, "DDS Header size mismatch");
+static_assert(sizeof(DDS_HEADER_DXT10) == 20, "DDS DX10 Extended Header size mismatch");
+
+struct DXGIFormatMapping
+{
+    PixelFormat format;
+    uint32_t dxgiFormat;
+};
+
+static const DXGIFormatMapping kDXGIFormats[] = {
+    { PixelFormat_R8Unorm,              61 },
+    { PixelFormat_R8Snorm,              63 },
+    { PixelFormat_R8Uint,               62 },
+    { PixelFormat_R8Sint,               64 },
+    { PixelFormat_R16Unorm,             56 },
+    { PixelFormat_R16Snorm,             58 },
+    { PixelFormat_R16Uint,              57 },
+    { PixelFormat_R16Sint,              59 },
+    { PixelFormat_R16Float,             54 },
+    { PixelFormat_RG8Unorm,             49 },
+    { PixelFormat_RG8Snorm,             51 },
+    { PixelFormat_RG8Uint,              50 },
+    { PixelFormat_RG8Sint,              52 },
+    { PixelFormat_BGRA4Unorm,           115 },
+    { PixelFormat_B5G6R5Unorm,          85 },
+    { PixelFormat_BGR5A1Unorm,          86 },
+    { PixelFormat_R32Uint,              42 },
+    { PixelFormat_R32Sint,              43 },
+    { PixelFormat_R32Float,             41 },
+    { PixelFormat_RG16Unorm,            35 },
+    { PixelFormat_RG16Snorm,            37 },
+    { PixelFormat_RG16Uint,             36 },
+    { PixelFormat_RG16Sint,             38 },
+    { PixelFormat_RG16Float,            34 },
+    { PixelFormat_RGBA8Unorm,           28 },
+    { PixelFormat_RGBA8UnormSrgb,       29 },
+    { PixelFormat_RGBA8Snorm,           31 },
+    { PixelFormat_RGBA8Uint,            30 },
+    { PixelFormat_RGBA8Sint,            32 },
+    { PixelFormat_BGRA8Unorm,           87 },
+    { PixelFormat_BGRA8UnormSrgb,       91 },
+    { PixelFormat_RGB10A2Unorm,         24 },
+    { PixelFormat_RGB10A2Uint,          25 },
+    { PixelFormat_RG11B10UFloat,        26 },
+    { PixelFormat_RGB9E5UFloat,         67 },
+    { PixelFormat_RG32Uint,             17 },
+    { PixelFormat_RG32Sint,             18 },
+    { PixelFormat_RG32Float,            16 },
+    { PixelFormat_RGBA16Unorm,          11 },
+    { PixelFormat_RGBA16Snorm,          13 },
+    { PixelFormat_RGBA16Uint,           12 },
+    { PixelFormat_RGBA16Sint,           14 },
+    { PixelFormat_RGBA16Float,          10 },
+    { PixelFormat_RGBA32Uint,           3 },
+    { PixelFormat_RGBA32Sint,           4 },
+    { PixelFormat_RGBA32Float,          2 },
+    { PixelFormat_Depth16Unorm,         55 },
+    { PixelFormat_Depth24UnormStencil8, 45 },
+    { PixelFormat_Depth32Float,         40 },
+    { PixelFormat_Depth32FloatStencil8, 20 },
+    { PixelFormat_BC1RGBAUnorm,         71 },
+    { PixelFormat_BC1RGBAUnormSrgb,     72 },
+    { PixelFormat_BC2RGBAUnorm,         74 },
+    { PixelFormat_BC2RGBAUnormSrgb,     75 },
+    { PixelFormat_BC3RGBAUnorm,         77 },
+    { PixelFormat_BC3RGBAUnormSrgb,     78 },
+    { PixelFormat_BC4RUnorm,            80 },
+    { PixelFormat_BC4RSnorm,            81 },
+    { PixelFormat_BC5RGUnorm,           83 },
+    { PixelFormat_BC5RGSnorm,           84 },
+    { PixelFormat_BC6HRGBUfloat,        95 },
+    { PixelFormat_BC6HRGBFloat,         96 },
+    { PixelFormat_BC7RGBAUnorm,         98 },
+    { PixelFormat_BC7RGBAUnormSrgb,     99 },
+};
+
+static PixelFormat FromDXGIFormat(uint32_t dxgiFormat)
+{
+    for (uint32_t i = 0; i < ALIMER_ARRAYSIZE(kDXGIFormats); ++i)
+    {
+        if (kDXGIFormats[i].dxgiFormat == dxgiFormat)
+            return kDXGIFormats[i].format;
+    }
+
+    return PixelFormat_Undefined;
+}
+
+static PixelFormat FromDDSPixelFormat(const DDS_PIXELFORMAT& ddspf)
+{
+    if (ddspf.flags & DDS_PF_FOURCC)
+    {
+        switch (ddspf.fourCC)
+        {
+            case DDS_MAKEFOURCC('D', 'X', 'T', '1'): return PixelFormat_BC1RGBAUnorm;
+            case DDS_MAKEFOURCC('D', 'X', 'T', '2'):
+            case DDS_MAKEFOURCC('D', 'X', 'T', '3'): return PixelFormat_BC2RGBAUnorm;
+            case DDS_MAKEFOURCC('D', 'X', 'T', '4'):
+            case DDS_MAKEFOURCC('D', 'X', 'T', '5'): return PixelFormat_BC3RGBAUnorm;
+            case DDS_MAKEFOURCC('A', 'T', 'I', '1'):
+            case DDS_MAKEFOURCC('B', 'C', '4', 'U'): return PixelFormat_BC4RUnorm;
+            case DDS_MAKEFOURCC('B', 'C', '4', 'S'): return PixelFormat_BC4RSnorm;
+            case DDS_MAKEFOURCC('A', 'T', 'I', '2'):
+            case DDS_MAKEFOURCC('B', 'C', '5', 'U'): return PixelFormat_BC5RGUnorm;
+            case DDS_MAKEFOURCC('B', 'C', '5', 'S'): return PixelFormat_BC5RGSnorm;
+            // D3DFORMAT values stored as FourCC
+            case 36:  return PixelFormat_RGBA16Unorm;
+            case 110: return PixelFormat_RGBA16Snorm;
+            case 111: return PixelFormat_R16Float;
+            case 112: return PixelFormat_RG16Float;
+            case 113: return PixelFormat_RGBA16Float;
+            case 114: return PixelFormat_R32Float;
+            case 115: return PixelFormat_RG32Float;
+            case 116: return PixelFormat_RGBA32Float;
+            default:  return PixelFormat_Undefined;
+        }
+    }
+
+    if (ddspf.flags & DDS_PF_RGB)
+    {
+        switch (ddspf.RGBBitCount)
+        {
+            case 32:
+                if (ddspf.RBitMask == 0x000000ff && ddspf.GBitMask == 0x0000ff00 && ddspf.BBitMask == 0x00ff0000)
+                    return PixelFormat_RGBA8Unorm;
+                if (ddspf.RBitMask == 0x00ff0000 && ddspf.GBitMask == 0x0000ff00 && ddspf.BBitMask == 0x000000ff)
+                    return PixelFormat_BGRA8Unorm;
+                if (ddspf.RBitMask == 0x0000ffff && ddspf.GBitMask == 0xffff0000)
+                    return PixelFormat_RG16Unorm;
+                if (ddspf.RBitMask == 0xffffffff)
+                    return PixelFormat_R32Float;
+                return PixelFormat_Undefined;
+            case 16:
+                if (ddspf.RBitMask == 0xf800 && ddspf.GBitMask == 0x07e0 && ddspf.BBitMask == 0x001f)
+                    return PixelFormat_B5G6R5Unorm;
+                if (ddspf.RBitMask == 0x7c00 && ddspf.GBitMask == 0x03e0 && ddspf.BBitMask == 0x001f && ddspf.ABitMask == 0x8000)
+                    return PixelFormat_BGR5A1Unorm;
+                if (ddspf.RBitMask == 0x0f00 && ddspf.GBitMask == 0x00f0 && ddspf.BBitMask == 0x000f && ddspf.ABitMask == 0xf000)
+                    return PixelFormat_BGRA4Unorm;
+                return PixelFormat_Undefined;
+            default:
+                return PixelFormat_Undefined;
+        }
+    }
+
+    if (ddspf.flags & DDS_PF_LUMINANCE)
+    {
+        if (ddspf.RGBBitCount == 8)
+            return PixelFormat_R8Unorm;
+        if (ddspf.RGBBitCount == 16 && ddspf.ABitMask == 0)
+            return PixelFormat_R16Unorm;
+        if (ddspf.RGBBitCount == 16 && ddspf.ABitMask == 0xff00)
+            return PixelFormat_RG8Unorm;
+    }
+
+    return PixelFormat_Undefined;
+}
+
+// Parse the headers into an image description, dataOffset receives the start of the payload.
+static bool DDS_ParseHeader(const uint8_t* data, size_t size, ImageDesc* desc, size_t* dataOffset)
+{
+    if (size < sizeof(uint32_t) + sizeof(DDS_HEADER))
+        return false;
+
+    uint32_t magic;
+    DDS_HEADER header;
+    memcpy(&magic, data, sizeof(uint32_t));
+    memcpy(&header, data + sizeof(uint32_t), sizeof(DDS_HEADER));
+    if (magic != DDS_MAGIC || header.size != sizeof(DDS_HEADER) || header.ddspf.size != sizeof(DDS_PIXELFORMAT))
+        return false;
+
+    memset(desc, 0, sizeof(ImageDesc));
+    desc->width = header.width;
+    desc->height = header.height;
+    desc->depthOrArrayLayers = 1;
+    desc->mipLevelCount = header.mipMapCount > 0 ? header.mipMapCount : 1;
+    desc->rowPitchAlignment = 1;
+    *dataOffset = sizeof(uint32_t) + sizeof(DDS_HEADER);
+
+    if ((header.ddspf.flags & DDS_PF_FOURCC) && header.ddspf.fourCC == DDS_MAKEFOURCC('D', 'X', '1', '0'))
+    {
+        if (size < *dataOffset + sizeof(DDS_HEADER_DXT10))
+            return false;
+
+        DDS_HEADER_DXT10 header10;
+        memcpy(&header10, data + *dataOffset, sizeof(DDS_HEADER_DXT10));
+        *dataOffset += sizeof(DDS_HEADER_DXT10);
+
+        desc->format = FromDXGIFormat(header10.dxgiFormat);
+        if (header10.arraySize == 0 || header10.arraySize > ALIMER_IMAGE_MAX_LAYERS)
+            return false;
+
+        switch (header10.resourceDimension)
+        {
+            case DDS_DIMENSION_TEXTURE1D:
+                desc->dimension = ImageDimension_1D;
+                desc->height = 1;
+                desc->depthOrArrayLayers = header10.arraySize;
+                break;
+            case DDS_DIMENSION_TEXTURE2D:
+                if (header10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+                {
+                    desc->dimension = ImageDimension_Cube;
+                    desc->depthOrArrayLayers = header10.arraySize * 6;
+                }
+                else
+                {
+                    desc->dimension = ImageDimension_2D;
+                    desc->depthOrArrayLayers = header10.arraySize;
+                }
+                break;
+            case DDS_DIMENSION_TEXTURE3D:
+                desc->dimension = ImageDimension_3D;
+                desc->depthOrArrayLayers = header.depth;
+                break;
+            default:
+                return false;
+        }
+    }
+    else
+    {
+        desc->format = FromDDSPixelFormat(header.ddspf);
+        if ((header.flags & DDS_HEADER_FLAGS_DEPTH) && (header.caps2 & DDS_CAPS2_VOLUME))
+        {
+            desc->dimension = ImageDimension_3D;
+            desc->depthOrArrayLayers = header.depth;
+        }
+        else if (header.caps2 & DDS_CAPS2_CUBEMAP)
+        {
+            // Partial cubemaps are not supported.
+            desc->dimension = ImageDimension_Cube;
+            desc->depthOrArrayLayers = 6;
+        }
+        else
+        {
+            desc->dimension = ImageDimension_2D;
+        }
+    }
+
+    return desc->format != PixelFormat_Undefined;
+}
+
+static bool DDS_GetInfo(const uint8_t* data, size_t size, ImageInfo* info)
+{
+    ImageDesc desc;
+    size_t dataOffset;
+    if (!DDS_ParseHeader(data, size, &desc, &dataOffset))
+        return false;
+
+    info->dimension = desc.dimension;
+    info->format = desc.format;
+    info->width = desc.width;
+    info->height = desc.height;
+    info->depthOrArrayLayers = desc.depthOrArrayLayers;
+    info->mipLevelCount = desc.mipLevelCount;
+    info->channels = 0;
+    return true;
+}
+
+// DDS stores subresources tightly packed in our layout order, with a mapping the payload is referenced in place.
+static Image* DDS_Load(const uint8_t* data, size_t size, MappedFile* mapping)
+{
+    ImageDesc desc;
+    size_t dataOffset;
+    if (!DDS_ParseHeader(data, size, &desc, &dataOffset))
+        return nullptr;
+
+    // The declared levels and layers must be in the file before anything is allocated for them.
+    uint32_t mipLevelCount;
+    size_t dataSize;
+    if (!ValidateImageDesc(&desc, &mipLevelCount) || mipLevelCount != desc.mipLevelCount ||
+        !GetImageDataSize(&desc, mipLevelCount, &dataSize) || dataSize > size - dataOffset)
+    {
+        return nullptr;
+    }
+
+    Image* image = CreateImageLayout(&desc);
+    if (!image)
+        return nullptr;
+
+    if (mapping)
+    {
+        image->pData = (uint8_t*)mapping->data + dataOffset;
+        image->mapping = *mapping;
+        memset(mapping, 0, sizeof(MappedFile));
+    }
+    else
+    {
+        MemoryCategoryScope category(MemoryCategory_ImageStorage);
+        image->pData = alimerMalloc(image->dataSize);
+        if (!image->pData)
+        {
+            alimerImageDestroy(image);
+            return nullptr;
+        }
+        memcpy(image->pData, data + dataOffset, image->dataSize);
+    }
+
+    UpdateLevelPixels(image);
+    return image;
+}
+
+// KTX2, see https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+#define KTX2_LEVEL_INDEX_OFFSET 80
+
+struct KTX2_HEADER
+{
+    uint8_t identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct KTX2_LEVEL
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+static_assert(sizeof(KTX2_HEADER) == KTX2_LEVEL_INDEX_OFFSET, "KTX2 Header size mismatch");
+static_assert(sizeof(KTX2_LEVEL) == 24, "KTX2 Level Index size mismatch");
+
+struct VkFormatMapping
+{
+    PixelFormat format;
+    uint32_t vkFormat;
+    /// Size of the data type used to upload the format, 1 for block compressed formats.
+    uint32_t typeSize;
+};
+
+// Packed formats use the Vulkan format with the same bit layout (B5G6R5 is VK_FORMAT_R5G6B5_UNORM_PACK16),
+// the combined depth stencil formats are laid out differently than in Vulkan and have no mapping.
+static const VkFormatMapping kVkFormats[] = {
+    { PixelFormat_R8Unorm,              9,   1 },
+    { PixelFormat_R8Snorm,              10,  1 },
+    { PixelFormat_R8Uint,               13,  1 },
+    { PixelFormat_R8Sint,               14,  1 },
+    { PixelFormat_R16Unorm,             70,  2 },
+    { PixelFormat_R16Snorm,             71,  2 },
+    { PixelFormat_R16Uint,              74,  2 },
+    { PixelFormat_R16Sint,              75,  2 },
+    { PixelFormat_R16Float,             76,  2 },
+    { PixelFormat_RG8Unorm,             16,  1 },
+    { PixelFormat_RG8Snorm,             17,  1 },
+    { PixelFormat_RG8Uint,              20,  1 },
+    { PixelFormat_RG8Sint,              21,  1 },
+    { PixelFormat_BGRA4Unorm,           1000340000, 2 },
+    { PixelFormat_B5G6R5Unorm,          4,   2 },
+    { PixelFormat_BGR5A1Unorm,          8,   2 },
+    { PixelFormat_R32Uint,              98,  4 },
+    { PixelFormat_R32Sint,              99,  4 },
+    { PixelFormat_R32Float,             100, 4 },
+    { PixelFormat_RG16Unorm,            77,  2 },
+    { PixelFormat_RG16Snorm,            78,  2 },
+    { PixelFormat_RG16Uint,             81,  2 },
+    { PixelFormat_RG16Sint,             82,  2 },
+    { PixelFormat_RG16Float,            83,  2 },
+    { PixelFormat_RGBA8Unorm,           37,  1 },
+    { PixelFormat_RGBA8UnormSrgb,       43,  1 },
+    { PixelFormat_RGBA8Snorm,           38,  1 },
+    { PixelFormat_RGBA8Uint,            41,  1 },
+    { PixelFormat_RGBA8Sint,            42,  1 },
+    { PixelFormat_BGRA8Unorm,           44,  1 },
+    { PixelFormat_BGRA8UnormSrgb,       50,  1 },
+    { PixelFormat_RGB10A2Unorm,         64,  4 },
+    { PixelFormat_RGB10A2Uint,          68,  4 },
+    { PixelFormat_RG11B10UFloat,        122, 4 },
+    { PixelFormat_RGB9E5UFloat,         123, 4 },
+    { PixelFormat_RG32Uint,             101, 4 },
+    { PixelFormat_RG32Sint,             102, 4 },
+    { PixelFormat_RG32Float,            103, 4 },
+    { PixelFormat_RGBA16Unorm,          91,  2 },
+    { PixelFormat_RGBA16Snorm,          92,  2 },
+    { PixelFormat_RGBA16Uint,           95,  2 },
+    { PixelFormat_RGBA16Sint,           96,  2 },
+    { PixelFormat_RGBA16Float,          97,  2 },
+    { PixelFormat_RGBA32Uint,           107, 4 },
+    { PixelFormat_RGBA32Sint,           108, 4 },
+    { PixelFormat_RGBA32Float,          109, 4 },
+    { PixelFormat_Depth16Unorm,         124, 2 },
+    { PixelFormat_Depth32Float,         126, 4 },
+    { PixelFormat_BC1RGBAUnorm,         133, 1 },
+    { PixelFormat_BC1RGBAUnormSrgb,     134, 1 },
+    { PixelFormat_BC2RGBAUnorm,         135, 1 },
+    { PixelFormat_BC2RGBAUnormSrgb,     136, 1 },
+    { PixelFormat_BC3RGBAUnorm,         137, 1 },
+    { PixelFormat_BC3RGBAUnormSrgb,     138, 1 },
+    { PixelFormat_BC4RUnorm,            139, 1 },
+    { PixelFormat_BC4RSnorm,            140, 1 },
+    { PixelFormat_BC5RGUnorm,           141, 1 },
+    { PixelFormat_BC5RGSnorm,           142, 1 },
+    { PixelFormat_BC6HRGBUfloat,        143, 1 },
+    { PixelFormat_BC6HRGBFloat,         144, 1 },
+    { PixelFormat_BC7RGBAUnorm,         145, 1 },
+    { PixelFormat_BC7RGBAUnormSrgb,     146, 1 },
+    { PixelFormat_ETC2RGB8Unorm,        147, 1 },
+    { PixelFormat_ETC2RGB8UnormSrgb,    148, 1 },
+    { PixelFormat_ETC2RGB8A1Unorm,      149, 1 },
+    { PixelFormat_ETC2RGB8A1UnormSrgb,  150, 1 },
+    { PixelFormat_ETC2RGBA8Unorm,       151, 1 },
+    { PixelFormat_ETC2RGBA8UnormSrgb,   152, 1 },
+    { PixelFormat_EACR11Unorm,          153, 1 },
+    { PixelFormat_EACR11Snorm,          154, 1 },
+    { PixelFormat_EACRG11Unorm,         155, 1 },
+    { PixelFormat_EACRG11Snorm,         156, 1 },
+    { PixelFormat_ASTC4x4Unorm,         157, 1 },
+    { PixelFormat_ASTC4x4UnormSrgb,     158, 1 },
+    { PixelFormat_ASTC5x4Unorm,         159, 1 },
+    { PixelFormat_ASTC5x4UnormSrgb,     160, 1 },
+    { PixelFormat_ASTC5x5Unorm,         161, 1 },
+    { PixelFormat_ASTC5x5UnormSrgb,     162, 1 },
+    { PixelFormat_ASTC6x5Unorm,         163, 1 },
+    { PixelFormat_ASTC6x5UnormSrgb,     164, 1 },
+    { PixelFormat_ASTC6x6Unorm,         165, 1 },
+    { PixelFormat_ASTC6x6UnormSrgb,     166, 1 },
+    { PixelFormat_ASTC8x5Unorm,         167, 1 },
+    { PixelFormat_ASTC8x5UnormSrgb,     168, 1 },
+    { PixelFormat_ASTC8x6Unorm,         169, 1 },
+    { PixelFormat_ASTC8x6UnormSrgb,     170, 1 },
+    { PixelFormat_ASTC8x8Unorm,         171, 1 },
+    { PixelFormat_ASTC8x8UnormSrgb,     172, 1 },
+    { PixelFormat_ASTC10x5Unorm,        173, 1 },
+    { PixelFormat_ASTC10x5UnormSrgb,    174, 1 },
+    { PixelFormat_ASTC10x6Unorm,        175, 1 },
+    { PixelFormat_ASTC10x6UnormSrgb,    176, 1 },
+    { PixelFormat_ASTC10x8Unorm,        177, 1 },
+    { PixelFormat_ASTC10x8UnormSrgb,    178, 1 },
+    { PixelFormat_ASTC10x10Unorm,       179, 1 },
+    { PixelFormat_ASTC10x10UnormSrgb,   180, 1 },
+    { PixelFormat_ASTC12x10Unorm,       181, 1 },
+    { PixelFormat_ASTC12x10UnormSrgb,   182, 1 },
+    { PixelFormat_ASTC12x12Unorm,       183, 1 },
+    { PixelFormat_ASTC12x12UnormSrgb,   184, 1 },
+};
+
+static const VkFormatMapping* FindVkFormat(PixelFormat format)
+{
+    for (uint32_t i = 0; i < ALIMER_ARRAYSIZE(kVkFormats); ++i)
+    {
+        if (kVkFormats[i].format == format)
+            return &kVkFormats[i];
+    }
+
+    return nullptr;
+}
+
+static PixelFormat FromVkFormat(uint32_t vkFormat)
+{
+    for (uint32_t i = 0; i < ALIMER_ARRAYSIZE(kVkFormats); ++i)
+    {
+        if (kVkFormats[i].vkFormat == vkFormat)
+            return kVkFormats[i].format;
+    }
+
+    return PixelFormat_Undefined;
+}
+
+// Parse the header into an image description and validate the level index, levels receives the first entry of the index.
+static bool KTX2_ParseHeader(const uint8_t* data, size_t size, ImageDesc* desc, const uint8_t** levels)
+{
+    if (size < sizeof(KTX2_HEADER))
+        return false;
+
+    KTX2_HEADER header;
+    memcpy(&header, data, sizeof(KTX2_HEADER));
+    if (memcmp(header.identifier, kKTX2Identifier, sizeof(kKTX2Identifier)) != 0)
+        return false;
+
+    // Supercompressed payloads (BasisLZ, Zstandard, ZLIB) can't be referenced as is.
+    if (header.supercompressionScheme != 0 || header.pixelWidth == 0 || (header.faceCount != 1 && header.faceCount != 6))
+        return false;
+
+    memset(desc, 0, sizeof(ImageDesc));
+    desc->format = FromVkFormat(header.vkFormat);
+    desc->width = header.pixelWidth;
+    desc->height = header.pixelHeight > 0 ? header.pixelHeight : 1;
+    // A level count of 0 asks the loader to generate the mips, only the top level is stored.
+    desc->mipLevelCount = header.levelCount > 0 ? header.levelCount : 1;
+    desc->rowPitchAlignment = 1;
+
+    const uint32_t layerCount = header.layerCount > 0 ? header.layerCount : 1;
+    if (layerCount > ALIMER_IMAGE_MAX_LAYERS)
+        return false;
+
+    if (header.pixelDepth > 0)
+    {
+        // 3D arrays have no equivalent.
+        if (layerCount > 1 || header.faceCount != 1)
+            return false;
+
+        desc->dimension = ImageDimension_3D;
+        desc->depthOrArrayLayers = header.pixelDepth;
+    }
+    else if (header.faceCount == 6)
+    {
+        desc->dimension = ImageDimension_Cube;
+        desc->depthOrArrayLayers = layerCount * 6;
+    }
+    else
+    {
+        desc->dimension = header.pixelHeight > 0 ? ImageDimension_2D : ImageDimension_1D;
+        desc->depthOrArrayLayers = layerCount;
+    }
+
+    if ((size - KTX2_LEVEL_INDEX_OFFSET) / sizeof(KTX2_LEVEL) < desc->mipLevelCount)
+        return false;
+
+    *levels = data + KTX2_LEVEL_INDEX_OFFSET;
+    return desc->format != PixelFormat_Undefined;
+}
+
+// Check the description and every entry of the level index against the file size, before anything is allocated for them.
+static bool KTX2_ValidateLevels(const ImageDesc& desc, const uint8_t* levels, uint32_t levelCount, size_t size)
+{
+    uint32_t mipLevelCount;
+    if (!ValidateImageDesc(&desc, &mipLevelCount) || mipLevelCount != desc.mipLevelCount)
+        return false;
+
+    const bool volume = desc.dimension == ImageDimension_3D;
+    const uint32_t layerCount = volume ? 1u : desc.depthOrArrayLayers;
+    for (uint32_t mipLevel = 0; mipLevel < levelCount; ++mipLevel)
+    {
+        KTX2_LEVEL level;
+        memcpy(&level, levels + mipLevel * sizeof(KTX2_LEVEL), sizeof(KTX2_LEVEL));
+
+        ImageLevel subresource;
+        size_t subresourceSize = 0;
+        size_t levelSize;
+        const uint32_t width = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t depth = volume ? std::max(desc.depthOrArrayLayers >> mipLevel, 1u) : 1u;
+        if (!SetupLevelLayout(&subresource, desc.format, width, height, depth, 1, &subresourceSize) ||
+            !MultiplySize(subresourceSize, layerCount, &levelSize))
+        {
+            return false;
+        }
+
+        if (level.byteLength < levelSize || level.byteOffset > size || level.byteLength > size - level.byteOffset)
+            return false;
+    }
+    return true;
+}
+
+static bool KTX2_GetInfo(const uint8_t* data, size_t size, ImageInfo* info)
+{
+    ImageDesc desc;
+    const uint8_t* levels;
+    if (!KTX2_ParseHeader(data, size, &desc, &levels))
+        return false;
+
+    info->dimension = desc.dimension;
+    info->format = desc.format;
+    info->width = desc.width;
+    info->height = desc.height;
+    info->depthOrArrayLayers = desc.depthOrArrayLayers;
+    info->mipLevelCount = desc.mipLevelCount;
+    info->channels = 0;
+    return true;
+}
+
+// KTX2 stores the levels smallest first, each level holding every layer (and face) with tightly packed rows.
+// A single level file matches our layout and is referenced in place with a mapping, otherwise each subresource is copied.
+static Image* KTX2_Load(const uint8_t* data, size_t size, MappedFile* mapping)
+{
+    ImageDesc desc;
+    const uint8_t* levels;
+    if (!KTX2_ParseHeader(data, size, &desc, &levels) || !KTX2_ValidateLevels(desc, levels, desc.mipLevelCount, size))
+        return nullptr;
+
+    Image* image = CreateImageLayout(&desc);
+    if (!image)
+        return nullptr;
+
+    const uint32_t layerCount = GetLayerCount(image);
+
+    KTX2_LEVEL top;
+    memcpy(&top, levels, sizeof(KTX2_LEVEL));
+    if (mapping && image->mipLevelCount == 1)
+    {
+        image->pData = (uint8_t*)mapping->data + top.byteOffset;
+        image->mapping = *mapping;
+        memset(mapping, 0, sizeof(MappedFile));
+        UpdateLevelPixels(image);
+        return image;
+    }
+
+    MemoryCategoryScope category(MemoryCategory_ImageStorage);
+    image->pData = alimerMalloc(image->dataSize);
+    if (!image->pData)
+    {
+        alimerImageDestroy(image);
+        return nullptr;
+    }
+
+    UpdateLevelPixels(image);
+    for (uint32_t mipLevel = 0; mipLevel < image->mipLevelCount; ++mipLevel)
+    {
+        KTX2_LEVEL level;
+        memcpy(&level, levels + mipLevel * sizeof(KTX2_LEVEL), sizeof(KTX2_LEVEL));
+
+        const uint8_t* src = data + level.byteOffset;
+        for (uint32_t layer = 0; layer < layerCount; ++layer)
+        {
+            ImageLevel& subresource = image->levels[layer * image->mipLevelCount + mipLevel];
+            const size_t subresourceSize = subresource.slicePitch * subresource.depth;
+            memcpy(subresource.pixels, src, subresourceSize);
+            src += subresourceSize;
+        }
+    }
+
+    return image;
+}
+
+Image* alimerImageCreateFromMemory(const void* pData, size_t dataSize)
+{
+    if (pData == nullptr || dataSize == 0)
+        return nullptr;
+
+    MemoryCategoryScope category(MemoryCategory_ImageDecode);
+    const uint8_t* data = (const uint8_t*)pData;
+    switch (DetectFileType(data, dataSize))
+    {
+        case ImageFileType_QOI:
+            return QOI_LoadFromMemory(data, dataSize);
+        case ImageFileType_EXR:
+            return EXR_Load(data, dataSize, nullptr);
+        case ImageFileType_DDS:
+            return DDS_Load(data, dataSize, nullptr);
+        case ImageFileType_KTX2:
+            return KTX2_Load(data, dataSize, nullptr);
+        case ImageFileType_BMP:
+        case ImageFileType_PNG:
+        case ImageFileType_JPG:
+        case ImageFileType_TGA:
+        case ImageFileType_GIF:
+        case ImageFileType_HDR:
+            return STB_LoadFromMemory(data, dataSize);
+        default:
+            return nullptr;
+    }
+}
+
+Image* alimerImageCreateFromFile(const char* path)
+{
+    if (path == nullptr)
+        return nullptr;
+
+    MappedFile mapping;
+    if (!alimerMapFile(path, &mapping))
+        return nullptr;
+
+    MemoryCategoryScope category(MemoryCategory_ImageDecode);
+    // Block data is adopted with the mapping, everything else is decoded straight from the mapped pages.
+    const uint8_t* data = (const uint8_t*)mapping.data;
+    Image* image = nullptr;
+    switch (DetectFileType(data, mapping.size))
+    {
+        case ImageFileType_DDS:
+            image = DDS_Load(data, mapping.size, &mapping);
+            break;
+        case ImageFileType_KTX2:
+            image = KTX2_Load(data, mapping.size, &mapping);
+            break;
+        default:
+            image = alimerImageCreateFromMemory(data, mapping.size);
+            break;
+    }
+
+    alimerUnmapFile(&mapping);
+    return image;
+}
+
+struct DecodeBatchJob
+{
+    const void** buffers;
+    const size_t* sizes;
+    Image** outImages;
+    // Indices sorted by decreasing size, so the long decodes start first and small ones fill the gaps.
+    const uint32_t* order;
+    uint32_t count;
+    std::atomic<uint32_t> next;
+    std::atomic<uint32_t> decoded;
+};
+
+static void DecodeBatchLane(uint32_t lane, void* userData)
+{
+    ALIMER_UNUSED(lane);
+
+    DecodeBatchJob* job = (DecodeBatchJob*)userData;
+    uint32_t decoded = 0;
+    uint32_t next;
+    while ((next = job->next.fetch_add(1, std::memory_order_relaxed)) < job->count)
+    {
+        const uint32_t index = job->order[next];
+        job->outImages[index] = alimerImageCreateFromMemory(job->buffers[index], job->sizes[index]);
+        if (job->outImages[index])
+            decoded++;
+    }
+
+    job->decoded.fetch_add(decoded, std::memory_order_relaxed);
+}
+
+uint32_t alimerImageDecodeBatch(const void** buffers, const size_t* sizes, uint32_t count, Image** outImages, uint32_t threadCount)
+{
+    if (!buffers || !sizes || !outImages || count == 0)
+        return 0;
+
+    uint32_t* order = ALIMER_ALLOCN(uint32_t, count);
+    if (!order)
+        return 0;
+
+    for (uint32_t i = 0; i < count; ++i)
+        order[i] = i;
+
+    std::sort(order, order + count, [sizes](uint32_t a, uint32_t b) { return sizes[a] > sizes[b]; });
+
+    DecodeBatchJob job;
+    job.buffers = buffers;
+    job.sizes = sizes;
+    job.outImages = outImages;
+    job.order = order;
+    job.count = count;
+    job.next.store(0, std::memory_order_relaxed);
+    job.decoded.store(0, std::memory_order_relaxed);
+
+    // Each lane keeps pulling the next image until the list is exhausted, the lane count caps the concurrency.
+    uint32_t laneCount = alimerGetThreadCount();
+    if (threadCount > 0 && threadCount < laneCount)
+        laneCount = threadCount;
+    if (count < laneCount)
+        laneCount = count;
+
+    alimerParallelFor(laneCount, DecodeBatchLane, &job);
+
+    alimerFree(order);
+    return job.decoded.load(std::memory_order_relaxed);
+}
+
+bool alimerImageGetInfoFromMemory(const void* pData, size_t dataSize, ImageInfo* info)
+{
+    if (pData == nullptr || dataSize == 0 || info == nullptr)
+        return false;
+
+    const uint8_t* data = (const uint8_t*)pData;
+    memset(info, 0, sizeof(ImageInfo));
+    info->fileType = DetectFileType(data, dataSize);
+    info->dimension = ImageDimension_2D;
+    info->depthOrArrayLayers = 1;
+    info->mipLevelCount = 1;
+
+    switch (info->fileType)
+    {
+        case ImageFileType_QOI:
+            return QOI_GetInfo(data, dataSize, info);
+        case ImageFileType_EXR:
+            return EXR_GetInfo(data, dataSize, info);
+        case ImageFileType_DDS:
+            return DDS_GetInfo(data, dataSize, info);
+        case ImageFileType_KTX2:
+            return KTX2_GetInfo(data, dataSize, info);
+        case ImageFileType_BMP:
+        case ImageFileType_PNG:
+        case ImageFileType_JPG:
+        case ImageFileType_TGA:
+        case ImageFileType_GIF:
+        case ImageFileType_HDR:
+            return STB_GetInfo(data, dataSize, info);
+        default:
+            return false;
+    }
+}
+
+// Streaming: decoded rows are handed out in bands of a fixed height, the decoders keep a few rows of state at most.
+#define ALIMER_DEFAULT_BAND_HEIGHT 64
+
+struct ImageStream
+{
+    ImageInfo info;
+    ImageStreamCallback callback;
+    void* userData;
+    uint32_t bandHeight;
+    size_t rowPitch;
+    uint8_t* band;
+    uint32_t bandY;
+    uint32_t bandRows;
+    bool stopped;
+};
+
+static size_t GetRowPitch(PixelFormat format, uint32_t width)
+{
+    const PixelFormatInfo& info = kFormatDesc[(uint32_t)format];
+    return (size_t)((width + info.blockWidth - 1) / info.blockWidth) * info.bytesPerBlock;
+}
+
+static bool StreamEmit(ImageStream* stream, uint32_t y, uint32_t rowCount, size_t rowPitch, const uint8_t* pixels)
+{
+    ImageStreamBand band;
+    band.y = y;
+    band.rowCount = rowCount;
+    band.rowPitch = rowPitch;
+    band.pixels = pixels;
+    if (!stream->callback(&stream->info, &band, stream->userData))
+        stream->stopped = true;
+
+    return !stream->stopped;
+}
+
+// Set up the band buffer for decoders that produce one row at a time.
+static bool StreamBeginRows(ImageStream* stream)
+{
+    stream->rowPitch = GetRowPitch(stream->info.format, stream->info.width);
+    stream->band = (uint8_t*)alimerMalloc(stream->rowPitch * stream->bandHeight);
+    stream->bandY = 0;
+    stream->bandRows = 0;
+    return stream->band != nullptr;
+}
+
+static uint8_t* StreamNextRow(ImageStream* stream)
+{
+    return stream->band + stream->bandRows * stream->rowPitch;
+}
+
+static bool StreamCommitRow(ImageStream* stream)
+{
+    if (++stream->bandRows < stream->bandHeight)
+        return true;
+
+    const bool result = StreamEmit(stream, stream->bandY, stream->bandRows, stream->rowPitch, stream->band);
+    stream->bandY += stream->bandRows;
+    stream->bandRows = 0;
+    return result;
+}
+
+static bool StreamEndRows(ImageStream* stream)
+{
+    bool result = true;
+    if (stream->bandRows > 0)
+        result = StreamEmit(stream, stream->bandY, stream->bandRows, stream->rowPitch, stream->band);
+
+    alimerFree(stream->band);
+    stream->band = nullptr;
+    return result && stream->bandY + stream->bandRows == stream->info.height;
+}
+
+// Rows of an image that is already in memory (decoded, or a DDS payload), bands point straight at the data.
+static bool StreamLevel(ImageStream* stream, const uint8_t* pixels, size_t rowPitch)
+{
+    const PixelFormatInfo& formatInfo = kFormatDesc[(uint32_t)stream->info.format];
+    const uint32_t blockHeight = formatInfo.blockHeight;
+    const uint32_t bandHeight = ((stream->bandHeight + blockHeight - 1) / blockHeight) * blockHeight;
+    for (uint32_t y = 0; y < stream->info.height; y += bandHeight)
+    {
+        const uint32_t rowCount = stream->info.height - y < bandHeight ? stream->info.height - y : bandHeight;
+        if (!StreamEmit(stream, y, rowCount, rowPitch, pixels + (size_t)(y / blockHeight) * rowPitch))
+            return false;
+    }
+
+    return true;
+}
+
+static bool StreamDecodedImage(ImageStream* stream, const uint8_t* data, size_t size)
+{
+    Image* image = alimerImageCreateFromMemory(data, size);
+    if (!image)
+        return false;
+
+    stream->info.format = image->format;
+    stream->info.width = image->width;
+    stream->info.height = image->height;
+    const bool result = StreamLevel(stream, (const uint8_t*)image->pData, image->levels[0].rowPitch);
+    alimerImageDestroy(image);
+    return result;
+}
+
+static uint32_t ReadBE32(const uint8_t* data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static uint32_t ReadLE16(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8);
+}
+
+static uint32_t ReadLE32(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+struct PNGStream
+{
+    ImageStream* stream;
+    const uint8_t* data;
+    size_t size;
+    size_t chunkOffset;
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t bitDepth;
+    uint32_t colorType;
+    uint32_t filterStride;
+    size_t rowBytes;
+
+    uint8_t* prevRow;
+    uint8_t* row;
+    size_t rowFilled;
+    uint32_t y;
+
+    uint8_t palette[256 * 4];
+    bool hasTransparency;
+    uint16_t transparency[3];
+};
+
+// Feed the inflater with the IDAT chunks one after another.
+static size_t PNG_ReadData(void* userData, const uint8_t** data)
+{
+    PNGStream* png = (PNGStream*)userData;
+    while (png->chunkOffset + 12 <= png->size)
+    {
+        const uint32_t length = ReadBE32(png->data + png->chunkOffset);
+        const uint8_t* type = png->data + png->chunkOffset + 4;
+        const size_t dataOffset = png->chunkOffset + 8;
+        if (length > png->size - dataOffset - 4)
+            return 0;
+
+        png->chunkOffset = dataOffset + length + 4;
+        if (memcmp(type, "IDAT", 4) == 0 && length > 0)
+        {
+            *data = png->data + dataOffset;
+            return length;
+        }
+        if (memcmp(type, "IEND", 4) == 0)
+            return 0;
+    }
+
+    return 0;
+}
+
+static uint8_t PaethPredictor(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = abs(p - a);
+    const int pb = abs(p - b);
+    const int pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return (uint8_t)a;
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+static bool PNG_Unfilter(PNGStream* png)
+{
+    const uint32_t filter = png->row[0];
+    uint8_t* cur = png->row + 1;
+    const uint8_t* prev = png->prevRow + 1;
+    const size_t stride = png->filterStride;
+    switch (filter)
+    {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = stride; i < png->rowBytes; ++i)
+                cur[i] = (uint8_t)(cur[i] + cur[i - stride]);
+            break;
+        case 2:
+            for (size_t i = 0; i < png->rowBytes; ++i)
+                cur[i] = (uint8_t)(cur[i] + prev[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < stride; ++i)
+                cur[i] = (uint8_t)(cur[i] + (prev[i] >> 1));
+            for (size_t i = stride; i < png->rowBytes; ++i)
+                cur[i] = (uint8_t)(cur[i] + ((cur[i - stride] + prev[i]) >> 1));
+            break;
+        case 4:
+            for (size_t i = 0; i < stride; ++i)
+                cur[i] = (uint8_t)(cur[i] + prev[i]);
+            for (size_t i = stride; i < png->rowBytes; ++i)
+                cur[i] = (uint8_t)(cur[i] + PaethPredictor(cur[i - stride], prev[i], prev[i - stride]));
+            break;
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+static uint32_t PNG_GetSample(const uint8_t* row, uint32_t index, uint32_t bitDepth)
+{
+    switch (bitDepth)
+    {
+        case 1: return (row[index >> 3] >> (7 - (index & 7))) & 0x1;
+        case 2: return (row[index >> 2] >> (6 - 2 * (index & 3))) & 0x3;
+        case 4: return (row[index >> 1] >> (4 - 4 * (index & 1))) & 0xF;
+        case 8: return row[index];
+        default: return ((uint32_t)row[index * 2] << 8) | row[index * 2 + 1];
+    }
+}
+
+// Expand a row to the format the full decoder produces (R8/R16 for gray, RGBA8/RGBA16 otherwise).
+static void PNG_ConvertRow(const PNGStream* png, const uint8_t* src, uint8_t* dst)
+{
+    static const uint32_t kGrayScale[9] = { 0, 0xFF, 0x55, 0, 0x11, 0, 0, 0, 1 };
+    const uint32_t width = png->width;
+
+    if (png->colorType == 3)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+            memcpy(dst + x * 4, png->palette + PNG_GetSample(src, x, png->bitDepth) * 4, 4);
+        return;
+    }
+
+    const uint32_t channels = png->colorType == 0 ? 1 : png->colorType == 2 ? 3 : png->colorType == 4 ? 2 : 4;
+    const uint32_t maxValue = png->bitDepth == 16 ? 0xFFFF : 0xFF;
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        uint32_t values[4] = { 0, 0, 0, maxValue };
+        for (uint32_t c = 0; c < channels; ++c)
+            values[c] = PNG_GetSample(src, x * channels + c, png->bitDepth);
+
+        if (png->colorType == 0 && png->bitDepth < 8)
+            values[0] *= kGrayScale[png->bitDepth];
+
+        if (png->colorType == 0)
+        {
+            if (png->bitDepth == 16)
+                memcpy(dst + x * 2, &values[0], 2);
+            else
+                dst[x] = (uint8_t)values[0];
+            continue;
+        }
+
+        if (png->colorType == 2 && png->hasTransparency &&
+            values[0] == png->transparency[0] && values[1] == png->transparency[1] && values[2] == png->transparency[2])
+        {
+            values[3] = 0;
+        }
+        else if (png->colorType == 4)
+        {
+            values[3] = values[1];
+            values[1] = values[2] = values[0];
+        }
+
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            if (png->bitDepth == 16)
+            {
+                const uint16_t value = (uint16_t)values[c];
+                memcpy(dst + (x * 4 + c) * 2, &value, 2);
+            }
+            else
+            {
+                dst[x * 4 + c] = (uint8_t)values[c];
+            }
+        }
+    }
+}
+
+static bool PNG_WriteData(void* userData, const uint8_t* data, size_t size)
+{
+    PNGStream* png = (PNGStream*)userData;
+    while (size > 0 && png->y < png->height)
+    {
+        const size_t count = (1 + png->rowBytes - png->rowFilled) < size ? (1 + png->rowBytes - png->rowFilled) : size;
+        memcpy(png->row + png->rowFilled, data, count);
+        png->rowFilled += count;
+        data += count;
+        size -= count;
+
+        if (png->rowFilled < 1 + png->rowBytes)
+            break;
+
+        if (!PNG_Unfilter(png))
+            return false;
+
+        PNG_ConvertRow(png, png->row + 1, StreamNextRow(png->stream));
+        if (!StreamCommitRow(png->stream))
+            return false;
+
+        uint8_t* prevRow = png->prevRow;
+        png->prevRow = png->row;
+        png->row = prevRow;
+        png->rowFilled = 0;
+        png->y++;
+    }
+
+    return true;
+}
+
+static bool PNG_Stream(ImageStream* stream, const uint8_t* data, size_t size)
+{
+    static const uint8_t kPngMagic[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    if (size < 8 + 25 || memcmp(data, kPngMagic, 8) != 0 || memcmp(data + 12, "IHDR", 4) != 0)
+        return false;
+
+    PNGStream png = {};
+    png.stream = stream;
+    png.data = data;
+    png.size = size;
+    png.width = ReadBE32(data + 16);
+    png.height = ReadBE32(data + 20);
+    png.bitDepth = data[24];
+    png.colorType = data[25];
+
+    // Adam7 needs the whole image before any row is complete.
+    const uint32_t interlace = data[28];
+    if (interlace != 0)
+        return StreamDecodedImage(stream, data, size);
+
+    uint32_t channels;
+    switch (png.colorType)
+    {
+        case 0: channels = 1; break;
+        case 2: channels = 3; break;
+        case 3: channels = 1; break;
+        case 4: channels = 2; break;
+        case 6: channels = 4; break;
+        default: return false;
+    }
+
+    if (png.width == 0 || png.height == 0 || (png.bitDepth != 1 && png.bitDepth != 2 && png.bitDepth != 4 && png.bitDepth != 8 && png.bitDepth != 16))
+        return false;
+
+    // Palette and transparency come before the first IDAT.
+    for (uint32_t i = 0; i < 256; ++i)
+        png.palette[i * 4 + 3] = 0xFF;
+
+    bool hasPaletteAlpha = false;
+    png.chunkOffset = 8;
+    while (png.chunkOffset + 12 <= size)
+    {
+        const uint32_t length = ReadBE32(data + png.chunkOffset);
+        const uint8_t* type = data + png.chunkOffset + 4;
+        const uint8_t* chunk = data + png.chunkOffset + 8;
+        if (length > size - png.chunkOffset - 12 || memcmp(type, "IDAT", 4) == 0)
+            break;
+
+        if (memcmp(type, "PLTE", 4) == 0)
+        {
+            for (uint32_t i = 0; i < length / 3 && i < 256; ++i)
+                memcpy(png.palette + i * 4, chunk + i * 3, 3);
+        }
+        else if (memcmp(type, "tRNS", 4) == 0)
+        {
+            if (png.colorType == 3)
+            {
+                hasPaletteAlpha = true;
+                for (uint32_t i = 0; i < length && i < 256; ++i)
+                    png.palette[i * 4 + 3] = chunk[i];
+            }
+            else if (png.colorType == 2 && length >= 6)
+            {
+                png.hasTransparency = true;
+                for (uint32_t c = 0; c < 3; ++c)
+                    png.transparency[c] = (uint16_t)((chunk[c * 2] << 8) | chunk[c * 2 + 1]);
+            }
+        }
+        png.chunkOffset += 12 + length;
+    }
+
+    stream->info.width = png.width;
+    stream->info.height = png.height;
+    stream->info.channels = png.colorType == 3 ? (hasPaletteAlpha ? 4 : 3) : channels;
+    if (png.colorType == 0)
+        stream->info.format = png.bitDepth == 16 ? PixelFormat_R16Unorm : PixelFormat_R8Unorm;
+    else
+        stream->info.format = png.bitDepth == 16 ? PixelFormat_RGBA16Unorm : PixelFormat_RGBA8Unorm;
+
+    const uint32_t bitsPerPixel = channels * png.bitDepth;
+    png.filterStride = bitsPerPixel >= 8 ? bitsPerPixel / 8 : 1;
+    png.rowBytes = ((size_t)png.width * bitsPerPixel + 7) / 8;
+
+    // Two filter rows (the first "previous" row is all zeros) plus the band.
+    uint8_t* rows = (uint8_t*)alimerCalloc(2, png.rowBytes + 1);
+    if (!rows || !StreamBeginRows(stream))
+    {
+        alimerFree(rows);
+        return false;
+    }
+    png.prevRow = rows;
+    png.row = rows + png.rowBytes + 1;
+
+    png.chunkOffset = 8;
+    bool result = alimerInflate(PNG_ReadData, PNG_WriteData, &png, true);
+    result = StreamEndRows(stream) && result;
+    alimerFree(rows);
+    return result;
+}
+
+static bool BMP_Stream(ImageStream* stream, const uint8_t* data, size_t size)
+{
+    if (size < 54)
+        return false;
+
+    const uint32_t pixelOffset = ReadLE32(data + 10);
+    const uint32_t headerSize = ReadLE32(data + 14);
+    const int32_t width = (int32_t)ReadLE32(data + 18);
+    const int32_t height = (int32_t)ReadLE32(data + 22);
+    const uint32_t bitCount = ReadLE16(data + 28);
+    const uint32_t compression = ReadLE32(data + 30);
+    if (headerSize < 40 || width <= 0 || height == 0 || height == INT_MIN)
+        return StreamDecodedImage(stream, data, size);
+
+    // BI_RGB with 8, 24 or 32 bits and BI_BITFIELDS with the standard 32-bit masks, anything else goes through stb_image.
+    bool supported = (compression == 0 && (bitCount == 8 || bitCount == 24 || bitCount == 32));
+    if (compression == 3 && bitCount == 32 && size >= 14 + 52 &&
+        ReadLE32(data + 54) == 0x00FF0000 && ReadLE32(data + 58) == 0x0000FF00 && ReadLE32(data + 62) == 0x000000FF)
+    {
+        supported = true;
+    }
+    if (!supported)
+        return StreamDecodedImage(stream, data, size);
+
+    const bool topDown = height < 0;
+    const uint32_t rows = (uint32_t)(topDown ? -height : height);
+    const size_t srcPitch = (((size_t)width * bitCount + 31) / 32) * 4;
+    if (pixelOffset > size || rows > (size - pixelOffset) / srcPitch)
+        return false;
+
+    uint32_t paletteCount = 0;
+    if (bitCount == 8)
+    {
+        paletteCount = ReadLE32(data + 46);
+        if (paletteCount == 0 || paletteCount > 256)
+            paletteCount = 256;
+        if ((size_t)14 + headerSize + (size_t)paletteCount * 4 > pixelOffset)
+            return false;
+    }
+    const uint8_t* palette = bitCount == 8 ? data + 14 + headerSize : nullptr;
+
+    // Like stb_image, a 32-bit image whose alpha is all zero is opaque. Looking at the mapped rows costs no memory.
+    bool useAlpha = false;
+    if (bitCount == 32)
+    {
+        for (uint32_t y = 0; y < rows && !useAlpha; ++y)
+        {
+            const uint8_t* src = data + pixelOffset + y * srcPitch;
+            for (int32_t x = 0; x < width; ++x)
+            {
+                if (src[x * 4 + 3] != 0)
+                {
+                    useAlpha = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    stream->info.width = (uint32_t)width;
+    stream->info.height = rows;
+    stream->info.channels = bitCount == 32 && useAlpha ? 4 : 3;
+    stream->info.format = PixelFormat_RGBA8Unorm;
+    if (!StreamBeginRows(stream))
+        return false;
+
+    bool result = true;
+    for (uint32_t y = 0; y < rows && result; ++y)
+    {
+        const uint8_t* src = data + pixelOffset + (topDown ? y : rows - 1 - y) * srcPitch;
+        uint8_t* dst = StreamNextRow(stream);
+        for (int32_t x = 0; x < width; ++x, dst += 4)
+        {
+            // Indices past a short palette read its first entry, as for TGA color maps.
+            const uint8_t* bgra = bitCount == 8 ? palette + (src[x] < paletteCount ? src[x] : 0) * 4 : src + x * (bitCount / 8);
+            dst[0] = bgra[2];
+            dst[1] = bgra[1];
+            dst[2] = bgra[0];
+            dst[3] = bitCount == 32 && useAlpha ? bgra[3] : 0xFF;
+        }
+        result = StreamCommitRow(stream);
+    }
+
+    return StreamEndRows(stream) && result;
+}
+
+// RLE packet position, packets can cross rows so a row starts from the state the previous one left.
+struct TGARleState
+{
+    size_t offset;
+    uint32_t left;
+    bool run;
+};
+
+static const uint8_t* TGA_NextRlePixel(TGARleState* state, const uint8_t* data, size_t size, uint32_t pixelSize)
+{
+    if (state->left == 0)
+    {
+        if (state->offset >= size)
+            return nullptr;
+
+        const uint8_t header = data[state->offset++];
+        state->left = (header & 0x7F) + 1;
+        state->run = (header & 0x80) != 0;
+    }
+
+    if (state->offset + pixelSize > size)
+        return nullptr;
+
+    // A run repeats one value, its offset moves on once the packet is done.
+    const uint8_t* pixel = data + state->offset;
+    if (!state->run || state->left == 1)
+        state->offset += pixelSize;
+    state->left--;
+    return pixel;
+}
+
+static bool TGA_Stream(ImageStream* stream, const uint8_t* data, size_t size)
+{
+    if (size < 18)
+        return false;
+
+    const uint32_t idLength = data[0];
+    const uint32_t colorMapType = data[1];
+    const uint32_t imageType = data[2];
+    const uint32_t colorMapFirst = ReadLE16(data + 3);
+    const uint32_t colorMapLength = ReadLE16(data + 5);
+    const uint32_t colorMapBits = data[7];
+    const uint32_t width = ReadLE16(data + 12);
+    const uint32_t height = ReadLE16(data + 14);
+    const uint32_t bitCount = data[16];
+    const bool topDown = (data[17] & 0x20) != 0;
+
+    // Color-mapped (8-bit indices into a 24/32-bit palette), true color (24/32-bit) and 8-bit gray, raw or RLE.
+    const bool rle = imageType >= 9;
+    const uint32_t baseType = rle ? imageType - 8 : imageType;
+    const bool supported =
+        (baseType == 1 && colorMapType == 1 && colorMapLength > 0 && bitCount == 8 && (colorMapBits == 24 || colorMapBits == 32)) ||
+        (baseType == 2 && (bitCount == 24 || bitCount == 32)) ||
+        (baseType == 3 && bitCount == 8);
+    if (!supported || (data[17] & 0x10) != 0)
+        return StreamDecodedImage(stream, data, size);
+
+    const size_t colorMapOffset = 18 + idLength;
+    const size_t colorMapSize = colorMapType == 1 ? (size_t)colorMapLength * ((colorMapBits + 7) / 8) : 0;
+    const size_t pixelOffset = colorMapOffset + colorMapSize;
+    const uint32_t pixelSize = bitCount / 8;
+    const size_t srcPitch = (size_t)width * pixelSize;
+    if (width == 0 || height == 0 || pixelOffset > size || (!rle && srcPitch * height > size - pixelOffset))
+        return false;
+
+    // Bottom-up RLE files store the top row last, one pass records where every row starts and checks the packets.
+    TGARleState state = { pixelOffset, 0, false };
+    TGARleState* rowStates = nullptr;
+    if (rle && !topDown)
+    {
+        rowStates = ALIMER_ALLOCN(TGARleState, height);
+        if (!rowStates)
+            return false;
+
+        for (uint32_t row = 0; row < height; ++row)
+        {
+            rowStates[row] = state;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                if (!TGA_NextRlePixel(&state, data, size, pixelSize))
+                {
+                    alimerFree(rowStates);
+                    return false;
+                }
+            }
+        }
+    }
+
+    stream->info.width = width;
+    stream->info.height = height;
+    stream->info.channels = baseType == 3 ? 1 : (baseType == 1 ? colorMapBits : bitCount) / 8;
+    stream->info.format = baseType == 3 ? PixelFormat_R8Unorm : PixelFormat_RGBA8Unorm;
+    if (!StreamBeginRows(stream))
+    {
+        alimerFree(rowStates);
+        return false;
+    }
+
+    const uint32_t colorMapStride = colorMapBits / 8;
+    bool result = true;
+    for (uint32_t y = 0; y < height && result; ++y)
+    {
+        const uint32_t row = topDown ? y : height - 1 - y;
+        const uint8_t* src = rle ? nullptr : data + pixelOffset + row * srcPitch;
+        if (rowStates)
+            state = rowStates[row];
+
+        uint8_t* dst = StreamNextRow(stream);
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint8_t* pixel = rle ? TGA_NextRlePixel(&state, data, size, pixelSize) : src + x * pixelSize;
+            if (!pixel)
+            {
+                result = false;
+                break;
+            }
+
+            if (baseType == 3)
+            {
+                dst[x] = pixel[0];
+                continue;
+            }
+
+            const uint8_t* bgra = pixel;
+            uint32_t stride = pixelSize;
+            if (baseType == 1)
+            {
+                const uint32_t index = pixel[0] >= colorMapFirst ? pixel[0] - colorMapFirst : 0;
+                bgra = data + colorMapOffset + (index < colorMapLength ? index : 0) * colorMapStride;
+                stride = colorMapStride;
+            }
+            dst[x * 4 + 0] = bgra[2];
+            dst[x * 4 + 1] = bgra[1];
+            dst[x * 4 + 2] = bgra[0];
+            dst[x * 4 + 3] = stride == 4 ? bgra[3] : 0xFF;
+        }
+        result = result && StreamCommitRow(stream);
+    }
+
+    alimerFree(rowStates);
+    return StreamEndRows(stream) && result;
+}
+
+static bool DDS_Stream(ImageStream* stream, const uint8_t* data, size_t size)
+{
+    ImageDesc desc;
+    size_t dataOffset;
+    uint32_t mipLevelCount;
+    if (!DDS_ParseHeader(data, size, &desc, &dataOffset) || !ValidateImageDesc(&desc, &mipLevelCount))
+        return false;
+
+    // First layer, top mip level, straight from the payload.
+    ImageLevel top;
+    size_t levelSize = 0;
+    const uint32_t depth = desc.dimension == ImageDimension_3D ? desc.depthOrArrayLayers : 1;
+    if (!SetupLevelLayout(&top, desc.format, desc.width, desc.height, depth, 1, &levelSize) || levelSize > size - dataOffset)
+        return false;
+
+    stream->info.dimension = desc.dimension;
+    stream->info.format = desc.format;
+    stream->info.width = desc.width;
+    stream->info.height = desc.height;
+    stream->info.depthOrArrayLayers = desc.depthOrArrayLayers;
+    stream->info.mipLevelCount = desc.mipLevelCount;
+    return StreamLevel(stream, data + dataOffset, top.rowPitch);
+}
+
+static bool KTX2_Stream(ImageStream* stream, const uint8_t* data, size_t size)
+{
+    ImageDesc desc;
+    const uint8_t* levels;
+    if (!KTX2_ParseHeader(data, size, &desc, &levels) || !KTX2_ValidateLevels(desc, levels, 1, size))
+        return false;
+
+    // First layer of the top level, which comes first in its level data.
+    KTX2_LEVEL level;
+    memcpy(&level, levels, sizeof(KTX2_LEVEL));
+    const size_t rowPitch = GetRowPitch(desc.format, desc.width);
+
+    stream->info.dimension = desc.dimension;
+    stream->info.format = desc.format;
+    stream->info.width = desc.width;
+    stream->info.height = desc.height;
+    stream->info.depthOrArrayLayers = desc.depthOrArrayLayers;
+    stream->info.mipLevelCount = desc.mipLevelCount;
+    return StreamLevel(stream, data + level.byteOffset, rowPitch);
+}
+
+// Scanline EXR, one chunk (up to 32 lines) is decompressed at a time and converted to RGBA16Float or RGBA32Float rows.
+// Tiled EXR, one row of tiles at a time is decoded on worker threads into a buffer as tall as the tiles and handed out in bands.
+static bool EXR_StreamTiles(ImageStream* stream, EXRHeader* header, const uint8_t* data, size_t size)
+{
+    EXRDecodeJob job;
+    job.header = header;
+    job.data = data;
+    job.size = size;
+    job.offsetTable = (size_t)header->header_len + 8;
+    job.linesPerChunk = 0;
+    job.failed = false;
+
+    std::vector<size_t> channelOffsets;
+    size_t channelOffset = 0;
+    const PixelFormat format = EXR_SelectChannels(*header, nullptr, job.channelIndex);
+    const uint32_t width = (uint32_t)(header->data_window.max_x - header->data_window.min_x + 1);
+    const uint32_t height = (uint32_t)(header->data_window.max_y - header->data_window.min_y + 1);
+    if (format == PixelFormat_Undefined || header->tile_size_x <= 0 || header->tile_size_y <= 0 ||
+        !tinyexr::ComputeChannelLayout(&channelOffsets, &job.pixelDataSize, &channelOffset, header->num_channels, header->channels))
+    {
+        return false;
+    }
+
+    job.tilesX = (width + header->tile_size_x - 1) / header->tile_size_x;
+    job.tilesY = (height + header->tile_size_y - 1) / header->tile_size_y;
+    if (job.offsetTable + (size_t)job.tilesX * job.tilesY * 8 > size)
+        return false;
+
+    EXR_SetRequestedTypes(header, format);
+    job.channelOffsets = &channelOffsets;
+    stream->info.format = format;
+    stream->info.width = width;
+    stream->info.height = height;
+    stream->info.channels = (uint32_t)header->num_channels;
+
+    // The level keeps the image size for the tile clipping, its pixels only hold the current row of tiles.
+    const uint32_t tileRows = std::min((uint32_t)header->tile_size_y, height);
+    ImageLevel tiles = {};
+    tiles.width = width;
+    tiles.height = height;
+    tiles.depth = 1;
+    tiles.format = format;
+    tiles.rowPitch = GetRowPitch(format, width);
+    tiles.rowCount = tileRows;
+    tiles.pixels = (uint8_t*)alimerMalloc(tiles.rowPitch * tileRows);
+    job.level = &tiles;
+
+    bool result = tiles.pixels && StreamBeginRows(stream);
+    for (uint32_t tileY = 0; result && tileY < job.tilesY; ++tileY)
+    {
+        job.bandY = tileY * tileRows;
+        job.bandHeight = std::min(tileRows, height - job.bandY);
+        job.firstChunk = tileY * job.tilesX;
+        if (job.tilesX == 1)
+            EXR_DecodeChunks(0, &job);
+        else
+            alimerParallelFor(job.tilesX, EXR_DecodeChunks, &job);
+
+        result = !job.failed;
+        for (uint32_t row = 0; result && row < job.bandHeight; ++row)
+        {
+            memcpy(StreamNextRow(stream), tiles.pixels + row * tiles.rowPitch, tiles.rowPitch);
+            result = StreamCommitRow(stream);
+        }
+    }
+
+    if (stream->band)
+        result = StreamEndRows(stream) && result;
+    alimerFree(tiles.pixels);
+    return result;
+}
+
+static bool EXR_Stream(ImageStream* stream, const uint8_t* data, size_t size)
+{
+    EXRVersion version;
+    if (ParseEXRVersionFromMemory(&version, data, size) != TINYEXR_SUCCESS || version.multipart || version.non_image)
+        return false;
+
+    EXRHeader header;
+    if (!EXR_ParseHeader(data, size, &header))
+        return false;
+
+    if (header.tiled)
+    {
+        const bool result = EXR_StreamTiles(stream, &header, data, size);
+        FreeEXRHeader(&header);
+        return result;
+    }
+
+    const int linesPerChunk = EXR_GetLinesPerChunk(header);
+    std::vector<size_t> channelOffsets;
+    int pixelDataSize = 0;
+    size_t channelOffset = 0;
+    int channelIndex[4];
+    const PixelFormat format = EXR_SelectChannels(header, nullptr, channelIndex);
+    if (format == PixelFormat_Undefined ||
+        !tinyexr::ComputeChannelLayout(&channelOffsets, &pixelDataSize, &channelOffset, header.num_channels, header.channels))
+    {
+        FreeEXRHeader(&header);
+        return false;
+    }
+
+    const uint32_t width = (uint32_t)(header.data_window.max_x - header.data_window.min_x + 1);
+    const uint32_t height = (uint32_t)(header.data_window.max_y - header.data_window.min_y + 1);
+    const uint32_t chunkCount = (height + linesPerChunk - 1) / linesPerChunk;
+    const size_t offsetTable = (size_t)header.header_len + 8;
+    if (offsetTable + (size_t)chunkCount * 8 > size)
+    {
+        FreeEXRHeader(&header);
+        return false;
+    }
+
+    EXR_SetRequestedTypes(&header, format);
+    stream->info.format = format;
+    stream->info.width = width;
+    stream->info.height = height;
+    stream->info.channels = (uint32_t)header.num_channels;
+
+    // Planar output of one chunk, 4 bytes per sample whatever the channel type.
+    const size_t planeSize = (size_t)width * linesPerChunk;
+    uint8_t* planes = (uint8_t*)alimerMalloc(planeSize * 4 * header.num_channels);
+    unsigned char** images = ALIMER_ALLOCN(unsigned char*, header.num_channels);
+    bool result = planes && images && StreamBeginRows(stream);
+    for (int c = 0; result && c < header.num_channels; ++c)
+        images[c] = planes + planeSize * 4 * c;
+
+    for (uint32_t chunk = 0; chunk < chunkCount && result; ++chunk)
+    {
+        uint64_t offset;
+        memcpy(&offset, data + offsetTable + chunk * 8, 8);
+        tinyexr::swap8((tinyexr::tinyexr_uint64*)&offset);
+        if (offset < offsetTable || offset + 8 > size)
+        {
+            result = false;
+            break;
+        }
+
+        int lineNo;
+        int dataLength;
+        memcpy(&lineNo, data + offset, 4);
+        memcpy(&dataLength, data + offset + 4, 4);
+        tinyexr::swap4(&lineNo);
+        tinyexr::swap4(&dataLength);
+
+        const uint32_t y = chunk * linesPerChunk;
+        const int lineCount = (int)(height - y < (uint32_t)linesPerChunk ? height - y : (uint32_t)linesPerChunk);
+        if ((int64_t)lineNo - header.data_window.min_y != (int64_t)y || dataLength <= 0 || (uint64_t)dataLength > size - offset - 8)
+        {
+            result = false;
+            break;
+        }
+
+        // Increasing line order and line 0 of the plane buffers, every chunk lands at the top of the planes.
+        if (!tinyexr::DecodePixelData(images, header.requested_pixel_types, data + offset + 8, (size_t)dataLength,
+            header.compression_type, 0, (int)width, lineCount, (int)width, 0, 0, lineCount, (size_t)pixelDataSize,
+            (size_t)header.num_custom_attributes, header.custom_attributes, (size_t)header.num_channels, header.channels, channelOffsets))
+        {
+            result = false;
+            break;
+        }
+
+        for (int line = 0; line < lineCount && result; ++line)
+        {
+            EXR_InterleaveRow(header, channelIndex, format, images, (size_t)line * width, (int)width, StreamNextRow(stream));
+            result = StreamCommitRow(stream);
+        }
+    }
+
+    if (stream->band)
+        result = StreamEndRows(stream) && result;
+    alimerFree(images);
+    alimerFree(planes);
+    FreeEXRHeader(&header);
+    return result;
+}
+
+bool alimerImageStreamFromMemory(const void* pData, size_t dataSize, uint32_t bandHeight, ImageStreamCallback callback, void* userData)
+{
+    if (pData == nullptr || dataSize == 0 || callback == nullptr)
+        return false;
+
+    MemoryCategoryScope category(MemoryCategory_ImageDecode);
+    const uint8_t* data = (const uint8_t*)pData;
+    ImageStream stream = {};
+    stream.info.fileType = DetectFileType(data, dataSize);
+    stream.info.dimension = ImageDimension_2D;
+    stream.info.depthOrArrayLayers = 1;
+    stream.info.mipLevelCount = 1;
+    stream.callback = callback;
+    stream.userData = userData;
+    stream.bandHeight = bandHeight > 0 ? bandHeight : ALIMER_DEFAULT_BAND_HEIGHT;
+
+    switch (stream.info.fileType)
+    {
+        case ImageFileType_PNG:
+            return PNG_Stream(&stream, data, dataSize);
+        case ImageFileType_BMP:
+            return BMP_Stream(&stream, data, dataSize);
+        case ImageFileType_TGA:
+            return TGA_Stream(&stream, data, dataSize);
+        case ImageFileType_DDS:
+            return DDS_Stream(&stream, data, dataSize);
+        case ImageFileType_KTX2:
+            return KTX2_Stream(&stream, data, dataSize);
+        case ImageFileType_EXR:
+            return EXR_Stream(&stream, data, dataSize);
+        case ImageFileType_JPG:
+        case ImageFileType_GIF:
+        case ImageFileType_HDR:
+        case ImageFileType_QOI:
+            return StreamDecodedImage(&stream, data, dataSize);
+        default:
+            return false;
+    }
+}
+
+bool alimerImageStreamFromFile(const char* path, uint32_t bandHeight, ImageStreamCallback callback, void* userData)
+{
+    if (path == nullptr)
+        return false;
+
+    MappedFile mapping;
+    if (!alimerMapFile(path, &mapping))
+        return false;
+
+    const bool result = alimerImageStreamFromMemory(mapping.data, mapping.size, bandHeight, callback, userData);
+    alimerUnmapFile(&mapping);
+    return result;
+}
+
+// Box filter 2^n x 2^n source blocks into one output row at a time.
+struct ReducedStream
+{
+    uint32_t mipLevel;
+    // Output size, 0 for the source size >> mipLevel.
+    uint32_t width;
+    uint32_t height;
+    Image* image;
+    float* sums;
+    uint32_t channels;
+    uint32_t rowsInSum;
+    uint32_t outY;
+};
+
+static bool ReduceGetLayout(PixelFormat format, uint32_t* channels)
+{
+    switch (format)
+    {
+        case PixelFormat_R8Unorm:
+        case PixelFormat_R16Unorm:
+            *channels = 1;
+            return true;
+        case PixelFormat_RGBA8Unorm:
+        case PixelFormat_RGBA16Unorm:
+        case PixelFormat_RGBA16Float:
+        case PixelFormat_RGBA32Float:
+            *channels = 4;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static float ReduceLoad(PixelFormat format, const uint8_t* row, size_t index)
+{
+    switch (format)
+    {
+        case PixelFormat_R8Unorm:
+        case PixelFormat_RGBA8Unorm:
+            return row[index];
+        case PixelFormat_R16Unorm:
+        case PixelFormat_RGBA16Unorm:
+            return ((const uint16_t*)row)[index];
+        case PixelFormat_RGBA16Float:
+        {
+            tinyexr::FP16 half;
+            half.u = ((const uint16_t*)row)[index];
+            return tinyexr::half_to_float(half).f;
+        }
+        default:
+            return ((const float*)row)[index];
+    }
+}
+
+static void ReduceStore(PixelFormat format, uint8_t* row, size_t index, float value)
+{
+    switch (format)
+    {
+        case PixelFormat_R8Unorm:
+        case PixelFormat_RGBA8Unorm:
+            row[index] = (uint8_t)(value + 0.5f);
+            break;
+        case PixelFormat_R16Unorm:
+        case PixelFormat_RGBA16Unorm:
+            ((uint16_t*)row)[index] = (uint16_t)(value + 0.5f);
+            break;
+        case PixelFormat_RGBA16Float:
+        {
+            tinyexr::FP32 single;
+            single.f = value;
+            ((uint16_t*)row)[index] = tinyexr::float_to_half_full(single).u;
+            break;
+        }
+        default:
+            ((float*)row)[index] = value;
+            break;
+    }
+}
+
+static void ReduceFlushRow(ReducedStream* reduced, uint32_t sourceWidth)
+{
+    Image* image = reduced->image;
+    const ImageLevel* level = &image->levels[0];
+    uint8_t* dst = level->pixels + (size_t)reduced->outY * level->rowPitch;
+    const uint32_t factor = 1u << reduced->mipLevel;
+    for (uint32_t x = 0; x < level->width; ++x)
+    {
+        const uint32_t columns = x + 1 == level->width ? sourceWidth - x * factor : factor;
+        const float scale = 1.0f / (float)(columns * reduced->rowsInSum);
+        for (uint32_t c = 0; c < reduced->channels; ++c)
+        {
+            const size_t index = (size_t)x * reduced->channels + c;
+            ReduceStore(image->format, dst, index, reduced->sums[index] * scale);
+            reduced->sums[index] = 0.0f;
+        }
+    }
+
+    reduced->rowsInSum = 0;
+    reduced->outY++;
+}
+
+static bool ALIMER_CALL ReduceBand(const ImageInfo* info, const ImageStreamBand* band, void* userData)
+{
+    ReducedStream* reduced = (ReducedStream*)userData;
+    const uint32_t factor = 1u << reduced->mipLevel;
+    if (!reduced->image)
+    {
+        ImageDesc desc = {};
+        desc.dimension = ImageDimension_2D;
+        desc.format = info->format;
+        desc.width = (info->width >> reduced->mipLevel) > 0 ? info->width >> reduced->mipLevel : 1;
+        desc.height = (info->height >> reduced->mipLevel) > 0 ? info->height >> reduced->mipLevel : 1;
+        if (reduced->width > 0)
+        {
+            desc.width = reduced->width;
+            desc.height = reduced->height;
+        }
+        desc.depthOrArrayLayers = 1;
+        desc.mipLevelCount = 1;
+        desc.rowPitchAlignment = 1;
+        if (!ReduceGetLayout(info->format, &reduced->channels))
+            return false;
+
+        reduced->image = alimerImageCreate(&desc);
+        reduced->sums = ALIMER_ALLOCN(float, (size_t)desc.width * reduced->channels);
+        if (!reduced->image || !reduced->sums)
+            return false;
+    }
+
+    const uint32_t outWidth = reduced->image->width;
+    const uint32_t outHeight = reduced->image->height;
+    for (uint32_t row = 0; row < band->rowCount; ++row)
+    {
+        // Odd sizes fold the trailing source rows and columns into the last output texel.
+        const uint8_t* src = band->pixels + row * band->rowPitch;
+        for (uint32_t x = 0; x < info->width; ++x)
+        {
+            const uint32_t outX = x / factor < outWidth ? x / factor : outWidth - 1;
+            for (uint32_t c = 0; c < reduced->channels; ++c)
+                reduced->sums[(size_t)outX * reduced->channels + c] += ReduceLoad(info->format, src, (size_t)x * reduced->channels + c);
+        }
+
+        reduced->rowsInSum++;
+        const uint32_t y = band->y + row + 1;
+        if ((reduced->rowsInSum == factor && reduced->outY + 1 < outHeight) || y == info->height)
+            ReduceFlushRow(reduced, info->width);
+    }
+
+    return true;
+}
+
+// JPEG reduces by up to 8 in the IDCT (libjpeg style DCT scaling), so the entropy decoded blocks never become
+// full resolution pixels and color conversion runs on the small image. The box filter takes the rest of the factor.
+static bool JPG_Reduce(ReducedStream* reduced, const uint8_t* data, size_t size)
+{
+    ImageInfo info = {};
+    if (!STB_GetInfo(data, size, &info))
+        return false;
+
+    // Padding in the partial edge blocks would show in tiny images, those are cheap to decode at full size anyway.
+    uint32_t shift = reduced->mipLevel < 3 ? reduced->mipLevel : 3;
+    while (shift > 0 && (info.width < (8u << shift) || info.height < (8u << shift)))
+        shift--;
+
+    reduced->width = (info.width >> reduced->mipLevel) > 0 ? info.width >> reduced->mipLevel : 1;
+    reduced->height = (info.height >> reduced->mipLevel) > 0 ? info.height >> reduced->mipLevel : 1;
+    reduced->mipLevel -= shift;
+
+    ScratchScope scratch;
+    int width, height, channels;
+    const uint32_t bytesPerPixel = info.channels == 1 ? 1 : 4;
+    stbi_uc* pixels = stbi_load_jpeg_scaled_from_memory(data, (int)size, &width, &height, &channels, (int)bytesPerPixel, (int)shift);
+    if (!pixels)
+        return false;
+
+    // stb decodes 4:2:2 and 4:4:0 files at full size, the box filter then takes the whole factor.
+    if (shift > 0 && (uint32_t)width == info.width)
+        reduced->mipLevel += shift;
+
+    // When the IDCT covers the whole factor only the partial edge blocks are left, those are cropped.
+    bool result = true;
+    const size_t srcRowPitch = (size_t)width * bytesPerPixel;
+    if (reduced->mipLevel == 0)
+    {
+        reduced->image = alimerImageCreate2D(info.format, reduced->width, reduced->height, 1, 1);
+        result = reduced->image != nullptr;
+        if (result)
+        {
+            const ImageLevel* level = &reduced->image->levels[0];
+            for (uint32_t y = 0; y < level->height; ++y)
+                memcpy(level->pixels + y * level->rowPitch, pixels + y * srcRowPitch, level->width * bytesPerPixel);
+        }
+    }
+    else
+    {
+        info.width = (uint32_t)width;
+        info.height = (uint32_t)height;
+        ImageStreamBand band = {};
+        band.rowCount = info.height;
+        band.rowPitch = srcRowPitch;
+        band.pixels = pixels;
+        result = ReduceBand(&info, &band, reduced);
+    }
+
+    stbi_image_free(pixels);
+    return result;
+}
+
+Image* alimerImageCreateFromMemoryReduced(const void* pData, size_t dataSize, uint32_t mipLevel)
+{
+    if (pData == nullptr || dataSize == 0 || mipLevel >= 32)
+        return nullptr;
+
+    MemoryCategoryScope category(MemoryCategory_ImageDecode);
+    const uint8_t* data = (const uint8_t*)pData;
+    ReducedStream reduced = {};
+    reduced.mipLevel = mipLevel;
+    bool result;
+    if (mipLevel > 0 && DetectFileType(data, dataSize) == ImageFileType_JPG)
+        result = JPG_Reduce(&reduced, data, dataSize);
+    else
+        result = alimerImageStreamFromMemory(data, dataSize, 0, ReduceBand, &reduced);
+
+    alimerFree(reduced.sums);
+    if (!result)
+    {
+        alimerImageDestroy(reduced.image);
+        return nullptr;
+    }
+
+    return reduced.image;
+}
+
+Image* alimerImageCreateFromFileReduced(const char* path, uint32_t mipLevel)
+{
+    if (path == nullptr)
+        return nullptr;
+
+    MappedFile mapping;
+    if (!alimerMapFile(path, &mapping))
+        return nullptr;
+
+    Image* image = alimerImageCreateFromMemoryReduced(mapping.data, mapping.size, mipLevel);
+    alimerUnmapFile(&mapping);
+    return image;
+}
+
+void alimerImageDestroy(Image* image)
+{
+    if (!image)
+        return;
+
+    FreeImageData(image);
+    alimerFree(image->levels);
+    alimerFree(image);
+    alimerTrackLiveImages(-1);
+}
+
+ImageDimension alimerImageGetDimension(Image* image)
+{
+    return image->dimension;
+}
+
+PixelFormat alimerImageGetFormat(Image* image)
+{
+    return image->format;
+}
+
+uint32_t alimerImageGetWidth(Image* image, uint32_t level)
+{
+    level = std::min(level, image->mipLevelCount - 1);
+    uint32_t result = image->width >> level;
+    return result > 0 ? result : 1;
+}
+
+uint32_t alimerImageGetHeight(Image* image, uint32_t level)
+{
+    level = std::min(level, image->mipLevelCount - 1);
+    uint32_t result = image->height >> level;
+    return result > 0 ? result : 1;
+}
+
+uint32_t alimerImageGetDepth(Image* image, uint32_t level)
+{
+    if (image->dimension != ImageDimension_3D)
+        return 1u;
+
+    level = std::min(level, image->mipLevelCount - 1);
+    uint32_t result = image->depthOrArrayLayers >> level;
+    return result > 0 ? result : 1;
+}
+
+uint32_t alimerImageGetArrayLayers(Image* image)
+{
+    if (image->dimension == ImageDimension_3D)
+        return 1u;
+
+    return image->depthOrArrayLayers;
+}
+
+uint32_t alimerImageGetMipLevelCount(Image* image)
+{
+    return image->mipLevelCount;
+}
+
+void* alimerImageGetData(Image* image, size_t* size)
+{
+    if (size)
+        *size = image->dataSize;
+
+    return image->pData;
+}
+
+uint32_t alimerImageGetRowPitchAlignment(Image* image)
+{
+    return image->rowPitchAlignment;
+}
+
+const ImageLevel* alimerImageGetLevel(Image* image, uint32_t layer, uint32_t mipLevel)
+{
+    if (!image || layer >= GetLayerCount(image) || mipLevel >= image->mipLevelCount)
+        return nullptr;
+
+    return &image->levels[layer * image->mipLevelCount + mipLevel];
+}
+
+bool alimerImageSetRowPitchAlignment(Image* image, uint32_t alignment)
+{
+    if (!image)
+        return false;
+
+    alignment = alignment > 0 ? alignment : 1;
+    if ((alignment & (alignment - 1)) != 0)
+        return false;
+
+    if (alignment == image->rowPitchAlignment)
+        return true;
+
+    return RelayoutImage(image, image->mipLevelCount, alignment);
+}
+
+static bool GetResizeLayout(PixelFormat format, uint32_t flags, stbir_pixel_layout* layout, stbir_datatype* datatype)
+{
+    const bool premultiplied = (flags & ImageMipmapFlags_PremultipliedAlpha) != 0;
+    const stbir_pixel_layout rgba = premultiplied ? STBIR_RGBA_PM : STBIR_RGBA;
+
+    switch (format)
+    {
+        case PixelFormat_R8Unorm:         *layout = STBIR_1CHANNEL; *datatype = STBIR_TYPE_UINT8; break;
+        case PixelFormat_RG8Unorm:        *layout = STBIR_2CHANNEL; *datatype = STBIR_TYPE_UINT8; break;
+        case PixelFormat_RGBA8Unorm:
+        case PixelFormat_RGBA8UnormSrgb:  *layout = rgba; *datatype = STBIR_TYPE_UINT8; break;
+        case PixelFormat_BGRA8Unorm:
+        case PixelFormat_BGRA8UnormSrgb:  *layout = premultiplied ? STBIR_BGRA_PM : STBIR_BGRA; *datatype = STBIR_TYPE_UINT8; break;
+        case PixelFormat_R16Unorm:        *layout = STBIR_1CHANNEL; *datatype = STBIR_TYPE_UINT16; break;
+        case PixelFormat_RG16Unorm:       *layout = STBIR_2CHANNEL; *datatype = STBIR_TYPE_UINT16; break;
+        case PixelFormat_RGBA16Unorm:     *layout = rgba; *datatype = STBIR_TYPE_UINT16; break;
+        case PixelFormat_R16Float:        *layout = STBIR_1CHANNEL; *datatype = STBIR_TYPE_HALF_FLOAT; break;
+        case PixelFormat_RG16Float:       *layout = STBIR_2CHANNEL; *datatype = STBIR_TYPE_HALF_FLOAT; break;
+        case PixelFormat_RGBA16Float:     *layout = rgba; *datatype = STBIR_TYPE_HALF_FLOAT; break;
+        case PixelFormat_R32Float:        *layout = STBIR_1CHANNEL; *datatype = STBIR_TYPE_FLOAT; break;
+        case PixelFormat_RG32Float:       *layout = STBIR_2CHANNEL; *datatype = STBIR_TYPE_FLOAT; break;
+        case PixelFormat_RGBA32Float:     *layout = rgba; *datatype = STBIR_TYPE_FLOAT; break;
+        default:
+            return false;
+    }
+
+    // Only 8-bit data can be filtered in linear space by stbir, sRGB alpha stays linear.
+    if (*datatype == STBIR_TYPE_UINT8 && (flags & ImageMipmapFlags_ForceLinear) == 0)
+    {
+        if (IsSrgbFormat(format) || (flags & ImageMipmapFlags_ForceSrgb) != 0)
+            *datatype = STBIR_TYPE_UINT8_SRGB;
+    }
+
+    return true;
+}
+
+struct MipmapLevelJob
+{
+    STBIR_RESIZE* resizes;
+    uint32_t splitCount;
+};
+
+static void GenerateMipmapSplit(uint32_t index, void* userData)
+{
+    MipmapLevelJob* job = (MipmapLevelJob*)userData;
+    stbir_resize_extended_split(&job->resizes[index / job->splitCount], (int)(index % job->splitCount), 1);
+}
+
+bool alimerImageGenerateMipmaps(Image* image, ImageFilter filter, uint32_t flags)
+{
+    if (!image || !image->pData || image->dimension == ImageDimension_3D || filter >= _ImageFilter_Count)
+        return false;
+
+    stbir_pixel_layout layout;
+    stbir_datatype datatype;
+    if (!GetResizeLayout(image->format, flags, &layout, &datatype))
+        return false;
+
+    // The filter samplers are charged like decoder memory, the grown chain goes to image storage.
+    MemoryCategoryScope category(MemoryCategory_ImageDecode);
+
+    // Grow the storage to hold the whole chain, keeping level 0 of every layer.
+    const uint32_t mipLevelCount = image->mipLevelCount > 1 ? image->mipLevelCount : GetFullMipLevelCount(image->width, image->height, 1);
+    if (mipLevelCount != image->mipLevelCount && !RelayoutImage(image, mipLevelCount, image->rowPitchAlignment))
+        return false;
+
+    const uint32_t layerCount = image->depthOrArrayLayers;
+    const stbir_edge edge = (flags & ImageMipmapFlags_Wrap) ? STBIR_EDGE_WRAP : STBIR_EDGE_CLAMP;
+    STBIR_RESIZE* resizes = ALIMER_ALLOCN(STBIR_RESIZE, layerCount);
+    if (!resizes)
+        return false;
+
+    // Every level depends on the previous one: levels run in order, layers and output rows of a level run in parallel.
+    bool result = true;
+    for (uint32_t mipLevel = 1; mipLevel < mipLevelCount && result; ++mipLevel)
+    {
+        MipmapLevelJob job;
+        job.resizes = resizes;
+        job.splitCount = 0;
+        for (uint32_t layer = 0; layer < layerCount; ++layer)
+        {
+            const ImageLevel* src = &image->levels[layer * mipLevelCount + mipLevel - 1];
+            const ImageLevel* dst = &image->levels[layer * mipLevelCount + mipLevel];
+            STBIR_RESIZE* resize = &resizes[layer];
+            stbir_resize_init(resize,
+                src->pixels, (int)src->width, (int)src->height, (int)src->rowPitch,
+                dst->pixels, (int)dst->width, (int)dst->height, (int)dst->rowPitch,
+                layout, datatype);
+            stbir_set_edgemodes(resize, edge, edge);
+            stbir_set_filters(resize, (stbir_filter)filter, (stbir_filter)filter);
+
+            // Same dimensions for every layer, so the split count is the same too.
+            const int splits = stbir_build_samplers_with_splits(resize, (int)alimerGetThreadCount());
+            if (splits <= 0)
+            {
+                result = false;
+                for (uint32_t i = 0; i < layer; ++i)
+                    stbir_free_samplers(&resizes[i]);
+                break;
+            }
+            job.splitCount = (uint32_t)splits;
+        }
+
+        if (!result)
+            break;
+
+        alimerParallelFor(layerCount * job.splitCount, GenerateMipmapSplit, &job);
+
+        for (uint32_t layer = 0; layer < layerCount; ++layer)
+            stbir_free_samplers(&resizes[layer]);
+    }
+
+    alimerFree(resizes);
+    return result;
+}
+
+struct ImageResizer
+{
+    PixelFormat format;
+    uint32_t srcWidth;
+    uint32_t srcHeight;
+    uint32_t width;
+    uint32_t height;
+    uint32_t splitCount;
+    STBIR_RESIZE resize;
+    // Formats stbir can't read go through RGBA float in the pixel callbacks, which read and write these levels.
+    uint32_t bytesPerPixel;
+    const ImageLevel* src;
+    const ImageLevel* dst;
+};
+
+static const void* ResizeConvertInput(void* optionalOutput, const void* inputPtr, int pixelCount, int x, int y, void* context)
+{
+    ALIMER_UNUSED(inputPtr);
+    const ImageResizer* resizer = (const ImageResizer*)context;
+    const ImageLevel* src = resizer->src;
+    const uint8_t* pixels = src->pixels + (size_t)y * src->rowPitch + (size_t)x * resizer->bytesPerPixel;
+    alimerConvertPixels(src->format, pixels, PixelFormat_RGBA32Float, optionalOutput, (uint32_t)pixelCount);
+    return optionalOutput;
+}
+
+static void ResizeConvertOutput(const void* outputPtr, int pixelCount, int y, void* context)
+{
+    const ImageResizer* resizer = (const ImageResizer*)context;
+    const ImageLevel* dst = resizer->dst;
+    alimerConvertPixels(PixelFormat_RGBA32Float, outputPtr, dst->format, dst->pixels + (size_t)y * dst->rowPitch, (uint32_t)pixelCount);
+}
+
+static void ResizeSplit(uint32_t index, void* userData)
+{
+    ImageResizer* resizer = (ImageResizer*)userData;
+    stbir_resize_extended_split(&resizer->resize, (int)index, 1);
+}
+
+ImageResizer* alimerImageResizerCreate(PixelFormat format, uint32_t srcWidth, uint32_t srcHeight, uint32_t width, uint32_t height, ImageFilter filter, ImageEdgeMode edgeMode, uint32_t flags)
+{
+    if (srcWidth == 0 || srcHeight == 0 || width == 0 || height == 0 || filter >= _ImageFilter_Count || edgeMode >= _ImageEdgeMode_Count)
+        return nullptr;
+
+    // stbir addresses rows with int strides.
+    const uint64_t maxWidth = srcWidth > width ? srcWidth : width;
+    if (maxWidth * 16 > INT_MAX || srcHeight > INT_MAX || height > INT_MAX)
+        return nullptr;
+
+    stbir_pixel_layout layout;
+    stbir_datatype datatype;
+    const bool convert = !GetResizeLayout(format, flags, &layout, &datatype);
+    if (convert)
+    {
+        // alimerConvertPixels linearizes sRGB, so the float data is filtered as is.
+        if (!alimerIsConvertibleFormat(format))
+            return nullptr;
+
+        layout = (flags & ImageMipmapFlags_PremultipliedAlpha) ? STBIR_RGBA_PM : STBIR_RGBA;
+        datatype = STBIR_TYPE_FLOAT;
+    }
+
+    MemoryCategoryScope category(MemoryCategory_ImageDecode);
+    ImageResizer* resizer = ALIMER_ALLOC(ImageResizer);
+    if (!resizer)
+        return nullptr;
+
+    resizer->format = format;
+    resizer->srcWidth = srcWidth;
+    resizer->srcHeight = srcHeight;
+    resizer->width = width;
+    resizer->height = height;
+    resizer->bytesPerPixel = GetFormatBytesPerBlock(format);
+
+    // Buffers are set per image, building the samplers only needs the shape.
+    STBIR_RESIZE* resize = &resizer->resize;
+    stbir_resize_init(resize, nullptr, (int)srcWidth, (int)srcHeight, 0, nullptr, (int)width, (int)height, 0, layout, datatype);
+    stbir_set_edgemodes(resize, (stbir_edge)edgeMode, (stbir_edge)edgeMode);
+    stbir_set_filters(resize, (stbir_filter)filter, (stbir_filter)filter);
+    stbir_set_user_data(resize, resizer);
+    if (convert)
+        stbir_set_pixel_callbacks(resize, ResizeConvertInput, ResizeConvertOutput);
+
+    const int splits = stbir_build_samplers_with_splits(resize, (int)alimerGetThreadCount());
+    if (splits <= 0)
+    {
+        alimerFree(resizer);
+        return nullptr;
+    }
+
+    resizer->splitCount = (uint32_t)splits;
+    return resizer;
+}
+
+void alimerImageResizerDestroy(ImageResizer* resizer)
+{
+    if (!resizer)
+        return;
+
+    stbir_free_samplers(&resizer->resize);
+    alimerFree(resizer);
+}
+
+Image* alimerImageResizerRun(ImageResizer* resizer, Image* image)
+{
+    if (!resizer || !image || !image->pData || image->dimension == ImageDimension_3D)
+        return nullptr;
+
+    if (image->format != resizer->format || image->width != resizer->srcWidth || image->height != resizer->srcHeight)
+        return nullptr;
+
+    ImageDesc desc = {};
+    desc.dimension = image->dimension;
+    desc.format = image->format;
+    desc.width = resizer->width;
+    desc.height = resizer->height;
+    desc.depthOrArrayLayers = image->depthOrArrayLayers;
+    desc.mipLevelCount = 1;
+    desc.rowPitchAlignment = image->rowPitchAlignment;
+    Image* result = alimerImageCreate(&desc);
+    if (!result)
+        return nullptr;
+
+    // The samplers hold the buffer pointers and the per split scratch, so layers run one after the other.
+    for (uint32_t layer = 0; layer < image->depthOrArrayLayers; ++layer)
+    {
+        resizer->src = &image->levels[layer * image->mipLevelCount];
+        resizer->dst = &result->levels[layer];
+        stbir_set_buffer_ptrs(&resizer->resize, resizer->src->pixels, (int)resizer->src->rowPitch, resizer->dst->pixels, (int)resizer->dst->rowPitch);
+        if (resizer->splitCount == 1)
+            ResizeSplit(0, resizer);
+        else
+            alimerParallelFor(resizer->splitCount, ResizeSplit, resizer);
+    }
+
+    resizer->src = nullptr;
+    resizer->dst = nullptr;
+    return result;
+}
+
+Image* alimerImageResize(Image* image, uint32_t width, uint32_t height, ImageFilter filter, ImageEdgeMode edgeMode, uint32_t flags)
+{
+    if (!image)
+        return nullptr;
+
+    ImageResizer* resizer = alimerImageResizerCreate(image->format, image->width, image->height, width, height, filter, edgeMode, flags);
+    if (!resizer)
+        return nullptr;
+
+    Image* result = alimerImageResizerRun(resizer, image);
+    alimerImageResizerDestroy(resizer);
+    return result;
+}
+
+// Rows of blocks are converted in tasks of about this many pixels.
+#define ALIMER_CONVERT_TASK_PIXELS 65536
+
+struct ConvertTask
+{
+    uint32_t levelIndex;
+    uint32_t firstRow;
+    uint32_t rowCount;
+};
+
+struct ConvertJob
+{
+    const Image* src;
+    Image* dst;
+    const ConvertTask* tasks;
+};
+
+static void ConvertRows(uint32_t index, void* userData)
+{
+    const ConvertJob* job = (const ConvertJob*)userData;
+    const ConvertTask& task = job->tasks[index];
+    const ImageLevel& src = job->src->levels[task.levelIndex];
+    const ImageLevel& dst = job->dst->levels[task.levelIndex];
+
+    // Depth slices follow each other with the same row pitch, so rows are indexed across the whole level.
+    for (uint32_t row = task.firstRow; row < task.firstRow + task.rowCount; ++row)
+    {
+        alimerConvertPixels(src.format, src.pixels + row * src.rowPitch, dst.format, dst.pixels + row * dst.rowPitch, src.width);
+    }
+}
+
+Image* alimerImageConvert(Image* image, PixelFormat format)
+{
+    if (!image || !image->pData || !alimerIsConvertibleFormat(image->format) || !alimerIsConvertibleFormat(format))
+        return nullptr;
+
+    ImageDesc desc = {};
+    desc.dimension = image->dimension;
+    desc.format = format;
+    desc.width = image->width;
+    desc.height = image->height;
+    desc.depthOrArrayLayers = image->depthOrArrayLayers;
+    desc.mipLevelCount = image->mipLevelCount;
+    desc.rowPitchAlignment = image->rowPitchAlignment;
+    Image* result = alimerImageCreate(&desc);
+    if (!result)
+        return nullptr;
+
+    const uint32_t levelCount = GetLayerCount(image) * image->mipLevelCount;
+    uint32_t taskCount = 0;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        const ImageLevel& level = image->levels[i];
+        const uint32_t rowsPerTask = level.width < ALIMER_CONVERT_TASK_PIXELS ? ALIMER_CONVERT_TASK_PIXELS / level.width : 1;
+        taskCount += (level.rowCount * level.depth + rowsPerTask - 1) / rowsPerTask;
+    }
+
+    ConvertTask* tasks = ALIMER_ALLOCN(ConvertTask, taskCount);
+    if (!tasks)
+    {
+        alimerImageDestroy(result);
+        return nullptr;
+    }
+
+    ConvertTask* task = tasks;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        const ImageLevel& level = image->levels[i];
+        const uint32_t rowsPerTask = level.width < ALIMER_CONVERT_TASK_PIXELS ? ALIMER_CONVERT_TASK_PIXELS / level.width : 1;
+        const uint32_t rowCount = level.rowCount * level.depth;
+        for (uint32_t row = 0; row < rowCount; row += rowsPerTask, ++task)
+        {
+            task->levelIndex = i;
+            task->firstRow = row;
+            task->rowCount = rowCount - row < rowsPerTask ? rowCount - row : rowsPerTask;
+        }
+    }
+
+    ConvertJob job;
+    job.src = image;
+    job.dst = result;
+    job.tasks = tasks;
+    if (taskCount == 1)
+        ConvertRows(0, &job);
+    else
+        alimerParallelFor(taskCount, ConvertRows, &job);
+
+    alimerFree(tasks);
+    return result;
+}
+
+struct CompressTask
+{
+    uint32_t levelIndex;
+    // Block row across the depth slices of the level.
+    uint32_t blockRow;
+};
+
+struct CompressJob
+{
+    // Levels of the source and the compressed image, or views of one band of them.
+    const ImageLevel* srcLevels;
+    const ImageLevel* dstLevels;
+    const CompressTask* tasks;
+    PixelFormat blockFormat;
+    ImageCompressQuality quality;
+    std::atomic<bool> failed;
+};
+
+static void SetupCompressJob(CompressJob* job, PixelFormat format, ImageCompressQuality quality)
+{
+    job->quality = quality < _ImageCompressQuality_Count ? quality : ImageCompressQuality_Normal;
+    job->failed = false;
+    if (format == PixelFormat_BC4RSnorm || format == PixelFormat_BC5RGSnorm || format == PixelFormat_EACR11Snorm || format == PixelFormat_EACRG11Snorm)
+        job->blockFormat = PixelFormat_RGBA8Snorm;
+    else if (IsSrgbFormat(format))
+        job->blockFormat = PixelFormat_RGBA8UnormSrgb;
+    else
+        job->blockFormat = PixelFormat_RGBA8Unorm;
+}
+
+static void CompressBlockRow(uint32_t index, void* userData)
+{
+    CompressJob* job = (CompressJob*)userData;
+    const CompressTask& task = job->tasks[index];
+    const ImageLevel& src = job->srcLevels[task.levelIndex];
+    const ImageLevel& dst = job->dstLevels[task.levelIndex];
+    const PixelFormatInfo& formatDesc = kFormatDesc[(uint32_t)dst.format];
+    const uint32_t blockWidth = formatDesc.blockWidth;
+    const uint32_t blockHeight = formatDesc.blockHeight;
+    const uint32_t slice = task.blockRow / dst.rowCount;
+    const uint32_t y = (task.blockRow % dst.rowCount) * blockHeight;
+    const uint32_t blockCount = (src.width + blockWidth - 1) / blockWidth;
+    const uint32_t rowWidth = blockCount * blockWidth;
+
+    ScratchScope scratch;
+    uint8_t* rows = (uint8_t*)alimerScratchAlloc((size_t)rowWidth * blockHeight * 4);
+    if (!rows)
+    {
+        job->failed.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    // Edge blocks repeat the last row and column.
+    for (uint32_t i = 0; i < blockHeight; ++i)
+    {
+        const uint32_t row = y + i < src.height ? y + i : src.height - 1;
+        const uint8_t* srcRow = src.pixels + (slice * src.height + row) * src.rowPitch;
+        uint8_t* packed = rows + i * rowWidth * 4;
+        alimerConvertPixels(src.format, srcRow, job->blockFormat, packed, src.width);
+        for (uint32_t x = src.width; x < rowWidth; ++x)
+            memcpy(packed + x * 4, packed + (src.width - 1) * 4, 4);
+    }
+
+    uint8_t* output = dst.pixels + task.blockRow * dst.rowPitch;
+    for (uint32_t b = 0; b < blockCount; ++b)
+    {
+        // ASTC blocks go up to 12x12 pixels.
+        uint8_t block[144][4];
+        for (uint32_t i = 0; i < blockHeight; ++i)
+            memcpy(block[i * blockWidth], rows + (i * rowWidth + b * blockWidth) * 4, blockWidth * 4);
+        alimerEncodeBlock(dst.format, block[0], output + b * formatDesc.bytesPerBlock, job->quality);
+    }
+
+    alimerScratchFree(rows);
+}
+
+Image* alimerImageCompress(Image* image, PixelFormat format, ImageCompressQuality quality)
+{
+    if (!image || !image->pData || !alimerIsConvertibleFormat(image->format) || !alimerIsBlockEncodable(format))
+        return nullptr;
+
+    ImageDesc desc = {};
+    desc.dimension = image->dimension;
+    desc.format = format;
+    desc.width = image->width;
+    desc.height = image->height;
+    desc.depthOrArrayLayers = image->depthOrArrayLayers;
+    desc.mipLevelCount = image->mipLevelCount;
+    desc.rowPitchAlignment = image->rowPitchAlignment;
+    Image* result = alimerImageCreate(&desc);
+    if (!result)
+        return nullptr;
+
+    const uint32_t levelCount = GetLayerCount(image) * image->mipLevelCount;
+    uint32_t taskCount = 0;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        taskCount += result->levels[i].rowCount * result->levels[i].depth;
+    }
+
+    CompressTask* tasks = ALIMER_ALLOCN(CompressTask, taskCount);
+    if (!tasks)
+    {
+        alimerImageDestroy(result);
+        return nullptr;
+    }
+
+    CompressTask* task = tasks;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        const uint32_t blockRows = result->levels[i].rowCount * result->levels[i].depth;
+        for (uint32_t row = 0; row < blockRows; ++row, ++task)
+        {
+            task->levelIndex = i;
+            task->blockRow = row;
+        }
+    }
+
+    CompressJob job;
+    job.srcLevels = image->levels;
+    job.dstLevels = result->levels;
+    job.tasks = tasks;
+    SetupCompressJob(&job, format, quality);
+    if (taskCount == 1)
+        CompressBlockRow(0, &job);
+    else
+        alimerParallelFor(taskCount, CompressBlockRow, &job);
+
+    alimerFree(tasks);
+    if (job.failed)
+    {
+        alimerImageDestroy(result);
+        return nullptr;
+    }
+
+    return result;
+}
+
+// Compress the decoded bands as they arrive, each band covers whole block rows except the last one.
+struct CompressStream
+{
+    PixelFormat format;
+    ImageCompressQuality quality;
+    Image* image;
+    CompressTask* tasks;
+};
+
+static bool ALIMER_CALL CompressBand(const ImageInfo* info, const ImageStreamBand* band, void* userData)
+{
+    CompressStream* stream = (CompressStream*)userData;
+    const uint32_t blockHeight = kFormatDesc[(uint32_t)stream->format].blockHeight;
+    if (!stream->image)
+    {
+        if (!alimerIsConvertibleFormat(info->format))
+            return false;
+
+        ImageDesc desc = {};
+        desc.dimension = ImageDimension_2D;
+        desc.format = stream->format;
+        desc.width = info->width;
+        desc.height = info->height;
+        desc.depthOrArrayLayers = 1;
+        desc.mipLevelCount = 1;
+        desc.rowPitchAlignment = 1;
+        stream->image = alimerImageCreate(&desc);
+        stream->tasks = ALIMER_ALLOCN(CompressTask, stream->image ? stream->image->levels[0].rowCount : 0);
+        if (!stream->image || !stream->tasks)
+            return false;
+    }
+
+    if (band->y % blockHeight != 0 || (band->rowCount % blockHeight != 0 && band->y + band->rowCount != info->height))
+        return false;
+
+    ImageLevel src = {};
+    src.width = info->width;
+    src.height = band->rowCount;
+    src.depth = 1;
+    src.format = info->format;
+    src.rowPitch = band->rowPitch;
+    src.pixels = (uint8_t*)band->pixels;
+
+    const ImageLevel& level = stream->image->levels[0];
+    ImageLevel dst = level;
+    dst.height = band->rowCount;
+    dst.rowCount = (band->rowCount + blockHeight - 1) / blockHeight;
+    dst.pixels = level.pixels + (band->y / blockHeight) * level.rowPitch;
+    for (uint32_t row = 0; row < dst.rowCount; ++row)
+    {
+        stream->tasks[row].levelIndex = 0;
+        stream->tasks[row].blockRow = row;
+    }
+
+    CompressJob job;
+    job.srcLevels = &src;
+    job.dstLevels = &dst;
+    job.tasks = stream->tasks;
+    SetupCompressJob(&job, stream->format, stream->quality);
+    if (dst.rowCount == 1)
+        CompressBlockRow(0, &job);
+    else
+        alimerParallelFor(dst.rowCount, CompressBlockRow, &job);
+
+    return !job.failed;
+}
+
+Image* alimerImageCompressFromMemory(const void* pData, size_t dataSize, PixelFormat format, ImageCompressQuality quality)
+{
+    if (pData == nullptr || dataSize == 0 || !alimerIsBlockEncodable(format))
+        return nullptr;
+
+    // Bands of whole block rows, about as tall as the default band.
+    const uint32_t blockHeight = kFormatDesc[(uint32_t)format].blockHeight;
+    const uint32_t bandHeight = std::max(ALIMER_DEFAULT_BAND_HEIGHT / blockHeight, 1u) * blockHeight;
+    CompressStream stream = {};
+    stream.format = format;
+    stream.quality = quality;
+    const bool result = alimerImageStreamFromMemory(pData, dataSize, bandHeight, CompressBand, &stream);
+    alimerFree(stream.tasks);
+    if (!result)
+    {
+        alimerImageDestroy(stream.image);
+        return nullptr;
+    }
+
+    return stream.image;
+}
+
+Image* alimerImageCompressFromFile(const char* path, PixelFormat format, ImageCompressQuality quality)
+{
+    if (path == nullptr)
+        return nullptr;
+
+    MappedFile mapping;
+    if (!alimerMapFile(path, &mapping))
+        return nullptr;
+
+    Image* image = alimerImageCompressFromMemory(mapping.data, mapping.size, format, quality);
+    alimerUnmapFile(&mapping);
+    return image;
+}
+
+struct DecompressJob
+{
+    const Image* src;
+    Image* dst;
+    const ConvertTask* tasks;
+    PixelFormat blockFormat;
+    std::atomic<bool> failed;
+};
+
+static void DecompressBlockRows(uint32_t index, void* userData)
+{
+    DecompressJob* job = (DecompressJob*)userData;
+    const ConvertTask& task = job->tasks[index];
+    const ImageLevel& src = job->src->levels[task.levelIndex];
+    const ImageLevel& dst = job->dst->levels[task.levelIndex];
+    const PixelFormatInfo& formatDesc = kFormatDesc[(uint32_t)src.format];
+    const uint32_t blockWidth = formatDesc.blockWidth;
+    const uint32_t blockHeight = formatDesc.blockHeight;
+    const uint32_t blockCount = (src.width + blockWidth - 1) / blockWidth;
+    const size_t rowPitch = (size_t)blockCount * blockWidth * GetFormatBytesPerBlock(job->blockFormat);
+
+    ScratchScope scratch;
+    uint8_t* rows = (uint8_t*)alimerScratchAlloc(rowPitch * blockHeight);
+    if (!rows)
+    {
+        job->failed.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    for (uint32_t blockRow = task.firstRow; blockRow < task.firstRow + task.rowCount; ++blockRow)
+    {
+        alimerDecodeBlocks(src.format, src.pixels + blockRow * src.rowPitch, blockCount, rows, rowPitch);
+
+        // Edge blocks are cropped to the level size.
+        const uint32_t slice = blockRow / src.rowCount;
+        const uint32_t y = (blockRow % src.rowCount) * blockHeight;
+        for (uint32_t i = 0; i < blockHeight && y + i < dst.height; ++i)
+        {
+            uint8_t* dstRow = dst.pixels + (slice * dst.height + y + i) * dst.rowPitch;
+            alimerConvertPixels(job->blockFormat, rows + i * rowPitch, dst.format, dstRow, dst.width);
+        }
+    }
+
+    alimerScratchFree(rows);
+}
+
+Image* alimerImageDecompress(Image* image, PixelFormat format)
+{
+    if (!image || !image->pData || !IsCompressedFormat(image->format) || !alimerIsConvertibleFormat(format))
+        return nullptr;
+
+    ImageDesc desc = {};
+    desc.dimension = image->dimension;
+    desc.format = format;
+    desc.width = image->width;
+    desc.height = image->height;
+    desc.depthOrArrayLayers = image->depthOrArrayLayers;
+    desc.mipLevelCount = image->mipLevelCount;
+    desc.rowPitchAlignment = image->rowPitchAlignment;
+    Image* result = alimerImageCreate(&desc);
+    if (!result)
+        return nullptr;
+
+    // Block rows are grouped like the rows of alimerImageConvert, small mips end up in a single task.
+    const uint32_t levelCount = GetLayerCount(image) * image->mipLevelCount;
+    const uint32_t blockHeight = kFormatDesc[(uint32_t)image->format].blockHeight;
+    uint32_t taskCount = 0;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        const ImageLevel& level = image->levels[i];
+        const uint32_t rowPixels = level.width * blockHeight;
+        const uint32_t rowsPerTask = rowPixels < ALIMER_CONVERT_TASK_PIXELS ? ALIMER_CONVERT_TASK_PIXELS / rowPixels : 1;
+        taskCount += (level.rowCount * level.depth + rowsPerTask - 1) / rowsPerTask;
+    }
+
+    ConvertTask* tasks = ALIMER_ALLOCN(ConvertTask, taskCount);
+    if (!tasks)
+    {
+        alimerImageDestroy(result);
+        return nullptr;
+    }
+
+    ConvertTask* task = tasks;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        const ImageLevel& level = image->levels[i];
+        const uint32_t rowPixels = level.width * blockHeight;
+        const uint32_t rowsPerTask = rowPixels < ALIMER_CONVERT_TASK_PIXELS ? ALIMER_CONVERT_TASK_PIXELS / rowPixels : 1;
+        const uint32_t rowCount = level.rowCount * level.depth;
+        for (uint32_t row = 0; row < rowCount; row += rowsPerTask, ++task)
+        {
+            task->levelIndex = i;
+            task->firstRow = row;
+            task->rowCount = rowCount - row < rowsPerTask ? rowCount - row : rowsPerTask;
+        }
+    }
+
+    DecompressJob job;
+    job.src = image;
+    job.dst = result;
+    job.tasks = tasks;
+    job.blockFormat = alimerGetBlockDecodeFormat(image->format);
+    job.failed = false;
+    if (taskCount == 1)
+        DecompressBlockRows(0, &job);
+    else
+        alimerParallelFor(taskCount, DecompressBlockRows, &job);
+
+    alimerFree(tasks);
+    if (job.failed)
+    {
+        alimerImageDestroy(result);
+        return nullptr;
+    }
+
+    return result;
+}
+
+// Container writers, the subresources are written as is and only the row pitch padding is dropped.
+static bool WriteSubresource(const ImageLevel& level, ImageWriteCallback callback, void* userData)
+{
+    const size_t rowSize = GetRowPitch(level.format, level.width);
+    const size_t rowCount = (size_t)level.rowCount * level.depth;
+    if (rowSize == level.rowPitch)
+        return callback(level.pixels, rowSize * rowCount, userData);
+
+    for (size_t row = 0; row < rowCount; ++row)
+    {
+        if (!callback(level.pixels + row * level.rowPitch, rowSize, userData))
+            return false;
+    }
+
+    return true;
+}
+
+#define DDS_HEADER_FLAGS_TEXTURE    0x00001007u // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+#define DDS_HEADER_FLAGS_MIPMAP     0x00020000u
+#define DDS_HEADER_FLAGS_PITCH      0x00000008u
+#define DDS_HEADER_FLAGS_LINEARSIZE 0x00080000u
+#define DDS_SURFACE_FLAGS_TEXTURE   0x00001000u
+#define DDS_SURFACE_FLAGS_COMPLEX   0x00000008u
+#define DDS_SURFACE_FLAGS_MIPMAP    0x00400000u
+#define DDS_CAPS2_CUBEMAP_ALLFACES  0x0000FE00u
+
+static uint32_t ToDXGIFormat(PixelFormat format)
+{
+    for (uint32_t i = 0; i < ALIMER_ARRAYSIZE(kDXGIFormats); ++i)
+    {
+        if (kDXGIFormats[i].format == format)
+            return kDXGIFormats[i].dxgiFormat;
+    }
+
+    return 0;
+}
+
+// Always written with the DX10 header, which can describe arrays and every DXGI format.
+static bool DDS_Save(Image* image, ImageWriteCallback callback, void* userData)
+{
+    const uint32_t dxgiFormat = ToDXGIFormat(image->format);
+    if (dxgiFormat == 0)
+        return false;
+
+    struct
+    {
+        uint32_t magic;
+        DDS_HEADER header;
+        DDS_HEADER_DXT10 header10;
+    } file;
+    memset(&file, 0, sizeof(file));
+
+    const ImageLevel& top = image->levels[0];
+    file.magic = DDS_MAGIC;
+    file.header.size = sizeof(DDS_HEADER);
+    file.header.flags = DDS_HEADER_FLAGS_TEXTURE;
+    file.header.width = image->width;
+    file.header.height = image->height;
+    file.header.depth = 1;
+    file.header.mipMapCount = image->mipLevelCount;
+    file.header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+    file.header.ddspf.flags = DDS_PF_FOURCC;
+    file.header.ddspf.fourCC = DDS_MAKEFOURCC('D', 'X', '1', '0');
+    file.header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+    if (IsCompressedFormat(image->format))
+    {
+        file.header.flags |= DDS_HEADER_FLAGS_LINEARSIZE;
+        file.header.pitchOrLinearSize = (uint32_t)(GetRowPitch(image->format, top.width) * top.rowCount);
+    }
+    else
+    {
+        file.header.flags |= DDS_HEADER_FLAGS_PITCH;
+        file.header.pitchOrLinearSize = (uint32_t)GetRowPitch(image->format, top.width);
+    }
+
+    if (image->mipLevelCount > 1)
+    {
+        file.header.flags |= DDS_HEADER_FLAGS_MIPMAP;
+        file.header.caps |= DDS_SURFACE_FLAGS_COMPLEX | DDS_SURFACE_FLAGS_MIPMAP;
+    }
+
+    file.header10.dxgiFormat = dxgiFormat;
+    file.header10.arraySize = image->depthOrArrayLayers;
+    switch (image->dimension)
+    {
+        case ImageDimension_1D:
+            file.header10.resourceDimension = DDS_DIMENSION_TEXTURE1D;
+            break;
+        case ImageDimension_3D:
+            file.header.flags |= DDS_HEADER_FLAGS_DEPTH;
+            file.header.depth = image->depthOrArrayLayers;
+            file.header.caps |= DDS_SURFACE_FLAGS_COMPLEX;
+            file.header.caps2 = DDS_CAPS2_VOLUME;
+            file.header10.resourceDimension = DDS_DIMENSION_TEXTURE3D;
+            file.header10.arraySize = 1;
+            break;
+        case ImageDimension_Cube:
+            file.header.caps |= DDS_SURFACE_FLAGS_COMPLEX;
+            file.header.caps2 = DDS_CAPS2_CUBEMAP | DDS_CAPS2_CUBEMAP_ALLFACES;
+            file.header10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+            file.header10.miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
+            file.header10.arraySize = image->depthOrArrayLayers / 6;
+            break;
+        default:
+            file.header10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+            break;
+    }
+
+    if (!callback(&file, sizeof(file), userData))
+        return false;
+
+    // Our subresource order is the DDS one.
+    const uint32_t levelCount = GetLayerCount(image) * image->mipLevelCount;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        if (!WriteSubresource(image->levels[i], callback, userData))
+            return false;
+    }
+
+    return true;
+}
+
+// Data Format Descriptor, see https://registry.khronos.org/DataFormat/specs/1.3/dataformat.1.3.html
+#define KDF_MODEL_RGBSDA    1
+#define KDF_MODEL_BC1A      128
+#define KDF_MODEL_BC2       129
+#define KDF_MODEL_BC3       130
+#define KDF_MODEL_BC4       131
+#define KDF_MODEL_BC5       132
+#define KDF_MODEL_BC6H      133
+#define KDF_MODEL_BC7       134
+#define KDF_MODEL_ETC2      161
+#define KDF_MODEL_ASTC      162
+
+#define KDF_CHANNEL_RED     0
+#define KDF_CHANNEL_GREEN   1
+#define KDF_CHANNEL_BLUE    2
+#define KDF_CHANNEL_DEPTH   14
+#define KDF_CHANNEL_ALPHA   15
+#define KDF_CHANNEL_BC1A_ALPHAPRESENT 1
+#define KDF_CHANNEL_ETC2_COLOR 2
+
+#define KDF_SAMPLE_LINEAR   0x10
+#define KDF_SAMPLE_EXPONENT 0x20
+#define KDF_SAMPLE_SIGNED   0x40
+#define KDF_SAMPLE_FLOAT    0x80
+
+#define KDF_MAX_SAMPLES     6
+
+struct KDFSample
+{
+    uint32_t channel;
+    uint32_t bitOffset;
+    uint32_t bitLength;
+    uint32_t lower;
+    uint32_t upper;
+};
+
+struct KDFDescriptor
+{
+    uint32_t model;
+    uint32_t sampleCount;
+    KDFSample samples[KDF_MAX_SAMPLES];
+};
+
+// Add a sample whose range follows the format kind, block compressed samples use the full 32-bit range.
+static void AddKDFSample(KDFDescriptor* desc, PixelFormat format, uint32_t channel, uint32_t bitOffset, uint32_t bitLength)
+{
+    KDFSample& sample = desc->samples[desc->sampleCount++];
+    const uint32_t rangeBits = IsCompressedFormat(format) ? 32 : bitLength;
+    sample.channel = channel;
+    sample.bitOffset = bitOffset;
+    sample.bitLength = bitLength;
+    switch (kFormatDesc[(uint32_t)format].kind)
+    {
+        case PixelFormatKind_Snorm:
+            sample.channel |= KDF_SAMPLE_SIGNED;
+            sample.upper = rangeBits >= 32 ? 0x7FFFFFFFu : (1u << (rangeBits - 1)) - 1;
+            sample.lower = 0u - sample.upper;
+            break;
+        case PixelFormatKind_Uint:
+            sample.lower = 0;
+            sample.upper = 1;
+            break;
+        case PixelFormatKind_Sint:
+            sample.channel |= KDF_SAMPLE_SIGNED;
+            sample.lower = 0xFFFFFFFFu;
+            sample.upper = 1;
+            break;
+        case PixelFormatKind_Float:
+            // -1.0f to 1.0f, or 0.0f to 1.0f for the unsigned float formats.
+            sample.channel |= KDF_SAMPLE_FLOAT;
+            sample.lower = 0;
+            sample.upper = 0x3F800000u;
+            if (format != PixelFormat_RG11B10UFloat && format != PixelFormat_RGB9E5UFloat && format != PixelFormat_BC6HRGBUfloat)
+            {
+                sample.channel |= KDF_SAMPLE_SIGNED;
+                sample.lower = 0xBF800000u;
+            }
+            break;
+        default:
+            sample.lower = 0;
+            sample.upper = rangeBits >= 32 ? 0xFFFFFFFFu : (1u << rangeBits) - 1;
+            break;
+    }
+
+    // Alpha is never sRGB encoded.
+    if (IsSrgbFormat(format) && channel == KDF_CHANNEL_ALPHA)
+        sample.channel |= KDF_SAMPLE_LINEAR;
+}
+
+static void GetKDFDescriptor(PixelFormat format, uint32_t typeSize, KDFDescriptor* desc)
+{
+    desc->model = KDF_MODEL_RGBSDA;
+    desc->sampleCount = 0;
+    switch (format)
+    {
+        case PixelFormat_BGRA4Unorm:
+            AddKDFSample(desc, format, KDF_CHANNEL_BLUE, 0, 4);
+            AddKDFSample(desc, format, KDF_CHANNEL_GREEN, 4, 4);
+            AddKDFSample(desc, format, KDF_CHANNEL_RED, 8, 4);
+            AddKDFSample(desc, format, KDF_CHANNEL_ALPHA, 12, 4);
+            break;
+        case PixelFormat_B5G6R5Unorm:
+            AddKDFSample(desc, format, KDF_CHANNEL_BLUE, 0, 5);
+            AddKDFSample(desc, format, KDF_CHANNEL_GREEN, 5, 6);
+            AddKDFSample(desc, format, KDF_CHANNEL_RED, 11, 5);
+            break;
+        case PixelFormat_BGR5A1Unorm:
+            AddKDFSample(desc, format, KDF_CHANNEL_BLUE, 0, 5);
+            AddKDFSample(desc, format, KDF_CHANNEL_GREEN, 5, 5);
+            AddKDFSample(desc, format, KDF_CHANNEL_RED, 10, 5);
+            AddKDFSample(desc, format, KDF_CHANNEL_ALPHA, 15, 1);
+            break;
+        case PixelFormat_RGB10A2Unorm:
+        case PixelFormat_RGB10A2Uint:
+            AddKDFSample(desc, format, KDF_CHANNEL_RED, 0, 10);
+            AddKDFSample(desc, format, KDF_CHANNEL_GREEN, 10, 10);
+            AddKDFSample(desc, format, KDF_CHANNEL_BLUE, 20, 10);
+            AddKDFSample(desc, format, KDF_CHANNEL_ALPHA, 30, 2);
+            break;
+        case PixelFormat_RG11B10UFloat:
+            AddKDFSample(desc, format, KDF_CHANNEL_RED, 0, 11);
+            AddKDFSample(desc, format, KDF_CHANNEL_GREEN, 11, 11);
+            AddKDFSample(desc, format, KDF_CHANNEL_BLUE, 22, 10);
+            break;
+        case PixelFormat_RGB9E5UFloat:
+            // A mantissa and the shared exponent per channel, the ranges are the ones of the specification example.
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                const KDFSample mantissa = { c, c * 9, 9, 0, 8448 };
+                const KDFSample exponent = { c | KDF_SAMPLE_EXPONENT, 27, 5, 15, 31 };
+                desc->samples[desc->sampleCount++] = mantissa;
+                desc->samples[desc->sampleCount++] = exponent;
+            }
+            break;
+        case PixelFormat_BGRA8Unorm:
+        case PixelFormat_BGRA8UnormSrgb:
+            AddKDFSample(desc, format, KDF_CHANNEL_BLUE, 0, 8);
+            AddKDFSample(desc, format, KDF_CHANNEL_GREEN, 8, 8);
+            AddKDFSample(desc, format, KDF_CHANNEL_RED, 16, 8);
+            AddKDFSample(desc, format, KDF_CHANNEL_ALPHA, 24, 8);
+            break;
+        case PixelFormat_Depth16Unorm:
+        case PixelFormat_Depth32Float:
+            AddKDFSample(desc, format, KDF_CHANNEL_DEPTH, 0, typeSize * 8);
+            break;
+        case PixelFormat_BC1RGBAUnorm:
+        case PixelFormat_BC1RGBAUnormSrgb:
+            desc->model = KDF_MODEL_BC1A;
+            AddKDFSample(desc, format, KDF_CHANNEL_BC1A_ALPHAPRESENT, 0, 64);
+            break;
+        case PixelFormat_BC2RGBAUnorm:
+        case PixelFormat_BC2RGBAUnormSrgb:
+        case PixelFormat_BC3RGBAUnorm:
+        case PixelFormat_BC3RGBAUnormSrgb:
+            desc->model = (format == PixelFormat_BC2RGBAUnorm || format == PixelFormat_BC2RGBAUnormSrgb) ? KDF_MODEL_BC2 : KDF_MODEL_BC3;
+            AddKDFSample(desc, format, KDF_CHANNEL_ALPHA, 0, 64);
+            AddKDFSample(desc, format, 0, 64, 64);
+            break;
+        case PixelFormat_BC4RUnorm:
+        case PixelFormat_BC4RSnorm:
+            desc->model = KDF_MODEL_BC4;
+            AddKDFSample(desc, format, 0, 0, 64);
+            break;
+        case PixelFormat_BC5RGUnorm:
+        case PixelFormat_BC5RGSnorm:
+            desc->model = KDF_MODEL_BC5;
+            AddKDFSample(desc, format, KDF_CHANNEL_RED, 0, 64);
+            AddKDFSample(desc, format, KDF_CHANNEL_GREEN, 64, 64);
+            break;
+        case PixelFormat_BC6HRGBUfloat:
+        case PixelFormat_BC6HRGBFloat:
+            desc->model = KDF_MODEL_BC6H;
+            AddKDFSample(desc, format, 0, 0, 128);
+            break;
+        case PixelFormat_BC7RGBAUnorm:
+        case PixelFormat_BC7RGBAUnormSrgb:
+            desc->model = KDF_MODEL_BC7;
+            AddKDFSample(desc, format, 0, 0, 128);
+            break;
+        case PixelFormat_ETC2RGB8Unorm:
+        case PixelFormat_ETC2RGB8UnormSrgb:
+            desc->model = KDF_MODEL_ETC2;
+            AddKDFSample(desc, format, KDF_CHANNEL_ETC2_COLOR, 0, 64);
+            break;
+        case PixelFormat_ETC2RGB8A1Unorm:
+        case PixelFormat_ETC2RGB8A1UnormSrgb:
+            desc->model = KDF_MODEL_ETC2;
+            AddKDFSample(desc, format, KDF_CHANNEL_ETC2_COLOR, 0, 64);
+            AddKDFSample(desc, format, KDF_CHANNEL_ALPHA, 0, 64);
+            break;
+        case PixelFormat_ETC2RGBA8Unorm:
+        case PixelFormat_ETC2RGBA8UnormSrgb:
+            desc->model = KDF_MODEL_ETC2;
+            AddKDFSample(desc, format, KDF_CHANNEL_ALPHA, 0, 64);
+            AddKDFSample(desc, format, KDF_CHANNEL_ETC2_COLOR, 64, 64);
+            break;
+        case PixelFormat_EACR11Unorm:
+        case PixelFormat_EACR11Snorm:
+            desc->model = KDF_MODEL_ETC2;
+            AddKDFSample(desc, format, KDF_CHANNEL_RED, 0, 64);
+            break;
+        case PixelFormat_EACRG11Unorm:
+        case PixelFormat_EACRG11Snorm:
+            desc->model = KDF_MODEL_ETC2;
+            AddKDFSample(desc, format, KDF_CHANNEL_RED, 0, 64);
+            AddKDFSample(desc, format, KDF_CHANNEL_GREEN, 64, 64);
+            break;
+        default:
+            if (IsASTCCompressedFormat(format))
+            {
+                desc->model = KDF_MODEL_ASTC;
+                AddKDFSample(desc, format, 0, 0, 128);
+            }
+            else
+            {
+                // R, RG or RGBA with channels of the type size.
+                const uint32_t channelCount = kFormatDesc[(uint32_t)format].bytesPerBlock / typeSize;
+                static const uint32_t kChannels[4] = { KDF_CHANNEL_RED, KDF_CHANNEL_GREEN, KDF_CHANNEL_BLUE, KDF_CHANNEL_ALPHA };
+                for (uint32_t c = 0; c < channelCount; ++c)
+                    AddKDFSample(desc, format, kChannels[c], c * typeSize * 8, typeSize * 8);
+            }
+            break;
+    }
+}
+
+// The levels are written smallest first, each one aligned to lcm(block size, 4) which is the larger of both for our formats.
+static bool KTX2_Save(Image* image, ImageWriteCallback callback, void* userData)
+{
+    const VkFormatMapping* mapping = FindVkFormat(image->format);
+    if (!mapping)
+        return false;
+
+    const PixelFormatInfo& info = kFormatDesc[(uint32_t)image->format];
+    KDFDescriptor desc;
+    GetKDFDescriptor(image->format, mapping->typeSize, &desc);
+
+    const uint32_t mipLevelCount = image->mipLevelCount;
+    const uint32_t layerCount = GetLayerCount(image);
+    const uint32_t dfdSize = 4 + 24 + desc.sampleCount * 16;
+    const size_t headerSize = KTX2_LEVEL_INDEX_OFFSET + mipLevelCount * sizeof(KTX2_LEVEL) + dfdSize;
+    const size_t alignment = info.bytesPerBlock > 4 ? info.bytesPerBlock : 4;
+
+    MemoryCategoryScope category(MemoryCategory_Encoder);
+    uint8_t* header = (uint8_t*)alimerCalloc(1, headerSize);
+    if (!header)
+        return false;
+
+    KTX2_HEADER file;
+    memset(&file, 0, sizeof(file));
+    memcpy(file.identifier, kKTX2Identifier, sizeof(kKTX2Identifier));
+    file.vkFormat = mapping->vkFormat;
+    file.typeSize = mapping->typeSize;
+    file.pixelWidth = image->width;
+    file.pixelHeight = image->dimension == ImageDimension_1D ? 0 : image->height;
+    file.faceCount = 1;
+    file.levelCount = mipLevelCount;
+    file.dfdByteOffset = (uint32_t)(KTX2_LEVEL_INDEX_OFFSET + mipLevelCount * sizeof(KTX2_LEVEL));
+    file.dfdByteLength = dfdSize;
+    switch (image->dimension)
+    {
+        case ImageDimension_3D:
+            file.pixelDepth = image->depthOrArrayLayers;
+            break;
+        case ImageDimension_Cube:
+            file.faceCount = 6;
+            file.layerCount = image->depthOrArrayLayers > 6 ? image->depthOrArrayLayers / 6 : 0;
+            break;
+        default:
+            file.layerCount = image->depthOrArrayLayers > 1 ? image->depthOrArrayLayers : 0;
+            break;
+    }
+    memcpy(header, &file, sizeof(file));
+
+    // Level index, the offsets follow the write order (smallest level first).
+    size_t offset = headerSize;
+    for (uint32_t mipLevel = mipLevelCount; mipLevel-- > 0;)
+    {
+        const ImageLevel& level = image->levels[mipLevel];
+        KTX2_LEVEL entry;
+        offset = AlignSize(offset, alignment);
+        entry.byteOffset = offset;
+        entry.byteLength = (uint64_t)GetRowPitch(image->format, level.width) * level.rowCount * level.depth * layerCount;
+        entry.uncompressedByteLength = entry.byteLength;
+        memcpy(header + KTX2_LEVEL_INDEX_OFFSET + mipLevel * sizeof(KTX2_LEVEL), &entry, sizeof(KTX2_LEVEL));
+        offset += (size_t)entry.byteLength;
+    }
+
+    // Basic descriptor block: straight alpha, BT.709 primaries.
+    uint32_t* dfd = (uint32_t*)(header + file.dfdByteOffset);
+    dfd[0] = dfdSize;
+    dfd[1] = 0;
+    dfd[2] = 2 | ((dfdSize - 4) << 16);
+    dfd[3] = desc.model | (1u << 8) | ((IsSrgbFormat(image->format) ? 2u : 1u) << 16);
+    dfd[4] = (uint32_t)(info.blockWidth - 1) | ((uint32_t)(info.blockHeight - 1) << 8);
+    dfd[5] = info.bytesPerBlock;
+    dfd[6] = 0;
+    for (uint32_t i = 0; i < desc.sampleCount; ++i)
+    {
+        const KDFSample& sample = desc.samples[i];
+        uint32_t* words = dfd + 7 + i * 4;
+        words[0] = sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24);
+        words[1] = 0;
+        words[2] = sample.lower;
+        words[3] = sample.upper;
+    }
+
+    bool result = callback(header, headerSize, userData);
+    alimerFree(header);
+
+    static const uint8_t kPadding[16] = {};
+    offset = headerSize;
+    for (uint32_t mipLevel = mipLevelCount; result && mipLevel-- > 0;)
+    {
+        const size_t padding = AlignSize(offset, alignment) - offset;
+        if (padding > 0)
+            result = callback(kPadding, padding, userData);
+        offset += padding;
+
+        for (uint32_t layer = 0; result && layer < layerCount; ++layer)
+        {
+            const ImageLevel& level = image->levels[layer * mipLevelCount + mipLevel];
+            result = WriteSubresource(level, callback, userData);
+            offset += GetRowPitch(image->format, level.width) * level.rowCount * level.depth;
+        }
+    }
+
+    return result;
+}
+
+// Flat containers store the top level of the first layer, converted to one of the layouts they support.
+static bool IsWideFormat(PixelFormat format)
+{
+    switch (format)
+    {
+        case PixelFormat_R16Unorm:
+        case PixelFormat_R16Snorm:
+        case PixelFormat_RG16Unorm:
+        case PixelFormat_RG16Snorm:
+        case PixelFormat_RGB10A2Unorm:
+        case PixelFormat_RGBA16Unorm:
+        case PixelFormat_RGBA16Snorm:
+            return true;
+        default:
+            return GetPixelFormatKind(format) == PixelFormatKind_Float;
+    }
+}
+
+// 8-bit layouts keep the sRGB encoding of the source instead of linearizing it.
+static PixelFormat GetSaveFormat(PixelFormat format, bool allowWide, bool allowGray)
+{
+    switch (format)
+    {
+        case PixelFormat_R8Unorm:
+        case PixelFormat_RG8Unorm:
+        case PixelFormat_R16Unorm:
+        case PixelFormat_RG16Unorm:
+            if (allowGray)
+            {
+                if (allowWide || format == PixelFormat_R8Unorm || format == PixelFormat_RG8Unorm)
+                    return format;
+                // 8-bit only targets keep the channel count.
+                return format == PixelFormat_RG16Unorm ? PixelFormat_RG8Unorm : PixelFormat_R8Unorm;
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (IsSrgbFormat(format))
+        return PixelFormat_RGBA8UnormSrgb;
+    return allowWide && IsWideFormat(format) ? PixelFormat_RGBA16Unorm : PixelFormat_RGBA8Unorm;
+}
+
+static void ConvertRow(const ImageLevel& level, uint32_t row, PixelFormat format, uint8_t* dst)
+{
+    const uint8_t* src = level.pixels + (size_t)row * level.rowPitch;
+    if (level.format == format)
+        memcpy(dst, src, GetRowPitch(format, level.width));
+    else
+        alimerConvertPixels(level.format, src, format, dst, level.width);
+}
+
+// The stb and QOI writers take tightly packed pixels, the level is used in place when it already is.
+static const uint8_t* GetPackedPixels(const ImageLevel& level, PixelFormat format, uint8_t** storage)
+{
+    const size_t rowSize = GetRowPitch(format, level.width);
+    *storage = nullptr;
+    if (level.format == format && level.rowPitch == rowSize)
+        return level.pixels;
+
+    *storage = (uint8_t*)alimerMalloc(rowSize * level.height);
+    if (!*storage)
+        return nullptr;
+
+    for (uint32_t y = 0; y < level.height; ++y)
+        ConvertRow(level, y, format, *storage + y * rowSize);
+    return *storage;
+}
+
+static void WriteBE32(uint8_t* dst, uint32_t value)
+{
+    dst[0] = (uint8_t)(value >> 24);
+    dst[1] = (uint8_t)(value >> 16);
+    dst[2] = (uint8_t)(value >> 8);
+    dst[3] = (uint8_t)value;
+}
+
+// PNG: rows are filtered and deflated in independent bands on the worker pool. Every band but the last ends with a sync flush,
+// so their IDAT chunks concatenate into one zlib stream whose Adler-32 is combined from the per band checksums.
+#define ALIMER_PNG_BAND_SIZE (256 * 1024)
+
+struct PNGBand
+{
+    uint32_t firstRow;
+    uint32_t rowCount;
+    /// Complete IDAT chunk: length, type, deflate data and CRC.
+    uint8_t* chunk;
+    size_t chunkSize;
+    uint32_t adler;
+    size_t rawSize;
+};
+
+struct PNGSaveJob
+{
+    const ImageLevel* level;
+    PixelFormat format;
+    size_t rowSize;
+    uint32_t pixelSize;
+    uint32_t channels;
+    uint32_t deflateLevel;
+    uint8_t zlibFlags;
+    PNGBand* bands;
+};
+
+static bool PNG_WriteChunk(const char* type, const void* data, size_t size, ImageWriteCallback callback, void* userData)
+{
+    uint8_t header[8];
+    uint8_t footer[4];
+    WriteBE32(header, (uint32_t)size);
+    memcpy(header + 4, type, 4);
+    WriteBE32(footer, alimerCrc32(alimerCrc32(0, type, 4), data, size));
+    return callback(header, 8, userData) && (size == 0 || callback(data, size, userData)) && callback(footer, 4, userData);
+}
+
+// Filter type with the smallest sum of absolute values, the usual heuristic. prev is a zero row above the first image row.
+static void PNG_FilterRow(const uint8_t* cur, const uint8_t* prev, size_t rowSize, uint32_t pixelSize, uint8_t* dst, uint8_t* candidate)
+{
+    uint64_t bestSum = UINT64_MAX;
+    for (uint32_t filter = 0; filter < 5; ++filter)
+    {
+        uint8_t* out = candidate + 1;
+        candidate[0] = (uint8_t)filter;
+        switch (filter)
+        {
+            case 0:
+                memcpy(out, cur, rowSize);
+                break;
+            case 1:
+                memcpy(out, cur, pixelSize);
+                for (size_t i = pixelSize; i < rowSize; ++i)
+                    out[i] = (uint8_t)(cur[i] - cur[i - pixelSize]);
+                break;
+            case 2:
+                for (size_t i = 0; i < rowSize; ++i)
+                    out[i] = (uint8_t)(cur[i] - prev[i]);
+                break;
+            case 3:
+                for (size_t i = 0; i < pixelSize; ++i)
+                    out[i] = (uint8_t)(cur[i] - (prev[i] >> 1));
+                for (size_t i = pixelSize; i < rowSize; ++i)
+                    out[i] = (uint8_t)(cur[i] - ((cur[i - pixelSize] + prev[i]) >> 1));
+                break;
+            default:
+                for (size_t i = 0; i < pixelSize; ++i)
+                    out[i] = (uint8_t)(cur[i] - prev[i]);
+                for (size_t i = pixelSize; i < rowSize; ++i)
+                    out[i] = (uint8_t)(cur[i] - PaethPredictor(cur[i - pixelSize], prev[i], prev[i - pixelSize]));
+                break;
+        }
+
+        uint64_t sum = 0;
+        for (size_t i = 0; i < rowSize; ++i)
+            sum += (uint32_t)abs((int8_t)out[i]);
+        if (sum < bestSum)
+        {
+            bestSum = sum;
+            memcpy(dst, candidate, rowSize + 1);
+        }
+    }
+}
+
+static void PNG_ConvertRow(const PNGSaveJob* job, uint32_t y, uint8_t* dst)
+{
+    ConvertRow(*job->level, y, job->format, dst);
+    if (job->pixelSize / job->channels == 2)
+    {
+        // 16-bit samples are big endian.
+        for (size_t i = 0; i < job->rowSize; i += 2)
+            std::swap(dst[i], dst[i + 1]);
+    }
+}
+
+// Deflate the filtered rows of a band into a complete IDAT chunk, the first band carries the zlib header and the last one the final block.
+static bool PNG_WriteBandChunk(const PNGSaveJob* job, PNGBand& band, const uint8_t* raw)
+{
+    const bool first = band.firstRow == 0;
+    const bool last = band.firstRow + band.rowCount == job->level->height;
+    const size_t capacity = alimerDeflateBound(band.rawSize);
+    band.chunk = (uint8_t*)alimerMalloc(8 + 2 + capacity + 4);
+    if (!band.chunk)
+        return false;
+
+    size_t size = 0;
+    if (first)
+    {
+        band.chunk[8] = 0x78;
+        band.chunk[9] = job->zlibFlags;
+        size = 2;
+    }
+
+    const size_t compressedSize = alimerDeflate(raw, band.rawSize, job->deflateLevel, last, band.chunk + 8 + size, capacity);
+    if (!compressedSize)
+    {
+        alimerFree(band.chunk);
+        band.chunk = nullptr;
+        return false;
+    }
+
+    size += compressedSize;
+    WriteBE32(band.chunk, (uint32_t)size);
+    memcpy(band.chunk + 4, "IDAT", 4);
+    WriteBE32(band.chunk + 8 + size, alimerCrc32(0, band.chunk + 4, size + 4));
+    band.chunkSize = 8 + size + 4;
+    band.adler = alimerAdler32(1, raw, band.rawSize);
+    return true;
+}
+
+static void PNG_CompressBand(uint32_t index, void* userData)
+{
+    const PNGSaveJob* job = (const PNGSaveJob*)userData;
+    PNGBand& band = job->bands[index];
+    const size_t rowSize = job->rowSize;
+
+    MemoryCategoryScope category(MemoryCategory_Encoder);
+    ScratchScope scratch;
+    band.rawSize = band.rowCount * (rowSize + 1);
+    uint8_t* raw = (uint8_t*)alimerScratchAlloc(band.rawSize);
+    uint8_t* rows = (uint8_t*)alimerScratchAlloc(rowSize * 3 + 1);
+    if (raw && rows)
+    {
+        // Filters look at the previous unfiltered row, which for the first row of a band belongs to the band above.
+        uint8_t* prev = rows;
+        uint8_t* cur = rows + rowSize;
+        uint8_t* candidate = rows + rowSize * 2;
+        if (band.firstRow > 0)
+            PNG_ConvertRow(job, band.firstRow - 1, prev);
+        else
+            memset(prev, 0, rowSize);
+
+        for (uint32_t i = 0; i < band.rowCount; ++i)
+        {
+            PNG_ConvertRow(job, band.firstRow + i, cur);
+            PNG_FilterRow(cur, prev, rowSize, job->pixelSize, raw + i * (rowSize + 1), candidate);
+            std::swap(prev, cur);
+        }
+
+        PNG_WriteBandChunk(job, band, raw);
+    }
+
+    alimerScratchFree(rows);
+    alimerScratchFree(raw);
+}
+
+static bool PNG_Save(const ImageLevel& level, PixelFormat format, uint32_t quality, ImageWriteCallback callback, void* userData)
+{
+    static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    PNGSaveJob job = {};
+    uint32_t colorType = 6;
+    job.channels = 4;
+    if (format == PixelFormat_R8Unorm || format == PixelFormat_R16Unorm)
+    {
+        colorType = 0;
+        job.channels = 1;
+    }
+    else if (format == PixelFormat_RG8Unorm || format == PixelFormat_RG16Unorm)
+    {
+        colorType = 4;
+        job.channels = 2;
+    }
+
+    job.level = &level;
+    job.format = format;
+    job.rowSize = GetRowPitch(format, level.width);
+    job.pixelSize = GetFormatBytesPerBlock(format);
+    job.deflateLevel = quality == 0 ? 6 : quality > 9 ? 9 : quality;
+    job.zlibFlags = job.deflateLevel == 1 ? 0x01 : job.deflateLevel < 6 ? 0x5E : job.deflateLevel == 6 ? 0x9C : 0xDA;
+
+    uint8_t header[13];
+    WriteBE32(header, level.width);
+    WriteBE32(header + 4, level.height);
+    header[8] = (uint8_t)(job.pixelSize / job.channels * 8);
+    header[9] = (uint8_t)colorType;
+    header[10] = 0; // deflate
+    header[11] = 0; // adaptive filtering
+    header[12] = 0; // no interlace
+    if (!callback(kSignature, sizeof(kSignature), userData) || !PNG_WriteChunk("IHDR", header, sizeof(header), callback, userData))
+        return false;
+
+    const size_t rowsPerBand = std::max<size_t>(1, ALIMER_PNG_BAND_SIZE / (job.rowSize + 1));
+    const uint32_t bandCount = (uint32_t)((level.height + rowsPerBand - 1) / rowsPerBand);
+    job.bands = ALIMER_ALLOCN(PNGBand, bandCount);
+    if (!job.bands)
+        return false;
+
+    for (uint32_t i = 0; i < bandCount; ++i)
+    {
+        job.bands[i].firstRow = (uint32_t)(i * rowsPerBand);
+        job.bands[i].rowCount = (uint32_t)std::min<size_t>(rowsPerBand, level.height - job.bands[i].firstRow);
+    }
+
+    // Bands are compressed a few per thread at a time and written in order, so only that many chunks are in memory.
+    const uint32_t waveSize = alimerGetThreadCount() * 2;
+    uint32_t adler = 1;
+    bool result = true;
+    for (uint32_t first = 0; result && first < bandCount; first += waveSize)
+    {
+        const uint32_t count = std::min(waveSize, bandCount - first);
+        PNGSaveJob wave = job;
+        wave.bands = job.bands + first;
+        if (count == 1)
+            PNG_CompressBand(0, &wave);
+        else
+            alimerParallelFor(count, PNG_CompressBand, &wave);
+
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            const PNGBand& band = job.bands[i];
+            result = result && band.chunk && callback(band.chunk, band.chunkSize, userData);
+            adler = alimerAdler32Combine(adler, band.adler, band.rawSize);
+            alimerFree(band.chunk);
+        }
+    }
+    alimerFree(job.bands);
+
+    uint8_t trailer[4];
+    WriteBE32(trailer, adler);
+    return result && PNG_WriteChunk("IDAT", trailer, sizeof(trailer), callback, userData) && PNG_WriteChunk("IEND", nullptr, 0, callback, userData);
+}
+
+struct STBWriteContext
+{
+    ImageWriteCallback callback;
+    void* userData;
+    bool failed;
+};
+
+static void STB_Write(void* context, void* data, int size)
+{
+    STBWriteContext* ctx = (STBWriteContext*)context;
+    if (!ctx->failed && size > 0 && !ctx->callback(data, (size_t)size, ctx->userData))
+        ctx->failed = true;
+}
+
+static bool STB_Save(const ImageLevel& level, ImageFileType fileType, uint32_t quality, ImageWriteCallback callback, void* userData)
+{
+    const bool hdr = fileType == ImageFileType_HDR;
+    const PixelFormat format = hdr ? PixelFormat_RGBA32Float : GetSaveFormat(level.format, false, true);
+    const int comp = format == PixelFormat_R8Unorm ? 1 : format == PixelFormat_RG8Unorm ? 2 : 4;
+
+    uint8_t* storage;
+    const uint8_t* pixels = GetPackedPixels(level, format, &storage);
+    if (!pixels)
+        return false;
+
+    STBWriteContext context = { callback, userData, false };
+    const int width = (int)level.width;
+    const int height = (int)level.height;
+    int result = 0;
+    switch (fileType)
+    {
+        case ImageFileType_JPG:
+            result = stbi_write_jpg_to_func(STB_Write, &context, width, height, comp, pixels, quality == 0 ? 90 : (int)std::min(quality, 100u));
+            break;
+        case ImageFileType_TGA:
+            result = stbi_write_tga_to_func(STB_Write, &context, width, height, comp, pixels);
+            break;
+        case ImageFileType_BMP:
+            result = stbi_write_bmp_to_func(STB_Write, &context, width, height, comp, pixels);
+            break;
+        case ImageFileType_HDR:
+            result = stbi_write_hdr_to_func(STB_Write, &context, width, height, comp, (const float*)pixels);
+            break;
+        default:
+            break;
+    }
+
+    alimerFree(storage);
+    return result != 0 && !context.failed;
+}
+
+static bool QOI_Save(const ImageLevel& level, ImageWriteCallback callback, void* userData)
+{
+    const PixelFormat format = GetSaveFormat(level.format, false, false);
+    uint8_t* storage;
+    const uint8_t* pixels = GetPackedPixels(level, format, &storage);
+    if (!pixels)
+        return false;
+
+    qoi_desc desc = {};
+    desc.width = level.width;
+    desc.height = level.height;
+    desc.channels = 4;
+    desc.colorspace = format == PixelFormat_RGBA8UnormSrgb ? QOI_SRGB : QOI_LINEAR;
+
+    // qoi_encode allocates its worst case size up front, the buffer comes from the scratch arena.
+    ScratchScope scratch;
+    int size = 0;
+    void* data = qoi_encode(pixels, &desc, &size);
+    alimerFree(storage);
+    if (!data)
+        return false;
+
+    const bool result = callback(data, (size_t)size, userData);
+    QOI_FREE(data);
+    return result;
+}
+
+static bool EXR_Save(const ImageLevel& level, ImageWriteCallback callback, void* userData)
+{
+    // Half sources stay half, everything else is written as float. Channels are stored in name order.
+    const PixelFormat format = level.format == PixelFormat_RGBA16Float ? PixelFormat_RGBA16Float : PixelFormat_RGBA32Float;
+    const uint32_t sampleSize = format == PixelFormat_RGBA16Float ? 2 : 4;
+    const int pixelType = format == PixelFormat_RGBA16Float ? TINYEXR_PIXELTYPE_HALF : TINYEXR_PIXELTYPE_FLOAT;
+    static const char* kChannelNames[4] = { "A", "B", "G", "R" };
+    static const uint32_t kChannelIndices[4] = { 3, 2, 1, 0 };
+
+    const size_t pixelCount = (size_t)level.width * level.height;
+    uint8_t* planes = (uint8_t*)alimerMalloc(pixelCount * sampleSize * 4);
+    uint8_t* row = (uint8_t*)alimerMalloc((size_t)level.width * sampleSize * 4);
+    if (!planes || !row)
+    {
+        alimerFree(planes);
+        alimerFree(row);
+        return false;
+    }
+
+    unsigned char* images[4];
+    for (uint32_t c = 0; c < 4; ++c)
+        images[c] = planes + c * pixelCount * sampleSize;
+
+    for (uint32_t y = 0; y < level.height; ++y)
+    {
+        ConvertRow(level, y, format, row);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            uint8_t* dst = images[c] + (size_t)y * level.width * sampleSize;
+            for (uint32_t x = 0; x < level.width; ++x)
+                memcpy(dst + x * sampleSize, row + (x * 4 + kChannelIndices[c]) * sampleSize, sampleSize);
+        }
+    }
+    alimerFree(row);
+
+    EXRChannelInfo channels[4] = {};
+    int pixelTypes[4];
+    int requestedPixelTypes[4];
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        strcpy(channels[c].name, kChannelNames[c]);
+        pixelTypes[c] = pixelType;
+        requestedPixelTypes[c] = pixelType;
+    }
+
+    EXRHeader header;
+    InitEXRHeader(&header);
+    header.num_channels = 4;
+    header.channels = channels;
+    header.pixel_types = pixelTypes;
+    header.requested_pixel_types = requestedPixelTypes;
+    header.compression_type = TINYEXR_COMPRESSIONTYPE_ZIP;
+
+    EXRImage exrImage;
+    InitEXRImage(&exrImage);
+    exrImage.images = images;
+    exrImage.width = (int)level.width;
+    exrImage.height = (int)level.height;
+    exrImage.num_channels = 4;
+
+    // tinyexr assembles the whole file and hands it over from plain malloc.
+    unsigned char* data = nullptr;
+    const char* error = nullptr;
+    const size_t size = SaveEXRImageToMemory(&exrImage, &header, &data, &error);
+    alimerFree(planes);
+    if (error)
+        FreeEXRErrorMessage(error);
+    if (size == 0 || !data)
+        return false;
+
+    const bool result = callback(data, size, userData);
+    free(data);
+    return result;
+}
+
+bool alimerImageSaveToMemory(Image* image, ImageFileType fileType, uint32_t quality, ImageWriteCallback callback, void* userData)
+{
+    if (!image || !image->pData || !callback)
+        return false;
+
+    MemoryCategoryScope category(MemoryCategory_Encoder);
+    switch (fileType)
+    {
+        case ImageFileType_DDS:
+            return DDS_Save(image, callback, userData);
+        case ImageFileType_KTX2:
+            return KTX2_Save(image, callback, userData);
+        case ImageFileType_PNG:
+        case ImageFileType_JPG:
+        case ImageFileType_TGA:
+        case ImageFileType_BMP:
+        case ImageFileType_HDR:
+        case ImageFileType_QOI:
+        case ImageFileType_EXR:
+            break;
+        default:
+            return false;
+    }
+
+    // Block compressed images are decoded first, straight to the layout the container stores.
+    Image* source = image;
+    if (IsCompressedFormat(image->format))
+    {
+        const PixelFormat decodeFormat = alimerGetBlockDecodeFormat(image->format);
+        PixelFormat format = GetSaveFormat(decodeFormat, fileType == ImageFileType_PNG, fileType != ImageFileType_QOI);
+        if (fileType == ImageFileType_HDR || fileType == ImageFileType_EXR)
+            format = decodeFormat == PixelFormat_RGBA16Float ? PixelFormat_RGBA16Float : PixelFormat_RGBA32Float;
+
+        source = alimerImageDecompress(image, format);
+        if (!source)
+            return false;
+    }
+    else if (!alimerIsConvertibleFormat(image->format))
+    {
+        return false;
+    }
+
+    const ImageLevel& level = source->levels[0];
+    bool result = false;
+    switch (fileType)
+    {
+        case ImageFileType_PNG:
+            result = PNG_Save(level, GetSaveFormat(level.format, true, true), quality, callback, userData);
+            break;
+        case ImageFileType_QOI:
+            result = QOI_Save(level, callback, userData);
+            break;
+        case ImageFileType_EXR:
+            result = EXR_Save(level, callback, userData);
+            break;
+        default:
+            result = STB_Save(level, fileType, quality, callback, userData);
+            break;
+    }
+
+    if (source != image)
+        alimerImageDestroy(source);
+    return result;
+}
+
+// Mip streaming: the image holds the levels from residentLevel to the smallest one, larger levels are read on request.
+// Bigger than any DDS header and than a KTX2 header with a full 32 level index.
+#define ALIMER_MIP_STREAM_HEADER_SIZE 1024
+
+struct MipStream
+{
+    ImageInfo info;
+    ImageDesc desc;
+    MipStreamReadCallback read;
+    void* userData;
+    MappedFile mapping;
+    /// Container offset of every subresource of the full chain, indexed like Image::levels.
+    uint64_t* offsets;
+    Image* image;
+    uint32_t residentLevel;
+};
+
+static bool ALIMER_CALL MipStreamReadMapping(uint64_t offset, void* dst, size_t size, void* userData)
+{
+    const MappedFile* mapping = (const MappedFile*)userData;
+    memcpy(dst, (const uint8_t*)mapping->data + offset, size);
+    return true;
+}
+
+// Compute the container offset of every subresource and check that they all lie inside the container.
+static bool MipStreamSetupOffsets(MipStream* stream, const uint8_t* header, size_t headerSize, uint64_t size)
+{
+    size_t dataOffset = 0;
+    const uint8_t* levels = nullptr;
+    switch (stream->info.fileType)
+    {
+        case ImageFileType_DDS:
+            if (!DDS_ParseHeader(header, headerSize, &stream->desc, &dataOffset))
+                return false;
+            break;
+        case ImageFileType_KTX2:
+            if (!KTX2_ParseHeader(header, headerSize, &stream->desc, &levels))
+                return false;
+            break;
+        default:
+            return false;
+    }
+
+    // Tightly packed layout of the full chain, which gives the subresource sizes and for DDS the offsets as well.
+    Image* layout = CreateImageLayout(&stream->desc);
+    if (!layout)
+        return false;
+
+    const uint32_t layerCount = GetLayerCount(layout);
+    const uint32_t mipLevelCount = layout->mipLevelCount;
+    bool result = mipLevelCount == stream->desc.mipLevelCount;
+    stream->offsets = ALIMER_ALLOCN(uint64_t, (size_t)layerCount * mipLevelCount);
+    for (uint32_t mipLevel = 0; result && stream->offsets && mipLevel < mipLevelCount; ++mipLevel)
+    {
+        uint64_t levelOffset = 0;
+        if (levels)
+        {
+            KTX2_LEVEL level;
+            memcpy(&level, levels + mipLevel * sizeof(KTX2_LEVEL), sizeof(KTX2_LEVEL));
+            levelOffset = level.byteOffset;
+            result = level.byteLength >= (uint64_t)layout->levels[mipLevel].slicePitch * layout->levels[mipLevel].depth * layerCount;
+        }
+
+        for (uint32_t layer = 0; result && layer < layerCount; ++layer)
+        {
+            const uint32_t index = layer * mipLevelCount + mipLevel;
+            const ImageLevel& subresource = layout->levels[index];
+            const uint64_t subresourceSize = (uint64_t)subresource.slicePitch * subresource.depth;
+            if (levels)
+                stream->offsets[index] = levelOffset + layer * subresourceSize;
+            else
+                stream->offsets[index] = dataOffset + subresource.offset;
+            result = stream->offsets[index] <= size && subresourceSize <= size - stream->offsets[index];
+        }
+    }
+
+    alimerImageDestroy(layout);
+    return result && stream->offsets;
+}
+
+MipStream* alimerMipStreamCreate(uint64_t size, MipStreamReadCallback read, void* userData, uint32_t tailLevelCount)
+{
+    if (size == 0 || read == nullptr)
+        return nullptr;
+
+    uint8_t header[ALIMER_MIP_STREAM_HEADER_SIZE];
+    const size_t headerSize = size < sizeof(header) ? (size_t)size : sizeof(header);
+    if (!read(0, header, headerSize, userData))
+        return nullptr;
+
+    MemoryCategoryScope category(MemoryCategory_ImageDecode);
+    MipStream* stream = ALIMER_ALLOC(MipStream);
+    if (!stream)
+        return nullptr;
+
+    stream->read = read;
+    stream->userData = userData;
+    stream->info.fileType = DetectFileType(header, headerSize);
+    if (!MipStreamSetupOffsets(stream, header, headerSize, size))
+    {
+        alimerMipStreamDestroy(stream);
+        return nullptr;
+    }
+
+    stream->info.dimension = stream->desc.dimension;
+    stream->info.format = stream->desc.format;
+    stream->info.width = stream->desc.width;
+    stream->info.height = stream->desc.height;
+    stream->info.depthOrArrayLayers = stream->desc.depthOrArrayLayers;
+    stream->info.mipLevelCount = stream->desc.mipLevelCount;
+
+    // Nothing is resident yet, the first request creates the image with the tail.
+    const uint32_t mipLevelCount = stream->desc.mipLevelCount;
+    stream->residentLevel = mipLevelCount;
+    const uint32_t tailLevel = tailLevelCount < mipLevelCount ? mipLevelCount - (tailLevelCount > 0 ? tailLevelCount : 1) : 0;
+    if (!alimerMipStreamSetResidentLevel(stream, tailLevel))
+    {
+        alimerMipStreamDestroy(stream);
+        return nullptr;
+    }
+
+    return stream;
+}
+
+MipStream* alimerMipStreamCreateFromFile(const char* path, uint32_t tailLevelCount)
+{
+    if (path == nullptr)
+        return nullptr;
+
+    MappedFile mapping;
+    if (!alimerMapFile(path, &mapping))
+        return nullptr;
+
+    // The stream keeps a copy of the mapping, the callback reads from that copy.
+    MipStream* stream = alimerMipStreamCreate(mapping.size, MipStreamReadMapping, &mapping, tailLevelCount);
+    if (!stream)
+    {
+        alimerUnmapFile(&mapping);
+        return nullptr;
+    }
+
+    stream->mapping = mapping;
+    stream->userData = &stream->mapping;
+    return stream;
+}
+
+void alimerMipStreamDestroy(MipStream* stream)
+{
+    if (!stream)
+        return;
+
+    alimerImageDestroy(stream->image);
+    if (stream->mapping.data)
+        alimerUnmapFile(&stream->mapping);
+    alimerFree(stream->offsets);
+    alimerFree(stream);
+}
+
+void alimerMipStreamGetInfo(MipStream* stream, ImageInfo* info)
+{
+    *info = stream->info;
+}
+
+Image* alimerMipStreamGetImage(MipStream* stream)
+{
+    return stream->image;
+}
+
+uint32_t alimerMipStreamGetResidentLevel(MipStream* stream)
+{
+    return stream->residentLevel;
+}
+
+bool alimerMipStreamSetResidentLevel(MipStream* stream, uint32_t mipLevel)
+{
+    const uint32_t mipLevelCount = stream->desc.mipLevelCount;
+    if (mipLevel >= mipLevelCount)
+        return false;
+
+    if (mipLevel == stream->residentLevel)
+        return true;
+
+    // Build the new chain next to the old one, so a failed read leaves the resident levels untouched.
+    ImageDesc desc = stream->desc;
+    desc.width = std::max(stream->desc.width >> mipLevel, 1u);
+    desc.height = std::max(stream->desc.height >> mipLevel, 1u);
+    if (desc.dimension == ImageDimension_3D)
+        desc.depthOrArrayLayers = std::max(stream->desc.depthOrArrayLayers >> mipLevel, 1u);
+    desc.mipLevelCount = mipLevelCount - mipLevel;
+
+    Image* image = CreateImageLayout(&desc);
+    if (!image)
+        return false;
+
+    {
+        MemoryCategoryScope category(MemoryCategory_ImageStorage);
+        image->pData = alimerMalloc(image->dataSize);
+    }
+
+    if (!image->pData)
+    {
+        alimerImageDestroy(image);
+        return false;
+    }
+
+    UpdateLevelPixels(image);
+    const uint32_t layerCount = GetLayerCount(image);
+    for (uint32_t layer = 0; layer < layerCount; ++layer)
+    {
+        for (uint32_t level = mipLevel; level < mipLevelCount; ++level)
+        {
+            ImageLevel& subresource = image->levels[layer * image->mipLevelCount + level - mipLevel];
+            if (level >= stream->residentLevel)
+            {
+                const Image* old = stream->image;
+                CopyLevel(&old->levels[layer * old->mipLevelCount + level - stream->residentLevel], &subresource);
+            }
+            else if (!stream->read(stream->offsets[layer * mipLevelCount + level], subresource.pixels, subresource.slicePitch * subresource.depth, stream->userData))
+            {
+                alimerImageDestroy(image);
+                return false;
+            }
+        }
+    }
+
+    // Swap the contents so the image handed out earlier stays valid.
+    if (stream->image)
+    {
+        std::swap(*stream->image, *image);
+        alimerImageDestroy(image);
+    }
+    else
+    {
+        stream->image = image;
+    }
+
+    stream->residentLevel = mipLevel;
+    return true;
 }
@@ -2,26 +2,626 @@
 // Licensed under the MIT License (MIT). See LICENSE in the repository root for more information.
 
 #include "alimer_internal.h"
+#if defined(_WIN32)
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static void* ALIMER_CALL DefaultAllocate(size_t size, void* userData)
+{
+    ALIMER_UNUSED(userData);
+    return malloc(size);
+}
+
+static void* ALIMER_CALL DefaultReallocate(void* ptr, size_t size, void* userData)
+{
+    ALIMER_UNUSED(userData);
+    return realloc(ptr, size);
+}
+
+static void ALIMER_CALL DefaultFree(void* ptr, void* userData)
+{
+    ALIMER_UNUSED(userData);
+    free(ptr);
+}
+
+static AllocationCallbacks s_allocator = { DefaultAllocate, DefaultReallocate, DefaultFree, nullptr };
+
+void alimerSetAllocator(const AllocationCallbacks* callbacks)
+{
+    if (callbacks && callbacks->allocate && callbacks->reallocate && callbacks->free)
+    {
+        s_allocator = *callbacks;
+    }
+    else
+    {
+        s_allocator.allocate = DefaultAllocate;
+        s_allocator.reallocate = DefaultReallocate;
+        s_allocator.free = DefaultFree;
+        s_allocator.userData = nullptr;
+    }
+}
+
+namespace
+{
+    // Every heap allocation is preceded by its size and category, kept 16 bytes to preserve the alignment.
+    constexpr size_t kAllocationHeaderSize = 16;
+
+    struct AllocationHeader
+    {
+        size_t size;
+        uint32_t category;
+    };
+
+    struct MemoryCounters
+    {
+        std::atomic<uint64_t> currentBytes;
+        std::atomic<uint64_t> peakBytes;
+        std::atomic<uint64_t> allocationCount;
+        std::atomic<uint64_t> liveAllocations;
+    };
+
+    MemoryCounters s_memoryTotal;
+    MemoryCounters s_memoryCategories[_MemoryCategory_Count];
+    std::atomic<uint64_t> s_mappedBytes(0);
+    std::atomic<int32_t> s_liveImages(0);
+    std::atomic<int32_t> s_liveFonts(0);
+    thread_local MemoryCategory t_memoryCategory = MemoryCategory_Internal;
+
+    void UpdatePeak(std::atomic<uint64_t>& peak, uint64_t value)
+    {
+        uint64_t current = peak.load(std::memory_order_relaxed);
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void AddBytes(MemoryCounters& counters, uint64_t size)
+    {
+        const uint64_t current = counters.currentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        UpdatePeak(counters.peakBytes, current);
+    }
+
+    void RemoveBytes(MemoryCounters& counters, uint64_t size)
+    {
+        counters.currentBytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    void TrackAllocation(uint32_t category, uint64_t size)
+    {
+        MemoryCounters* counters[2] = { &s_memoryTotal, &s_memoryCategories[category] };
+        for (MemoryCounters* c : counters)
+        {
+            AddBytes(*c, size);
+            c->allocationCount.fetch_add(1, std::memory_order_relaxed);
+            c->liveAllocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void TrackFree(uint32_t category, uint64_t size)
+    {
+        MemoryCounters* counters[2] = { &s_memoryTotal, &s_memoryCategories[category] };
+        for (MemoryCounters* c : counters)
+        {
+            RemoveBytes(*c, size);
+            c->liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    AllocationHeader* GetAllocationHeader(void* ptr)
+    {
+        return (AllocationHeader*)((uint8_t*)ptr - kAllocationHeaderSize);
+    }
+
+    void ReadCounters(const MemoryCounters& counters, MemoryCategoryStats* stats)
+    {
+        stats->currentBytes = counters.currentBytes.load(std::memory_order_relaxed);
+        stats->peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+        stats->allocationCount = counters.allocationCount.load(std::memory_order_relaxed);
+        stats->liveAllocations = counters.liveAllocations.load(std::memory_order_relaxed);
+    }
+}
 
 void* alimerCalloc(size_t count, size_t size)
 {
-    return calloc(count, size);
+    if (size != 0 && count > SIZE_MAX / size)
+        return nullptr;
+
+    void* data = alimerMalloc(count * size);
+    if (data)
+        memset(data, 0, count * size);
+    return data;
 }
 
 void* alimerMalloc(size_t size)
 {
-    return malloc(size);
+    if (size > SIZE_MAX - kAllocationHeaderSize)
+        return nullptr;
+
+    uint8_t* block = (uint8_t*)s_allocator.allocate(size + kAllocationHeaderSize, s_allocator.userData);
+    if (!block)
+        return nullptr;
+
+    AllocationHeader* header = (AllocationHeader*)block;
+    header->size = size;
+    header->category = t_memoryCategory;
+    TrackAllocation(header->category, size);
+    return block + kAllocationHeaderSize;
 }
 
 void* alimerRealloc(void* old, size_t size)
 {
-    void* data = realloc(old, size);
-    if (!data) abort();
-    //alimerProfileAlloc(data, size);
-    return data;
+    if (!old)
+        return alimerMalloc(size);
+
+    if (size > SIZE_MAX - kAllocationHeaderSize)
+        return nullptr;
+
+    // The block keeps its category, only the size changes.
+    const AllocationHeader oldHeader = *GetAllocationHeader(old);
+    uint8_t* block = (uint8_t*)s_allocator.reallocate(GetAllocationHeader(old), size + kAllocationHeaderSize, s_allocator.userData);
+    if (!block)
+        return nullptr;
+
+    ((AllocationHeader*)block)->size = size;
+    MemoryCounters* counters[2] = { &s_memoryTotal, &s_memoryCategories[oldHeader.category] };
+    for (MemoryCounters* c : counters)
+    {
+        if (size >= oldHeader.size)
+            AddBytes(*c, size - oldHeader.size);
+        else
+            RemoveBytes(*c, oldHeader.size - size);
+    }
+    return block + kAllocationHeaderSize;
 }
 
 void alimerFree(void* data)
 {
-    free(data);
+    if (!data)
+        return;
+
+    AllocationHeader* header = GetAllocationHeader(data);
+    TrackFree(header->category, header->size);
+    s_allocator.free(header, s_allocator.userData);
+}
+
+MemoryCategory alimerSetMemoryCategory(MemoryCategory category)
+{
+    const MemoryCategory previous = t_memoryCategory;
+    t_memoryCategory = category;
+    return previous;
+}
+
+void alimerSetAllocationCategory(void* ptr, MemoryCategory category)
+{
+    if (!ptr)
+        return;
+
+    AllocationHeader* header = GetAllocationHeader(ptr);
+    if (header->category == (uint32_t)category)
+        return;
+
+    // Moved rather than reallocated: the allocation count stays with the category that made it.
+    MemoryCounters& from = s_memoryCategories[header->category];
+    MemoryCounters& to = s_memoryCategories[category];
+    RemoveBytes(from, header->size);
+    from.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+    AddBytes(to, header->size);
+    to.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+    header->category = (uint32_t)category;
+}
+
+void alimerTrackMappedBytes(int64_t delta)
+{
+    s_mappedBytes.fetch_add((uint64_t)delta, std::memory_order_relaxed);
+}
+
+void alimerTrackLiveImages(int32_t delta)
+{
+    s_liveImages.fetch_add(delta, std::memory_order_relaxed);
+}
+
+void alimerTrackLiveFonts(int32_t delta)
+{
+    s_liveFonts.fetch_add(delta, std::memory_order_relaxed);
+}
+
+void alimerGetMemoryStats(MemoryStats* stats)
+{
+    ALIMER_ASSERT(stats);
+
+    ReadCounters(s_memoryTotal, &stats->total);
+    for (uint32_t i = 0; i < _MemoryCategory_Count; ++i)
+    {
+        ReadCounters(s_memoryCategories[i], &stats->categories[i]);
+    }
+    stats->mappedBytes = s_mappedBytes.load(std::memory_order_relaxed);
+    stats->liveImages = (uint32_t)s_liveImages.load(std::memory_order_relaxed);
+    stats->liveFonts = (uint32_t)s_liveFonts.load(std::memory_order_relaxed);
+}
+
+namespace
+{
+    // Every scratch allocation is preceded by its size, kept 16 bytes to preserve the alignment.
+    constexpr size_t kScratchHeaderSize = 16;
+    constexpr size_t kScratchAlignment = 16;
+
+    struct ScratchArena
+    {
+        uint8_t* base;
+        size_t capacity;
+        size_t offset;
+        // Offset where the innermost open scope starts, nothing below it is reclaimed before that scope ends.
+        size_t mark;
+        uint32_t depth;
+
+        ~ScratchArena()
+        {
+            alimerFree(base);
+        }
+
+        bool Owns(const void* ptr) const
+        {
+            return base && (const uint8_t*)ptr >= base && (const uint8_t*)ptr < base + capacity;
+        }
+    };
+
+    std::atomic<size_t> s_scratchSize(0);
+    thread_local ScratchArena t_scratch;
+
+    size_t GetScratchSize(const void* ptr)
+    {
+        size_t size;
+        memcpy(&size, (const uint8_t*)ptr - kScratchHeaderSize, sizeof(size_t));
+        return size;
+    }
+
+    // Last allocation of the innermost scope, the only one that can be freed or grown in place.
+    bool IsLastScratch(const ScratchArena& arena, const void* ptr)
+    {
+        const size_t start = (size_t)((const uint8_t*)ptr - arena.base);
+        return start - kScratchHeaderSize >= arena.mark && start + GetScratchSize(ptr) == arena.offset;
+    }
+}
+
+void alimerSetScratchArenaSize(size_t size)
+{
+    s_scratchSize.store(size, std::memory_order_relaxed);
+}
+
+size_t alimerScratchBegin(void)
+{
+    ScratchArena& arena = t_scratch;
+    if (arena.depth++ > 0)
+    {
+        const size_t mark = arena.mark;
+        arena.mark = arena.offset;
+        return mark;
+    }
+
+    // Outermost scope, pick up a size change (or a disabled arena) while nothing lives in it.
+    const size_t size = s_scratchSize.load(std::memory_order_relaxed);
+    if (arena.capacity != size)
+    {
+        MemoryCategoryScope category(MemoryCategory_Internal);
+        alimerFree(arena.base);
+        arena.base = size > 0 ? (uint8_t*)alimerMalloc(size) : nullptr;
+        arena.capacity = arena.base ? size : 0;
+    }
+    arena.offset = 0;
+    arena.mark = 0;
+    return 0;
+}
+
+void alimerScratchEnd(size_t mark)
+{
+    ScratchArena& arena = t_scratch;
+    ALIMER_ASSERT(arena.depth > 0 && mark <= arena.mark && arena.mark <= arena.offset);
+    arena.depth--;
+    arena.offset = arena.mark;
+    arena.mark = mark;
+}
+
+bool alimerScratchOwns(const void* ptr)
+{
+    return t_scratch.Owns(ptr);
+}
+
+void* alimerScratchAlloc(size_t size)
+{
+    ScratchArena& arena = t_scratch;
+    if (arena.depth > 0 && arena.base)
+    {
+        const size_t start = (arena.offset + kScratchHeaderSize + kScratchAlignment - 1) & ~(kScratchAlignment - 1);
+        if (start <= arena.capacity && size <= arena.capacity - start)
+        {
+            memcpy(arena.base + start - kScratchHeaderSize, &size, sizeof(size_t));
+            arena.offset = start + size;
+            return arena.base + start;
+        }
+    }
+
+    // No open scope, no arena or out of room.
+    return alimerMalloc(size);
+}
+
+void* alimerScratchRealloc(void* ptr, size_t size)
+{
+    if (!ptr)
+        return alimerScratchAlloc(size);
+
+    ScratchArena& arena = t_scratch;
+    if (!arena.Owns(ptr))
+        return alimerRealloc(ptr, size);
+
+    // Growing buffers (stb's zlib output) are usually the last allocation and grow in place.
+    const size_t oldSize = GetScratchSize(ptr);
+    const size_t start = (size_t)((uint8_t*)ptr - arena.base);
+    if (IsLastScratch(arena, ptr) && size <= arena.capacity - start)
+    {
+        memcpy((uint8_t*)ptr - kScratchHeaderSize, &size, sizeof(size_t));
+        arena.offset = start + size;
+        return ptr;
+    }
+
+    void* data = alimerScratchAlloc(size);
+    if (data)
+        memcpy(data, ptr, oldSize < size ? oldSize : size);
+    return data;
+}
+
+void alimerScratchFree(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    ScratchArena& arena = t_scratch;
+    if (!arena.Owns(ptr))
+    {
+        alimerFree(ptr);
+        return;
+    }
+
+    // Freed in LIFO order the space is reused right away, otherwise it comes back when its scope ends.
+    if (IsLastScratch(arena, ptr))
+        arena.offset = (size_t)((uint8_t*)ptr - arena.base) - kScratchHeaderSize;
+}
+
+#if defined(_WIN32)
+bool alimerMapFile(const char* path, MappedFile* file)
+{
+    memset(file, 0, sizeof(MappedFile));
+
+    wchar_t widePath[MAX_PATH];
+    if (!MultiByteToWideChar(CP_UTF8, 0, path, -1, widePath, MAX_PATH))
+        return false;
+
+    HANDLE fileHandle = CreateFileW(widePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0 || (uint64_t)fileSize.QuadPart > SIZE_MAX)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    // The view keeps the mapping (and the file) alive, both handles can be closed right away.
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(fileHandle);
+    if (!mappingHandle)
+        return false;
+
+    void* data = MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mappingHandle);
+    if (!data)
+        return false;
+
+    file->data = data;
+    file->size = (size_t)fileSize.QuadPart;
+    alimerTrackMappedBytes((int64_t)file->size);
+    return true;
+}
+
+void alimerUnmapFile(MappedFile* file)
+{
+    if (file->data)
+    {
+        UnmapViewOfFile(file->data);
+        alimerTrackMappedBytes(-(int64_t)file->size);
+    }
+
+    memset(file, 0, sizeof(MappedFile));
+}
+#else
+bool alimerMapFile(const char* path, MappedFile* file)
+{
+    memset(file, 0, sizeof(MappedFile));
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX)
+    {
+        close(fd);
+        return false;
+    }
+
+    // The mapping holds its own reference to the file.
+    void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    alimerTrackMappedBytes((int64_t)file->size);
+    return true;
+}
+
+void alimerUnmapFile(MappedFile* file)
+{
+    if (file->data)
+    {
+        munmap(file->data, file->size);
+        alimerTrackMappedBytes(-(int64_t)file->size);
+    }
+
+    memset(file, 0, sizeof(MappedFile));
+}
+#endif
+
+namespace
+{
+    struct ParallelJob
+    {
+        ParallelForFunc func;
+        void* userData;
+        // Category of the calling thread, the workers charge their allocations to it while running the job.
+        MemoryCategory category;
+        uint32_t count;
+        std::atomic<uint32_t> next;
+        // Number of workers currently holding a pointer to this job (guarded by ThreadPool::mutex).
+        uint32_t refs;
+    };
+
+    struct ThreadPool
+    {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        std::vector<ParallelJob*> jobs;
+        std::vector<std::thread> workers;
+
+        ThreadPool()
+        {
+            uint32_t hardwareThreads = std::thread::hardware_concurrency();
+            for (uint32_t i = 1; i < hardwareThreads; ++i)
+            {
+                workers.emplace_back([this]() { WorkerMain(); });
+            }
+        }
+
+        static void Execute(ParallelJob* job)
+        {
+            MemoryCategoryScope category(job->category);
+            uint32_t index;
+            while ((index = job->next.fetch_add(1, std::memory_order_relaxed)) < job->count)
+            {
+                job->func(index, job->userData);
+            }
+        }
+
+        void WorkerMain()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                wake.wait(lock, [this]() { return !jobs.empty(); });
+
+                // Newest job first so nested parallel loops complete before their parents.
+                ParallelJob* job = jobs.back();
+                job->refs++;
+                lock.unlock();
+
+                Execute(job);
+
+                lock.lock();
+                Remove(job);
+                if (--job->refs == 0)
+                    finished.notify_all();
+            }
+        }
+
+        void Remove(ParallelJob* job)
+        {
+            for (size_t i = 0; i < jobs.size(); ++i)
+            {
+                if (jobs[i] == job)
+                {
+                    jobs.erase(jobs.begin() + i);
+                    break;
+                }
+            }
+        }
+
+        void Run(uint32_t count, ParallelForFunc func, void* userData)
+        {
+            ParallelJob job;
+            job.func = func;
+            job.userData = userData;
+            job.category = t_memoryCategory;
+            job.count = count;
+            job.next.store(0, std::memory_order_relaxed);
+            job.refs = 0;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(&job);
+            }
+            if (count - 1 < workers.size())
+            {
+                for (uint32_t i = 1; i < count; ++i)
+                    wake.notify_one();
+            }
+            else
+            {
+                wake.notify_all();
+            }
+
+            Execute(&job);
+
+            // Every index is claimed, wait for the workers still running the last ones.
+            std::unique_lock<std::mutex> lock(mutex);
+            Remove(&job);
+            finished.wait(lock, [&job]() { return job.refs == 0; });
+        }
+    };
+
+    ThreadPool& GetThreadPool()
+    {
+        // Intentionally leaked: workers sleep on the condition variable until process exit,
+        // joining them from a static destructor would deadlock under the loader lock when unloaded as a DLL.
+        static ThreadPool* pool = new ThreadPool();
+        return *pool;
+    }
+}
+
+uint32_t alimerGetThreadCount(void)
+{
+    return (uint32_t)GetThreadPool().workers.size() + 1;
+}
+
+void alimerParallelFor(uint32_t count, ParallelForFunc func, void* userData)
+{
+    if (count == 0)
+        return;
+
+    ThreadPool& pool = GetThreadPool();
+    if (count == 1 || pool.workers.empty())
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            func(i, userData);
+        return;
+    }
+
+    pool.Run(count, func, userData);
 }
@@ -80,4 +80,119 @@ _ALIMER_EXTERN void alimerFree(void* data);
 #define ALIMER_ALLOC(type)          ((type*)alimerCalloc(1, sizeof(type)))
 #define ALIMER_ALLOCN(type, n)      ((type*)alimerCalloc(n, sizeof(type)))
 
+/* Memory accounting */
+/// Set the category charged for the calling thread allocations, returns the previous one.
+_ALIMER_EXTERN MemoryCategory alimerSetMemoryCategory(MemoryCategory category);
+/// Move an allocation to another category, used when decoder output is adopted as image storage.
+_ALIMER_EXTERN void alimerSetAllocationCategory(void* ptr, MemoryCategory category);
+_ALIMER_EXTERN void alimerTrackMappedBytes(int64_t delta);
+_ALIMER_EXTERN void alimerTrackLiveImages(int32_t delta);
+_ALIMER_EXTERN void alimerTrackLiveFonts(int32_t delta);
+
+#ifdef __cplusplus
+struct MemoryCategoryScope
+{
+    MemoryCategory previous;
+    explicit MemoryCategoryScope(MemoryCategory category) : previous(alimerSetMemoryCategory(category)) {}
+    ~MemoryCategoryScope() { alimerSetMemoryCategory(previous); }
+};
+#endif
+
+/* Scratch memory */
+/// Open a scratch scope on the calling thread, allocations made with alimerScratchAlloc until the matching end come from the thread arena.
+/// The returned mark restores the enclosing scope, allocations of an enclosing scope freed in a nested one come back when their own scope ends.
+_ALIMER_EXTERN size_t alimerScratchBegin(void);
+_ALIMER_EXTERN void alimerScratchEnd(size_t mark);
+/// Check if a pointer lives in the calling thread arena, such memory must be copied out before the scope ends.
+_ALIMER_EXTERN bool alimerScratchOwns(const void* ptr);
+
+/// Fall back to alimerMalloc outside of a scope or once the arena is full, the free/realloc functions accept both kinds of pointers.
+_ALIMER_EXTERN void* alimerScratchAlloc(size_t size);
+_ALIMER_EXTERN void* alimerScratchRealloc(void* ptr, size_t size);
+_ALIMER_EXTERN void alimerScratchFree(void* ptr);
+
+#ifdef __cplusplus
+struct ScratchScope
+{
+    size_t mark;
+    ScratchScope() : mark(alimerScratchBegin()) {}
+    ~ScratchScope() { alimerScratchEnd(mark); }
+};
+#endif
+
+/* File mapping */
+typedef struct MappedFile {
+    void* data;
+    size_t size;
+} MappedFile;
+
+/// Map a whole file copy-on-write: pages are read lazily and writes stay private to the process.
+_ALIMER_EXTERN bool alimerMapFile(const char* path, MappedFile* file);
+_ALIMER_EXTERN void alimerUnmapFile(MappedFile* file);
+
+/* Compression */
+/// Return the next chunk of compressed input in data and its size, 0 once the input is exhausted.
+typedef size_t (*InflateReadFunc)(void* userData, const uint8_t** data);
+/// Receive decompressed bytes, return false to abort.
+typedef bool (*InflateWriteFunc)(void* userData, const uint8_t* data, size_t size);
+
+/// Decompress a deflate stream (zlibHeader for the RFC 1950 wrapper) in bounded memory, the output is delivered in pieces of at most 96KB.
+_ALIMER_EXTERN bool alimerInflate(InflateReadFunc read, InflateWriteFunc write, void* userData, bool zlibHeader);
+
+/// Outcome of alimerInflateBuffer, zlib streams also fail on a missing or wrong Adler-32 trailer.
+typedef enum InflateStatus {
+    InflateStatus_Success = 0,
+    /// Corrupt or truncated stream.
+    InflateStatus_InvalidData,
+    /// The stream decoded fine so far but dst is too small, a caller with a growing buffer can retry.
+    InflateStatus_OutputFull,
+} InflateStatus;
+
+/// Decompress a whole deflate stream into dst. outSize receives the decompressed size.
+_ALIMER_EXTERN InflateStatus alimerInflateBuffer(const void* src, size_t srcSize, void* dst, size_t dstCapacity, size_t* outSize, bool zlibHeader);
+
+/// Largest raw deflate output alimerDeflate can produce for size input bytes.
+_ALIMER_EXTERN size_t alimerDeflateBound(size_t size);
+/// Compress to a raw deflate stream (level 1-9, 0 for the default), returns the written size or 0 if dst is too small.
+/// Unless finalBlock is set the output ends with a sync flush, so independently compressed segments can be concatenated.
+_ALIMER_EXTERN size_t alimerDeflate(const void* data, size_t size, uint32_t level, bool finalBlock, void* dst, size_t dstCapacity);
+/// Running checksums, start from 1 for Adler-32 and from 0 for CRC-32.
+_ALIMER_EXTERN uint32_t alimerAdler32(uint32_t adler, const void* data, size_t size);
+/// Adler-32 of the concatenation of two buffers from their own checksums and the size of the second one.
+_ALIMER_EXTERN uint32_t alimerAdler32Combine(uint32_t adler1, uint32_t adler2, size_t size2);
+_ALIMER_EXTERN uint32_t alimerCrc32(uint32_t crc, const void* data, size_t size);
+
+/* Pixel conversion */
+/// Check if a format can be converted from and to, every uncompressed color format can.
+_ALIMER_EXTERN bool alimerIsConvertibleFormat(PixelFormat format);
+/// Convert a run of pixels through RGBA float (sRGB formats are linearized), src and dst must not overlap.
+_ALIMER_EXTERN bool alimerConvertPixels(PixelFormat srcFormat, const void* src, PixelFormat dstFormat, void* dst, uint32_t count);
+
+/* Block compression */
+/// Check if alimerEncodeBlock supports a format (BC1-BC5, BC7, ETC2/EAC and ASTC LDR).
+_ALIMER_EXTERN bool alimerIsBlockEncodable(PixelFormat format);
+/// Encode one block from its row major RGBA8 pixels (RGBA8Snorm values for the BC4/BC5/EAC snorm formats), the block size comes from the format.
+_ALIMER_EXTERN void alimerEncodeBlock(PixelFormat format, const uint8_t* pixels, void* block, ImageCompressQuality quality);
+_ALIMER_EXTERN void alimerEncodeETCBlock(PixelFormat format, const uint8_t* pixels, void* block, ImageCompressQuality quality);
+_ALIMER_EXTERN void alimerEncodeASTCBlock(uint32_t blockWidth, uint32_t blockHeight, bool srgb, const uint8_t* pixels, void* block, ImageCompressQuality quality);
+
+/// Format the block decoders write: RGBA8 (sRGB and snorm follow the source), RGBA16 for the EAC 11-bit formats and RGBA16Float for BC6H.
+_ALIMER_EXTERN PixelFormat alimerGetBlockDecodeFormat(PixelFormat format);
+/// Decode a row of blocks of any compressed format, the block height rows of blockCount * blockWidth pixels are rowPitch bytes apart.
+_ALIMER_EXTERN void alimerDecodeBlocks(PixelFormat format, const void* blocks, uint32_t blockCount, void* pixels, size_t rowPitch);
+_ALIMER_EXTERN void alimerDecodeETCBlocks(PixelFormat format, const void* blocks, uint32_t blockCount, void* pixels, size_t rowPitch);
+_ALIMER_EXTERN void alimerDecodeASTCBlocks(uint32_t blockWidth, uint32_t blockHeight, bool srgb, const void* blocks, uint32_t blockCount, void* pixels, size_t rowPitch);
+
+/// Nearest palette entry (squared RGBA distance, at most 32 entries) of every pixel, errors receives the distance to it.
+_ALIMER_EXTERN void alimerFindNearestColors(const uint8_t (*pixels)[4], uint32_t count, const uint8_t (*palette)[4], uint32_t paletteSize, uint8_t* indices, uint32_t* errors);
+
+/* Threading */
+typedef void (*ParallelForFunc)(uint32_t index, void* userData);
+
+/// Number of threads (workers plus the calling thread) that can run a parallel for.
+_ALIMER_EXTERN uint32_t alimerGetThreadCount(void);
+
+/// Run func for every index in [0, count) on the worker pool, the calling thread participates and the call returns once every index is done.
+_ALIMER_EXTERN void alimerParallelFor(uint32_t count, ParallelForFunc func, void* userData);
+
 #endif /* _ALIMER_INTERNAL_H */
@@ -0,0 +1,1621 @@
+// Copyright (c) Amer Koleci and Contributors.
+// Licensed under the MIT License (MIT). See LICENSE in the repository root for more information.
+
+#include "alimer_internal.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define ALIMER_SSE2 1
+#endif
+
+// Every AVX2 CPU has carry-less multiply and SSE4.1, MSVC doesn't define __PCLMUL__.
+#if defined(__PCLMUL__) || (defined(_MSC_VER) && defined(__AVX2__))
+#   include <immintrin.h>
+#   define ALIMER_PCLMUL 1
+#endif
+
+// Inflate (RFC 1950/1951). The decoder runs over a 64-bit bit buffer refilled a word at a time and two level lookup tables
+// whose entries carry the length/distance base and extra bit count, so a match is decoded with a single refill.
+// Streaming output goes through a window of 32KB history plus a write area, a caller provided buffer is used directly.
+namespace
+{
+    constexpr size_t kWindowSize = 32768;
+    constexpr size_t kStreamBufferSize = 64 * 1024;
+    constexpr uint32_t kMaxMatch = 258;
+    constexpr uint32_t kLitLenTableBits = 11;
+    constexpr uint32_t kDistTableBits = 8;
+    constexpr uint32_t kCodeLengthTableBits = 7;
+    // Main table plus subtables: a subtable of n bits takes at least n + 1 codes, which bounds how many of them fit.
+    constexpr uint32_t kLitLenTableSize = (1 << kLitLenTableBits) + (286 / 5) * 16;
+    constexpr uint32_t kDistTableSize = (1 << kDistTableBits) + (30 / 8) * 128;
+
+    // Table entry: code length in bits 0-3, extra bit count in 4-7, flags in 8-11, subtable bits in 12-15 and the value
+    // (literal, length or distance base, subtable offset) in 16-31.
+    constexpr uint32_t kEntryLiteral = 0x100;
+    constexpr uint32_t kEntrySubtable = 0x200;
+    constexpr uint32_t kEntryEndOfBlock = 0x400;
+    constexpr uint32_t kEntryInvalid = 0x800;
+
+    const uint16_t kLengthBase[31] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258, 0, 0 };
+    const uint8_t kLengthExtra[31] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0, 0, 0 };
+    const uint16_t kDistBase[32] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577, 0, 0 };
+    const uint8_t kDistExtra[32] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 0, 0 };
+    const uint8_t kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    uint32_t BitReverse16(uint32_t n)
+    {
+        n = ((n & 0xAAAA) >> 1) | ((n & 0x5555) << 1);
+        n = ((n & 0xCCCC) >> 2) | ((n & 0x3333) << 2);
+        n = ((n & 0xF0F0) >> 4) | ((n & 0x0F0F) << 4);
+        n = ((n & 0xFF00) >> 8) | ((n & 0x00FF) << 8);
+        return n;
+    }
+
+    uint32_t BitReverse(uint32_t v, uint32_t bits)
+    {
+        return BitReverse16(v) >> (16 - bits);
+    }
+
+    uint64_t Load64LE(const uint8_t* p)
+    {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        uint64_t value = 0;
+        for (uint32_t i = 0; i < 8; ++i)
+            value |= (uint64_t)p[i] << (i * 8);
+        return value;
+#else
+        uint64_t value;
+        memcpy(&value, p, 8);
+        return value;
+#endif
+    }
+
+    // What each symbol decodes to, without the code length.
+    struct DecodeResults
+    {
+        uint32_t litLen[288];
+        uint32_t dist[32];
+        uint32_t codeLength[19];
+
+        DecodeResults()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+                litLen[i] = (i << 16) | kEntryLiteral;
+            litLen[256] = kEntryEndOfBlock;
+            for (uint32_t i = 257; i < 288; ++i)
+                litLen[i] = i < 286 ? ((uint32_t)kLengthBase[i - 257] << 16) | ((uint32_t)kLengthExtra[i - 257] << 4) : kEntryInvalid;
+            for (uint32_t i = 0; i < 32; ++i)
+                dist[i] = i < 30 ? ((uint32_t)kDistBase[i] << 16) | ((uint32_t)kDistExtra[i] << 4) : kEntryInvalid;
+            for (uint32_t i = 0; i < 19; ++i)
+                codeLength[i] = i << 16;
+        }
+    };
+
+    const DecodeResults& GetDecodeResults()
+    {
+        static const DecodeResults results;
+        return results;
+    }
+
+    // Canonical Huffman decode table, codes longer than tableBits continue in a subtable sized for the codes sharing the prefix (zlib's scheme).
+    bool BuildDecodeTable(uint32_t* table, uint32_t tableBits, uint32_t capacity, const uint8_t* lengths, uint32_t count, const uint32_t* results)
+    {
+        uint32_t lengthCounts[16] = {};
+        for (uint32_t i = 0; i < count; ++i)
+            lengthCounts[lengths[i]]++;
+        lengthCounts[0] = 0;
+
+        int32_t left = 1;
+        uint32_t maxLength = 0;
+        for (uint32_t length = 1; length < 16; ++length)
+        {
+            left = (left << 1) - (int32_t)lengthCounts[length];
+            if (left < 0)
+                return false;
+            if (lengthCounts[length])
+                maxLength = length;
+        }
+
+        // Incomplete codes are only legal for a single code of one bit, which also keeps the subtable bound above.
+        if (left > 0 && maxLength > 1)
+            return false;
+
+        uint32_t offsets[16];
+        offsets[1] = 0;
+        for (uint32_t length = 1; length < 15; ++length)
+            offsets[length + 1] = offsets[length] + lengthCounts[length];
+
+        uint16_t sorted[288];
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (lengths[i])
+                sorted[offsets[lengths[i]]++] = (uint16_t)i;
+        }
+
+        const uint32_t tableSize = 1u << tableBits;
+        for (uint32_t i = 0; i < tableSize; ++i)
+            table[i] = kEntryInvalid;
+
+        uint32_t code = 0;
+        uint32_t index = 0;
+        uint32_t used = tableSize;
+        uint32_t prefix = UINT32_MAX;
+        uint32_t subtableStart = 0;
+        for (uint32_t length = 1; length <= maxLength; ++length)
+        {
+            for (uint32_t k = 0; k < lengthCounts[length]; ++k, ++code)
+            {
+                const uint32_t symbol = sorted[index++];
+                const uint32_t reversed = BitReverse(code, length);
+                if (length <= tableBits)
+                {
+                    const uint32_t entry = results[symbol] | length;
+                    for (uint32_t j = reversed; j < tableSize; j += 1u << length)
+                        table[j] = entry;
+                    continue;
+                }
+
+                if ((reversed & (tableSize - 1)) != prefix)
+                {
+                    // Grow the subtable until the codes left at the following lengths fill it.
+                    prefix = reversed & (tableSize - 1);
+                    uint32_t subtableBits = length - tableBits;
+                    int32_t slots = 1 << subtableBits;
+                    while (subtableBits + tableBits < maxLength)
+                    {
+                        slots -= (int32_t)(lengthCounts[subtableBits + tableBits] - (subtableBits + tableBits == length ? k : 0));
+                        if (slots <= 0)
+                            break;
+                        subtableBits++;
+                        slots <<= 1;
+                    }
+
+                    if (used + (1u << subtableBits) > capacity)
+                        return false;
+
+                    subtableStart = used;
+                    used += 1u << subtableBits;
+                    for (uint32_t j = subtableStart; j < used; ++j)
+                        table[j] = kEntryInvalid;
+                    table[prefix] = (subtableStart << 16) | (subtableBits << 12) | kEntrySubtable | tableBits;
+                }
+
+                const uint32_t subtableBits = (table[prefix] >> 12) & 15;
+                const uint32_t entry = results[symbol] | (length - tableBits);
+                for (uint32_t j = reversed >> tableBits; j < (1u << subtableBits); j += 1u << (length - tableBits))
+                    table[subtableStart + j] = entry;
+            }
+            code <<= 1;
+        }
+
+        return true;
+    }
+
+    struct FixedTables
+    {
+        uint32_t litLen[kLitLenTableSize];
+        uint32_t dist[kDistTableSize];
+
+        FixedTables()
+        {
+            uint8_t sizes[288 + 32];
+            memset(sizes, 8, 144);
+            memset(sizes + 144, 9, 112);
+            memset(sizes + 256, 7, 24);
+            memset(sizes + 280, 8, 8);
+            memset(sizes + 288, 5, 32);
+            const DecodeResults& results = GetDecodeResults();
+            BuildDecodeTable(litLen, kLitLenTableBits, kLitLenTableSize, sizes, 288, results.litLen);
+            BuildDecodeTable(dist, kDistTableBits, kDistTableSize, sizes + 288, 32, results.dist);
+        }
+    };
+
+    const FixedTables& GetFixedTables()
+    {
+        static const FixedTables tables;
+        return tables;
+    }
+
+    struct Inflater
+    {
+        InflateReadFunc read;
+        InflateWriteFunc write;
+        void* userData;
+
+        const uint8_t* in;
+        const uint8_t* inEnd;
+        // Bits above bitCount may hold the start of the next input byte, they're the same bits a refill would OR in.
+        uint64_t bits;
+        uint32_t bitCount;
+        // Zero bytes appended past the end of the input, a valid stream never consumes them.
+        uint32_t padding;
+        bool failed;
+
+        // Streaming output (write set) flushes and slides the window, a caller buffer fails once it's full.
+        uint8_t* window;
+        size_t capacity;
+        size_t pos;
+        size_t flushed;
+        bool outputFull;
+        // Adler-32 of the output flushed so far, checked against the zlib trailer.
+        uint32_t adler;
+
+        const uint32_t* litLenTable;
+        const uint32_t* distTable;
+        uint32_t litLen[kLitLenTableSize];
+        uint32_t dist[kDistTableSize];
+    };
+
+    bool NextInput(Inflater* z)
+    {
+        size_t size = 0;
+        if (z->read)
+            size = z->read(z->userData, &z->in);
+        if (size == 0)
+        {
+            z->in = z->inEnd = nullptr;
+            z->read = nullptr;
+            return false;
+        }
+
+        z->inEnd = z->in + size;
+        return true;
+    }
+
+    void Refill(Inflater* z)
+    {
+        if (z->inEnd - z->in >= 8)
+        {
+            z->bits |= Load64LE(z->in) << z->bitCount;
+            z->in += (63 - z->bitCount) >> 3;
+            z->bitCount |= 56;
+            return;
+        }
+
+        while (z->bitCount <= 56)
+        {
+            if (z->in == z->inEnd && (z->padding > 0 || !NextInput(z)))
+            {
+                // Out of input, feed zeros and fail if too many of them get used.
+                if (++z->padding > 16)
+                    z->failed = true;
+                z->bitCount += 8;
+                continue;
+            }
+
+            z->bits |= (uint64_t)(*z->in++) << z->bitCount;
+            z->bitCount += 8;
+        }
+    }
+
+    uint32_t GetBits(Inflater* z, uint32_t count)
+    {
+        if (z->bitCount < count)
+            Refill(z);
+
+        const uint32_t value = (uint32_t)(z->bits & ((1ull << count) - 1));
+        z->bits >>= count;
+        z->bitCount -= count;
+        return value;
+    }
+
+    // Needs at least 15 bits in the buffer.
+    uint32_t DecodeEntry(uint64_t* bits, uint32_t* bitCount, const uint32_t* table, uint32_t tableBits)
+    {
+        uint32_t entry = table[*bits & ((1u << tableBits) - 1)];
+        if (entry & kEntrySubtable)
+        {
+            *bits >>= tableBits;
+            *bitCount -= tableBits;
+            entry = table[(entry >> 16) + (*bits & ((1u << ((entry >> 12) & 15)) - 1))];
+        }
+
+        const uint32_t length = entry & 15;
+        *bits >>= length;
+        *bitCount -= length;
+        return entry;
+    }
+
+    bool Flush(Inflater* z)
+    {
+        if (z->write && z->pos > z->flushed && !z->write(z->userData, z->window + z->flushed, z->pos - z->flushed))
+            return false;
+
+        z->adler = alimerAdler32(z->adler, z->window + z->flushed, z->pos - z->flushed);
+        z->flushed = z->pos;
+        return true;
+    }
+
+    // Make room for at least one more match: streaming output keeps the last 32KB as history, a caller buffer can't grow.
+    bool MakeRoom(Inflater* z)
+    {
+        if (!z->write)
+        {
+            z->outputFull = z->pos == z->capacity;
+            return !z->outputFull;
+        }
+        if (z->pos < kWindowSize)
+            return true;
+
+        if (!Flush(z))
+            return false;
+
+        memmove(z->window, z->window + z->pos - kWindowSize, kWindowSize);
+        z->pos = kWindowSize;
+        z->flushed = kWindowSize;
+        return true;
+    }
+
+    bool PutByte(Inflater* z, uint8_t value)
+    {
+        if (z->pos == z->capacity && !MakeRoom(z))
+            return false;
+
+        z->window[z->pos++] = value;
+        return true;
+    }
+
+    bool InflateStored(Inflater* z)
+    {
+        GetBits(z, z->bitCount & 7);
+        const uint32_t length = GetBits(z, 16);
+        const uint32_t nlength = GetBits(z, 16);
+        if (length != (~nlength & 0xFFFF) || z->failed)
+            return false;
+
+        // Whole bytes left in the bit buffer come first, padding isn't data.
+        uint32_t remaining = length;
+        uint32_t buffered = z->bitCount / 8;
+        if (buffered < z->padding)
+            return false;
+        buffered -= z->padding;
+        for (; buffered > 0 && remaining > 0; --buffered, --remaining)
+        {
+            if (!PutByte(z, (uint8_t)z->bits))
+                return false;
+            z->bits >>= 8;
+            z->bitCount -= 8;
+        }
+
+        if (remaining == 0)
+            return true;
+
+        // The bit buffer is empty now (a stored block longer than the buffer consumes it all), copy straight from the input.
+        z->bits = 0;
+        z->bitCount = 0;
+        z->padding = 0;
+        while (remaining > 0)
+        {
+            if (z->in == z->inEnd && !NextInput(z))
+                return false;
+            if (z->pos == z->capacity && !MakeRoom(z))
+                return false;
+
+            size_t count = std::min<size_t>(remaining, (size_t)(z->inEnd - z->in));
+            count = std::min(count, z->capacity - z->pos);
+            memcpy(z->window + z->pos, z->in, count);
+            z->pos += count;
+            z->in += count;
+            remaining -= (uint32_t)count;
+        }
+
+        return true;
+    }
+
+    bool ReadDynamicTables(Inflater* z)
+    {
+        const uint32_t hlit = GetBits(z, 5) + 257;
+        const uint32_t hdist = GetBits(z, 5) + 1;
+        const uint32_t hclen = GetBits(z, 4) + 4;
+        if (hlit > 286 || hdist > 30)
+            return false;
+
+        uint8_t codeLengthSizes[19] = {};
+        for (uint32_t i = 0; i < hclen; ++i)
+            codeLengthSizes[kCodeLengthOrder[i]] = (uint8_t)GetBits(z, 3);
+
+        const DecodeResults& results = GetDecodeResults();
+        uint32_t codeLengths[1 << kCodeLengthTableBits];
+        if (!BuildDecodeTable(codeLengths, kCodeLengthTableBits, 1 << kCodeLengthTableBits, codeLengthSizes, 19, results.codeLength))
+            return false;
+
+        uint8_t sizes[286 + 30] = {};
+        uint32_t count = 0;
+        while (count < hlit + hdist)
+        {
+            if (z->bitCount < 16)
+                Refill(z);
+            const uint32_t entry = DecodeEntry(&z->bits, &z->bitCount, codeLengths, kCodeLengthTableBits);
+            if ((entry & kEntryInvalid) || z->failed)
+                return false;
+
+            const uint32_t c = entry >> 16;
+            if (c < 16)
+            {
+                sizes[count++] = (uint8_t)c;
+                continue;
+            }
+
+            uint8_t fill = 0;
+            uint32_t repeat;
+            if (c == 16)
+            {
+                if (count == 0)
+                    return false;
+                repeat = GetBits(z, 2) + 3;
+                fill = sizes[count - 1];
+            }
+            else if (c == 17)
+            {
+                repeat = GetBits(z, 3) + 3;
+            }
+            else
+            {
+                repeat = GetBits(z, 7) + 11;
+            }
+
+            if (hlit + hdist - count < repeat)
+                return false;
+            memset(sizes + count, fill, repeat);
+            count += repeat;
+        }
+
+        // The end of block code must exist.
+        if (sizes[256] == 0)
+            return false;
+
+        z->litLenTable = z->litLen;
+        z->distTable = z->dist;
+        return BuildDecodeTable(z->litLen, kLitLenTableBits, kLitLenTableSize, sizes, hlit, results.litLen)
+            && BuildDecodeTable(z->dist, kDistTableBits, kDistTableSize, sizes + hlit, hdist, results.dist);
+    }
+
+    void UseFixedTables(Inflater* z)
+    {
+        const FixedTables& tables = GetFixedTables();
+        z->litLenTable = tables.litLen;
+        z->distTable = tables.dist;
+    }
+
+    // Copy a match that may overlap its source, up to 7 bytes past the end can be written for distances of 8 or more.
+    void CopyMatch(uint8_t* out, uint32_t distance, uint32_t length)
+    {
+        const uint8_t* src = out - distance;
+        uint8_t* end = out + length;
+        if (distance >= 8)
+        {
+            do
+            {
+                memcpy(out, src, 8);
+                out += 8;
+                src += 8;
+            } while (out < end);
+        }
+        else if (distance == 1)
+        {
+            memset(out, *src, length);
+        }
+        else
+        {
+            while (out < end)
+                *out++ = *src++;
+        }
+    }
+
+    bool InflateHuffman(Inflater* z)
+    {
+        const uint32_t* litLenTable = z->litLenTable;
+        const uint32_t* distTable = z->distTable;
+        for (;;)
+        {
+            // Fast loop: at least 16 input bytes and room for the longest match plus the copy overrun. The state lives in
+            // locals, the output stores would otherwise force reloads of it.
+            if (z->write && z->capacity - z->pos < kMaxMatch + 8 && !MakeRoom(z))
+                return false;
+
+            if (z->inEnd - z->in >= 16 && z->capacity - z->pos >= kMaxMatch + 8)
+            {
+                const uint8_t* in = z->in;
+                const uint8_t* inLimit = z->inEnd - 16;
+                uint64_t bits = z->bits;
+                uint32_t bitCount = z->bitCount;
+                uint8_t* window = z->window;
+                uint8_t* out = window + z->pos;
+                uint8_t* outLimit = window + z->capacity - (kMaxMatch + 8);
+                bool endOfBlock = false;
+                bool invalid = false;
+                while (in <= inLimit && out <= outLimit)
+                {
+                    bits |= Load64LE(in) << bitCount;
+                    in += (63 - bitCount) >> 3;
+                    bitCount |= 56;
+
+                    uint32_t entry = DecodeEntry(&bits, &bitCount, litLenTable, kLitLenTableBits);
+                    if (entry & kEntryLiteral)
+                    {
+                        *out++ = (uint8_t)(entry >> 16);
+                        // Most literals come in runs, a second one fits in the bits left.
+                        entry = DecodeEntry(&bits, &bitCount, litLenTable, kLitLenTableBits);
+                        if (entry & kEntryLiteral)
+                        {
+                            *out++ = (uint8_t)(entry >> 16);
+                            continue;
+                        }
+                        // Not a literal: the length extra bits and the distance may need more than what's left.
+                        bits |= Load64LE(in) << bitCount;
+                        in += (63 - bitCount) >> 3;
+                        bitCount |= 56;
+                    }
+
+                    if (entry & (kEntryEndOfBlock | kEntryInvalid))
+                    {
+                        endOfBlock = (entry & kEntryEndOfBlock) != 0;
+                        invalid = !endOfBlock;
+                        break;
+                    }
+
+                    const uint32_t lengthExtra = (entry >> 4) & 15;
+                    const uint32_t length = (entry >> 16) + (uint32_t)(bits & ((1u << lengthExtra) - 1));
+                    bits >>= lengthExtra;
+                    bitCount -= lengthExtra;
+
+                    entry = DecodeEntry(&bits, &bitCount, distTable, kDistTableBits);
+                    if (entry & kEntryInvalid)
+                    {
+                        invalid = true;
+                        break;
+                    }
+
+                    const uint32_t distExtra = (entry >> 4) & 15;
+                    const uint32_t distance = (entry >> 16) + (uint32_t)(bits & ((1u << distExtra) - 1));
+                    bits >>= distExtra;
+                    bitCount -= distExtra;
+
+                    // Whatever was slid out is at least 32KB back, so only the bytes produced so far bound the distance.
+                    if (distance > (size_t)(out - window))
+                    {
+                        invalid = true;
+                        break;
+                    }
+
+                    CopyMatch(out, distance, length);
+                    out += length;
+                }
+
+                z->in = in;
+                z->bits = bits;
+                z->bitCount = bitCount;
+                z->pos = (size_t)(out - window);
+                if (invalid)
+                    return false;
+                if (endOfBlock)
+                    return true;
+                continue;
+            }
+
+            // Slow path, one symbol at a time near the end of the input chunk or of the output.
+            if (z->bitCount < 48)
+                Refill(z);
+            uint32_t entry = DecodeEntry(&z->bits, &z->bitCount, litLenTable, kLitLenTableBits);
+            if ((entry & kEntryInvalid) || z->failed)
+                return false;
+
+            if (entry & kEntryLiteral)
+            {
+                if (!PutByte(z, (uint8_t)(entry >> 16)))
+                    return false;
+                continue;
+            }
+
+            if (entry & kEntryEndOfBlock)
+                return true;
+
+            const uint32_t length = (entry >> 16) + GetBits(z, (entry >> 4) & 15);
+            if (z->bitCount < 32)
+                Refill(z);
+            entry = DecodeEntry(&z->bits, &z->bitCount, distTable, kDistTableBits);
+            if (entry & kEntryInvalid)
+                return false;
+
+            const size_t distance = (entry >> 16) + GetBits(z, (entry >> 4) & 15);
+            if (distance > z->pos || z->failed)
+                return false;
+
+            for (uint32_t i = 0; i < length; ++i)
+            {
+                if (!PutByte(z, z->window[z->pos - distance]))
+                    return false;
+            }
+        }
+    }
+
+    // The zeros fed past the end of the input sit above the real bits, a truncated stream is one that got down to them.
+    bool PaddingConsumed(const Inflater* z)
+    {
+        return z->bitCount < z->padding * 8;
+    }
+
+    bool RunInflate(Inflater* z, bool zlibHeader)
+    {
+        z->adler = 1;
+        bool result = true;
+        if (zlibHeader)
+        {
+            const uint32_t cmf = GetBits(z, 8);
+            const uint32_t flg = GetBits(z, 8);
+            // Deflate only, no preset dictionary.
+            result = ((cmf << 8) | flg) % 31 == 0 && (cmf & 15) == 8 && (flg & 32) == 0;
+        }
+
+        bool finalBlock = false;
+        while (result && !finalBlock)
+        {
+            finalBlock = GetBits(z, 1) != 0;
+            switch (GetBits(z, 2))
+            {
+                case 0:
+                    result = InflateStored(z);
+                    break;
+                case 1:
+                    UseFixedTables(z);
+                    result = InflateHuffman(z);
+                    break;
+                case 2:
+                    result = ReadDynamicTables(z) && InflateHuffman(z);
+                    break;
+                default:
+                    result = false;
+                    break;
+            }
+            result = result && !z->failed;
+        }
+
+        if (!result || !Flush(z))
+            return false;
+
+        if (zlibHeader)
+        {
+            GetBits(z, z->bitCount & 7);
+            uint32_t adler = 0;
+            for (uint32_t i = 0; i < 4; ++i)
+                adler = (adler << 8) | GetBits(z, 8);
+            if (adler != z->adler)
+                return false;
+        }
+
+        return !PaddingConsumed(z);
+    }
+}
+
+bool alimerInflate(InflateReadFunc read, InflateWriteFunc write, void* userData, bool zlibHeader)
+{
+    ScratchScope scratch;
+    Inflater* z = (Inflater*)alimerScratchAlloc(sizeof(Inflater));
+    if (!z)
+        return false;
+
+    memset(z, 0, offsetof(Inflater, litLen));
+    z->read = read;
+    z->write = write;
+    z->userData = userData;
+    z->capacity = kWindowSize + kStreamBufferSize;
+    z->window = (uint8_t*)alimerScratchAlloc(z->capacity);
+
+    const bool result = z->window != nullptr && RunInflate(z, zlibHeader);
+    alimerScratchFree(z->window);
+    alimerScratchFree(z);
+    return result;
+}
+
+InflateStatus alimerInflateBuffer(const void* src, size_t srcSize, void* dst, size_t dstCapacity, size_t* outSize, bool zlibHeader)
+{
+    ScratchScope scratch;
+    Inflater* z = (Inflater*)alimerScratchAlloc(sizeof(Inflater));
+    if (!z)
+        return InflateStatus_InvalidData;
+
+    memset(z, 0, offsetof(Inflater, litLen));
+    z->in = (const uint8_t*)src;
+    z->inEnd = z->in + srcSize;
+    z->window = (uint8_t*)dst;
+    z->capacity = dstCapacity;
+
+    InflateStatus status = InflateStatus_Success;
+    if (!RunInflate(z, zlibHeader))
+        status = z->outputFull && !PaddingConsumed(z) ? InflateStatus_OutputFull : InflateStatus_InvalidData;
+    if (outSize)
+        *outSize = z->pos;
+    alimerScratchFree(z);
+    return status;
+}
+
+// Deflate (RFC 1951): hash chain LZ77 with lazy matching, every block goes out as dynamic, fixed or stored Huffman, whichever is the smallest.
+namespace
+{
+    constexpr uint32_t kHashBits = 15;
+    constexpr uint32_t kHashSize = 1 << kHashBits;
+    constexpr uint32_t kWindowMask = kWindowSize - 1;
+    constexpr uint32_t kMaxDistance = kWindowSize - 1;
+    constexpr uint32_t kMinMatch = 3;
+    constexpr uint32_t kBlockTokens = 16384;
+    constexpr uint32_t kMaxCodeLength = 15;
+
+    // Same tuning as zlib: levels 1-3 take the first good enough match, 4-9 look one byte ahead.
+    struct DeflateConfig
+    {
+        uint16_t goodLength;
+        uint16_t lazyLength;
+        uint16_t niceLength;
+        uint16_t maxChain;
+    };
+
+    const DeflateConfig kDeflateConfigs[10] = {
+        { 0, 0, 0, 0 },
+        { 4, 4, 8, 4 },
+        { 4, 5, 16, 8 },
+        { 4, 6, 32, 32 },
+        { 4, 4, 16, 16 },
+        { 8, 16, 32, 32 },
+        { 8, 16, 128, 128 },
+        { 8, 32, 128, 256 },
+        { 32, 128, 258, 1024 },
+        { 32, 258, 258, 4096 },
+    };
+
+    struct DeflateTables
+    {
+        uint8_t lengthCode[256];
+        uint8_t distCode[512];
+        uint16_t fixedLengthCodes[288];
+        uint8_t fixedLengthSizes[288];
+        uint16_t fixedDistCodes[30];
+        uint8_t fixedDistSizes[30];
+
+        DeflateTables()
+        {
+            for (uint32_t code = 0; code < 28; ++code)
+            {
+                for (uint32_t i = 0; i < (1u << kLengthExtra[code]); ++i)
+                    lengthCode[kLengthBase[code] - kMinMatch + i] = (uint8_t)code;
+            }
+            lengthCode[kMaxMatch - kMinMatch] = 28;
+
+            // zlib layout: distances up to 256 directly, larger ones by their value / 128.
+            for (uint32_t code = 0; code < 30; ++code)
+            {
+                for (uint32_t i = 0; i < (1u << kDistExtra[code]); ++i)
+                {
+                    const uint32_t dist = kDistBase[code] - 1 + i;
+                    if (dist < 256)
+                        distCode[dist] = (uint8_t)code;
+                    else
+                        distCode[256 + (dist >> 7)] = (uint8_t)code;
+                }
+            }
+
+            for (uint32_t i = 0; i < 288; ++i)
+                fixedLengthSizes[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+            for (uint32_t i = 0; i < 30; ++i)
+                fixedDistSizes[i] = 5;
+            BuildCodes(fixedLengthSizes, 288, fixedLengthCodes);
+            BuildCodes(fixedDistSizes, 30, fixedDistCodes);
+        }
+
+        // Canonical codes, bit reversed since deflate writes them from the most significant bit.
+        static void BuildCodes(const uint8_t* sizes, uint32_t count, uint16_t* codes)
+        {
+            uint32_t sizeCounts[kMaxCodeLength + 1] = {};
+            uint32_t nextCode[kMaxCodeLength + 1] = {};
+            for (uint32_t i = 0; i < count; ++i)
+                sizeCounts[sizes[i]]++;
+            sizeCounts[0] = 0;
+
+            uint32_t code = 0;
+            for (uint32_t i = 1; i <= kMaxCodeLength; ++i)
+            {
+                code = (code + sizeCounts[i - 1]) << 1;
+                nextCode[i] = code;
+            }
+
+            for (uint32_t i = 0; i < count; ++i)
+                codes[i] = sizes[i] ? (uint16_t)BitReverse(nextCode[sizes[i]]++, sizes[i]) : 0;
+        }
+    };
+
+    const DeflateTables& GetDeflateTables()
+    {
+        static const DeflateTables tables;
+        return tables;
+    }
+
+    uint32_t GetDistCode(const DeflateTables& tables, uint32_t dist)
+    {
+        return dist <= 256 ? tables.distCode[dist - 1] : tables.distCode[256 + ((dist - 1) >> 7)];
+    }
+
+    struct SymbolFrequency
+    {
+        uint32_t key;
+        uint16_t symbol;
+    };
+
+    // In place minimum redundancy code (Moffat and Katajainen) over frequencies sorted in increasing order, keys become code lengths.
+    void ComputeCodeLengths(SymbolFrequency* a, int n)
+    {
+        if (n == 1)
+        {
+            a[0].key = 1;
+            return;
+        }
+
+        a[0].key += a[1].key;
+        int root = 0;
+        int leaf = 2;
+        for (int next = 1; next < n - 1; ++next)
+        {
+            if (leaf >= n || a[root].key < a[leaf].key)
+            {
+                a[next].key = a[root].key;
+                a[root++].key = (uint32_t)next;
+            }
+            else
+            {
+                a[next].key = a[leaf++].key;
+            }
+
+            if (leaf >= n || (root < next && a[root].key < a[leaf].key))
+            {
+                a[next].key += a[root].key;
+                a[root++].key = (uint32_t)next;
+            }
+            else
+            {
+                a[next].key += a[leaf++].key;
+            }
+        }
+
+        a[n - 2].key = 0;
+        for (int next = n - 3; next >= 0; --next)
+            a[next].key = a[a[next].key].key + 1;
+
+        int available = 1;
+        int used = 0;
+        uint32_t depth = 0;
+        root = n - 2;
+        int next = n - 1;
+        while (available > 0)
+        {
+            while (root >= 0 && a[root].key == depth)
+            {
+                used++;
+                root--;
+            }
+            while (available > used)
+            {
+                a[next--].key = depth;
+                available--;
+            }
+            available = 2 * used;
+            depth++;
+            used = 0;
+        }
+    }
+
+    // Huffman code lengths limited to maxLength, at least two symbols get a code so every decoder accepts the table.
+    void BuildCodeLengths(const uint32_t* frequencies, uint32_t count, uint32_t maxLength, uint8_t* sizes)
+    {
+        SymbolFrequency symbols[288];
+        int n = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            sizes[i] = 0;
+            if (frequencies[i])
+                symbols[n++] = { frequencies[i], (uint16_t)i };
+        }
+
+        for (uint32_t i = 0; n < 2 && i < count; ++i)
+        {
+            if (!frequencies[i] && (n == 0 || symbols[0].symbol != i))
+                symbols[n++] = { 1, (uint16_t)i };
+        }
+
+        std::sort(symbols, symbols + n, [](const SymbolFrequency& a, const SymbolFrequency& b) { return a.key < b.key; });
+        ComputeCodeLengths(symbols, n);
+
+        // Move overlong codes to maxLength and rebalance until the Kraft sum is exactly one again.
+        uint32_t lengthCounts[289] = {};
+        for (int i = 0; i < n; ++i)
+            lengthCounts[symbols[i].key]++;
+        for (uint32_t i = maxLength + 1; i < 289; ++i)
+            lengthCounts[maxLength] += lengthCounts[i];
+
+        uint32_t total = 0;
+        for (uint32_t i = maxLength; i > 0; --i)
+            total += lengthCounts[i] << (maxLength - i);
+        while (total != (1u << maxLength))
+        {
+            lengthCounts[maxLength]--;
+            for (uint32_t i = maxLength - 1; i > 0; --i)
+            {
+                if (lengthCounts[i])
+                {
+                    lengthCounts[i]--;
+                    lengthCounts[i + 1] += 2;
+                    break;
+                }
+            }
+            total--;
+        }
+
+        // Least frequent symbols come first and take the longest codes.
+        int index = 0;
+        for (uint32_t length = maxLength; length > 0; --length)
+        {
+            for (uint32_t i = lengthCounts[length]; i > 0; --i)
+                sizes[symbols[index++].symbol] = (uint8_t)length;
+        }
+    }
+
+    struct Deflater
+    {
+        const uint8_t* data;
+        size_t size;
+        DeflateConfig config;
+
+        uint8_t* out;
+        uint8_t* outEnd;
+        uint64_t bits;
+        uint32_t bitCount;
+        bool overflow;
+
+        uint32_t head[kHashSize];
+        uint32_t prev[kWindowSize];
+
+        // A literal is stored as its byte, a match as 256 + length - 3 followed by its distance.
+        uint16_t tokens[kBlockTokens];
+        uint16_t distances[kBlockTokens];
+        uint32_t tokenCount;
+        size_t blockStart;
+        uint32_t lengthFrequencies[286];
+        uint32_t distFrequencies[30];
+    };
+
+    void PutBits(Deflater* z, uint32_t value, uint32_t count)
+    {
+        z->bits |= (uint64_t)value << z->bitCount;
+        z->bitCount += count;
+        while (z->bitCount >= 8)
+        {
+            if (z->out == z->outEnd)
+            {
+                z->overflow = true;
+                z->bitCount = 0;
+                z->bits = 0;
+                return;
+            }
+
+            *z->out++ = (uint8_t)z->bits;
+            z->bits >>= 8;
+            z->bitCount -= 8;
+        }
+    }
+
+    void AlignBits(Deflater* z)
+    {
+        if (z->bitCount & 7)
+            PutBits(z, 0, 8 - (z->bitCount & 7));
+    }
+
+    uint32_t Hash(const uint8_t* p)
+    {
+        const uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+        return (v * 2654435761u) >> (32 - kHashBits);
+    }
+
+    // Positions are stored plus one so a zeroed table means empty.
+    uint32_t InsertHash(Deflater* z, size_t pos)
+    {
+        const uint32_t hash = Hash(z->data + pos);
+        const uint32_t candidate = z->head[hash];
+        z->prev[pos & kWindowMask] = candidate;
+        z->head[hash] = (uint32_t)pos + 1;
+        return candidate;
+    }
+
+    uint16_t Load16(const uint8_t* p)
+    {
+        uint16_t value;
+        memcpy(&value, p, 2);
+        return value;
+    }
+
+    uint32_t MatchLength(const uint8_t* a, const uint8_t* b, uint32_t maxLength)
+    {
+        uint32_t length = 0;
+        while (length + 8 <= maxLength)
+        {
+            uint64_t x, y;
+            memcpy(&x, a + length, 8);
+            memcpy(&y, b + length, 8);
+            if (x != y)
+            {
+                uint64_t diff = x ^ y;
+                while (!(diff & 0xFF))
+                {
+                    diff >>= 8;
+                    length++;
+                }
+                return length;
+            }
+            length += 8;
+        }
+
+        while (length < maxLength && a[length] == b[length])
+            length++;
+        return length;
+    }
+
+    // Longest match for pos along the hash chain, only matches longer than prevLength are reported.
+    uint32_t FindMatch(const Deflater* z, size_t pos, uint32_t candidate, uint32_t prevLength, uint32_t* distance)
+    {
+        const size_t remaining = z->size - pos;
+        const uint32_t maxLength = remaining < kMaxMatch ? (uint32_t)remaining : kMaxMatch;
+        const uint32_t niceLength = z->config.niceLength < maxLength ? z->config.niceLength : maxLength;
+        const uint8_t* current = z->data + pos;
+        uint32_t chain = prevLength >= z->config.goodLength ? z->config.maxChain >> 2 : z->config.maxChain;
+        uint32_t bestLength = prevLength < kMinMatch - 1 ? kMinMatch - 1 : prevLength;
+        uint32_t bestDistance = 0;
+
+        while (candidate && chain--)
+        {
+            const size_t matchPos = candidate - 1;
+            if (pos - matchPos > kMaxDistance)
+                break;
+
+            // Cheap rejects first: the two bytes that would extend the best match, then the start of the match.
+            const uint8_t* match = z->data + matchPos;
+            if (bestLength < maxLength && Load16(match + bestLength - 1) == Load16(current + bestLength - 1) && Load16(match) == Load16(current))
+            {
+                const uint32_t length = MatchLength(match, current, maxLength);
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestDistance = (uint32_t)(pos - matchPos);
+                    if (length >= niceLength)
+                        break;
+                }
+            }
+
+            candidate = z->prev[matchPos & kWindowMask];
+        }
+
+        *distance = bestDistance;
+        return bestDistance ? bestLength : 0;
+    }
+
+    // Code length alphabet encoding of the literal/length and distance sizes, runs use symbols 16, 17 and 18.
+    uint32_t EncodeCodeLengths(const uint8_t* sizes, uint32_t count, uint8_t* symbols, uint8_t* extras)
+    {
+        uint32_t symbolCount = 0;
+        for (uint32_t i = 0; i < count;)
+        {
+            const uint8_t size = sizes[i];
+            uint32_t run = 1;
+            while (i + run < count && sizes[i + run] == size)
+                run++;
+            i += run;
+
+            if (size == 0)
+            {
+                while (run >= 11)
+                {
+                    const uint32_t repeat = run < 138 ? run : 138;
+                    symbols[symbolCount] = 18;
+                    extras[symbolCount++] = (uint8_t)(repeat - 11);
+                    run -= repeat;
+                }
+                if (run >= 3)
+                {
+                    symbols[symbolCount] = 17;
+                    extras[symbolCount++] = (uint8_t)(run - 3);
+                    run = 0;
+                }
+            }
+            else
+            {
+                symbols[symbolCount] = size;
+                extras[symbolCount++] = 0;
+                run--;
+                while (run >= 3)
+                {
+                    const uint32_t repeat = run < 6 ? run : 6;
+                    symbols[symbolCount] = 16;
+                    extras[symbolCount++] = (uint8_t)(repeat - 3);
+                    run -= repeat;
+                }
+            }
+
+            while (run--)
+            {
+                symbols[symbolCount] = size;
+                extras[symbolCount++] = 0;
+            }
+        }
+
+        return symbolCount;
+    }
+
+    uint64_t GetTokenBits(const Deflater* z, const uint8_t* lengthSizes, const uint8_t* distSizes)
+    {
+        uint64_t bits = lengthSizes[256];
+        for (uint32_t i = 0; i < 286; ++i)
+        {
+            if (z->lengthFrequencies[i] && i != 256)
+                bits += (uint64_t)z->lengthFrequencies[i] * (lengthSizes[i] + (i > 256 ? kLengthExtra[i - 257] : 0));
+        }
+        for (uint32_t i = 0; i < 30; ++i)
+            bits += (uint64_t)z->distFrequencies[i] * (distSizes[i] + kDistExtra[i]);
+        return bits;
+    }
+
+    void WriteTokens(Deflater* z, const uint16_t* lengthCodes, const uint8_t* lengthSizes, const uint16_t* distCodes, const uint8_t* distSizes)
+    {
+        const DeflateTables& tables = GetDeflateTables();
+        for (uint32_t i = 0; i < z->tokenCount; ++i)
+        {
+            const uint32_t token = z->tokens[i];
+            if (token < 256)
+            {
+                PutBits(z, lengthCodes[token], lengthSizes[token]);
+                continue;
+            }
+
+            const uint32_t length = token - 256;
+            const uint32_t code = tables.lengthCode[length];
+            PutBits(z, lengthCodes[257 + code], lengthSizes[257 + code]);
+            PutBits(z, length + kMinMatch - kLengthBase[code], kLengthExtra[code]);
+
+            const uint32_t dist = z->distances[i];
+            const uint32_t distCode = GetDistCode(tables, dist);
+            PutBits(z, distCodes[distCode], distSizes[distCode]);
+            PutBits(z, dist - kDistBase[distCode], kDistExtra[distCode]);
+        }
+
+        PutBits(z, lengthCodes[256], lengthSizes[256]);
+    }
+
+    void FlushBlock(Deflater* z, size_t blockEnd, bool finalBlock)
+    {
+        const DeflateTables& tables = GetDeflateTables();
+        z->lengthFrequencies[256] = 1;
+
+        uint8_t lengthSizes[286];
+        uint8_t distSizes[30];
+        BuildCodeLengths(z->lengthFrequencies, 286, kMaxCodeLength, lengthSizes);
+        BuildCodeLengths(z->distFrequencies, 30, kMaxCodeLength, distSizes);
+
+        uint32_t lengthCount = 286;
+        while (lengthCount > 257 && !lengthSizes[lengthCount - 1])
+            lengthCount--;
+        uint32_t distCount = 30;
+        while (distCount > 1 && !distSizes[distCount - 1])
+            distCount--;
+
+        uint8_t sizes[286 + 30];
+        memcpy(sizes, lengthSizes, lengthCount);
+        memcpy(sizes + lengthCount, distSizes, distCount);
+        uint8_t symbols[286 + 30];
+        uint8_t extras[286 + 30];
+        const uint32_t symbolCount = EncodeCodeLengths(sizes, lengthCount + distCount, symbols, extras);
+
+        uint32_t codeLengthFrequencies[19] = {};
+        for (uint32_t i = 0; i < symbolCount; ++i)
+            codeLengthFrequencies[symbols[i]]++;
+        uint8_t codeLengthSizes[19];
+        uint16_t codeLengthCodes[19];
+        BuildCodeLengths(codeLengthFrequencies, 19, 7, codeLengthSizes);
+        DeflateTables::BuildCodes(codeLengthSizes, 19, codeLengthCodes);
+
+        uint32_t codeLengthCount = 19;
+        while (codeLengthCount > 4 && !codeLengthSizes[kCodeLengthOrder[codeLengthCount - 1]])
+            codeLengthCount--;
+
+        uint64_t dynamicBits = 3 + 14 + 3 * codeLengthCount + GetTokenBits(z, lengthSizes, distSizes);
+        for (uint32_t i = 0; i < symbolCount; ++i)
+            dynamicBits += codeLengthSizes[symbols[i]] + (symbols[i] == 16 ? 2 : symbols[i] == 17 ? 3 : symbols[i] == 18 ? 7 : 0);
+        const uint64_t fixedBits = 3 + GetTokenBits(z, tables.fixedLengthSizes, tables.fixedDistSizes);
+
+        // Stored blocks hold at most 65535 bytes each, the header of the first one is followed by the alignment to the current byte.
+        const size_t blockSize = blockEnd - z->blockStart;
+        const size_t storedCount = blockSize ? (blockSize + 65534) / 65535 : 1;
+        const uint64_t storedBits = blockSize * 8 + 35 + ((8 - ((z->bitCount + 3) & 7)) & 7) + (storedCount - 1) * 40;
+
+        if (storedBits <= dynamicBits && storedBits <= fixedBits)
+        {
+            size_t offset = z->blockStart;
+            for (size_t i = 0; i < storedCount; ++i)
+            {
+                const uint32_t size = (uint32_t)(blockEnd - offset < 65535 ? blockEnd - offset : 65535);
+                PutBits(z, (finalBlock && i + 1 == storedCount) ? 1 : 0, 3);
+                AlignBits(z);
+                PutBits(z, size, 16);
+                PutBits(z, ~size & 0xFFFF, 16);
+                if ((size_t)(z->outEnd - z->out) < size)
+                {
+                    z->overflow = true;
+                    break;
+                }
+                memcpy(z->out, z->data + offset, size);
+                z->out += size;
+                offset += size;
+            }
+        }
+        else if (fixedBits <= dynamicBits)
+        {
+            PutBits(z, (finalBlock ? 1 : 0) | (1 << 1), 3);
+            WriteTokens(z, tables.fixedLengthCodes, tables.fixedLengthSizes, tables.fixedDistCodes, tables.fixedDistSizes);
+        }
+        else
+        {
+            PutBits(z, (finalBlock ? 1 : 0) | (2 << 1), 3);
+            PutBits(z, lengthCount - 257, 5);
+            PutBits(z, distCount - 1, 5);
+            PutBits(z, codeLengthCount - 4, 4);
+            for (uint32_t i = 0; i < codeLengthCount; ++i)
+                PutBits(z, codeLengthSizes[kCodeLengthOrder[i]], 3);
+
+            for (uint32_t i = 0; i < symbolCount; ++i)
+            {
+                const uint32_t symbol = symbols[i];
+                PutBits(z, codeLengthCodes[symbol], codeLengthSizes[symbol]);
+                if (symbol >= 16)
+                    PutBits(z, extras[i], symbol == 16 ? 2 : symbol == 17 ? 3 : 7);
+            }
+
+            uint16_t lengthCodes[286];
+            uint16_t distCodes[30];
+            DeflateTables::BuildCodes(lengthSizes, 286, lengthCodes);
+            DeflateTables::BuildCodes(distSizes, 30, distCodes);
+            WriteTokens(z, lengthCodes, lengthSizes, distCodes, distSizes);
+        }
+
+        z->tokenCount = 0;
+        z->blockStart = blockEnd;
+        memset(z->lengthFrequencies, 0, sizeof(z->lengthFrequencies));
+        memset(z->distFrequencies, 0, sizeof(z->distFrequencies));
+    }
+
+    void AddLiteral(Deflater* z, size_t pos)
+    {
+        const uint8_t value = z->data[pos];
+        z->tokens[z->tokenCount++] = value;
+        z->lengthFrequencies[value]++;
+        if (z->tokenCount == kBlockTokens)
+            FlushBlock(z, pos + 1, false);
+    }
+
+    void AddMatch(Deflater* z, size_t pos, uint32_t length, uint32_t distance)
+    {
+        const DeflateTables& tables = GetDeflateTables();
+        z->tokens[z->tokenCount] = (uint16_t)(256 + length - kMinMatch);
+        z->distances[z->tokenCount++] = (uint16_t)distance;
+        z->lengthFrequencies[257 + tables.lengthCode[length - kMinMatch]]++;
+        z->distFrequencies[GetDistCode(tables, distance)]++;
+        if (z->tokenCount == kBlockTokens)
+            FlushBlock(z, pos + length, false);
+    }
+
+    void InsertRange(Deflater* z, size_t begin, size_t end)
+    {
+        if (end + kMinMatch > z->size + 1)
+            end = z->size + 1 > kMinMatch ? z->size + 1 - kMinMatch : 0;
+        for (size_t pos = begin; pos < end; ++pos)
+            InsertHash(z, pos);
+    }
+
+    void CompressGreedy(Deflater* z)
+    {
+        size_t pos = 0;
+        while (pos < z->size)
+        {
+            uint32_t length = 0;
+            uint32_t distance = 0;
+            if (pos + kMinMatch <= z->size)
+                length = FindMatch(z, pos, InsertHash(z, pos), 0, &distance);
+
+            if (length == 0)
+            {
+                AddLiteral(z, pos++);
+                continue;
+            }
+
+            AddMatch(z, pos, length, distance);
+            // Long matches skip the hash updates, as zlib does on its fast levels.
+            if (length <= z->config.lazyLength)
+                InsertRange(z, pos + 1, pos + length);
+            pos += length;
+        }
+    }
+
+    void CompressLazy(Deflater* z)
+    {
+        uint32_t length = 0;
+        uint32_t distance = 0;
+        bool pendingLiteral = false;
+        size_t pos = 0;
+        while (pos < z->size)
+        {
+            const uint32_t prevLength = length;
+            const uint32_t prevDistance = distance;
+            length = 0;
+            if (pos + kMinMatch <= z->size)
+            {
+                const uint32_t candidate = InsertHash(z, pos);
+                if (prevLength < z->config.lazyLength)
+                    length = FindMatch(z, pos, candidate, prevLength, &distance);
+            }
+
+            // The match found one byte earlier wins unless this one is longer.
+            if (prevLength >= kMinMatch && length == 0)
+            {
+                AddMatch(z, pos - 1, prevLength, prevDistance);
+                InsertRange(z, pos + 1, pos - 1 + prevLength);
+                pos += prevLength - 1;
+                pendingLiteral = false;
+                continue;
+            }
+
+            if (pendingLiteral)
+                AddLiteral(z, pos - 1);
+            pendingLiteral = true;
+            pos++;
+        }
+
+        if (pendingLiteral)
+            AddLiteral(z, z->size - 1);
+    }
+}
+
+size_t alimerDeflateBound(size_t size)
+{
+    // Worst case is a stored block for every kBlockTokens literals, plus the empty block of a sync flush.
+    return size + (size / kBlockTokens + 1) * 6 + (size / 65535 + 1) * 5 + 16;
+}
+
+size_t alimerDeflate(const void* data, size_t size, uint32_t level, bool finalBlock, void* dst, size_t dstCapacity)
+{
+    ScratchScope scratch;
+    Deflater* z = (Deflater*)alimerScratchAlloc(sizeof(Deflater));
+    if (!z)
+        return 0;
+
+    memset(z->head, 0, sizeof(z->head));
+    z->data = (const uint8_t*)data;
+    z->size = size;
+    z->config = kDeflateConfigs[level < 1 ? 6 : level > 9 ? 9 : level];
+    z->out = (uint8_t*)dst;
+    z->outEnd = z->out + dstCapacity;
+    z->bits = 0;
+    z->bitCount = 0;
+    z->overflow = false;
+    z->tokenCount = 0;
+    z->blockStart = 0;
+    memset(z->lengthFrequencies, 0, sizeof(z->lengthFrequencies));
+    memset(z->distFrequencies, 0, sizeof(z->distFrequencies));
+
+    if (level <= 3 && level > 0)
+        CompressGreedy(z);
+    else
+        CompressLazy(z);
+
+    if (z->tokenCount > 0 || z->blockStart < size || (size == 0 && finalBlock))
+        FlushBlock(z, size, finalBlock);
+    else if (finalBlock)
+        PutBits(z, 1 | (1 << 1), 3 + 7); // an empty fixed block: header and end of block code 0
+
+    // Sync flush: an empty stored block leaves the stream byte aligned so another one can follow.
+    if (!finalBlock)
+    {
+        PutBits(z, 0, 3);
+        AlignBits(z);
+        PutBits(z, 0xFFFF0000u, 32);
+    }
+    AlignBits(z);
+
+    const size_t result = z->overflow ? 0 : (size_t)(z->out - (uint8_t*)dst);
+    alimerScratchFree(z);
+    return result;
+}
+
+uint32_t alimerAdler32(uint32_t adler, const void* data, size_t size)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+#if defined(ALIMER_SSE2)
+    // 16 bytes per step: sad sums the bytes for a, b takes the running a once per step (times 16, added at the end)
+    // plus the bytes weighted 16 down to 1. 5552 bytes keep every lane from overflowing.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weightsLow = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+    const __m128i weightsHigh = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+    while (size >= 16)
+    {
+        const size_t blocks = std::min<size_t>(size, 5552) / 16;
+        __m128i sumA = zero;
+        __m128i sumPrefix = zero;
+        __m128i sumB = zero;
+        for (size_t i = 0; i < blocks; ++i)
+        {
+            const __m128i bytes = _mm_loadu_si128((const __m128i*)(p + i * 16));
+            sumPrefix = _mm_add_epi32(sumPrefix, sumA);
+            sumA = _mm_add_epi32(sumA, _mm_sad_epu8(bytes, zero));
+            sumB = _mm_add_epi32(sumB, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), weightsLow));
+            sumB = _mm_add_epi32(sumB, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), weightsHigh));
+        }
+
+        uint32_t lanesA[4];
+        uint32_t lanesPrefix[4];
+        uint32_t lanesB[4];
+        _mm_storeu_si128((__m128i*)lanesA, sumA);
+        _mm_storeu_si128((__m128i*)lanesPrefix, sumPrefix);
+        _mm_storeu_si128((__m128i*)lanesB, sumB);
+
+        const size_t count = blocks * 16;
+        uint64_t b64 = b + (uint64_t)a * count;
+        b64 += 16 * ((uint64_t)lanesPrefix[0] + lanesPrefix[1] + lanesPrefix[2] + lanesPrefix[3]);
+        b64 += (uint64_t)lanesB[0] + lanesB[1] + lanesB[2] + lanesB[3];
+        a = (uint32_t)((a + (uint64_t)lanesA[0] + lanesA[2]) % 65521);
+        b = (uint32_t)(b64 % 65521);
+        p += count;
+        size -= count;
+    }
+#endif
+
+    while (size > 0)
+    {
+        // 5552 is the largest run that cannot overflow b before the modulo.
+        const size_t count = size < 5552 ? size : 5552;
+        for (size_t i = 0; i < count; ++i)
+        {
+            a += p[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        p += count;
+        size -= count;
+    }
+
+    return (b << 16) | a;
+}
+
+uint32_t alimerAdler32Combine(uint32_t adler1, uint32_t adler2, size_t size2)
+{
+    const uint32_t base = 65521;
+    const uint32_t remainder = (uint32_t)(size2 % base);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = (uint32_t)(((uint64_t)remainder * sum1) % base);
+    sum1 += (adler2 & 0xFFFF) + base - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + base - remainder;
+    if (sum1 >= base)
+        sum1 -= base;
+    if (sum1 >= base)
+        sum1 -= base;
+    if (sum2 >= base * 2)
+        sum2 -= base * 2;
+    if (sum2 >= base)
+        sum2 -= base;
+    return sum1 | (sum2 << 16);
+}
+
+namespace
+{
+    // Slice-by-8: values[k][i] is the CRC of byte i followed by k zero bytes.
+    struct CrcTables
+    {
+        uint32_t values[8][256];
+
+        CrcTables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (uint32_t k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                values[0][i] = c;
+            }
+
+            for (uint32_t k = 1; k < 8; ++k)
+            {
+                for (uint32_t i = 0; i < 256; ++i)
+                    values[k][i] = values[0][values[k - 1][i] & 0xFF] ^ (values[k - 1][i] >> 8);
+            }
+        }
+    };
+
+    const CrcTables& GetCrcTables()
+    {
+        static const CrcTables tables;
+        return tables;
+    }
+
+#if defined(ALIMER_PCLMUL)
+    // Carry-less multiply folding ("Fast CRC Computation for Generic Polynomials Using PCLMULQDQ", Intel), size is a
+    // multiple of 16 and at least 64. Works on the inverted CRC like the table loop.
+    uint32_t Crc32Fold(uint32_t crc, const uint8_t* p, size_t size)
+    {
+        const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+        const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+        const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124);
+        const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+        const __m128i mask32 = _mm_setr_epi32(-1, 0, -1, 0);
+
+        __m128i x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)p), _mm_cvtsi32_si128((int)crc));
+        __m128i x2 = _mm_loadu_si128((const __m128i*)(p + 16));
+        __m128i x3 = _mm_loadu_si128((const __m128i*)(p + 32));
+        __m128i x4 = _mm_loadu_si128((const __m128i*)(p + 48));
+        p += 64;
+        size -= 64;
+
+        // Four lanes of 128 bits folded 512 bits ahead.
+        for (; size >= 64; p += 64, size -= 64)
+        {
+            const __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+            const __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+            const __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+            const __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+            x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k1k2, 0x11), x5), _mm_loadu_si128((const __m128i*)p));
+            x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, k1k2, 0x11), x6), _mm_loadu_si128((const __m128i*)(p + 16)));
+            x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, k1k2, 0x11), x7), _mm_loadu_si128((const __m128i*)(p + 32)));
+            x4 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x4, k1k2, 0x11), x8), _mm_loadu_si128((const __m128i*)(p + 48)));
+        }
+
+        // Fold the lanes and any remaining 16 byte blocks into one.
+        const __m128i rest[3] = { x2, x3, x4 };
+        for (uint32_t i = 0; i < 3; ++i)
+            x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), _mm_clmulepi64_si128(x1, k3k4, 0x00)), rest[i]);
+        for (; size >= 16; p += 16, size -= 16)
+            x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), _mm_clmulepi64_si128(x1, k3k4, 0x00)), _mm_loadu_si128((const __m128i*)p));
+
+        // 128 to 64 bits, then a Barrett reduction to 32.
+        x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5k0, 0x00), x2);
+
+        x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+        x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask32), poly, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+        return (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+    }
+#endif
+}
+
+uint32_t alimerCrc32(uint32_t crc, const void* data, size_t size)
+{
+    const CrcTables& tables = GetCrcTables();
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+
+#if defined(ALIMER_PCLMUL)
+    if (size >= 64)
+    {
+        const size_t count = size & ~(size_t)15;
+        crc = Crc32Fold(crc, p, count);
+        p += count;
+        size -= count;
+    }
+#endif
+
+    for (; size >= 8; p += 8, size -= 8)
+    {
+        const uint32_t low = crc ^ ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+        crc = tables.values[7][low & 0xFF] ^ tables.values[6][(low >> 8) & 0xFF] ^ tables.values[5][(low >> 16) & 0xFF] ^ tables.values[4][low >> 24]
+            ^ tables.values[3][p[4]] ^ tables.values[2][p[5]] ^ tables.values[1][p[6]] ^ tables.values[0][p[7]];
+    }
+
+    for (; size > 0; ++p, --size)
+        crc = tables.values[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
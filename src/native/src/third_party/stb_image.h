@@ -433,6 +433,13 @@ STBIDEF stbi_uc *stbi_load_from_file  (FILE *f, int *x, int *y, int *channels_in
 STBIDEF stbi_uc *stbi_load_gif_from_memory(stbi_uc const *buffer, int len, int **delays, int *x, int *y, int *z, int *comp, int req_comp);
 #endif
 
+#ifndef STBI_NO_JPEG
+// decode a JPEG at 1/2, 1/4 or 1/8 of its size (scale_shift 1 to 3) with reduced size IDCTs,
+// the output size is rounded up. Files whose chroma is subsampled differently in x and y
+// (4:2:2, 4:4:0) can't be scaled with square IDCTs and decode at full size, check *x and *y
+STBIDEF stbi_uc *stbi_load_jpeg_scaled_from_memory(stbi_uc const *buffer, int len, int *x, int *y, int *channels_in_file, int desired_channels, int scale_shift);
+#endif
+
 #ifdef STBI_WINDOWS_UTF8
 STBIDEF int stbi_convert_wchar_to_utf8(char *buffer, size_t bufferlen, const wchar_t* input);
 #endif
@@ -688,6 +695,11 @@ typedef unsigned char validate_uint32[sizeof(stbi__uint32)==4 ? 1 : -1];
 #define STBI_REALLOC_SIZED(p,oldsz,newsz) STBI_REALLOC(p,newsz)
 #endif
 
+// PNG IDAT decompression, can be routed to another zlib implementation
+#ifndef STBI_PNG_ZLIB_DECODE
+#define STBI_PNG_ZLIB_DECODE(buffer,len,initial_size,outlen,parse_header) stbi_zlib_decode_malloc_guesssize_headerflag(buffer,len,initial_size,outlen,parse_header)
+#endif
+
 // x86/x64 detection
 #if defined(__x86_64__) || defined(_M_X64)
 #define STBI__X64_TARGET
@@ -1974,6 +1986,8 @@ typedef struct
       stbi_uc *linebuf;
       short   *coeff;   // progressive only
       int      coeff_w, coeff_h; // number of 8x8 coefficient blocks
+      int      scale_shift; // blocks of this component decode to (8 >> scale_shift) pixels
+      void   (*idct_block_kernel)(stbi_uc *out, int out_stride, short data[64]);
    } img_comp[4];
 
    stbi__uint32   code_buffer; // jpeg entropy-coded buffer
@@ -1990,6 +2004,7 @@ typedef struct
    int            jfif;
    int            app14_color_transform; // Adobe APP14 tag
    int            rgb;
+   int            scale_shift; // the image decodes at 1/(1 << scale_shift) of its size
 
    int scan_n, order[4];
    int restart_interval, todo;
@@ -2523,6 +2538,88 @@ static void stbi__idct_block(stbi_uc *out, int out_stride, short data[64])
    }
 }
 
+// reduced size IDCTs for scaled decoding. like libjpeg's jidctred.c these
+// produce the average of each 2x2 (or 4x4) group of pixels the full 8x8 IDCT
+// would, so they filter and decimate in one step: cos((2x+1)u*pi/16) averaged
+// over the group folds into a single constant per output and frequency. the
+// middle frequency (and for 2x2 every even one but DC) cancels out entirely.
+// constants include the 1/2 of each 8 point 1D pass
+#define STBI__IDCT_4(s0,s1,s2,s3,s5,s6,s7) \
+   int t0 = (s0) * stbi__f2f(0.353553391f); \
+   int t2 = (s2) * stbi__f2f(0.326640741f) - (s6) * stbi__f2f(0.135299025f); \
+   int x0 = t0 + t2, x1 = t0 - t2; \
+   int o0 = (s1) * stbi__f2f(0.453063723f) + (s3) * stbi__f2f(0.159094823f) \
+          - (s5) * stbi__f2f(0.106303762f) - (s7) * stbi__f2f(0.090119978f); \
+   int o1 = (s1) * stbi__f2f(0.187665139f) - (s3) * stbi__f2f(0.384088878f) \
+          + (s5) * stbi__f2f(0.256639984f) - (s7) * stbi__f2f(0.037328917f);
+
+#define STBI__IDCT_2(s0,s1,s3,s5,s7) \
+   int x0 = (s0) * stbi__f2f(0.353553391f); \
+   int o0 = (s1) * stbi__f2f(0.320364431f) - (s3) * stbi__f2f(0.112497028f) \
+          + (s5) * stbi__f2f(0.075168111f) - (s7) * stbi__f2f(0.063724447f);
+
+static void stbi__idct_block_4x4(stbi_uc *out, int out_stride, short data[64])
+{
+   int i,val[32],*v=val;
+   stbi_uc *o;
+   short *d = data;
+
+   // columns, 4 outputs from each
+   for (i=0; i < 8; ++i,++d,++v) {
+      if (d[ 8]==0 && d[16]==0 && d[24]==0 && d[40]==0 && d[48]==0 && d[56]==0) {
+         int dcterm = (d[0] * stbi__f2f(0.353553391f) + 512) >> 10;
+         v[0] = v[8] = v[16] = v[24] = dcterm;
+      } else {
+         STBI__IDCT_4(d[0],d[8],d[16],d[24],d[40],d[48],d[56])
+         // keep 2 extra bits of precision, like the 8x8 version
+         x0 += 512; x1 += 512;
+         v[ 0] = (x0+o0) >> 10;
+         v[24] = (x0-o0) >> 10;
+         v[ 8] = (x1+o1) >> 10;
+         v[16] = (x1-o1) >> 10;
+      }
+   }
+
+   for (i=0, v=val, o=out; i < 4; ++i,v+=8,o+=out_stride) {
+      STBI__IDCT_4(v[0],v[1],v[2],v[3],v[5],v[6],v[7])
+      // 1<<12 from the constants and 1<<2 from the first pass
+      x0 += 8192 + (128<<14);
+      x1 += 8192 + (128<<14);
+      o[0] = stbi__clamp((x0+o0) >> 14);
+      o[3] = stbi__clamp((x0-o0) >> 14);
+      o[1] = stbi__clamp((x1+o1) >> 14);
+      o[2] = stbi__clamp((x1-o1) >> 14);
+   }
+}
+
+static void stbi__idct_block_2x2(stbi_uc *out, int out_stride, short data[64])
+{
+   int i,val[16],*v=val;
+   short *d = data;
+
+   // columns, 2 outputs from each
+   for (i=0; i < 8; ++i,++d,++v) {
+      STBI__IDCT_2(d[0],d[8],d[24],d[40],d[56])
+      x0 += 512;
+      v[0] = (x0+o0) >> 10;
+      v[8] = (x0-o0) >> 10;
+   }
+
+   for (i=0, v=val; i < 2; ++i,v+=8,out+=out_stride) {
+      STBI__IDCT_2(v[0],v[1],v[3],v[5],v[7])
+      x0 += 8192 + (128<<14);
+      out[0] = stbi__clamp((x0+o0) >> 14);
+      out[1] = stbi__clamp((x0-o0) >> 14);
+   }
+}
+
+// the DC coefficient is 8 times the block average
+static void stbi__idct_block_1x1(stbi_uc *out, int out_stride, short data[64])
+{
+   STBI_NOTUSED(out_stride);
+   out[0] = stbi__clamp(((data[0]+4) >> 3) + 128);
+}
+
 #ifdef STBI_SSE2
 // sse2 integer IDCT. not the fastest possible implementation but it
 // produces bit-identical results to the generic C version so it's
@@ -2702,6 +2799,116 @@ static void stbi__idct_simd(stbi_uc *out, int out_stride, short data[64])
 #undef dct_pass
 }
 
+// sse2 version of stbi__idct_block_4x4, bit-identical to it. the column pass
+// works on all 8 columns at once, the row pass computes each output as an 8
+// term dot product and sums the pmaddwd partials with a transpose
+static void stbi__idct_simd_4x4(stbi_uc *out, int out_stride, short data[64])
+{
+   int i;
+   __m128i row0, row1, row2, row3, row5, row6, row7, zero = _mm_setzero_si128();
+   __m128i v[4], sums[4];
+
+   #define dct_const(x,y)  _mm_setr_epi16((x),(y),(x),(y),(x),(y),(x),(y))
+   #define dct_row_const(a,b,c,d,e,f,g,h) _mm_setr_epi16((a),(b),(c),(d),(e),(f),(g),(h))
+
+   // the 4x4 constants, each output takes +/- the same magnitudes
+   #define K0 stbi__f2f(0.353553391f)
+   #define K2 stbi__f2f(0.326640741f)
+   #define K6 stbi__f2f(0.135299025f)
+   #define A1 stbi__f2f(0.453063723f)
+   #define A3 stbi__f2f(0.159094823f)
+   #define A5 stbi__f2f(0.106303762f)
+   #define A7 stbi__f2f(0.090119978f)
+   #define B1 stbi__f2f(0.187665139f)
+   #define B3 stbi__f2f(0.384088878f)
+   #define B5 stbi__f2f(0.256639984f)
+   #define B7 stbi__f2f(0.037328917f)
+
+   // one half (4 columns) of the column pass, 32-bit results
+   #define dct_col_half(unpack, r0, r1, r2, r3) \
+      { \
+         __m128i p02 = unpack(row0, row2), p6z = unpack(row6, zero); \
+         __m128i p13 = unpack(row1, row3), p57 = unpack(row5, row7); \
+         __m128i e0 = _mm_add_epi32(_mm_madd_epi16(p02, c02a), _mm_madd_epi16(p6z, c6a)); \
+         __m128i e1 = _mm_add_epi32(_mm_madd_epi16(p02, c02b), _mm_madd_epi16(p6z, c6b)); \
+         __m128i o0 = _mm_add_epi32(_mm_madd_epi16(p13, c13a), _mm_madd_epi16(p57, c57a)); \
+         __m128i o1 = _mm_add_epi32(_mm_madd_epi16(p13, c13b), _mm_madd_epi16(p57, c57b)); \
+         e0 = _mm_add_epi32(e0, bias_0); \
+         e1 = _mm_add_epi32(e1, bias_0); \
+         r0 = _mm_srai_epi32(_mm_add_epi32(e0, o0), 10); \
+         r3 = _mm_srai_epi32(_mm_sub_epi32(e0, o0), 10); \
+         r1 = _mm_srai_epi32(_mm_add_epi32(e1, o1), 10); \
+         r2 = _mm_srai_epi32(_mm_sub_epi32(e1, o1), 10); \
+      }
+
+   __m128i c02a = dct_const(K0,  K2), c02b = dct_const(K0, -K2);
+   __m128i c6a  = dct_const(-K6, 0),  c6b  = dct_const(K6, 0);
+   __m128i c13a = dct_const(A1,  A3), c13b = dct_const(B1, -B3);
+   __m128i c57a = dct_const(-A5, -A7), c57b = dct_const(B5, -B7);
+   __m128i w[4];
+   __m128i bias_0 = _mm_set1_epi32(512);
+   __m128i bias_1 = _mm_set1_epi32(8192 + (128<<14));
+   w[0] = dct_row_const(K0,  A1,  K2,  A3, 0, -A5, -K6, -A7);
+   w[1] = dct_row_const(K0,  B1, -K2, -B3, 0,  B5,  K6, -B7);
+   w[2] = dct_row_const(K0, -B1, -K2,  B3, 0, -B5,  K6,  B7);
+   w[3] = dct_row_const(K0, -A1,  K2, -A3, 0,  A5, -K6,  A7);
+
+   row0 = _mm_load_si128((const __m128i *) (data + 0*8));
+   row1 = _mm_load_si128((const __m128i *) (data + 1*8));
+   row2 = _mm_load_si128((const __m128i *) (data + 2*8));
+   row3 = _mm_load_si128((const __m128i *) (data + 3*8));
+   row5 = _mm_load_si128((const __m128i *) (data + 5*8));
+   row6 = _mm_load_si128((const __m128i *) (data + 6*8));
+   row7 = _mm_load_si128((const __m128i *) (data + 7*8));
+
+   // column pass, the 4 output rows keep their 8 frequencies as 16-bit
+   {
+      __m128i l0, l1, l2, l3, h0, h1, h2, h3;
+      dct_col_half(_mm_unpacklo_epi16, l0, l1, l2, l3)
+      dct_col_half(_mm_unpackhi_epi16, h0, h1, h2, h3)
+      v[0] = _mm_packs_epi32(l0, h0);
+      v[1] = _mm_packs_epi32(l1, h1);
+      v[2] = _mm_packs_epi32(l2, h2);
+      v[3] = _mm_packs_epi32(l3, h3);
+   }
+
+   // row pass
+   for (i=0; i < 4; ++i) {
+      __m128i m0 = _mm_madd_epi16(v[i], w[0]);
+      __m128i m1 = _mm_madd_epi16(v[i], w[1]);
+      __m128i m2 = _mm_madd_epi16(v[i], w[2]);
+      __m128i m3 = _mm_madd_epi16(v[i], w[3]);
+      __m128i t01 = _mm_add_epi32(_mm_unpacklo_epi32(m0, m1), _mm_unpackhi_epi32(m0, m1));
+      __m128i t23 = _mm_add_epi32(_mm_unpacklo_epi32(m2, m3), _mm_unpackhi_epi32(m2, m3));
+      __m128i sum = _mm_add_epi32(_mm_unpacklo_epi64(t01, t23), _mm_unpackhi_epi64(t01, t23));
+      sums[i] = _mm_srai_epi32(_mm_add_epi32(sum, bias_1), 14);
+   }
+
+   {
+      __m128i p = _mm_packus_epi16(_mm_packs_epi32(sums[0], sums[1]), _mm_packs_epi32(sums[2], sums[3]));
+      for (i=0; i < 4; ++i, out += out_stride) {
+         int pixels = _mm_cvtsi128_si32(p);
+         memcpy(out, &pixels, 4);
+         p = _mm_srli_si128(p, 4);
+      }
+   }
+
+#undef dct_const
+#undef dct_row_const
+#undef dct_col_half
+#undef K0
+#undef K2
+#undef K6
+#undef A1
+#undef A3
+#undef A5
+#undef A7
+#undef B1
+#undef B3
+#undef B5
+#undef B7
+}
+
 #endif // STBI_SSE2
 
 #ifdef STBI_NEON
@@ -2954,6 +3161,7 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
          int i,j;
          STBI_SIMD_ALIGN(short, data[64]);
          int n = z->order[0];
+         int bs = 8 >> z->img_comp[n].scale_shift;
          // non-interleaved data, we just need to process one block at a time,
          // in trivial scanline order
          // number of blocks to do just depends on how many actual "pixels" this
@@ -2964,7 +3172,7 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                int ha = z->img_comp[n].ha;
                if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               z->img_comp[n].idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*bs+i*bs, z->img_comp[n].w2, data);
                // every data block is an MCU, so countdown the restart interval
                if (--z->todo <= 0) {
                   if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
@@ -2988,11 +3196,12 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
                   // by the basic H and V specified for the component
                   for (y=0; y < z->img_comp[n].v; ++y) {
                      for (x=0; x < z->img_comp[n].h; ++x) {
-                        int x2 = (i*z->img_comp[n].h + x)*8;
-                        int y2 = (j*z->img_comp[n].v + y)*8;
+                        int bs = 8 >> z->img_comp[n].scale_shift;
+                        int x2 = (i*z->img_comp[n].h + x)*bs;
+                        int y2 = (j*z->img_comp[n].v + y)*bs;
                         int ha = z->img_comp[n].ha;
                         if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-                        z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*y2+x2, z->img_comp[n].w2, data);
+                        z->img_comp[n].idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*y2+x2, z->img_comp[n].w2, data);
                      }
                   }
                }
@@ -3083,13 +3292,14 @@ static void stbi__jpeg_finish(stbi__jpeg *z)
       // dequantize and idct the data
       int i,j,n;
       for (n=0; n < z->s->img_n; ++n) {
+         int bs = 8 >> z->img_comp[n].scale_shift;
          int w = (z->img_comp[n].x+7) >> 3;
          int h = (z->img_comp[n].y+7) >> 3;
          for (j=0; j < h; ++j) {
             for (i=0; i < w; ++i) {
                short *data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
                stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               z->img_comp[n].idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*bs+i*bs, z->img_comp[n].w2, data);
             }
          }
       }
@@ -3261,6 +3471,23 @@ static int stbi__free_jpeg_components(stbi__jpeg *z, int ncomp, int why)
    return why;
 }
 
+// the IDCT that turns a block into (8 >> scale_shift) by (8 >> scale_shift) pixels
+typedef void (*stbi__idct_kernel)(stbi_uc *out, int out_stride, short data[64]);
+static stbi__idct_kernel stbi__idct_scaled_kernel(stbi__jpeg *z, int scale_shift)
+{
+   switch (scale_shift) {
+      case 1:
+#ifdef STBI_SSE2
+         if (stbi__sse2_available())
+            return stbi__idct_simd_4x4;
+#endif
+         return stbi__idct_block_4x4;
+      case 2: return stbi__idct_block_2x2;
+      case 3: return stbi__idct_block_1x1;
+      default: return z->idct_block_kernel;
+   }
+}
+
 static int stbi__process_frame_header(stbi__jpeg *z, int scan)
 {
    stbi__context *s = z->s;
@@ -3309,6 +3536,22 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       if (v_max % z->img_comp[i].v != 0) return stbi__err("bad V","Corrupt JPEG");
    }
 
+   // like libjpeg, a component subsampled by 2^k takes k steps less of the scaling in its IDCT and so
+   // comes out at the scaled image size instead of being upsampled from blocks that are too small;
+   // the kernels are square, so a file subsampled differently in x and y isn't scaled at all
+   for (i=0; i < s->img_n; ++i) {
+      int hk = 0, vk = 0;
+      while (hk < z->scale_shift && (h_max / z->img_comp[i].h) % (2 << hk) == 0) ++hk;
+      while (vk < z->scale_shift && (v_max / z->img_comp[i].v) % (2 << vk) == 0) ++vk;
+      if (hk != vk) z->scale_shift = 0;
+   }
+   for (i=0; i < s->img_n; ++i) {
+      int k = 0;
+      while (k < z->scale_shift && (h_max / z->img_comp[i].h) % (2 << k) == 0) ++k;
+      z->img_comp[i].scale_shift = z->scale_shift - k;
+      z->img_comp[i].idct_block_kernel = stbi__idct_scaled_kernel(z, z->img_comp[i].scale_shift);
+   }
+
    // compute interleaved mcu info
    z->img_h_max = h_max;
    z->img_v_max = v_max;
@@ -3329,8 +3572,8 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       //
       // img_mcu_x, img_mcu_y: <=17 bits; comp[i].h and .v are <=4 (checked earlier)
       // so these muls can't overflow with 32-bit ints (which we require)
-      z->img_comp[i].w2 = z->img_mcu_x * z->img_comp[i].h * 8;
-      z->img_comp[i].h2 = z->img_mcu_y * z->img_comp[i].v * 8;
+      z->img_comp[i].w2 = z->img_mcu_x * z->img_comp[i].h * (8 >> z->img_comp[i].scale_shift);
+      z->img_comp[i].h2 = z->img_mcu_y * z->img_comp[i].v * (8 >> z->img_comp[i].scale_shift);
       z->img_comp[i].coeff = 0;
       z->img_comp[i].raw_coeff = 0;
       z->img_comp[i].linebuf = NULL;
@@ -3340,10 +3583,10 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       // align blocks for idct using mmx/sse
       z->img_comp[i].data = (stbi_uc*) (((size_t) z->img_comp[i].raw_data + 15) & ~15);
       if (z->progressive) {
-         // w2, h2 are multiples of 8 (see above)
-         z->img_comp[i].coeff_w = z->img_comp[i].w2 / 8;
-         z->img_comp[i].coeff_h = z->img_comp[i].h2 / 8;
-         z->img_comp[i].raw_coeff = stbi__malloc_mad3(z->img_comp[i].w2, z->img_comp[i].h2, sizeof(short), 15);
+         // w2, h2 are multiples of the scaled block size (see above)
+         z->img_comp[i].coeff_w = z->img_mcu_x * z->img_comp[i].h;
+         z->img_comp[i].coeff_h = z->img_mcu_y * z->img_comp[i].v;
+         z->img_comp[i].raw_coeff = stbi__malloc_mad3(z->img_comp[i].coeff_w * 8, z->img_comp[i].coeff_h * 8, sizeof(short), 15);
          if (z->img_comp[i].raw_coeff == NULL)
             return stbi__free_jpeg_components(z, i+1, stbi__err("outofmem", "Out of memory"));
          z->img_comp[i].coeff = (short*) (((size_t) z->img_comp[i].raw_coeff + 15) & ~15);
@@ -3873,6 +4116,21 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
    // load a jpeg image from whichever source, but leave in YCbCr format
    if (!stbi__decode_jpeg_image(z)) { stbi__cleanup_jpeg(z); return NULL; }
 
+   // from here on every size is in scaled pixels, and a component that took less of the scaling
+   // counts as that much less subsampled so the resampler doesn't stretch it
+   if (z->scale_shift) {
+      int round = (1 << z->scale_shift) - 1;
+      z->s->img_x = (z->s->img_x + round) >> z->scale_shift;
+      z->s->img_y = (z->s->img_y + round) >> z->scale_shift;
+      for (n=0; n < z->s->img_n; ++n) {
+         int shift = z->img_comp[n].scale_shift;
+         z->img_comp[n].x = (z->img_comp[n].x + (1 << shift) - 1) >> shift;
+         z->img_comp[n].y = (z->img_comp[n].y + (1 << shift) - 1) >> shift;
+         z->img_comp[n].h <<= z->scale_shift - shift;
+         z->img_comp[n].v <<= z->scale_shift - shift;
+      }
+   }
+
    // determine actual number of components to generate
    n = req_comp ? req_comp : z->s->img_n >= 3 ? 3 : 1;
 
@@ -4076,6 +4334,24 @@ static int stbi__jpeg_info(stbi__context *s, int *x, int *y, int *comp)
    STBI_FREE(j);
    return result;
 }
+
+STBIDEF stbi_uc *stbi_load_jpeg_scaled_from_memory(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, int scale_shift)
+{
+   unsigned char* result;
+   stbi__context s;
+   stbi__jpeg* j;
+   if (scale_shift < 0 || scale_shift > 3) return stbi__errpuc("bad scale", "Internal error");
+   stbi__start_mem(&s,buffer,len);
+   j = (stbi__jpeg*) stbi__malloc(sizeof(stbi__jpeg));
+   if (!j) return stbi__errpuc("outofmem", "Out of memory");
+   memset(j, 0, sizeof(stbi__jpeg));
+   j->s = &s;
+   stbi__setup_jpeg(j);
+   j->scale_shift = scale_shift;
+   result = load_jpeg_image(j, x,y,comp,req_comp);
+   STBI_FREE(j);
+   return result;
+}
 #endif
 
 // public domain zlib decode    v0.2  Sean Barrett 2006-11-18
@@ -5204,7 +5480,7 @@ static int stbi__parse_png_file(stbi__png *z, int scan, int req_comp)
             // initial guess for decoded data size to avoid unnecessary reallocs
             bpl = (s->img_x * z->depth + 7) / 8; // bytes per line, per component
             raw_len = bpl * s->img_y * s->img_n /* pixels */ + s->img_y /* filter mode per row */;
-            z->expanded = (stbi_uc *) stbi_zlib_decode_malloc_guesssize_headerflag((char *) z->idata, ioff, raw_len, (int *) &raw_len, !is_iphone);
+            z->expanded = (stbi_uc *) STBI_PNG_ZLIB_DECODE((char *) z->idata, ioff, raw_len, (int *) &raw_len, !is_iphone);
             if (z->expanded == NULL) return 0; // zlib should set error
             STBI_FREE(z->idata); z->idata = NULL;
             if ((req_comp == s->img_n+1 && req_comp != 3 && !pal_img_n) || has_trans)
@@ -3248,6 +3248,10 @@ static void stbir__calculate_in_pixel_range( int * first_pixel, int * last_pixel
   first = (int)(STBIR_FLOORF(in_pixel_influence_lowerbound + 0.5f));
   last = (int)(STBIR_FLOORF(in_pixel_influence_upperbound - 0.5f));
 
+  // a point sample footprint is exactly one input pixel wide, rounding can leave it empty
+  if ( last < first )
+    last = first;
+
   if ( edge == STBIR_EDGE_WRAP )
   {
     if ( first < -input_size )
@@ -1378,7 +1378,7 @@ static bool CompressZip(unsigned char *dst,
     return false;
   }
   memcpy(dst, ret, outSize);
-  free(ret);
+  STBIW_FREE(ret);
 
   compressedSize = outSize;
 #elif defined(TINYEXR_USE_NANOZLIB) && (TINYEXR_USE_NANOZLIB==1)
@@ -0,0 +1,193 @@
+// Round trip, truncation, corruption and mutation tests for the deflate codec, returns non zero on failure.
+#include "alimer_internal.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+    int s_failures = 0;
+
+#define CHECK(cond, ...) \
+    do { if (!(cond)) { s_failures++; printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+    uint32_t s_seed = 12345;
+
+    uint32_t Random()
+    {
+        s_seed = s_seed * 1664525u + 1013904223u;
+        return s_seed >> 8;
+    }
+
+    // Text-like data with repeats at every distance class, plus some noise.
+    std::vector<uint8_t> MakeData(size_t size, uint32_t noise)
+    {
+        static const char kWords[] = "the quick brown fox jumps over the lazy dog 0123456789 ";
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (Random() % 100 < noise)
+                data[i] = (uint8_t)Random();
+            else if (i > 300 && Random() % 4 == 0)
+                data[i] = data[i - 1 - Random() % 300];
+            else
+                data[i] = (uint8_t)kWords[i % (sizeof(kWords) - 1)];
+        }
+        return data;
+    }
+
+    // zlib wrapper around alimerDeflate, the same layout PNG and EXR use.
+    std::vector<uint8_t> Compress(const std::vector<uint8_t>& data, uint32_t level)
+    {
+        std::vector<uint8_t> stream(alimerDeflateBound(data.size()) + 6);
+        stream[0] = 0x78;
+        stream[1] = 0x9C;
+        const size_t size = alimerDeflate(data.data(), data.size(), level, true, stream.data() + 2, stream.size() - 6);
+        const uint32_t adler = alimerAdler32(1, data.data(), data.size());
+        uint8_t* trailer = stream.data() + 2 + size;
+        trailer[0] = (uint8_t)(adler >> 24);
+        trailer[1] = (uint8_t)(adler >> 16);
+        trailer[2] = (uint8_t)(adler >> 8);
+        trailer[3] = (uint8_t)adler;
+        stream.resize(size + 6);
+        return stream;
+    }
+
+    struct StreamContext
+    {
+        const std::vector<uint8_t>* input;
+        size_t offset;
+        size_t chunkSize;
+        std::vector<uint8_t> output;
+    };
+
+    size_t ReadChunk(void* userData, const uint8_t** data)
+    {
+        StreamContext* context = (StreamContext*)userData;
+        const size_t size = std::min(context->chunkSize, context->input->size() - context->offset);
+        *data = context->input->data() + context->offset;
+        context->offset += size;
+        return size;
+    }
+
+    bool WriteChunk(void* userData, const uint8_t* data, size_t size)
+    {
+        StreamContext* context = (StreamContext*)userData;
+        context->output.insert(context->output.end(), data, data + size);
+        return true;
+    }
+
+    void TestRoundTrip()
+    {
+        const size_t sizes[] = { 0, 1, 17, 1000, 65536, 300000 };
+        for (size_t size : sizes)
+        {
+            for (uint32_t level = 1; level <= 9; level += 4)
+            {
+                const std::vector<uint8_t> data = MakeData(size, level == 5 ? 60 : 5);
+                const std::vector<uint8_t> stream = Compress(data, level);
+
+                std::vector<uint8_t> output(data.size() + 1);
+                size_t outSize = 0;
+                const InflateStatus status = alimerInflateBuffer(stream.data(), stream.size(), output.data(), data.size(), &outSize, true);
+                CHECK(status == InflateStatus_Success && outSize == data.size() && (outSize == 0 || memcmp(output.data(), data.data(), outSize) == 0),
+                    "buffer round trip, size %zu level %u, status %d", size, level, (int)status);
+
+                // Raw deflate, the zlib header and trailer stripped.
+                const std::vector<uint8_t> raw(stream.begin() + 2, stream.end() - 4);
+                CHECK(alimerInflateBuffer(raw.data(), raw.size(), output.data(), data.size(), &outSize, false) == InflateStatus_Success && outSize == data.size(),
+                    "raw round trip, size %zu level %u", size, level);
+
+                for (size_t chunkSize : { (size_t)1, (size_t)7, (size_t)4096 })
+                {
+                    StreamContext context = { &stream, 0, chunkSize, {} };
+                    const bool result = alimerInflate(ReadChunk, WriteChunk, &context, true);
+                    CHECK(result && context.output == data, "streamed round trip, size %zu level %u chunk %zu", size, level, chunkSize);
+                }
+
+                if (size > 0)
+                {
+                    CHECK(alimerInflateBuffer(stream.data(), stream.size(), output.data(), data.size() - 1, &outSize, true) == InflateStatus_OutputFull,
+                        "short output, size %zu level %u", size, level);
+                }
+            }
+        }
+    }
+
+    // Every prefix of a stream is invalid, even when the zero padding would fill the output.
+    void TestTruncation()
+    {
+        const std::vector<uint8_t> data = MakeData(5000, 10);
+        const std::vector<uint8_t> stream = Compress(data, 6);
+        std::vector<uint8_t> output(data.size());
+        for (size_t size = 0; size < stream.size(); ++size)
+        {
+            size_t outSize = 0;
+            const InflateStatus status = alimerInflateBuffer(stream.data(), size, output.data(), output.size(), &outSize, true);
+            CHECK(status == InflateStatus_InvalidData, "truncated to %zu of %zu bytes, status %d", size, stream.size(), (int)status);
+
+            const std::vector<uint8_t> prefix(stream.begin(), stream.begin() + size);
+            StreamContext context = { &prefix, 0, 64, {} };
+            CHECK(!alimerInflate(ReadChunk, WriteChunk, &context, true), "streamed truncated to %zu bytes", size);
+        }
+    }
+
+    void TestChecksum()
+    {
+        const std::vector<uint8_t> data = MakeData(2000, 10);
+        std::vector<uint8_t> output(data.size());
+        for (size_t i = 0; i < 4; ++i)
+        {
+            std::vector<uint8_t> stream = Compress(data, 6);
+            stream[stream.size() - 1 - i] ^= 0x01;
+            size_t outSize = 0;
+            CHECK(alimerInflateBuffer(stream.data(), stream.size(), output.data(), output.size(), &outSize, true) == InflateStatus_InvalidData,
+                "adler byte %zu flipped", i);
+        }
+    }
+
+    // Random byte flips, inserts and cuts: no crash, and nothing but the original data is ever accepted.
+    void TestMutations()
+    {
+        const std::vector<uint8_t> inputs[] = { MakeData(3000, 5), MakeData(700, 80), std::vector<uint8_t>(4000, 'A') };
+
+        std::vector<uint8_t> output;
+        for (uint32_t iteration = 0; iteration < 20000; ++iteration)
+        {
+            const std::vector<uint8_t>& data = inputs[iteration % 3];
+            std::vector<uint8_t> stream = Compress(data, 1 + iteration % 9);
+            const uint32_t mutations = 1 + Random() % 4;
+            for (uint32_t m = 0; m < mutations && !stream.empty(); ++m)
+            {
+                const size_t at = Random() % stream.size();
+                switch (Random() % 4)
+                {
+                    case 0: stream[at] ^= (uint8_t)(1u << (Random() % 8)); break;
+                    case 1: stream[at] = (uint8_t)Random(); break;
+                    case 2: stream.insert(stream.begin() + at, (uint8_t)Random()); break;
+                    default: stream.resize(at); break;
+                }
+            }
+
+            output.assign(data.size() + Random() % 64, 0);
+            size_t outSize = 0;
+            const InflateStatus status = alimerInflateBuffer(stream.data(), stream.size(), output.data(), output.size(), &outSize, true);
+            if (status == InflateStatus_Success)
+            {
+                CHECK(outSize == data.size() && memcmp(output.data(), data.data(), outSize) == 0, "mutation %u accepted with different output", iteration);
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestRoundTrip();
+    TestTruncation();
+    TestChecksum();
+    TestMutations();
+    if (s_failures == 0)
+        printf("alimer_zlib_tests: all passed\n");
+    return s_failures == 0 ? 0 : 1;
+}